@@ -0,0 +1,25 @@
+#!/bin/bash
+# Local hub balancing test: the login server, four fake hubs (tools/loadtest) and the fake clients, each its own process.
+# The hubs start with 0, 10 and 20 players, the login server has to even them out. The fourth one reports a tick over
+# budget and must get no one. Clients that log in again have to go back to their hub.
+# Run from the build directory: ../scripts/test_login_balance.sh [clientCount]
+CLIENT_COUNT=${1:-60}
+EXE=""
+[ -f login_srv.exe ] && EXE=".exe"
+
+./login_srv$EXE > /dev/null 2>&1 &
+LOGIN=$!
+trap 'kill -INT $LOGIN; wait' EXIT # the hubs stop with the login server
+
+./loadtest$EXE lobby 11911 50 0 5 > /dev/null 2>&1 &
+./loadtest$EXE lobby 11912 50 10 5 > /dev/null 2>&1 &
+./loadtest$EXE lobby 11913 50 20 5 > /dev/null 2>&1 &
+./loadtest$EXE lobby 11914 50 0 30 > /dev/null 2>&1 &
+sleep 2 # first load reports
+if ! kill -0 $LOGIN 2>/dev/null; then
+	echo "login server failed to start (port 10900 or 10901 in use?)"
+	trap - EXIT
+	exit 1
+fi
+
+./loadtest$EXE login $CLIENT_COUNT 11914 11911:0 11912:10 11913:20
@@ -0,0 +1,23 @@
+#!/bin/bash
+# Local placement test: the MatchMaker, three fake play servers (tools/loadtest) and a fake hub, each its own process.
+# The play servers cost 0.3, 0.9 and 2.7ms of tick per game, placement by load has to give the cheaper ones more games.
+# Run from the build directory: ../scripts/test_placement.sh [matchCount]
+MATCH_COUNT=${1:-30}
+EXE=""
+[ -f mm_srv.exe ] && EXE=".exe"
+
+./mm_srv$EXE > /dev/null 2>&1 &
+MM=$!
+trap 'kill -INT $MM; wait' EXIT # the play servers stop with the matchmaker
+
+./loadtest$EXE play 11901 20 0.3 > /dev/null 2>&1 &
+./loadtest$EXE play 11902 20 0.9 > /dev/null 2>&1 &
+./loadtest$EXE play 11903 20 2.7 > /dev/null 2>&1 &
+sleep 2 # first load reports
+if ! kill -0 $MM 2>/dev/null; then
+	echo "matchmaker failed to start (port 13900 in use?)"
+	trap - EXIT
+	exit 1
+fi
+
+./loadtest$EXE hub $MATCH_COUNT 11901 11902 11903
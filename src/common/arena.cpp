@@ -0,0 +1,197 @@
+#include "arena.h"
+
+static inline i32 SizeClass(size_t size)
+{
+	i32 shift = MemArena::MIN_CLASS_SHIFT;
+	while(((size_t)1 << shift) < size) shift++;
+	return shift - MemArena::MIN_CLASS_SHIFT;
+}
+
+void MemArena::Init(const char* name_, size_t chunkSize_)
+{
+	ASSERT(head == nullptr);
+	name = name_;
+	chunkSize = chunkSize_;
+}
+
+MemArena::Chunk* MemArena::NewChunk(size_t size)
+{
+	Chunk* chunk = (Chunk*)memAlloc(sizeof(Chunk) + size);
+	ASSERT(chunk);
+	chunk->next = nullptr;
+	chunk->size = size;
+	chunk->used = 0;
+
+	reservedBytes += size;
+	chunkCount++;
+	return chunk;
+}
+
+void* MemArena::AllocFromChunk(size_t size)
+{
+	// dedicated chunk, behind the current one so it keeps bump allocating
+	if(size > chunkSize / 2) {
+		Chunk* chunk = NewChunk(size);
+		chunk->used = size;
+		if(head) {
+			chunk->next = head->next;
+			head->next = chunk;
+		}
+		else {
+			head = chunk;
+		}
+		return chunk->Data();
+	}
+
+	if(!head || head->size - head->used < size) {
+		Chunk* chunk = NewChunk(chunkSize);
+		chunk->next = head;
+		head = chunk;
+	}
+
+	void* ptr = head->Data() + head->used;
+	head->used += size;
+	return ptr;
+}
+
+void* MemArena::Alloc(size_t size)
+{
+	ASSERT(chunkSize > 0);
+	if(size == 0) size = 1;
+
+	void* ptr;
+	if(size <= ((size_t)1 << MAX_CLASS_SHIFT)) {
+		const i32 c = SizeClass(size);
+		size = (size_t)1 << (c + MIN_CLASS_SHIFT);
+
+		if(freeList[c]) {
+			ptr = freeList[c];
+			freeList[c] = freeList[c]->next;
+		}
+		else {
+			ptr = AllocFromChunk(size);
+		}
+	}
+	else {
+		size = (size + 15) & ~(size_t)15;
+		ptr = AllocFromChunk(size);
+	}
+
+	usedBytes += size;
+	peakBytes = MAX(peakBytes, usedBytes);
+	return ptr;
+}
+
+void MemArena::Free(void* ptr, size_t size)
+{
+	if(!ptr) return;
+	if(!head) return; // the memory went away with the chunks (Release, Swap), containers freeing after that
+	if(size == 0) size = 1;
+
+	if(size <= ((size_t)1 << MAX_CLASS_SHIFT)) {
+		const i32 c = SizeClass(size);
+		FreeBlock* block = (FreeBlock*)ptr;
+		block->next = freeList[c];
+		freeList[c] = block;
+		usedBytes -= (size_t)1 << (c + MIN_CLASS_SHIFT);
+	}
+	else {
+		usedBytes -= (size + 15) & ~(size_t)15;
+	}
+}
+
+void MemArena::Reset()
+{
+	memset(freeList, 0, sizeof(freeList));
+	usedBytes = 0;
+
+	if(!head) return;
+
+	// what the last use needed, in one chunk, so the next one doesn't have to grow again
+	if(chunkCount > 1) {
+		const size_t size = MAX(reservedBytes, chunkSize);
+		Release();
+		head = NewChunk(size);
+		return;
+	}
+
+	head->used = 0;
+}
+
+void MemArena::Release()
+{
+	Chunk* chunk = head;
+	while(chunk) {
+		Chunk* next = chunk->next;
+		memFree(chunk);
+		chunk = next;
+	}
+
+	head = nullptr;
+	memset(freeList, 0, sizeof(freeList));
+	usedBytes = 0;
+	reservedBytes = 0;
+	chunkCount = 0;
+}
+
+void MemArena::Swap(MemArena* other)
+{
+	eastl::swap(name, other->name);
+	eastl::swap(chunkSize, other->chunkSize);
+	eastl::swap(head, other->head);
+	for(i32 i = 0; i < CLASS_COUNT; i++) {
+		eastl::swap(freeList[i], other->freeList[i]);
+	}
+	eastl::swap(usedBytes, other->usedBytes);
+	eastl::swap(peakBytes, other->peakBytes);
+	eastl::swap(reservedBytes, other->reservedBytes);
+	eastl::swap(chunkCount, other->chunkCount);
+}
+
+void* ArenaAllocator::allocate(size_t n, int flags)
+{
+	if(arena) return arena->Alloc(n);
+	return memAlloc(n);
+}
+
+void* ArenaAllocator::allocate(size_t n, size_t alignment, size_t offset, int flags)
+{
+	ASSERT(alignment <= 16 && offset == 0);
+	return allocate(n, flags);
+}
+
+void ArenaAllocator::deallocate(void* p, size_t n)
+{
+	if(arena) {
+		arena->Free(p, n);
+		return;
+	}
+	memFree(p);
+}
+
+void* ArenaHashAllocator::allocate(size_t n, int flags)
+{
+	if(!arena) return memAlloc(n);
+
+	size_t* block = (size_t*)arena->Alloc(n + HEADER_SIZE);
+	*block = n + HEADER_SIZE;
+	return (u8*)block + HEADER_SIZE;
+}
+
+void* ArenaHashAllocator::allocate(size_t n, size_t alignment, size_t offset, int flags)
+{
+	ASSERT(alignment <= 16 && offset == 0);
+	return allocate(n, flags);
+}
+
+void ArenaHashAllocator::deallocate(void* p, size_t n)
+{
+	if(!arena) {
+		memFree(p);
+		return;
+	}
+
+	// n is the node size even for bucket arrays
+	size_t* block = (size_t*)((u8*)p - HEADER_SIZE);
+	arena->Free(block, *block);
+}
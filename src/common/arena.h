@@ -0,0 +1,97 @@
+#pragma once
+#include <common/base.h>
+
+// Region allocator owned by one instance (game, lane...), everything it holds is released at once with Reset/Release.
+// Blocks are bump allocated from chunks, freed blocks go to a free list per power of 2 size class and are reused by the next
+// allocation of that class, so containers that grow and shrink during a game don't make the region grow forever.
+// Blocks are 16 bytes aligned. Not thread safe, only one thread uses the arena at a time.
+struct MemArena
+{
+	enum {
+		MIN_CLASS_SHIFT = 4, // 16B
+		MAX_CLASS_SHIFT = 16, // 64KB, bigger blocks are never reused before Reset
+		CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1,
+	};
+
+	struct Chunk
+	{
+		Chunk* next;
+		size_t size; // usable bytes, after the header
+		size_t used;
+		size_t _pad; // keeps the data 16 aligned
+
+		inline u8* Data() { return (u8*)(this + 1); }
+	};
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	const char* name = "MemArena";
+	size_t chunkSize = 0;
+	Chunk* head = nullptr; // current chunk, full chunks follow
+	FreeBlock* freeList[CLASS_COUNT] = {};
+
+	// stats
+	size_t usedBytes = 0; // live blocks
+	size_t peakBytes = 0; // since Init
+	size_t reservedBytes = 0; // chunks
+	i32 chunkCount = 0;
+
+	MemArena() = default;
+	MemArena(const MemArena&) = delete;
+	MemArena& operator=(const MemArena&) = delete;
+
+	~MemArena()
+	{
+		Release();
+	}
+
+	void Init(const char* name_, size_t chunkSize_); // no memory until the first Alloc
+	void* Alloc(size_t size);
+	void Free(void* ptr, size_t size); // size has to be the one passed to Alloc, ignored once the chunks are released
+	void Reset(); // drops every block, keeps the memory as a single chunk
+	void Release(); // gives the chunks back to the heap
+	void Swap(MemArena* other);
+
+private:
+	void* AllocFromChunk(size_t size);
+	Chunk* NewChunk(size_t size);
+};
+
+// EASTL allocator on a MemArena, falls back to the heap when no arena is set.
+// Fixed containers take it as their overflow allocator, the arena has to be set while the container is empty.
+struct ArenaAllocator
+{
+	MemArena* arena = nullptr;
+
+	explicit ArenaAllocator(const char* name = nullptr) {}
+	explicit ArenaAllocator(MemArena* arena_): arena(arena_) {}
+
+	void* allocate(size_t n, int flags = 0);
+	void* allocate(size_t n, size_t alignment, size_t offset, int flags = 0);
+	void deallocate(void* p, size_t n);
+
+	inline const char* get_name() const { return arena ? arena->name : "ArenaAllocator"; }
+	inline void set_name(const char* name) {}
+};
+
+inline bool operator==(const ArenaAllocator& a, const ArenaAllocator& b) { return a.arena == b.arena; }
+inline bool operator!=(const ArenaAllocator& a, const ArenaAllocator& b) { return a.arena != b.arena; }
+
+// ArenaAllocator for the fixed hash tables (arena_hash_map).
+// They free their overflow bucket arrays with the node size, so the block size is kept in a header in front of each block.
+struct ArenaHashAllocator: ArenaAllocator
+{
+	enum {
+		HEADER_SIZE = 16 // keeps the block 16 aligned
+	};
+
+	explicit ArenaHashAllocator(const char* name = nullptr) {}
+	explicit ArenaHashAllocator(MemArena* arena_): ArenaAllocator(arena_) {}
+
+	void* allocate(size_t n, int flags = 0);
+	void* allocate(size_t n, size_t alignment, size_t offset, int flags = 0);
+	void deallocate(void* p, size_t n);
+};
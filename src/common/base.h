@@ -48,29 +48,76 @@ typedef double f64;
 
 STATIC_ASSERT(sizeof(wchar) == 2);
 
-inline void* memAlloc(size_t size)
+// Every allocation is tagged with the subsystem it belongs to, the current tag of the thread is set with MEM_TAG (scoped).
+// Live bytes and allocation counts are kept per thread and per tag without locks, MemGetStats sums them.
+// Blocks have a small header (size, tag), they have to be freed with memFree (new/delete go through it as well, see memory.cpp).
+enum class MemTag: u8
 {
-	//ProfileBlock("memAlloc");
-	void* ptr = malloc(size);
-	//ProfileMemAlloc(ptr, size);
-	return ptr;
-}
+	GENERAL = 0,
+	NETWORK,
+	REPLICATION,
+	PHYSICS,
+	CONTENT,
+	LOGGER,
+	INSTANCE,
+	_COUNT
+};
+
+const char* MemTagName(MemTag tag);
 
-inline void* memRealloc(void* inPtr, size_t size)
+void* memAlloc(size_t size);
+void* memRealloc(void* inPtr, size_t size); // the block keeps its tag
+void memFree(void* ptr);
+
+struct MemTagScope
 {
-	//ProfileBlock("memRealloc");
-	//ProfileMemFree(inPtr);
-	void* ptr = realloc(inPtr, size);
-	//ProfileMemAlloc(ptr, size);
-	return ptr;
-}
+	MemTag prev;
+
+	explicit MemTagScope(MemTag tag);
+	~MemTagScope();
+};
+
+#define MEM_TAG(TAG) const MemTagScope _memTagScope(TAG)
+
+MemTag MemCurrentTag(); // this thread
 
-inline void memFree(void* ptr)
+// Allocating inside the scope is reported (log) or asserts, for code that should not allocate once warmed up (game ticks).
+enum class MemNoAllocMode: u8
 {
-	//ProfileBlock("memFree");
-	//ProfileMemFree(ptr)
-	return free(ptr);
-}
+	OFF = 0,
+	LOG,
+	ASSERT
+};
+
+struct MemNoAllocScope
+{
+	MemNoAllocMode prev;
+
+	explicit MemNoAllocScope(MemNoAllocMode mode);
+	~MemNoAllocScope();
+};
+
+struct MemTagStats
+{
+	i64 liveBytes;
+	i64 allocCount;
+	i64 allocBytes; // total
+};
+
+struct MemStats
+{
+	MemTagStats tags[(i32)MemTag::_COUNT];
+	i64 noAllocViolations; // allocations inside a MemNoAllocScope
+};
+
+// Thread: Any
+// counters are read while other threads write them, a snapshot can be a few allocations off
+void MemGetStats(MemStats* out);
+i64 MemNoAllocViolationCount(); // this thread
+
+// Tracy memory profiling, one memory pool per tag (needs TRACY_ENABLE)
+// blocks allocated while disabled are not reported when freed
+void MemProfileEnable(bool enable);
 
 struct Buffer
 {
@@ -87,7 +134,7 @@ struct Buffer
 
 	~Buffer()
 	{
-		free(data);
+		memFree(data);
 	}
 
 	void Clear()
@@ -327,7 +374,7 @@ struct GrowableBuffer
 
 	void Release()
 	{
-		free(data);
+		memFree(data);
 		data = nullptr;
 		size = 0;
 		capacity = 0;
@@ -343,7 +390,7 @@ struct GrowableBuffer
 	u8* Append(const void* buff, i32 buffSize)
 	{
 		if(size + buffSize > capacity) {
-			Reserve(MIN(size+buffSize, capacity*2));
+			Reserve(MAX(size+buffSize, capacity*2));
 		}
 		memmove(data+size, buff, buffSize);
 		u8* r = data+size;
@@ -402,6 +449,8 @@ typedef LockGuardT<tracy::Lockable<Mutex>> LockGuard;
 #define ProfilePlotVarN(N, V) TracyPlot(N, V)
 #define ProfileMemAlloc(PTR, SIZE) TracyAlloc(PTR, SIZE)
 #define ProfileMemFree(PTR) TracyFree(PTR)
+#define ProfileMemAllocN(PTR, SIZE, NAME) TracyAllocN(PTR, SIZE, NAME)
+#define ProfileMemFreeN(PTR, NAME) TracyFreeN(PTR, NAME)
 #define ProfileAttachStringf(STRF, ...) char __buff##__LINE__[64];\
 	snprintf(__buff##__LINE__, sizeof(__buff##__LINE__), STRF, __VA_ARGS__);\
 	ZoneName(__buff##__LINE__, sizeof(__buff##__LINE__))
@@ -416,6 +465,8 @@ typedef LockGuardT<tracy::Lockable<Mutex>> LockGuard;
 #define ProfilePlotVarN(N,V)
 #define ProfileMemAlloc(PTR, SIZE)
 #define ProfileMemFree(PTR)
+#define ProfileMemAllocN(PTR, SIZE, NAME)
+#define ProfileMemFreeN(PTR, NAME)
 #define ProfileAttachStringf(STRF, ...)
 #define ProfileSetThreadName(NAME)
 
@@ -5,6 +5,7 @@
 
 // MQ, MR: Matchmaker Query, Response
 // HQ, HR: Hub server Query, Response
+// HL: Hub server to Login server
 // PQ, PR: Play server Query, Response
 
 enum class AccountUID: u32 {
@@ -15,6 +16,12 @@ enum class PartyUID: u32 {
 	INVALID = 0
 };
 
+// parties are only matched with parties of the same mode
+enum class MatchMode: u8 {
+	INVALID = 0,
+	ARENA_3V3 = 1
+};
+
 namespace In {
 
 constexpr u32 MagicHandshake = 0xaedf45;
@@ -82,8 +89,10 @@ struct HQ_PartyEnqueue
 {
 	enum { NET_ID = 1003 };
 
-	// TODO: some useful stuff here
 	PartyUID partyUID;
+	u8 mode; // MatchMode
+	u8 region;
+	u16 rating; // party average
 };
 
 PUSH_PACKED
@@ -134,6 +143,35 @@ struct HQ_RoomCreateGame
 };
 POP_PACKED
 
+// sent by hub servers to the login server once connected
+struct HL_Register
+{
+	enum { NET_ID = 1007 };
+
+	u32 magic;
+	eastl::array<u8,4> ip; // ip clients should connect to
+	u16 listenPort;
+	u16 maxPlayers;
+};
+
+// sent periodically by hub servers to the login server
+struct HL_LoadReport
+{
+	enum { NET_ID = 1008 };
+
+	u16 playerCount;
+	f32 tickP99Ms;
+};
+
+// member left the party (left the hub, disconnected), the party is taken out of the match queue
+struct HQ_PartyLeave
+{
+	enum { NET_ID = 1009 };
+
+	PartyUID partyUID;
+	AccountUID accountUID;
+};
+
 struct PQ_Handshake
 {
 	enum { NET_ID = 2001 };
@@ -149,6 +187,32 @@ struct PR_GameCreated
 	SortieUID sortieUID;
 };
 
+// sent periodically by play servers so the matchmaker can place new games
+struct PQ_LoadReport
+{
+	enum { NET_ID = 2003 };
+
+	struct Lane
+	{
+		u16 gameCount;
+		u16 playerCount;
+		f32 tickP99Ms;
+		u8 busyPercent; // time spent updating over time elapsed
+	};
+
+	u16 maxGamesPerLane;
+	u8 laneCount;
+	eastl::array<Lane,16> lanes;
+};
+
+// the game could not be built after PR_GameCreated (its map failed to load), the players connecting to it are rejected
+struct PN_GameFailed
+{
+	enum { NET_ID = 2004 };
+
+	SortieUID sortieUID;
+};
+
 struct MR_Handshake
 {
 	enum { NET_ID = 3002 };
@@ -212,6 +276,7 @@ struct MQ_CreateGame
 	};
 
 	SortieUID sortieUID;
+	MapIndex mapIndex;
 	u8 playerCount;
 	u8 spectatorCount;
 	eastl::array<Player,10> players;
@@ -229,4 +294,13 @@ struct MN_MatchCreated
 };
 POP_PACKED
 
+// a member left, the rest of the party is no longer queued (sent to the hubs of the remaining members)
+struct MN_PartyDequeued
+{
+	enum { NET_ID = 3009 };
+
+	PartyUID partyUID;
+	AccountUID leftAccountUID;
+};
+
 }
@@ -0,0 +1,76 @@
+#include "input_coalescer.h"
+#include "protocol.h" // NetHeader
+
+void InputCoalescer::AddInputType(u16 netID)
+{
+	ASSERT(!IsInputType(netID));
+	inputNetIDList.push_back(netID);
+}
+
+bool InputCoalescer::IsInputType(u16 netID) const
+{
+	foreach_const(it, inputNetIDList) {
+		if(*it == netID) return true;
+	}
+	return false;
+}
+
+i32 InputCoalescer::Coalesce(u8* data, i32 size)
+{
+	packetList.clear();
+	pendingList.clear();
+
+	i32 dropCount = 0;
+	i32 offset = 0;
+	while(offset + (i32)sizeof(NetHeader) <= size) {
+		const NetHeader& header = *(const NetHeader*)(data + offset);
+		if(header.size < sizeof(NetHeader) || offset + header.size > size) break;
+
+		const i32 packetIndex = packetList.size();
+		Packet& packet = packetList.push_back();
+		packet.offset = offset;
+		packet.size = header.size;
+		packet.keep = true;
+		offset += header.size;
+
+		if(!IsInputType(header.netID) || header.size < sizeof(NetHeader) + sizeof(u32)) {
+			pendingList.clear(); // barrier
+			continue;
+		}
+
+		const u32 localActorID = *(const u32*)(data + packet.offset + sizeof(NetHeader));
+		const u64 key = ((u64)header.netID << 32) | localActorID;
+
+		bool found = false;
+		foreach(p, pendingList) {
+			if(p->key == key) {
+				packetList[p->packetIndex].keep = false;
+				p->packetIndex = packetIndex;
+				dropCount++;
+				found = true;
+				break;
+			}
+		}
+
+		if(!found) {
+			pendingList.push_back(PendingInput{ key, packetIndex });
+		}
+	}
+
+	packetCount += packetList.size();
+	if(dropCount == 0) return size;
+	coalescedCount += dropCount;
+
+	i32 writeOffset = 0;
+	foreach_const(p, packetList) {
+		if(!p->keep) continue;
+		if(writeOffset != p->offset) {
+			memmove(data + writeOffset, data + p->offset, p->size);
+		}
+		writeOffset += p->size;
+	}
+
+	// unparsed end
+	memmove(data + writeOffset, data + offset, size - offset);
+	return writeOffset + (size - offset);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <common/base.h>
+#include <EASTL/fixed_vector.h>
+
+// Drops client movement inputs superseded later in the same chunk of received data, before packet handlers run.
+// A movement input (position, rotation) is superseded by a later input of the same type for the same actor.
+// Any other packet (jump, tag, skill cast...) is a barrier: inputs before it are kept so it runs on the state the client had.
+struct InputCoalescer
+{
+	enum {
+		MAX_INPUT_TYPES = 8,
+	};
+
+	u64 packetCount = 0;
+	u64 coalescedCount = 0;
+
+	// packets of this type start with the LocalActorID they move
+	void AddInputType(u16 netID);
+
+	// compacts the chunk in place, returns its new size
+	// malformed data is left as is from the first bad packet for the caller to deal with
+	i32 Coalesce(u8* data, i32 size);
+
+private:
+	struct Packet
+	{
+		i32 offset;
+		i32 size;
+		bool keep;
+	};
+
+	struct PendingInput
+	{
+		u64 key; // netID << 32 | LocalActorID
+		i32 packetIndex;
+	};
+
+	eastl::fixed_vector<u16,MAX_INPUT_TYPES,false> inputNetIDList;
+	eastl::fixed_vector<Packet,256,true> packetList;
+	eastl::fixed_vector<PendingInput,32,true> pendingList; // since the last barrier
+
+	bool IsInputType(u16 netID) const;
+};
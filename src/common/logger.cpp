@@ -1,4 +1,5 @@
 #include "logger.h"
+#include "base.h"
 #include "platform.h"
 #include <EASTL/array.h>
 #include <EAStdC/EASprintf.h>
@@ -15,6 +16,7 @@ bool g_LogVerbose = false; // TODO: load from config
 static intptr_t ThreadLogger(void* pData)
 {
 	Logger& logger = *(Logger*)pData;
+	MEM_TAG(MemTag::LOGGER);
 
 	while(logger.running) {
 		logger.WriteOut();
@@ -50,6 +52,7 @@ void Logger::Vlogf(const char* fmt, va_list list)
 	fmtBuff.append_sprintf_va_list(fmt, list);
 	const int len = fmtBuff.length();
 
+	MEM_TAG(MemTag::LOGGER);
 	const EA::Thread::AutoFutex lock(mutexBuffer);
 	buffer.append(fmtBuff.data(), fmtBuff.length());
 }
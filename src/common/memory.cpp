@@ -0,0 +1,253 @@
+#include "base.h"
+#include "thread_slots.h"
+#include <new>
+
+struct MemHeader
+{
+	u64 size;
+	u32 magic;
+	MemTag tag;
+	u8 profiled; // reported to Tracy
+	u8 _pad[2];
+};
+
+ASSERT_SIZE(MemHeader, 16); // keeps the blocks 16 aligned
+
+static const u32 MEM_MAGIC = 0x4D454D42;
+
+// Counters of one thread (ThreadSlots)
+struct MemThreadCounters
+{
+	volatile i64 liveBytes[(i32)MemTag::_COUNT];
+	volatile i64 allocCount[(i32)MemTag::_COUNT];
+	volatile i64 allocBytes[(i32)MemTag::_COUNT];
+	volatile i64 noAllocViolations;
+};
+
+enum {
+	MAX_THREADS = 128,
+	MAX_VIOLATION_LOGS = 32, // per thread
+};
+
+// plain zero initialized statics, memAlloc runs before the dynamic initializers
+static ThreadSlots<MemThreadCounters,MAX_THREADS> g_MemThreadCounters;
+static volatile bool g_MemProfile = false;
+
+static thread_local MemThreadCounters* t_MemCounters = nullptr;
+static thread_local i64 t_MemNoAllocViolations = 0; // the counters block may have been used by other threads before
+static thread_local MemTag t_MemTag = MemTag::GENERAL;
+static thread_local MemNoAllocMode t_MemNoAlloc = MemNoAllocMode::OFF;
+
+static const char* g_MemTagName[(i32)MemTag::_COUNT] = {
+	"General",
+	"Network",
+	"Replication",
+	"Physics",
+	"Content",
+	"Logger",
+	"Instance",
+};
+
+const char* MemTagName(MemTag tag)
+{
+	return g_MemTagName[(i32)tag];
+}
+
+static inline MemThreadCounters& ThreadCounters()
+{
+	return g_MemThreadCounters.Get(&t_MemCounters);
+}
+
+static inline void CounterAdd(MemThreadCounters& c, volatile i64* counter, i64 value)
+{
+	g_MemThreadCounters.Add(c, counter, value);
+}
+
+static void OnNoAllocViolation(size_t size, MemTag tag)
+{
+	const MemNoAllocMode mode = t_MemNoAlloc;
+	t_MemNoAlloc = MemNoAllocMode::OFF; // logging can allocate
+
+	MemThreadCounters& c = ThreadCounters();
+	CounterAdd(c, &c.noAllocViolations, 1);
+	t_MemNoAllocViolations++;
+
+	if(mode == MemNoAllocMode::ASSERT) {
+		LOG("ERROR(Memory): allocation in a no allocation scope (size=%llu tag=%s)", (unsigned long long)size, MemTagName(tag));
+		ASSERT_MSG(0, "allocation in a no allocation scope");
+	}
+	else if(t_MemNoAllocViolations <= MAX_VIOLATION_LOGS) {
+		WARN("Allocation in a no allocation scope (size=%llu tag=%s)%s", (unsigned long long)size, MemTagName(tag),
+			t_MemNoAllocViolations == MAX_VIOLATION_LOGS ? ", the next ones on this thread are only counted" : "");
+	}
+
+	t_MemNoAlloc = mode;
+}
+
+static void* OnAlloc(MemHeader* header, size_t size, MemTag tag)
+{
+	header->size = size;
+	header->magic = MEM_MAGIC;
+	header->tag = tag;
+	header->profiled = 0;
+
+	MemThreadCounters& c = ThreadCounters();
+	CounterAdd(c, &c.liveBytes[(i32)tag], (i64)size);
+	CounterAdd(c, &c.allocCount[(i32)tag], 1);
+	CounterAdd(c, &c.allocBytes[(i32)tag], (i64)size);
+
+	void* ptr = header + 1;
+	if(g_MemProfile) {
+		header->profiled = 1;
+		ProfileMemAllocN(ptr, size, g_MemTagName[(i32)tag]);
+	}
+	return ptr;
+}
+
+static void OnFree(void* ptr, u64 size, MemTag tag, u8 profiled)
+{
+	MemThreadCounters& c = ThreadCounters();
+	CounterAdd(c, &c.liveBytes[(i32)tag], -(i64)size);
+
+	if(profiled) {
+		ProfileMemFreeN(ptr, g_MemTagName[(i32)tag]);
+	}
+}
+
+void* memAlloc(size_t size)
+{
+	const MemTag tag = t_MemTag;
+	if(t_MemNoAlloc != MemNoAllocMode::OFF) OnNoAllocViolation(size, tag);
+
+	MemHeader* header = (MemHeader*)malloc(sizeof(MemHeader) + size);
+	if(!header) return nullptr;
+	return OnAlloc(header, size, tag);
+}
+
+void* memRealloc(void* inPtr, size_t size)
+{
+	if(!inPtr) return memAlloc(size);
+
+	MemHeader* header = (MemHeader*)inPtr - 1;
+	DBG_ASSERT(header->magic == MEM_MAGIC); // not allocated by memAlloc
+	const MemHeader prev = *header;
+	if(t_MemNoAlloc != MemNoAllocMode::OFF) OnNoAllocViolation(size, prev.tag);
+
+	header = (MemHeader*)realloc(header, sizeof(MemHeader) + size);
+	if(!header) return nullptr; // the block is untouched
+
+	OnFree(inPtr, prev.size, prev.tag, prev.profiled);
+	return OnAlloc(header, size, prev.tag);
+}
+
+void memFree(void* ptr)
+{
+	if(!ptr) return;
+
+	MemHeader* header = (MemHeader*)ptr - 1;
+	DBG_ASSERT(header->magic == MEM_MAGIC); // not allocated by memAlloc
+	OnFree(ptr, header->size, header->tag, header->profiled);
+	free(header);
+}
+
+MemTag MemCurrentTag()
+{
+	return t_MemTag;
+}
+
+MemTagScope::MemTagScope(MemTag tag)
+{
+	prev = t_MemTag;
+	t_MemTag = tag;
+}
+
+MemTagScope::~MemTagScope()
+{
+	t_MemTag = prev;
+}
+
+MemNoAllocScope::MemNoAllocScope(MemNoAllocMode mode)
+{
+	prev = t_MemNoAlloc;
+	t_MemNoAlloc = mode;
+}
+
+MemNoAllocScope::~MemNoAllocScope()
+{
+	t_MemNoAlloc = prev;
+}
+
+void MemGetStats(MemStats* out)
+{
+	memset(out, 0, sizeof(*out));
+
+	g_MemThreadCounters.ForEachUsed([out](const MemThreadCounters& c) {
+		for(i32 i = 0; i < (i32)MemTag::_COUNT; i++) {
+			out->tags[i].liveBytes += c.liveBytes[i];
+			out->tags[i].allocCount += c.allocCount[i];
+			out->tags[i].allocBytes += c.allocBytes[i];
+		}
+		out->noAllocViolations += c.noAllocViolations;
+	});
+}
+
+i64 MemNoAllocViolationCount()
+{
+	return t_MemNoAllocViolations;
+}
+
+void MemProfileEnable(bool enable)
+{
+	g_MemProfile = enable;
+}
+
+// every allocation goes through memAlloc, so the counters see EASTL, PhysX and third party allocations as well
+void* operator new(size_t size)
+{
+	return memAlloc(size);
+}
+
+void* operator new[](size_t size)
+{
+	return memAlloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return memAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return memAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	memFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	memFree(ptr);
+}
+
+void operator delete(void* ptr, size_t size) noexcept
+{
+	memFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t size) noexcept
+{
+	memFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	memFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	memFree(ptr);
+}
@@ -0,0 +1,304 @@
+#include "metrics.h"
+#include <EASTL/fixed_vector.h>
+
+#ifndef MSG_NOSIGNAL
+	#define MSG_NOSIGNAL 0 // no SIGPIPE on windows
+#endif
+
+enum class MetricType: u8
+{
+	COUNTER = 0,
+	GAUGE,
+	HISTOGRAM
+};
+
+struct MetricEntry
+{
+	const char* name;
+	const char* help;
+	MetricType type;
+	FixedStr64 labels;
+	void* metric;
+};
+
+enum {
+	MAX_METRICS = 512
+};
+
+static Mutex g_MetricsMutex;
+static eastl::fixed_vector<MetricEntry,MAX_METRICS,false> g_MetricList;
+
+static void* MetricsFind(const char* name, MetricType type, const char* labels)
+{
+	foreach_const(e, g_MetricList) {
+		if(strcmp(e->name, name) == 0 && e->labels == labels) {
+			ASSERT_MSG(e->type == type, "metric registered twice with different types");
+			return e->metric;
+		}
+	}
+	return nullptr;
+}
+
+static void MetricsPush(const char* name, const char* help, MetricType type, const char* labels, void* metric)
+{
+	ASSERT_MSG(!g_MetricList.full(), "too many metrics");
+
+	MetricEntry& e = g_MetricList.push_back();
+	e.name = name;
+	e.help = help;
+	e.type = type;
+	e.labels = labels;
+	e.metric = metric;
+}
+
+MetricCounter* MetricsAddCounter(const char* name, const char* help, const char* labels)
+{
+	LOCK_MUTEX(g_MetricsMutex);
+	MetricCounter* counter = (MetricCounter*)MetricsFind(name, MetricType::COUNTER, labels);
+	if(counter) return counter;
+
+	counter = new MetricCounter();
+	MetricsPush(name, help, MetricType::COUNTER, labels, counter);
+	return counter;
+}
+
+MetricGauge* MetricsAddGauge(const char* name, const char* help, const char* labels)
+{
+	LOCK_MUTEX(g_MetricsMutex);
+	MetricGauge* gauge = (MetricGauge*)MetricsFind(name, MetricType::GAUGE, labels);
+	if(gauge) return gauge;
+
+	gauge = new MetricGauge();
+	MetricsPush(name, help, MetricType::GAUGE, labels, gauge);
+	return gauge;
+}
+
+MetricHistogram* MetricsAddHistogram(const char* name, const char* help, const f64* bounds, i32 boundCount, const char* labels)
+{
+	ASSERT(boundCount > 0 && boundCount <= MetricHistogram::MAX_BOUNDS);
+
+	LOCK_MUTEX(g_MetricsMutex);
+	MetricHistogram* histogram = (MetricHistogram*)MetricsFind(name, MetricType::HISTOGRAM, labels);
+	if(histogram) return histogram;
+
+	histogram = new MetricHistogram();
+	for(i32 i = 0; i < boundCount; i++) {
+		DBG_ASSERT(i == 0 || bounds[i] > bounds[i-1]);
+		histogram->bounds[i] = bounds[i];
+	}
+	histogram->boundCount = boundCount;
+	MetricsPush(name, help, MetricType::HISTOGRAM, labels, histogram);
+	return histogram;
+}
+
+static const char* g_MetricTypeName[] = {
+	"counter",
+	"gauge",
+	"histogram"
+};
+
+// name{labels,extra}
+static const char* MetricLabels(const FixedStr64& labels, const char* extra)
+{
+	if(labels.empty() && !extra) return "";
+	if(!extra) return FMT("{%s}", labels.data());
+	if(labels.empty()) return FMT("{%s}", extra);
+	return FMT("{%s,%s}", labels.data(), extra);
+}
+
+static void MetricRender(eastl::string* out, const MetricEntry& e)
+{
+	switch(e.type) {
+		case MetricType::COUNTER:
+		case MetricType::GAUGE: {
+			const volatile i64* value = e.type == MetricType::COUNTER ? &((MetricCounter*)e.metric)->value : &((MetricGauge*)e.metric)->value;
+			out->append_sprintf("%s%s %lld\n", e.name, MetricLabels(e.labels, nullptr), (long long)EA::Thread::AtomicGetValue(value));
+		} break;
+
+		case MetricType::HISTOGRAM: {
+			const MetricHistogram& h = *(MetricHistogram*)e.metric;
+			i64 cumulative = 0;
+			for(i32 b = 0; b <= h.boundCount; b++) {
+				cumulative += EA::Thread::AtomicGetValue(&h.buckets[b]);
+				char le[64]; // not FMT, MetricLabels uses it
+				if(b < h.boundCount) snprintf(le, sizeof(le), "le=\"%.15g\"", h.bounds[b]);
+				else snprintf(le, sizeof(le), "le=\"+Inf\"");
+				out->append_sprintf("%s_bucket%s %lld\n", e.name, MetricLabels(e.labels, le), (long long)cumulative);
+			}
+			const f64 sum = (f64)EA::Thread::AtomicGetValue(&h.sum) / MetricHistogram::SUM_SCALE;
+			out->append_sprintf("%s_sum%s %f\n", e.name, MetricLabels(e.labels, nullptr), sum);
+			out->append_sprintf("%s_count%s %lld\n", e.name, MetricLabels(e.labels, nullptr), (long long)cumulative);
+		} break;
+	}
+}
+
+void MetricsRender(eastl::string* out)
+{
+	{
+		LOCK_MUTEX(g_MetricsMutex);
+
+		// one HELP/TYPE block per name, with every label set of that name
+		const i32 count = (i32)g_MetricList.size();
+		for(i32 i = 0; i < count; i++) {
+			const MetricEntry& first = g_MetricList[i];
+
+			bool done = false;
+			for(i32 j = 0; j < i && !done; j++) {
+				done = strcmp(g_MetricList[j].name, first.name) == 0;
+			}
+			if(done) continue;
+
+			out->append_sprintf("# HELP %s %s\n", first.name, first.help);
+			out->append_sprintf("# TYPE %s %s\n", first.name, g_MetricTypeName[(i32)first.type]);
+			for(i32 j = i; j < count; j++) {
+				if(strcmp(g_MetricList[j].name, first.name) == 0) {
+					MetricRender(out, g_MetricList[j]);
+				}
+			}
+		}
+	}
+
+	MemStats mem;
+	MemGetStats(&mem);
+	out->append_sprintf("# HELP mem_live_bytes Heap memory allocated and not freed yet, per subsystem\n");
+	out->append_sprintf("# TYPE mem_live_bytes gauge\n");
+	for(i32 i = 0; i < (i32)MemTag::_COUNT; i++) {
+		out->append_sprintf("mem_live_bytes{tag=\"%s\"} %lld\n", MemTagName((MemTag)i), (long long)mem.tags[i].liveBytes);
+	}
+	out->append_sprintf("# HELP mem_alloc_total Heap allocations, per subsystem\n");
+	out->append_sprintf("# TYPE mem_alloc_total counter\n");
+	for(i32 i = 0; i < (i32)MemTag::_COUNT; i++) {
+		out->append_sprintf("mem_alloc_total{tag=\"%s\"} %lld\n", MemTagName((MemTag)i), (long long)mem.tags[i].allocCount);
+	}
+}
+
+intptr_t ThreadMetrics(void* pData)
+{
+	ProfileSetThreadName("Metrics");
+	EA::Thread::SetThreadPriority(EA::Thread::kThreadPriorityMin); // never in the way of lanes
+
+	MetricsServer& server = *(MetricsServer*)pData;
+	server.Serve();
+	return 0;
+}
+
+void MetricsServer::Init(i32 port_)
+{
+	port = port_;
+	if(port == 0) return;
+
+	listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if(listenSocket == INVALID_SOCKET) {
+		WARN("Metrics disabled, socket failed (%d)", NetworkGetLastError());
+		return;
+	}
+
+	const i32 reuse = 1;
+	setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	// local only, scraped by an agent on the same machine
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons((u16)port);
+
+	if(bind(listenSocket, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(listenSocket, 8) == SOCKET_ERROR) {
+		WARN("Metrics disabled, failed to listen on port %d (%d)", port, NetworkGetLastError());
+		closesocket(listenSocket);
+		listenSocket = INVALID_SOCKET;
+		return;
+	}
+
+	running = true;
+	thread.Begin(ThreadMetrics, this);
+	LOG("Metrics on http://127.0.0.1:%d/metrics", port);
+}
+
+void MetricsServer::Cleanup()
+{
+	if(!running) return;
+
+	running = false;
+#ifdef CONF_WINDOWS
+	shutdown(listenSocket, SD_BOTH);
+#else
+	shutdown(listenSocket, SHUT_RDWR); // unblocks accept, close alone does not on linux
+#endif
+	closesocket(listenSocket);
+	listenSocket = INVALID_SOCKET;
+	thread.WaitForEnd();
+}
+
+static bool SendAll(SOCKET sock, const char* data, i32 size)
+{
+	while(size > 0) {
+		const i32 len = (i32)send(sock, data, size, MSG_NOSIGNAL);
+		if(len <= 0) return false;
+		data += len;
+		size -= len;
+	}
+	return true;
+}
+
+const i32 CLIENT_TIMEOUT_MS = 2000; // a scraper that stops sending or reading doesn't hold the metrics thread longer
+
+static void SetTimeouts(SOCKET sock, i32 timeoutMs)
+{
+#ifdef CONF_WINDOWS
+	const DWORD timeout = timeoutMs;
+#else
+	timeval timeout;
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_usec = (timeoutMs % 1000) * 1000;
+#endif
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+	setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+
+static bool StartsWith(const char* str, const char* prefix)
+{
+	return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+void MetricsServer::Serve()
+{
+	MEM_TAG(MemTag::NETWORK);
+
+	eastl::string page;
+	page.reserve(64 * 1024);
+
+	while(running) {
+		SOCKET sock = accept(listenSocket, nullptr, nullptr);
+		if(sock == INVALID_SOCKET) {
+			if(running) {
+				WARN("Metrics stopped, accept failed (%d)", NetworkGetLastError());
+			}
+			break;
+		}
+
+		SetTimeouts(sock, CLIENT_TIMEOUT_MS);
+
+		// the request line is all we look at, it comes in the first segment
+		char request[1024];
+		const i32 len = (i32)recv(sock, request, sizeof(request) - 1, 0);
+		if(len > 0) {
+			request[len] = 0;
+			const bool found = StartsWith(request, "GET /metrics ") || StartsWith(request, "GET /metrics?") || StartsWith(request, "GET / ");
+
+			page.clear();
+			if(found) {
+				MetricsRender(&page);
+			}
+
+			const char* header = FMT("HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n",
+				found ? "200 OK" : "404 Not Found", (i32)page.size());
+
+			if(SendAll(sock, header, (i32)strlen(header))) {
+				SendAll(sock, page.data(), (i32)page.size());
+			}
+		}
+
+		closesocket(sock);
+	}
+}
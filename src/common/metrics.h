@@ -0,0 +1,80 @@
+#pragma once
+#include <common/base.h>
+#include <common/network.h>
+#include <EASTL/string.h>
+#include <eathread/eathread_atomic.h>
+#include <eathread/eathread_thread.h>
+
+// Process wide counters, gauges and histograms, served as a Prometheus text page by MetricsServer.
+// Metrics are registered at init and live as long as the process. Updating one is a single atomic add or store,
+// never a lock, so lanes and the network thread update them as they go.
+// name and help have to be static strings, labels are copied (lane="0",queue="rogue").
+
+struct MetricCounter
+{
+	volatile i64 value = 0;
+
+	inline void Add(i64 v) { EA::Thread::AtomicFetchAdd(&value, v); }
+	inline void Inc() { Add(1); }
+};
+
+struct MetricGauge
+{
+	volatile i64 value = 0;
+
+	inline void Set(i64 v) { EA::Thread::AtomicSetValue(&value, v); }
+	inline void Add(i64 v) { EA::Thread::AtomicFetchAdd(&value, v); }
+};
+
+// Fixed buckets, a value goes to the first bucket with value <= bound.
+struct MetricHistogram
+{
+	enum {
+		MAX_BOUNDS = 16,
+		SUM_SCALE = 1000000, // the sum is an integer, in millionths
+	};
+
+	f64 bounds[MAX_BOUNDS]; // ascending, the +Inf bucket is implicit
+	i32 boundCount = 0;
+	volatile i64 buckets[MAX_BOUNDS + 1] = {}; // not cumulative, summed on render
+	volatile i64 sum = 0;
+
+	inline void Observe(f64 v)
+	{
+		i32 b = 0;
+		while(b < boundCount && v > bounds[b]) b++;
+		EA::Thread::AtomicFetchAdd(&buckets[b], (i64)1);
+		EA::Thread::AtomicFetchAdd(&sum, (i64)(v * SUM_SCALE));
+	}
+};
+
+// lane tick durations in ms, the tick budget is 1000/UPDATE_TICK_RATE
+const f64 METRICS_TICK_MS_BOUNDS[] = { 0.5, 1, 2, 4, 8, 12, 16, 20, 33, 50, 100 };
+
+// Thread: Any (locked)
+// the same name and labels give back the same metric
+MetricCounter* MetricsAddCounter(const char* name, const char* help, const char* labels = "");
+MetricGauge* MetricsAddGauge(const char* name, const char* help, const char* labels = "");
+MetricHistogram* MetricsAddHistogram(const char* name, const char* help, const f64* bounds, i32 boundCount, const char* labels = "");
+
+// Thread: Any
+// Prometheus text format, memory per tag (MemGetStats) is appended to the registered metrics
+void MetricsRender(eastl::string* out);
+
+// Plain HTTP on a local port, one scrape at a time on its own thread.
+// GET /metrics (or /) gets the MetricsRender page, anything else a 404.
+struct MetricsServer
+{
+	SOCKET listenSocket = INVALID_SOCKET;
+	i32 port = 0;
+	EA::Thread::Thread thread;
+	volatile bool running = false;
+
+	// port 0 disables it
+	// failing to listen is not fatal, the server runs without metrics
+	void Init(i32 port_);
+	void Cleanup();
+
+	// Thread: Metrics
+	void Serve();
+};
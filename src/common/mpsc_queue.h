@@ -0,0 +1,316 @@
+#pragma once
+#include <common/base.h>
+#include <eathread/eathread_atomic.h>
+#include <eathread/eathread_sync.h>
+#include <eathread/eathread_thread.h>
+#include <new>
+
+// Bounded lock-free multiple producers, single consumer queue.
+// Array of cells with a sequence number each (Dmitry Vyukov's bounded queue), producers claim a cell with a CAS,
+// the consumer never writes anything shared other than the cell sequence.
+// Capacity is set at runtime and rounded up to a power of 2.
+template<typename T>
+struct MPSCQueue
+{
+	struct Cell
+	{
+		EA::Thread::AtomicUint32 sequence;
+		T data;
+	};
+
+	Cell* cells = nullptr;
+	u32 mask = 0;
+
+	// keep producers and consumer on different cache lines
+	u8 _pad0[64];
+	EA::Thread::AtomicUint32 enqueuePos;
+	u8 _pad1[64];
+	u32 dequeuePos = 0; // consumer only
+
+	MPSCQueue() = default;
+	MPSCQueue(const MPSCQueue&) = delete;
+	MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+	~MPSCQueue()
+	{
+		Release();
+	}
+
+	void Init(u32 capacity)
+	{
+		ASSERT(cells == nullptr);
+		ASSERT(capacity > 0);
+
+		u32 size = 1;
+		while(size < capacity) size <<= 1;
+
+		cells = (Cell*)memAlloc(sizeof(Cell) * size);
+		for(u32 i = 0; i < size; i++) {
+			new(&cells[i]) Cell();
+			cells[i].sequence.SetValue(i);
+		}
+
+		mask = size - 1;
+		enqueuePos.SetValue(0);
+		dequeuePos = 0;
+	}
+
+	void Release()
+	{
+		if(!cells) return;
+
+		for(u32 i = 0; i <= mask; i++) {
+			cells[i].~Cell();
+		}
+		memFree(cells);
+		cells = nullptr;
+		mask = 0;
+	}
+
+	inline u32 Capacity() const { return mask + 1; }
+
+	// Thread: Consumer
+	// items pushed and not popped yet, including the ones a producer is still writing
+	inline u32 Size() const { return enqueuePos.GetValue() - dequeuePos; }
+
+	// Thread: Any
+	// returns false when full
+	bool TryPush(const T& item)
+	{
+		Cell* cell;
+		u32 pos = enqueuePos.GetValue();
+
+		while(true) {
+			cell = &cells[pos & mask];
+			const u32 seq = cell->sequence.GetValue();
+			const i32 diff = (i32)(seq - pos);
+
+			if(diff == 0) {
+				if(enqueuePos.SetValueConditional(pos + 1, pos)) break; // cell is ours
+			}
+			else if(diff < 0) {
+				return false; // the consumer has not freed this cell yet
+			}
+
+			pos = enqueuePos.GetValue();
+		}
+
+		cell->data = item;
+		EAWriteBarrier();
+		cell->sequence.SetValue(pos + 1); // publish
+		return true;
+	}
+
+	// Thread: Any
+	// waits for the consumer to make room when full
+	void Push(const T& item)
+	{
+		if(TryPush(item)) return;
+
+		ProfileBlock("MPSCQueue::Push wait");
+		do {
+			EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+		} while(!TryPush(item));
+	}
+
+	// Thread: Consumer
+	bool TryPop(T* out)
+	{
+		Cell& cell = cells[dequeuePos & mask];
+		const u32 seq = cell.sequence.GetValue();
+		if((i32)(seq - (dequeuePos + 1)) < 0) return false; // empty (or not published yet)
+
+		EAReadBarrier();
+		*out = cell.data;
+		EAReadWriteBarrier();
+		cell.sequence.SetValue(dequeuePos + mask + 1); // free for the producer one lap later
+		dequeuePos++;
+		return true;
+	}
+
+	// Thread: Consumer
+	// pops up to maxCount items into out, returns how many were popped
+	i32 PopBatch(T* out, i32 maxCount)
+	{
+		i32 count = 0;
+		while(count < maxCount && TryPop(&out[count])) {
+			count++;
+		}
+		return count;
+	}
+
+	// Thread: Consumer
+	// calls cb(T&) on each item in place, without copying it out, returns how many were popped
+	template<typename Callback>
+	i32 Drain(Callback cb)
+	{
+		i32 count = 0;
+		while(true) {
+			Cell& cell = cells[dequeuePos & mask];
+			const u32 seq = cell.sequence.GetValue();
+			if((i32)(seq - (dequeuePos + 1)) < 0) break;
+
+			EAReadBarrier();
+			cb(cell.data);
+			EAReadWriteBarrier();
+			cell.sequence.SetValue(dequeuePos + mask + 1);
+			dequeuePos++;
+			count++;
+		}
+		return count;
+	}
+};
+
+// Unbounded lock-free multiple producers, single consumer queue.
+// Linked list of nodes (Dmitry Vyukov's intrusive MPSC queue), producers swap the head then link the previous one,
+// the consumer owns the tail. One allocation per item, pushing never waits.
+// For producers that must not wait on the consumer, a lane pushing to the coordinator while the coordinator may be
+// waiting for room in one of that lane's queues for example.
+template<typename T>
+struct MPSCQueueUnbounded
+{
+	struct Node
+	{
+		EA::Thread::AtomicPointer next;
+		T data;
+	};
+
+	EA::Thread::AtomicPointer head; // last pushed node
+	EA::Thread::AtomicUint32 pushCount;
+
+	// keep producers and consumer on different cache lines
+	u8 _pad0[64];
+	Node* tail = nullptr; // consumer only, last popped node (its data was already popped)
+	u32 popCount = 0;
+
+	MPSCQueueUnbounded() = default;
+	MPSCQueueUnbounded(const MPSCQueueUnbounded&) = delete;
+	MPSCQueueUnbounded& operator=(const MPSCQueueUnbounded&) = delete;
+
+	~MPSCQueueUnbounded()
+	{
+		Release();
+	}
+
+	void Init()
+	{
+		ASSERT(tail == nullptr);
+
+		tail = NewNode();
+		head.SetValue(tail);
+		pushCount.SetValue(0);
+		popCount = 0;
+	}
+
+	// items not popped are dropped
+	void Release()
+	{
+		if(!tail) return;
+
+		while(tail) {
+			Node* next = (Node*)tail->next.GetValue();
+			FreeNode(tail);
+			tail = next;
+		}
+		head.SetValue(nullptr);
+	}
+
+	// Thread: Consumer
+	// items pushed and not popped yet, including the ones a producer is still linking
+	inline u32 Size() const { return pushCount.GetValue() - popCount; }
+
+	// Thread: Any
+	void Push(const T& item)
+	{
+		Node* node = NewNode();
+		node->data = item;
+		pushCount.Increment();
+
+		EAWriteBarrier();
+		Node* prev = (Node*)head.SetValue(node);
+		prev->next.SetValue(node); // publish, the consumer stops at prev until then
+	}
+
+	// Thread: Consumer
+	bool TryPop(T* out)
+	{
+		Node* next = (Node*)tail->next.GetValue();
+		if(!next) return false; // empty (or not linked yet)
+
+		EAReadBarrier();
+		*out = next->data;
+		FreeNode(tail);
+		tail = next;
+		popCount++;
+		return true;
+	}
+
+	// Thread: Consumer
+	// pops up to maxCount items into out, returns how many were popped
+	i32 PopBatch(T* out, i32 maxCount)
+	{
+		i32 count = 0;
+		while(count < maxCount && TryPop(&out[count])) {
+			count++;
+		}
+		return count;
+	}
+
+	// Thread: Consumer
+	// calls cb(T&) on each item in place, without copying it out, returns how many were popped
+	template<typename Callback>
+	i32 Drain(Callback cb)
+	{
+		i32 count = 0;
+		while(true) {
+			Node* next = (Node*)tail->next.GetValue();
+			if(!next) break;
+
+			EAReadBarrier();
+			cb(next->data);
+			FreeNode(tail);
+			tail = next;
+			popCount++;
+			count++;
+		}
+		return count;
+	}
+
+private:
+	static Node* NewNode()
+	{
+		Node* node = new(memAlloc(sizeof(Node))) Node();
+		node->next.SetValue(nullptr);
+		return node;
+	}
+
+	static void FreeNode(Node* node)
+	{
+		node->~Node();
+		memFree(node);
+	}
+};
+
+// Variable size data (packet streams) going through an MPSCQueue.
+// Allocated by the producer, freed by the consumer.
+struct QueueBlob
+{
+	u8* data;
+	i32 size;
+
+	static QueueBlob Copy(const void* src, i32 size)
+	{
+		QueueBlob blob;
+		blob.data = (u8*)memAlloc(size);
+		blob.size = size;
+		memmove(blob.data, src, size);
+		return blob;
+	}
+
+	void Free()
+	{
+		memFree(data);
+		data = nullptr;
+		size = 0;
+	}
+};
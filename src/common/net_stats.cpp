@@ -0,0 +1,195 @@
+#include "net_stats.h"
+#include "protocol.h"
+#include "utils.h"
+#include "thread_slots.h"
+#include <EASTL/fixed_vector.h>
+#include <EASTL/sort.h>
+
+enum {
+	MAX_NET_IDS = NetStatsReporter::MAX_NET_IDS,
+	MAX_THREADS = 64,
+};
+
+// Counters of one thread (ThreadSlots)
+struct NetThreadCounters
+{
+	volatile i64 bytes[(i32)NetDir::_COUNT][MAX_NET_IDS];
+	volatile i64 packets[(i32)NetDir::_COUNT][MAX_NET_IDS];
+};
+
+static ThreadSlots<NetThreadCounters,MAX_THREADS> g_NetThreadCounters;
+static thread_local NetThreadCounters* t_NetCounters = nullptr;
+
+static u8 g_NetIdIndex[0x10000]; // netID -> counter index, 0 is unknown
+static const char* g_NetIdName[MAX_NET_IDS];
+static i32 g_NetIdCount = 0;
+static FixedStr64 g_PlotName[(i32)NetDir::_COUNT][MAX_NET_IDS]; // Tracy keeps the pointer
+
+static const char* g_NetRoleName[(i32)NetRole::_COUNT] = {
+	"login",
+	"hub",
+	"play",
+	"matchmaker",
+};
+
+static const char* g_NetDirName[(i32)NetDir::_COUNT] = {
+	"recv",
+	"send",
+};
+
+void NetStatsCount(NetDir dir, u16 netID, i32 size)
+{
+	NetThreadCounters& c = g_NetThreadCounters.Get(&t_NetCounters);
+	const i32 i = g_NetIdIndex[netID];
+	g_NetThreadCounters.Add(c, &c.bytes[(i32)dir][i], size);
+	g_NetThreadCounters.Add(c, &c.packets[(i32)dir][i], 1);
+}
+
+static void NetStatsSum(NetStatsReporter::Totals* out)
+{
+	memset(out, 0, sizeof(*out));
+
+	g_NetThreadCounters.ForEachUsed([out](const NetThreadCounters& c) {
+		for(i32 d = 0; d < (i32)NetDir::_COUNT; d++) {
+			for(i32 i = 0; i < g_NetIdCount; i++) {
+				out->bytes[d][i] += c.bytes[d][i];
+				out->packets[d][i] += c.packets[d][i];
+			}
+		}
+	});
+}
+
+intptr_t ThreadNetStats(void* pData)
+{
+	ProfileSetThreadName("NetStats");
+	EA::Thread::SetThreadPriority(EA::Thread::kThreadPriorityMin);
+
+	NetStatsReporter& reporter = *(NetStatsReporter*)pData;
+	reporter.Run();
+	return 0;
+}
+
+void NetStatsReporter::Init(NetRole role_, i32 intervalSec_, i32 topCount_)
+{
+	role = role_;
+	intervalSec = intervalSec_;
+	topCount = topCount_;
+
+	i32 count;
+	const NetIdName* list = NetIdNameList(&count);
+	ASSERT(count < MAX_NET_IDS);
+
+	g_NetIdName[0] = "unknown";
+	for(i32 i = 0; i < count; i++) {
+		g_NetIdIndex[list[i].netID] = (u8)(i + 1);
+		g_NetIdName[i + 1] = list[i].name;
+	}
+	g_NetIdCount = count + 1;
+
+	for(i32 d = 0; d < (i32)NetDir::_COUNT; d++) {
+		for(i32 i = 0; i < g_NetIdCount; i++) {
+			g_PlotName[d][i].sprintf("Net %s %s (B/s)", g_NetDirName[d], g_NetIdName[i]);
+		}
+	}
+
+	NetStatsSum(&plotTotals);
+	windowTotals = plotTotals;
+	plotTime = TimeNow();
+	windowTime = plotTime;
+
+	running = true;
+	thread.Begin(ThreadNetStats, this);
+}
+
+void NetStatsReporter::Cleanup()
+{
+	if(!running) return;
+
+	running = false;
+	thread.WaitForEnd();
+
+	if(intervalSec > 0) {
+		Print();
+	}
+}
+
+void NetStatsReporter::Run()
+{
+	while(running) {
+		EA::Thread::ThreadSleep(100);
+
+		const Time now = TimeNow();
+		if(TimeDiffSec(TimeDiff(plotTime, now)) >= 1.0) {
+			Plot();
+		}
+		if(intervalSec > 0 && TimeDiffSec(TimeDiff(windowTime, now)) >= intervalSec) {
+			Print();
+		}
+	}
+}
+
+void NetStatsReporter::Plot()
+{
+	Totals totals;
+	NetStatsSum(&totals);
+
+	const Time now = TimeNow();
+	const f64 sec = TimeDiffSec(TimeDiff(plotTime, now));
+	(void)sec; // unused when the profiler is compiled out
+
+	for(i32 d = 0; d < (i32)NetDir::_COUNT; d++) {
+		i64 dirBytes = 0;
+		for(i32 i = 0; i < g_NetIdCount; i++) {
+			if(totals.bytes[d][i] == 0) continue; // never seen, no plot
+
+			const i64 bytes = totals.bytes[d][i] - plotTotals.bytes[d][i];
+			dirBytes += bytes;
+			ProfilePlotVarN(g_PlotName[d][i].data(), (i64)(bytes / sec));
+		}
+		ProfilePlotVarN(d == (i32)NetDir::RECV ? "Net recv total (B/s)" : "Net send total (B/s)", (i64)(dirBytes / sec));
+	}
+
+	plotTotals = totals;
+	plotTime = now;
+}
+
+void NetStatsReporter::Print()
+{
+	Totals totals;
+	NetStatsSum(&totals);
+
+	const Time now = TimeNow();
+	const f64 sec = MAX(TimeDiffSec(TimeDiff(windowTime, now)), 0.001);
+
+	LOG("Net stats (%s, last %.0fs) = {", g_NetRoleName[(i32)role], sec);
+	for(i32 d = 0; d < (i32)NetDir::_COUNT; d++) {
+		eastl::fixed_vector<eastl::pair<i64,i32>,MAX_NET_IDS,false> byBytes;
+		i64 dirBytes = 0;
+		i64 dirPackets = 0;
+		for(i32 i = 0; i < g_NetIdCount; i++) {
+			const i64 bytes = totals.bytes[d][i] - windowTotals.bytes[d][i];
+			dirBytes += bytes;
+			dirPackets += totals.packets[d][i] - windowTotals.packets[d][i];
+			if(bytes > 0) {
+				byBytes.push_back(eastl::pair<i64,i32>(bytes, i));
+			}
+		}
+
+		eastl::sort(byBytes.begin(), byBytes.end(), [](const eastl::pair<i64,i32>& a, const eastl::pair<i64,i32>& b) {
+			return a.first > b.first;
+		});
+
+		LOG("	%s %.2fKB/s %.0f packets/s", g_NetDirName[d], dirBytes / sec / 1024.0, dirPackets / sec);
+		for(i32 r = 0; r < MIN((i32)byBytes.size(), topCount); r++) {
+			const i32 i = byBytes[r].second;
+			const i64 bytes = byBytes[r].first;
+			const i64 packets = totals.packets[d][i] - windowTotals.packets[d][i];
+			LOG("		%-48s %9.2fKB/s %5.1f%% %8.1f packets/s %6lld B/packet", g_NetIdName[i],
+				bytes / sec / 1024.0, bytes * 100.0 / dirBytes, packets / sec, packets > 0 ? (long long)(bytes / packets) : 0LL);
+		}
+	}
+	LOG("}");
+
+	windowTotals = totals;
+	windowTime = now;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <common/base.h>
+#include <eathread/eathread_thread.h>
+
+// Bytes and packets per netID (NetHeader) and direction, counted by the network layer on the thread sending or receiving.
+// Every thread has its own counters (no lock, no atomic), NetStatsReporter sums them every second into rates,
+// plotted in Tracy, and logs the top netIDs by bytes/sec periodically.
+
+enum class NetRole: u8
+{
+	LOGIN = 0,
+	HUB,
+	PLAY,
+	MATCHMAKER,
+	_COUNT
+};
+
+enum class NetDir: u8
+{
+	RECV = 0,
+	SEND,
+	_COUNT
+};
+
+// Thread: Any
+// size includes the NetHeader, netIDs missing from NetIdNameList are counted together as "unknown"
+void NetStatsCount(NetDir dir, u16 netID, i32 size);
+
+struct NetStatsReporter
+{
+	enum {
+		MAX_NET_IDS = 256, // NetIdNameList + unknown
+	};
+
+	struct Totals
+	{
+		i64 bytes[(i32)NetDir::_COUNT][MAX_NET_IDS];
+		i64 packets[(i32)NetDir::_COUNT][MAX_NET_IDS];
+	};
+
+	NetRole role;
+	i32 intervalSec = 0;
+	i32 topCount = 0;
+
+	Totals plotTotals; // at the last plot
+	Totals windowTotals; // at the start of the log window
+	Time plotTime = Time::ZERO;
+	Time windowTime = Time::ZERO;
+
+	EA::Thread::Thread thread;
+	volatile bool running = false;
+
+	// Thread: Main, before the network starts
+	// intervalSec: top netIDs are logged at that interval, 0 only plots them
+	void Init(NetRole role_, i32 intervalSec_, i32 topCount_);
+	void Cleanup(); // logs the last window
+
+	// Thread: NetStats
+	void Run();
+	void Plot();
+	void Print();
+};
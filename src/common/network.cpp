@@ -1,5 +1,7 @@
 #include "network.h"
 #include "protocol.h"
+#include "metrics.h"
+#include "net_stats.h"
 
 const char* IpToString(const u8* ip)
 {
@@ -28,6 +30,7 @@ intptr_t ThreadNetwork(void* pData)
     ThreadSetCoreAffinity((i32)CoreAffinity::NETWORK);
 
 	Server& server = *(Server*)pData;
+	MEM_TAG(MemTag::NETWORK);
 
 	while(server.running) {
 		server.Update();
@@ -36,21 +39,33 @@ intptr_t ThreadNetwork(void* pData)
 	return 0;
 }
 
+// up to the default coalescing (64KB) and disconnection (4MB) thresholds
+static const f64 SEND_QUEUED_BYTES_BOUNDS[] = { 0, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304 };
+
 bool Server::Init()
 {
+	MEM_TAG(MemTag::NETWORK);
 	if(!NetworkInit()) return false;
 
 	clientIsConnected.fill(0);
 	clientDoDisconnect.fill(false);
 
+	metrics.connectedClients = MetricsAddGauge("net_connected_clients", "Clients connected");
+	metrics.sendQueuedBytes = MetricsAddGauge("net_send_queued_bytes", "Bytes waiting for the socket to finish sending, all clients");
+	metrics.clientSendQueuedBytes = MetricsAddHistogram("net_client_send_queued_bytes", "Bytes waiting for the socket to finish sending, per client and poll", SEND_QUEUED_BYTES_BOUNDS, ARRAY_COUNT(SEND_QUEUED_BYTES_BOUNDS));
+	metrics.recvBytes = MetricsAddCounter("net_recv_bytes_total", "Bytes received from clients");
+	metrics.recvPackets = MetricsAddCounter("net_recv_packets_total", "Packets received from clients");
+	metrics.sendBytes = MetricsAddCounter("net_send_bytes_total", "Bytes sent to clients");
+	metrics.sendPackets = MetricsAddCounter("net_send_packets_total", "Packets sent to clients, coalesced ones excluded");
+
 	for(int i = 0; i < MAX_CLIENTS; i++) {
 		clientSocket[i] = INVALID_SOCKET;
 		ClientNet& client = clientNet[i];
 		client.async.Init();
 	}
 
+	running = true; // before the poller starts, it stops as soon as it reads false
 	thread.Begin(ThreadNetwork, this);
-	running = true;
 	return true;
 }
 
@@ -82,6 +97,10 @@ ClientHandle Server::ListenerAddClient(SOCKET s, const sockaddr& addr_)
 				client.pendingSendBuff.Init(SEND_BUFF_LEN * 4);
 			}
 			client.pendingSendBuff.Clear();
+			client.coalesceMap.clear();
+			client.coalescedCount = 0;
+			client.pendingSendPackets = 0;
+			client.recvCounter.Reset();
 
 			client.async.PostConnectionInit(s);
 
@@ -126,19 +145,53 @@ void Server::DisconnectClient(ClientHandle clientHd)
 	clientDoDisconnect[clientID] = true;
 }
 
-void Server::ClientSend(i32 clientID, const void* data, i32 dataSize)
+// coalesceKey: 0 for packets that always have to be sent
+void Server::ClientSend(i32 clientID, const void* data, i32 dataSize, u64 coalesceKey)
 {
 	ASSERT(clientID >= 0 && clientID < MAX_CLIENTS);
 	if(clientSocket[clientID] == INVALID_SOCKET) return;
 
+	MEM_TAG(MemTag::NETWORK);
 	ClientNet& client = clientNet[clientID];
 	const LockGuard lock(client.mutexSend);
+
+	if(client.pendingSendBuff.size + dataSize > sendDisconnectThreshold) {
+		if(!clientDoDisconnect[clientID]) {
+			WARN("[client%03d] send queue over the limit (%d bytes queued), disconnecting", clientID, client.pendingSendBuff.size);
+			clientDoDisconnect[clientID] = true;
+		}
+		return;
+	}
+
+	if(coalesceKey != 0 && client.pendingSendBuff.size > sendCoalesceThreshold) {
+		auto found = client.coalesceMap.find(coalesceKey);
+		if(found != client.coalesceMap.end()) {
+			u8* queued = client.pendingSendBuff.data + found->second;
+			if(((const NetHeader*)queued)->size == dataSize) {
+				memmove(queued, data, dataSize);
+				client.coalescedCount++;
+				return;
+			}
+		}
+
+		if(client.coalesceMap.size() < COALESCE_CAPACITY) {
+			client.coalesceMap[coalesceKey] = client.pendingSendBuff.size;
+		}
+	}
+
 	client.pendingSendBuff.Append(data, dataSize);
+	client.pendingSendPackets++;
+	NetStatsCount(NetDir::SEND, ((const NetHeader*)data)->netID, dataSize);
 }
 
 // NOTE: this is called from the Poller thread
 void Server::Update()
 {
+	i64 sendQueuedTotal = 0;
+	i64 sendQueuedMax = 0;
+	i64 sendCoalesced = 0;
+	i64 connectedCount = 0;
+
 	for(int clientID = 0; clientID < MAX_CLIENTS; clientID++) {
 		if(clientIsConnected[clientID] == 0) continue; // first check for speed
 
@@ -148,6 +201,7 @@ void Server::Update()
 
 		SOCKET sock = clientSocket[clientID];
 		ASSERT(sock != INVALID_SOCKET);
+		connectedCount++;
 
 		if(clientDoDisconnect[clientID]) {
 			DisconnectClient(clientID);
@@ -180,17 +234,36 @@ void Server::Update()
 				{
 					LockGuard lock(client.mutexSend);
 					client.async.PushSendData(client.pendingSendBuff.data, client.pendingSendBuff.size);
+					metrics.sendBytes->Add(client.pendingSendBuff.size);
+					metrics.sendPackets->Add(client.pendingSendPackets);
 					client.pendingSendBuff.Clear();
+					client.coalesceMap.clear();
+					client.pendingSendPackets = 0;
 				}
 
 				bool r = client.async.StartSending();
 				if(!r) {
 					LOG("[client%03d] ERROR: send failed", clientID);
 					DisconnectClient(clientID);
+					continue;
 				}
 			}
 		}
+
+		// still queued: the socket has not finished sending the previous data
+		const i32 queued = client.pendingSendBuff.size;
+		sendQueuedTotal += queued;
+		sendQueuedMax = MAX(sendQueuedMax, (i64)queued);
+		metrics.clientSendQueuedBytes->Observe(queued);
+		sendCoalesced += client.coalescedCount;
 	}
+
+	ProfilePlotVarN("Send queued total (bytes)", sendQueuedTotal);
+	ProfilePlotVarN("Send queued max (bytes)", sendQueuedMax);
+	ProfilePlotVarN("Send coalesced packets", sendCoalesced);
+
+	metrics.connectedClients->Set(connectedCount);
+	metrics.sendQueuedBytes->Set(sendQueuedTotal);
 }
 
 void Server::TransferAllReceivedData(GrowableBuffer* out)
@@ -216,7 +289,7 @@ void Server::TransferAllReceivedData(GrowableBuffer* out)
 	}
 }
 
-void Server::TransferReceivedData(GrowableBuffer* out, const ClientHandle* clientList, const u32 clientCount)
+void Server::TransferReceivedData(GrowableBuffer* out, const ClientHandle* clientList, const u32 clientCount, Time* outOldestRecvTime)
 {
 	for(int i = 0; i < clientCount; i++) {
 		const i32 clientID = TryGetClientID(clientList[i]);
@@ -236,6 +309,10 @@ void Server::TransferReceivedData(GrowableBuffer* out, const ClientHandle* clien
 				out->Append(&header, sizeof(header));
 				out->Append(client.recvPendingProcessingBuff.data, client.recvPendingProcessingBuff.size);
 
+				if(outOldestRecvTime && (*outOldestRecvTime == Time::ZERO || client.recvPendingTime < *outOldestRecvTime)) {
+					*outOldestRecvTime = client.recvPendingTime;
+				}
+
 				client.recvPendingProcessingBuff.Clear();
 			}
 		}
@@ -269,12 +346,29 @@ void Server::ClientHandleReceivedData(i32 clientID, i32 dataLen)
 	LOG("[client%03d] Received %d bytes", clientID, dataLen);
 #endif
 
+	const u8* data = (const u8*)client.async.GetReceivedData();
+	metrics.recvBytes->Add(dataLen);
+	metrics.recvPackets->Add(client.recvCounter.Count(data, dataLen));
+
 	// append to pending processing buffer
 	LOCK_MUTEX(client.mutexRecv);
-	client.recvPendingProcessingBuff.Append(client.async.GetReceivedData(), dataLen);
+	if(client.recvPendingProcessingBuff.size == 0) {
+		client.recvPendingTime = TimeNow();
+	}
+	client.recvPendingProcessingBuff.Append(data, dataLen);
 }
 
 void Server::SendPacketData(ClientHandle clientHd, u16 netID, u16 packetSize, const void* packetData)
+{
+	ClientSendPacket(clientHd, netID, packetSize, packetData, 0);
+}
+
+void Server::SendStatePacketData(ClientHandle clientHd, u16 netID, u16 packetSize, const void* packetData, u32 key)
+{
+	ClientSendPacket(clientHd, netID, packetSize, packetData, ((u64)netID << 32) | key);
+}
+
+void Server::ClientSendPacket(ClientHandle clientHd, u16 netID, u16 packetSize, const void* packetData, u64 coalesceKey)
 {
 	const i32 clientID = TryGetClientID(clientHd);
 	if(clientID == -1) return;
@@ -289,7 +383,7 @@ void Server::SendPacketData(ClientHandle clientHd, u16 netID, u16 packetSize, co
 	memmove(sendBuff, &header, sizeof(header));
 	memmove(sendBuff+sizeof(NetHeader), packetData, packetSize);
 
-	ClientSend(clientID, sendBuff, packetTotalSize);
+	ClientSend(clientID, sendBuff, packetTotalSize, coalesceKey);
 
 	if(doTraceNetwork) {
 		static Mutex mutexFile;
@@ -408,6 +502,7 @@ void InnerConnection::SendPacketData(u16 netID, u16 packetSize, const void *pack
 	memmove(at, &header, sizeof(header));
 	memmove(at+sizeof(NetHeader), packetData, packetSize);
 	sendQ.size += packetTotalSize;
+	NetStatsCount(NetDir::SEND, netID, packetTotalSize);
 }
 
 void InnerConnection::SendPendingData()
@@ -429,7 +524,38 @@ void InnerConnection::RecvPendingData(u8* buff, const i32 buffCapacity, i32* siz
 	if(r == NetPollResult::SUCCESS) {
 		ASSERT(len <= buffCapacity);
 		memmove(buff, async.GetReceivedData(), len);
+		recvCounter.Count(buff, len);
 		*size = len;
 		async.StartReceiving();
 	}
 }
+
+i32 NetStreamCounter::Count(const u8* data, i32 dataLen)
+{
+	STATIC_ASSERT(sizeof(headerPart) == sizeof(NetHeader));
+
+	i32 count = 0;
+	i32 cursor = 0;
+	while(cursor < dataLen) {
+		if(packetLeft > 0) {
+			const i32 skip = MIN(packetLeft, dataLen - cursor);
+			packetLeft -= skip;
+			cursor += skip;
+			continue;
+		}
+
+		const i32 take = MIN((i32)sizeof(NetHeader) - headerPartLen, dataLen - cursor);
+		memmove(headerPart + headerPartLen, data + cursor, take);
+		headerPartLen += take;
+		cursor += take;
+		if(headerPartLen < (i32)sizeof(NetHeader)) break; // header split, the rest comes next time
+
+		const NetHeader& header = *(const NetHeader*)headerPart;
+		packetLeft = MAX((i32)header.size - (i32)sizeof(NetHeader), 0);
+		headerPartLen = 0;
+		NetStatsCount(NetDir::RECV, header.netID, header.size);
+		count++;
+	}
+
+	return count;
+}
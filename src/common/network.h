@@ -117,18 +117,51 @@ enum class ClientHandle: u32 {
 
 typedef LocalMapping<i32, ClientHandle, 0, MAX_CLIENTS, -1> ClientLocalMapping;
 
+// Counts received packets on the raw stream, a packet can be split over two receives.
+// Every packet header found is also counted in NetStats.
+struct NetStreamCounter
+{
+	u8 headerPart[4]; // NetHeader
+	i32 headerPartLen = 0;
+	i32 packetLeft = 0; // bytes of the current packet still to come
+
+	// returns the number of packet headers in data, the end of a packet started in a previous receive is skipped
+	i32 Count(const u8* data, i32 dataLen);
+
+	inline void Reset()
+	{
+		headerPartLen = 0;
+		packetLeft = 0;
+	}
+};
+
+struct MetricCounter;
+struct MetricGauge;
+struct MetricHistogram;
+
 struct Server
 {
 	// fixed non growing hash map
 	template<typename T1, typename T2, int CAPACITY>
 	using hash_map = eastl::fixed_hash_map<T1 ,T2, CAPACITY, CAPACITY+1, false>;
 
+	enum {
+		COALESCE_CAPACITY = 512,
+	};
+
 	struct ClientNet
 	{
 		AsyncConnection async;
 		sockaddr addr;
 		GrowableBuffer recvPendingProcessingBuff;
+		Time recvPendingTime = Time::ZERO; // when the oldest data in recvPendingProcessingBuff was received (guarded by mutexRecv)
 		GrowableBuffer pendingSendBuff;
+		// state packets queued while over sendCoalesceThreshold, (netID, key) -> offset in pendingSendBuff
+		// cleared when pendingSendBuff is pushed to the socket (guarded by mutexSend)
+		hash_map<u64,i32,COALESCE_CAPACITY> coalesceMap;
+		u32 coalescedCount = 0;
+		u32 pendingSendPackets = 0; // in pendingSendBuff (guarded by mutexSend)
+		NetStreamCounter recvCounter; // network thread only
 		ProfileMutex(Mutex, mutexRecv);
 		ProfileMutex(Mutex, mutexSend);
 		Mutex mutexConnect;
@@ -167,6 +200,24 @@ struct Server
 	i32 packetCounter = 0;
 	bool doTraceNetwork = false;
 
+	// registered in Init (common/metrics.h)
+	struct Metrics
+	{
+		MetricGauge* connectedClients;
+		MetricGauge* sendQueuedBytes;
+		MetricHistogram* clientSendQueuedBytes;
+		MetricCounter* recvBytes;
+		MetricCounter* recvPackets;
+		MetricCounter* sendBytes;
+		MetricCounter* sendPackets;
+	};
+
+	Metrics metrics;
+
+	// send backpressure, a client that can't keep up first gets only the latest state packets then is disconnected
+	i32 sendCoalesceThreshold = 64 * 1024; // bytes queued
+	i32 sendDisconnectThreshold = 4 * 1024 * 1024; // bytes queued
+
 	bool Init();
 	void Cleanup();
 
@@ -176,7 +227,8 @@ struct Server
 	void Update();
 
 	void TransferAllReceivedData(GrowableBuffer* out);
-	void TransferReceivedData(GrowableBuffer* out, const ClientHandle* clientList, const u32 clientCount);
+	// outOldestRecvTime: receive time of the oldest data transferred, unchanged when nothing is
+	void TransferReceivedData(GrowableBuffer* out, const ClientHandle* clientList, const u32 clientCount, Time* outOldestRecvTime = nullptr);
 
 	template<class Array>
 	void TransferConnectedClientList(Array* out)
@@ -219,6 +271,16 @@ struct Server
 	}
 	void SendPacketData(ClientHandle clientHd, u16 netID, u16 packetSize, const void* packetData);
 
+	// For packets that only carry the latest state of something (moves, rotations), key identifies that something.
+	// When the client is over sendCoalesceThreshold, a queued packet with the same netID and key is replaced
+	// instead of appending a new one.
+	template<typename Packet>
+	inline void SendStatePacket(ClientHandle clientHd, const Packet& packet, u32 key)
+	{
+		SendStatePacketData(clientHd, Packet::NET_ID, sizeof(packet), &packet, key);
+	}
+	void SendStatePacketData(ClientHandle clientHd, u16 netID, u16 packetSize, const void* packetData, u32 key);
+
 private:
 	inline i32 GetClientID(ClientHandle clientHd) const
 	{
@@ -243,7 +305,8 @@ private:
 
 	void DisconnectClient(i32 clientID);
 
-	void ClientSend(i32 clientID, const void* data, i32 dataSize);
+	void ClientSend(i32 clientID, const void* data, i32 dataSize, u64 coalesceKey = 0);
+	void ClientSendPacket(ClientHandle clientHd, u16 netID, u16 packetSize, const void* packetData, u64 coalesceKey);
 	bool ClientStartReceiving(i32 clientID);
 	void ClientHandleReceivedData(i32 clientID, i32 dataLen);
 };
@@ -266,6 +329,7 @@ struct Listener
 struct InnerConnection
 {
 	AsyncConnection async;
+	NetStreamCounter recvCounter;
 
 	struct SendQueue
 	{
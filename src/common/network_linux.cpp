@@ -41,7 +41,10 @@ bool AsyncConnection::ConnectTo(const u8* ip, u16 port)
 	ASSERT(s != INVALID_SOCKET);
 
 	int r = connect(s, (sockaddr*)&addr, sizeof(addr));
-	if (r == SOCKET_ERROR) return false;
+	if(r == SOCKET_ERROR) {
+		closesocket(s);
+		return false;
+	}
 
 	PostConnectionInit(s);
 	return true;
@@ -146,6 +149,7 @@ NetPollResult AsyncConnection::PollReceive(int* outRecvLen)
 				return NetPollResult::PENDING;
 			}
 			LOG("ERROR(PollReceive): recv failed (%d)", errno);
+			closesocket(sock);
 			sock = INVALID_SOCKET;
 			return NetPollResult::POLL_ERROR;
 		}
@@ -154,6 +158,7 @@ NetPollResult AsyncConnection::PollReceive(int* outRecvLen)
 			recvBuff.Append(recvTempBuff, len);
 		}
 		else if(len == 0) { // disconnect
+			closesocket(sock);
 			sock = INVALID_SOCKET;
 			return NetPollResult::POLL_ERROR;
 		}
@@ -202,6 +207,7 @@ NetPollResult AsyncConnection::PollSend()
 				return NetPollResult::PENDING;
 			}
 			LOG("ERROR(PollSend): write failed (%d)", errno);
+			closesocket(sock);
 			sock = INVALID_SOCKET;
 			return NetPollResult::POLL_ERROR;
 		}
@@ -49,7 +49,10 @@ bool AsyncConnection::ConnectTo(const u8* ip, u16 port)
 	ASSERT(s != INVALID_SOCKET);
 
 	int r = connect(s, (sockaddr*)&addr, sizeof(addr));
-	if(r == SOCKET_ERROR) return false;
+	if(r == SOCKET_ERROR) {
+		closesocket(s);
+		return false;
+	}
 
 	PostConnectionInit(s);
 	return true;
@@ -140,6 +143,7 @@ NetPollResult AsyncConnection::PollReceive(int* outRecvLen)
 		int err = WSAGetLastError();
 		if(err != WSA_IO_INCOMPLETE) {
 			LOG("ERROR(PollReceive): Recv WSAGetOverlappedResult failed (%d)", err);
+			closesocket(sock);
 			sock = INVALID_SOCKET;
 			return NetPollResult::POLL_ERROR;
 		}
@@ -147,6 +151,7 @@ NetPollResult AsyncConnection::PollReceive(int* outRecvLen)
 	}
 
 	if(len == 0) {
+		closesocket(sock);
 		sock = INVALID_SOCKET;
 		return NetPollResult::POLL_ERROR;
 	}
@@ -164,6 +169,7 @@ NetPollResult AsyncConnection::PollSend()
 		int err = WSAGetLastError();
 		if(err != WSA_IO_INCOMPLETE) {
 			LOG("ERROR(PollSend): Send WSAGetOverlappedResult failed (%d)", err);
+			closesocket(sock);
 			sock = INVALID_SOCKET;
 			return NetPollResult::POLL_ERROR;
 		}
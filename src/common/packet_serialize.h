@@ -1541,6 +1541,9 @@ inline const char* PacketSerialize<In::HQ_PartyEnqueue>(const void* packetData,
 
 	SER("HQ_PartyEnqueue(%d, %d) :: {", In::HQ_PartyEnqueue::NET_ID, packetSize);
 	SER("	partyUID=%u", packet.partyUID);
+	SER("	mode=%d", packet.mode);
+	SER("	region=%d", packet.region);
+	SER("	rating=%d", packet.rating);
 	SER("}");
 
 	return str.data();
@@ -1665,6 +1668,7 @@ inline const char* PacketSerialize<In::MQ_CreateGame>(const void* packetData, co
 
 	SER("MQ_CreateGame(%d, %d) :: {", In::MQ_CreateGame::NET_ID, packetSize);
 	SER("	sortieUID=%llu", packet.sortieUID);
+	SER("	mapIndex=%d", packet.mapIndex);
 	SER("	players(%d)=[", packet.playerCount);
 	for(auto* p = packet.players.begin(); p != packet.players.begin()+packet.playerCount; ++p) {
 		SER("	{");
@@ -1707,6 +1711,82 @@ inline const char* PacketSerialize<In::PR_GameCreated>(const void* packetData, c
 	return str.data();
 }
 
+template<>
+inline const char* PacketSerialize<In::PN_GameFailed>(const void* packetData, const i32 packetSize)
+{
+	SER_BEGIN();
+	const In::PN_GameFailed& packet = SafeCast<In::PN_GameFailed>(packetData, packetSize);
+
+	SER("PN_GameFailed(%d, %d) :: {", In::PN_GameFailed::NET_ID, packetSize);
+	SER("	sortieUID=%llu", packet.sortieUID);
+	SER("}");
+
+	return str.data();
+}
+
+template<>
+inline const char* PacketSerialize<In::HL_Register>(const void* packetData, const i32 packetSize)
+{
+	SER_BEGIN();
+	const In::HL_Register& packet = SafeCast<In::HL_Register>(packetData, packetSize);
+
+	SER("HL_Register(%d, %d) :: {", In::HL_Register::NET_ID, packetSize);
+	SER("	magic=%x", packet.magic);
+	SER("	ip=%d.%d.%d.%d", packet.ip[0], packet.ip[1], packet.ip[2], packet.ip[3]);
+	SER("	listenPort=%d", packet.listenPort);
+	SER("	maxPlayers=%d", packet.maxPlayers);
+	SER("}");
+
+	return str.data();
+}
+
+template<>
+inline const char* PacketSerialize<In::HL_LoadReport>(const void* packetData, const i32 packetSize)
+{
+	SER_BEGIN();
+	const In::HL_LoadReport& packet = SafeCast<In::HL_LoadReport>(packetData, packetSize);
+
+	SER("HL_LoadReport(%d, %d) :: {", In::HL_LoadReport::NET_ID, packetSize);
+	SER("	playerCount=%d", packet.playerCount);
+	SER("	tickP99Ms=%g", packet.tickP99Ms);
+	SER("}");
+
+	return str.data();
+}
+
+template<>
+inline const char* PacketSerialize<In::HQ_PartyLeave>(const void* packetData, const i32 packetSize)
+{
+	SER_BEGIN();
+	const In::HQ_PartyLeave& packet = SafeCast<In::HQ_PartyLeave>(packetData, packetSize);
+
+	SER("HQ_PartyLeave(%d, %d) :: {", In::HQ_PartyLeave::NET_ID, packetSize);
+	SER("	partyUID=%u", packet.partyUID);
+	SER("	accountUID=%u", packet.accountUID);
+	SER("}");
+
+	return str.data();
+}
+
+template<>
+inline const char* PacketSerialize<In::PQ_LoadReport>(const void* packetData, const i32 packetSize)
+{
+	SER_BEGIN();
+	const In::PQ_LoadReport& packet = SafeCast<In::PQ_LoadReport>(packetData, packetSize);
+
+	SER("PQ_LoadReport(%d, %d) :: {", In::PQ_LoadReport::NET_ID, packetSize);
+	SER("	maxGamesPerLane=%d", packet.maxGamesPerLane);
+	SER("	lanes(%d)=[", packet.laneCount);
+	for(i32 i = 0; i < packet.laneCount; i++) {
+		const In::PQ_LoadReport::Lane& l = packet.lanes[i];
+		SER("	{ gameCount=%d playerCount=%d tickP99Ms=%g busyPercent=%d }", l.gameCount, l.playerCount, l.tickP99Ms, l.busyPercent);
+	}
+	SER("	]");
+	SER("}");
+
+	return str.data();
+}
+
 template<>
 inline const char* PacketSerialize<In::MN_MatchCreated>(const void* packetData, const i32 packetSize)
 {
@@ -1722,6 +1802,20 @@ inline const char* PacketSerialize<In::MN_MatchCreated>(const void* packetData,
 	return str.data();
 }
 
+template<>
+inline const char* PacketSerialize<In::MN_PartyDequeued>(const void* packetData, const i32 packetSize)
+{
+	SER_BEGIN();
+	const In::MN_PartyDequeued& packet = SafeCast<In::MN_PartyDequeued>(packetData, packetSize);
+
+	SER("MN_PartyDequeued(%d, %d) :: {", In::MN_PartyDequeued::NET_ID, packetSize);
+	SER("	partyUID=%u", packet.partyUID);
+	SER("	leftAccountUID=%u", packet.leftAccountUID);
+	SER("}");
+
+	return str.data();
+}
+
 #define DEFAULT_SERIALIZE(PACKET)\
 	template<>\
 	inline const char* PacketSerialize<PACKET>(const void* packetData, const i32 packetSize)\
@@ -1763,6 +1857,7 @@ DEFAULT_SERIALIZE(Sv::SN_NotifyIngameSkillPoint);
 DEFAULT_SERIALIZE(Sv::SN_NotifyTimestamp);
 DEFAULT_SERIALIZE(Sv::SN_NotifyAasRestricted);
 DEFAULT_SERIALIZE(Sv::SN_PlayerSyncTurn);
+DEFAULT_SERIALIZE(Sv::SN_UpdateStat);
 DEFAULT_SERIALIZE(Sv::SN_DestroyEntity);
 DEFAULT_SERIALIZE(Sv::SN_RegionServicePolicy);
 DEFAULT_SERIALIZE(Sv::SN_AllCharacterBaseData);
@@ -30,4 +30,21 @@ void MakeDirectory(const char* path);
 
 const char* FormatPath(const char* path); // replace / with \ on windows
 
+// Read-only mapping of a whole file
+struct FileMapping
+{
+	const uint8_t* data;
+	int32_t size;
+	void* handle; // windows: file mapping object
+};
+
+bool FileMapReadOnly(const char* path, FileMapping* out); // pages are shared with the other processes mapping the file
+void FileUnmap(FileMapping* mapping);
+bool FileReplace(const char* from, const char* to); // atomic rename, overwrites 'to'
+typedef void(*Func_FileFound)(const char* name, void* user);
+void FileListMatching(const char* dir, const char* pattern, Func_FileFound func, void* user); // names of the files of dir matching pattern (* wildcards, any case)
+uint64_t FileModifiedTime(const char* path); // 0 when the file does not exist
+
+uint32_t GetProcessID();
+
 uint64_t CurrentFiletimeTimestampUTC();
@@ -4,6 +4,10 @@
 #include <signal.h>
 #include <sys/stat.h>
 #include <sys/prctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <dirent.h>
 #include <unistd.h>
 
 void DbgBreak()
@@ -40,6 +44,65 @@ const char* FormatPath(const char* path)
 	return path;
 }
 
+bool FileMapReadOnly(const char* path, FileMapping* out)
+{
+	int fd = open(path, O_RDONLY);
+	if(fd == -1) return false;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > INT32_MAX) {
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping keeps the file open
+	if(data == MAP_FAILED) return false;
+
+	out->data = (const uint8_t*)data;
+	out->size = (int32_t)st.st_size;
+	out->handle = nullptr;
+	return true;
+}
+
+void FileUnmap(FileMapping* mapping)
+{
+	if(!mapping->data) return;
+	munmap((void*)mapping->data, mapping->size);
+	mapping->data = nullptr;
+	mapping->size = 0;
+}
+
+bool FileReplace(const char* from, const char* to)
+{
+	return rename(from, to) == 0;
+}
+
+void FileListMatching(const char* dir, const char* pattern, Func_FileFound func, void* user)
+{
+	DIR* d = opendir(dir);
+	if(!d) return;
+
+	while(dirent* entry = readdir(d)) {
+		if(entry->d_type == DT_DIR) continue;
+		if(fnmatch(pattern, entry->d_name, FNM_CASEFOLD) != 0) continue; // like windows
+		func(entry->d_name, user);
+	}
+	closedir(d);
+}
+
+uint64_t FileModifiedTime(const char* path)
+{
+	struct stat st;
+	if(stat(path, &st) != 0) return 0;
+	return (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+}
+
+uint32_t GetProcessID()
+{
+	return (uint32_t)getpid();
+}
+
 void PlatformInit()
 {
 	prctl(PR_SET_DUMPABLE, 1); // enable generating dump when program crashes.
@@ -48,6 +48,76 @@ const char* FormatPath(const char* path)
 	return buff.data();
 }
 
+bool FileMapReadOnly(const char* path, FileMapping* out)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || size.QuadPart > INT32_MAX) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file); // the mapping object keeps the file open
+	if(!mapping) return false;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(!data) {
+		CloseHandle(mapping);
+		return false;
+	}
+
+	out->data = (const uint8_t*)data;
+	out->size = (int32_t)size.QuadPart;
+	out->handle = mapping;
+	return true;
+}
+
+void FileUnmap(FileMapping* mapping)
+{
+	if(!mapping->data) return;
+	UnmapViewOfFile(mapping->data);
+	CloseHandle(mapping->handle);
+	mapping->data = nullptr;
+	mapping->size = 0;
+	mapping->handle = nullptr;
+}
+
+bool FileReplace(const char* from, const char* to)
+{
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+void FileListMatching(const char* dir, const char* pattern, Func_FileFound func, void* user)
+{
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/%s", dir, pattern);
+
+	WIN32_FIND_DATAA found;
+	HANDLE find = FindFirstFileA(FormatPath(path), &found);
+	if(find == INVALID_HANDLE_VALUE) return;
+
+	do {
+		if(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+		func(found.cFileName, user);
+	} while(FindNextFileA(find, &found));
+	FindClose(find);
+}
+
+uint64_t FileModifiedTime(const char* path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if(!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes)) return 0;
+	return ((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+}
+
+uint32_t GetProcessID()
+{
+	return (uint32_t)GetCurrentProcessId();
+}
+
 void PlatformInit()
 {
 #ifdef TRACY_ENABLE
@@ -1,4 +1,5 @@
 #include "protocol.h"
+#include "inner_protocol.h"
 
 const char* ActionStateToString(ActionStateID state)
 {
@@ -872,3 +873,228 @@ ClassType ClassTypeFromString(const char* str)
 
 	return ClassType::NONE;
 }
+
+#define NET_ID_NAME(PACKET) { PACKET::NET_ID, #PACKET }
+
+static const NetIdName g_NetIdNameList[] = {
+	NET_ID_NAME(Cl::CQ_FirstHello),
+	NET_ID_NAME(Cl::CQ_UserLogin),
+	NET_ID_NAME(Cl::ConfirmLogin),
+	NET_ID_NAME(Cl::ConfirmGatewayInfo),
+	NET_ID_NAME(Cl::EnterQueue),
+	NET_ID_NAME(Cl::CQ_Authenticate),
+	NET_ID_NAME(Cl::CQ_AuthenticateGameServer),
+	NET_ID_NAME(Cl::CN_ReadyToLoadCharacter),
+	NET_ID_NAME(Cl::CN_GameMapLoaded),
+	NET_ID_NAME(Cl::CN_ReadyToLoadGameMap),
+	NET_ID_NAME(Cl::CN_UpdatePosition),
+	NET_ID_NAME(Cl::CN_GamePlayerSyncActionStateOnly),
+	NET_ID_NAME(Cl::CA_SetGameGvt),
+	NET_ID_NAME(Cl::CQ_GameIsReady),
+	NET_ID_NAME(Cl::CQ_LoadingComplete),
+	NET_ID_NAME(Cl::CN_MapIsLoaded),
+	NET_ID_NAME(Cl::CN_PlayerTagCompleted),
+	NET_ID_NAME(Cl::CQ_PlayerCastSkill),
+	NET_ID_NAME(Cl::SetNickname),
+	NET_ID_NAME(Cl::CheckDupNickname),
+	NET_ID_NAME(Cl::CQ_GetCharacterInfo),
+	NET_ID_NAME(Cl::CQ_SetLeaderCharacter),
+	NET_ID_NAME(Cl::CQ_GamePlayerTag),
+	NET_ID_NAME(Cl::CQ_RoomEquipWeapon),
+	NET_ID_NAME(Cl::CQ_RoomEquipSkill),
+	NET_ID_NAME(Cl::CQ_RoomSwapSkill),
+	NET_ID_NAME(Cl::CQ_RequestAreaPopularity),
+	NET_ID_NAME(Cl::CQ_PartyCreate),
+	NET_ID_NAME(Cl::CQ_PartyModify),
+	NET_ID_NAME(Cl::CQ_PartyOptionModify),
+	NET_ID_NAME(Cl::CA_SortieRoomFound),
+	NET_ID_NAME(Cl::CN_SortieRoomConfirm),
+	NET_ID_NAME(Cl::CQ_EnqueueGame),
+	NET_ID_NAME(Cl::CQ_MasterPick),
+	NET_ID_NAME(Cl::CQ_MasterUnpick),
+	NET_ID_NAME(Cl::CQ_MasterReset),
+	NET_ID_NAME(Cl::CQ_ReadySortieRoom),
+	NET_ID_NAME(Cl::CQ_PlayerJump),
+	NET_ID_NAME(Cl::CN_ChannelChatMessage),
+	NET_ID_NAME(Cl::CQ_JukeboxQueueSong),
+	NET_ID_NAME(Cl::CQ_GetGuildProfile),
+	NET_ID_NAME(Cl::CQ_GetGuildMemberList),
+	NET_ID_NAME(Cl::CQ_GetGuildHistoryList),
+	NET_ID_NAME(Cl::CQ_TierRecord),
+	NET_ID_NAME(Cl::CQ_GetGuildRankingSeasonList),
+	NET_ID_NAME(Cl::CN_GameUpdatePosition),
+	NET_ID_NAME(Cl::CN_GameUpdateRotation),
+	NET_ID_NAME(Cl::CQ_WhisperSend),
+	NET_ID_NAME(Cl::CQ_LoadingProgressData),
+	NET_ID_NAME(Cl::CQ_RTT_Time),
+	NET_ID_NAME(Cl::CQ_RequestCalendar),
+
+	NET_ID_NAME(Sv::SA_FirstHello),
+	NET_ID_NAME(Sv::SA_UserloginResult),
+	NET_ID_NAME(Sv::SA_UserloginResult2),
+	NET_ID_NAME(Sv::SA_AuthResult),
+	NET_ID_NAME(Sv::SN_RegionServicePolicy),
+	NET_ID_NAME(Sv::SN_StationList),
+	NET_ID_NAME(Sv::SN_TgchatServerInfo),
+	NET_ID_NAME(Sv::SN_DoConnectGameServer),
+	NET_ID_NAME(Sv::SN_DoConnectChannelServer),
+	NET_ID_NAME(Sv::SN_GameCreateActor),
+	NET_ID_NAME(Sv::SN_SpawnPosForMinimap),
+	NET_ID_NAME(Sv::SN_GameCreateSubActor),
+	NET_ID_NAME(Sv::SN_GameEnterActor),
+	NET_ID_NAME(Sv::SN_GameLeaveActor),
+	NET_ID_NAME(Sv::SN_StatusSnapshot),
+	NET_ID_NAME(Sv::SQ_CityLobbyJoinCity),
+	NET_ID_NAME(Sv::SN_CastSkill),
+	NET_ID_NAME(Sv::SN_ExecuteSkill),
+	NET_ID_NAME(Sv::SA_CastSkill),
+	NET_ID_NAME(Sv::SA_VersionInfo),
+	NET_ID_NAME(Sv::SN_PlayerSkillSlot),
+	NET_ID_NAME(Sv::SN_LoadCharacterStart),
+	NET_ID_NAME(Sv::SN_ScanEnd),
+	NET_ID_NAME(Sv::SN_GamePlayerSyncByInt),
+	NET_ID_NAME(Sv::SN_UpdateStat),
+	NET_ID_NAME(Sv::SN_Money),
+	NET_ID_NAME(Sv::SN_DestroyEntity),
+	NET_ID_NAME(Sv::SN_SetGameGvt),
+	NET_ID_NAME(Sv::SN_LobbyStartGame),
+	NET_ID_NAME(Sv::SN_LoadClearedStages),
+	NET_ID_NAME(Sv::SN_GameFieldReady),
+	NET_ID_NAME(Sv::SA_LoadingComplete),
+	NET_ID_NAME(Sv::SA_GameReady),
+	NET_ID_NAME(Sv::SN_GameStart),
+	NET_ID_NAME(Sv::SN_GamePlayerEquipWeapon),
+	NET_ID_NAME(Sv::SN_GamePlayerStock),
+	NET_ID_NAME(Sv::SN_PlayerStateInTown),
+	NET_ID_NAME(Sv::SN_CityMapInfo),
+	NET_ID_NAME(Sv::SN_SummaryInfoAll),
+	NET_ID_NAME(Sv::SN_AvailableSummaryRewardCountList),
+	NET_ID_NAME(Sv::SN_AchieveInfo),
+	NET_ID_NAME(Sv::SN_AchieveLatest),
+	NET_ID_NAME(Sv::SN_AchieveUpdate),
+	NET_ID_NAME(Sv::SN_AccountInfo),
+	NET_ID_NAME(Sv::SN_AccountExtraInfo),
+	NET_ID_NAME(Sv::SN_AllCharacterBaseData),
+	NET_ID_NAME(Sv::SN_GamePlayerTag),
+	NET_ID_NAME(Sv::SA_GetCharacterInfo),
+	NET_ID_NAME(Sv::SA_CheckDupNickname),
+	NET_ID_NAME(Sv::SA_SetLeader),
+	NET_ID_NAME(Sv::SN_LeaderCharacter),
+	NET_ID_NAME(Sv::SN_ProfileCharacters),
+	NET_ID_NAME(Sv::SN_ProfileItems),
+	NET_ID_NAME(Sv::SN_ProfileWeapons),
+	NET_ID_NAME(Sv::SN_ProfileSkills),
+	NET_ID_NAME(Sv::SN_ProfileTitles),
+	NET_ID_NAME(Sv::SN_ProfileMasterGears),
+	NET_ID_NAME(Sv::SA_EnqueueGame),
+	NET_ID_NAME(Sv::SA_AreaPopularity),
+	NET_ID_NAME(Sv::SN_AreaPopularity),
+	NET_ID_NAME(Sv::SA_PartyCreate),
+	NET_ID_NAME(Sv::SA_PartyModify),
+	NET_ID_NAME(Sv::SA_PartyOptionModify),
+	NET_ID_NAME(Sv::SN_EnqueueMatchingQueue),
+	NET_ID_NAME(Sv::SQ_MatchingPartyFound),
+	NET_ID_NAME(Sv::SN_MatchingPartyGathered),
+	NET_ID_NAME(Sv::SA_MasterPick),
+	NET_ID_NAME(Sv::SN_MasterPick),
+	NET_ID_NAME(Sv::SN_ReadySortieRoom),
+	NET_ID_NAME(Sv::SN_StartCountdownSortieRoom),
+	NET_ID_NAME(Sv::SN_SortiePrepare),
+	NET_ID_NAME(Sv::SN_SortiePrepareBotInfo),
+	NET_ID_NAME(Sv::SN_UpdateGameOwner),
+	NET_ID_NAME(Sv::SN_SummaryInfoLatest),
+	NET_ID_NAME(Sv::SN_NotifyPcDetailInfos),
+	NET_ID_NAME(Sv::SA_ResultSpAction),
+	NET_ID_NAME(Sv::SN_ChatChannelMessage),
+	NET_ID_NAME(Sv::SN_FriendList),
+	NET_ID_NAME(Sv::SN_FriendRequestList),
+	NET_ID_NAME(Sv::SN_MutualFriendList),
+	NET_ID_NAME(Sv::SN_BlockList),
+	NET_ID_NAME(Sv::SN_NotifyAasRestricted),
+	NET_ID_NAME(Sv::SN_Exp),
+	NET_ID_NAME(Sv::SN_JukeboxEnqueuedList),
+	NET_ID_NAME(Sv::SN_JukeboxPlay),
+	NET_ID_NAME(Sv::SN_JukeboxHotTrackList),
+	NET_ID_NAME(Sv::SN_TownHudStatistics),
+	NET_ID_NAME(Sv::SA_GetGuildProfile),
+	NET_ID_NAME(Sv::SA_GetGuildMemberList),
+	NET_ID_NAME(Sv::SA_GetGuildHistoryList),
+	NET_ID_NAME(Sv::SA_GetGuildRankingSeasonList),
+	NET_ID_NAME(Sv::SN_MyGuild),
+	NET_ID_NAME(Sv::SN_GuildMemberStatus),
+	NET_ID_NAME(Sv::SN_GuildChannelEnter),
+	NET_ID_NAME(Sv::SN_PlayerSyncMove),
+	NET_ID_NAME(Sv::SN_PlayerSyncTurn),
+	NET_ID_NAME(Sv::SN_PlayerSyncActionStateOnly),
+	NET_ID_NAME(Sv::SN_WeaponState),
+	NET_ID_NAME(Sv::SN_ProfileCharacterSkinList),
+	NET_ID_NAME(Sv::SN_NotifyUserLifeInfo),
+	NET_ID_NAME(Sv::SN_WarehouseItems),
+	NET_ID_NAME(Sv::SA_WhisperSend),
+	NET_ID_NAME(Sv::SN_WhisperReceive),
+	NET_ID_NAME(Sv::SN_MailUnreadNotice),
+	NET_ID_NAME(Sv::SN_UpdateEntrySystem),
+	NET_ID_NAME(Sv::SQ_Heartbeat),
+	NET_ID_NAME(Sv::SN_RunClientLevelEvent),
+	NET_ID_NAME(Sv::SN_RunClientLevelEventSeq),
+	NET_ID_NAME(Sv::SN_LoadingProgressData),
+	NET_ID_NAME(Sv::SN_MasterRotationInfo),
+	NET_ID_NAME(Sv::SN_SortieCharacterSlotInfo),
+	NET_ID_NAME(Sv::SN_SortieMasterPickPhaseStart),
+	NET_ID_NAME(Sv::SN_SortieMasterPickPhaseEnd),
+	NET_ID_NAME(Sv::SN_SortieMasterPickPhaseStepStart),
+	NET_ID_NAME(Sv::SN_SortieMasterPickPhaseStep),
+	NET_ID_NAME(Sv::SA_TierRecord),
+	NET_ID_NAME(Sv::SN_Unknown_62472),
+	NET_ID_NAME(Sv::SN_NotifyIsInSafeZone),
+	NET_ID_NAME(Sv::SN_NotifyIngameSkillPoint),
+	NET_ID_NAME(Sv::SN_NotifyTimestamp),
+	NET_ID_NAME(Sv::SA_RTT_Time),
+	NET_ID_NAME(Sv::SN_PveComradeInfo),
+	NET_ID_NAME(Sv::SN_ClientSettings),
+	NET_ID_NAME(Sv::QueueStatus),
+	NET_ID_NAME(Sv::SN_AccountEquipmentList),
+	NET_ID_NAME(Sv::SA_CalendarDetail),
+	NET_ID_NAME(Sv::SN_InitScoreBoard),
+	NET_ID_NAME(Sv::SN_InitIngameModeInfo),
+	NET_ID_NAME(Sv::SN_ActionChangeLevelEvent),
+	NET_ID_NAME(Sv::SN_UpdateMasterGroupingEffect),
+
+	NET_ID_NAME(In::HQ_Handshake),
+	NET_ID_NAME(In::HQ_PartyCreate),
+	NET_ID_NAME(In::HQ_PartyEnqueue),
+	NET_ID_NAME(In::HN_PlayerRoomFound),
+	NET_ID_NAME(In::HN_PlayerRoomConfirm),
+	NET_ID_NAME(In::HQ_RoomCreateGame),
+	NET_ID_NAME(In::HL_Register),
+	NET_ID_NAME(In::HL_LoadReport),
+	NET_ID_NAME(In::HQ_PartyLeave),
+	NET_ID_NAME(In::PQ_Handshake),
+	NET_ID_NAME(In::PR_GameCreated),
+	NET_ID_NAME(In::PQ_LoadReport),
+	NET_ID_NAME(In::PN_GameFailed),
+	NET_ID_NAME(In::MR_Handshake),
+	NET_ID_NAME(In::MR_PartyCreated),
+	NET_ID_NAME(In::MR_PartyEnqueued),
+	NET_ID_NAME(In::MN_MatchingPartyFound),
+	NET_ID_NAME(In::MN_RoomCreated),
+	NET_ID_NAME(In::MQ_CreateGame),
+	NET_ID_NAME(In::MN_MatchCreated),
+	NET_ID_NAME(In::MN_PartyDequeued),
+};
+
+#undef NET_ID_NAME
+
+const NetIdName* NetIdNameList(i32* outCount)
+{
+	*outCount = (i32)ARRAY_COUNT(g_NetIdNameList);
+	return g_NetIdNameList;
+}
+
+const char* NetIdToString(u16 netID)
+{
+	for(i32 i = 0; i < (i32)ARRAY_COUNT(g_NetIdNameList); i++) {
+		if(g_NetIdNameList[i].netID == netID) return g_NetIdNameList[i].name;
+	}
+	return "unknown";
+}
@@ -442,6 +442,16 @@ struct NetHeader
 
 ASSERT_SIZE(NetHeader, 4);
 
+// every packet with a NET_ID (Cl, Sv and In, netIDs don't overlap), for stats and logs
+struct NetIdName
+{
+	u16 netID;
+	const char* name; // "Cl::CQ_FirstHello"
+};
+
+const NetIdName* NetIdNameList(i32* outCount);
+const char* NetIdToString(u16 netID); // "unknown" when not in the list
+
 #define VEC(TYPE, NAME)\
 	u16 NAME##_count;\
 	TYPE NAME[1]
@@ -1368,6 +1378,18 @@ struct SN_GamePlayerSyncByInt
 };
 ASSERT_SIZE(SN_GamePlayerSyncByInt, 56);
 
+struct SN_UpdateStat
+{
+	enum { NET_ID = 62056 };
+
+	LocalActorID characterID;
+	i32 statType; // 0: hp
+	f32 cur;
+	f32 max;
+	i32 reasonCode;
+};
+ASSERT_SIZE(SN_UpdateStat, 20);
+
 PUSH_PACKED
 struct SN_Money
 {
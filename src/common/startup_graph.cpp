@@ -0,0 +1,144 @@
+#include "startup_graph.h"
+#include "utils.h"
+
+StartupGraph::StageID StartupGraph::AddStage(const char* name, StageFunc func, void* object, MemTag memTag)
+{
+	ASSERT(stageList.size() < MAX_STAGES);
+
+	Stage& stage = stageList.push_back();
+	stage.name = name;
+	stage.func = func;
+	stage.object = object;
+	stage.memTag = memTag;
+	stage.dependencyMask = 0;
+	stage.dependentMask = 0;
+	stage.failed = false;
+	stage.skipped = false;
+	stage.start = Time::ZERO;
+	stage.end = Time::ZERO;
+	return (StageID)stageList.size() - 1;
+}
+
+void StartupGraph::DependsOn(StageID stage, StageID dependency)
+{
+	ASSERT(stage >= 0 && stage < (StageID)stageList.size());
+	ASSERT(dependency >= 0 && dependency < stage); // keeps the graph acyclic
+
+	stageList[stage].dependencyMask |= 1 << dependency;
+	stageList[dependency].dependentMask |= 1 << stage;
+}
+
+void StartupGraph::RunStage(StageID stageID)
+{
+	Stage& stage = stageList[stageID];
+
+	// a failed dependency skips the whole branch
+	for(i32 d = 0; d < stageID; d++) {
+		if((stage.dependencyMask & (1 << d)) && (stageList[d].failed || stageList[d].skipped)) {
+			stage.skipped = true;
+			return;
+		}
+	}
+
+	ProfileFunction();
+	ProfileAttachStringf("%s", stage.name);
+	MEM_TAG(stage.memTag);
+	stage.start = TimeNow();
+	stage.failed = !stage.func(stage.object);
+	stage.end = TimeNow();
+
+	if(stage.failed) {
+		LOG("ERROR(StartupGraph): stage '%s' failed", stage.name);
+	}
+}
+
+void StartupStageTask(void* object, void* context)
+{
+	StartupGraph::TaskContext& ctx = *(StartupGraph::TaskContext*)context;
+	const StartupGraph::StageID stageID = (StartupGraph::StageID)(intptr_t)object;
+
+	ctx.graph->RunStage(stageID);
+	ctx.graph->Resolve(stageID, &ctx);
+}
+
+void StartupGraph::Resolve(StageID stageID, TaskContext* context)
+{
+	const u32 dependentMask = stageList[stageID].dependentMask;
+	for(i32 s = stageID + 1; s < (i32)stageList.size(); s++) {
+		if(!(dependentMask & (1 << s))) continue;
+
+		// last dependency done, queued before this task completes so the batch can't end early
+		if(stageList[s].pendingDependencies.Decrement() == 0) {
+			context->scheduler->Submit(context->batch, StartupStageTask, (void*)(intptr_t)s, context, nullptr);
+		}
+	}
+}
+
+bool StartupGraph::Run(TaskScheduler* scheduler)
+{
+	ProfileFunction();
+
+	runStart = TimeNow();
+
+	if(!scheduler || !scheduler->IsEnabled()) {
+		for(i32 s = 0; s < (i32)stageList.size(); s++) {
+			RunStage(s);
+		}
+	}
+	else {
+		TaskScheduler::Batch batch;
+		TaskContext context = { this, scheduler, &batch };
+
+		foreach(it, stageList) {
+			i32 count = 0;
+			for(u32 m = it->dependencyMask; m; m &= m - 1) count++;
+			it->pendingDependencies.SetValue(count);
+		}
+
+		for(i32 s = 0; s < (i32)stageList.size(); s++) {
+			if(stageList[s].dependencyMask == 0) {
+				scheduler->Submit(&batch, StartupStageTask, (void*)(intptr_t)s, &context, nullptr);
+			}
+		}
+
+		scheduler->Wait(&batch);
+	}
+
+	runEnd = TimeNow();
+
+	foreach_const(it, stageList) {
+		if(it->failed || it->skipped) return false;
+	}
+	return true;
+}
+
+void StartupGraph::PrintTimeline() const
+{
+	enum { BAR_WIDTH = 40 };
+
+	const f64 totalMs = TimeDurationMs(runStart, runEnd);
+	f64 serialMs = 0;
+
+	LOG("Boot timeline (%.2fms) = {", totalMs);
+	foreach_const(it, stageList) {
+		if(it->skipped) {
+			LOG("	%-24s skipped", it->name);
+			continue;
+		}
+
+		const f64 startMs = TimeDurationMs(runStart, it->start);
+		const f64 endMs = TimeDurationMs(runStart, it->end);
+		serialMs += endMs - startMs;
+
+		char bar[BAR_WIDTH + 1];
+		const i32 first = totalMs > 0 ? (i32)(startMs / totalMs * BAR_WIDTH) : 0;
+		const i32 last = totalMs > 0 ? (i32)(endMs / totalMs * BAR_WIDTH) : 0;
+		for(i32 i = 0; i < BAR_WIDTH; i++) {
+			bar[i] = (i >= first && i <= last) ? '#' : '.';
+		}
+		bar[BAR_WIDTH] = 0;
+
+		LOG("	%-24s %8.2f .. %8.2f ms (%7.2fms) |%s|%s", it->name, startMs, endMs, endMs - startMs, bar, it->failed ? " FAILED" : "");
+	}
+	LOG("} (stages sum=%.2fms)", serialMs);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <common/base.h>
+#include <common/task_scheduler.h>
+#include <eathread/eathread_atomic.h>
+
+// Startup stages with explicit dependencies, each stage runs as soon as the stages it depends on are done.
+// Stages run as tasks on a scheduler (in parallel), or in order on the calling thread without one.
+// A stage can only depend on stages added before it, so the insertion order is always a valid serial order.
+// When a stage fails the stages depending on it are skipped and Run returns false.
+struct StartupGraph
+{
+	enum {
+		MAX_STAGES = 32
+	};
+
+	typedef i32 StageID;
+	typedef bool (*StageFunc)(void* object);
+
+	// the stage allocates under memTag, wherever it runs
+	StageID AddStage(const char* name, StageFunc func, void* object, MemTag memTag = MemCurrentTag());
+	void DependsOn(StageID stage, StageID dependency);
+
+	// Thread: Main
+	// scheduler can be null
+	bool Run(TaskScheduler* scheduler);
+	void PrintTimeline() const; // per stage start/end relative to Run
+
+private:
+	struct Stage
+	{
+		const char* name;
+		StageFunc func;
+		void* object;
+		MemTag memTag;
+		u32 dependencyMask;
+		u32 dependentMask;
+
+		EA::Thread::AtomicInt32 pendingDependencies = 0;
+		bool failed;
+		bool skipped;
+		Time start;
+		Time end;
+	};
+
+	struct TaskContext
+	{
+		StartupGraph* graph;
+		TaskScheduler* scheduler;
+		TaskScheduler::Batch* batch;
+	};
+
+	eastl::fixed_vector<Stage,MAX_STAGES,false> stageList;
+	Time runStart = Time::ZERO;
+	Time runEnd = Time::ZERO;
+
+	void RunStage(StageID stageID);
+	void Resolve(StageID stageID, TaskContext* context); // queue the dependents that are ready
+
+	friend void StartupStageTask(void* object, void* context);
+};
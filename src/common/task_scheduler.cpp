@@ -0,0 +1,157 @@
+#include "task_scheduler.h"
+#include "utils.h"
+
+intptr_t ThreadTaskWorker(void* pData)
+{
+	TaskScheduler::Worker& worker = *(TaskScheduler::Worker*)pData;
+	TaskScheduler& scheduler = *worker.scheduler;
+	ProfileSetThreadName(FMT("Worker_%d", worker.index));
+	ThreadSetCoreAffinity(worker.coreID);
+
+	while(scheduler.running) {
+		TaskScheduler::Task task;
+		if(scheduler.TryGetTask(worker.index, &task)) {
+			scheduler.Execute(worker.index, task);
+			continue;
+		}
+
+		scheduler.semaphore.Wait();
+	}
+
+	return 0;
+}
+
+bool TaskScheduler::Worker::PushBack(const Task& task)
+{
+	LOCK_MUTEX(mutexDeque);
+	if(tail - head >= DEQUE_CAPACITY) return false;
+	deque[tail % DEQUE_CAPACITY] = task;
+	tail++;
+	return true;
+}
+
+bool TaskScheduler::Worker::PopBack(Task* out)
+{
+	LOCK_MUTEX(mutexDeque);
+	if(head == tail) return false;
+	tail--;
+	*out = deque[tail % DEQUE_CAPACITY];
+	return true;
+}
+
+bool TaskScheduler::Worker::StealFront(Task* out)
+{
+	LOCK_MUTEX(mutexDeque);
+	if(head == tail) return false;
+	*out = deque[head % DEQUE_CAPACITY];
+	head++;
+	return true;
+}
+
+bool TaskScheduler::Init(i32 workerCount_, i32 firstCoreID)
+{
+	if(workerCount_ < 0 || workerCount_ > MAX_WORKERS) {
+		LOG("ERROR(TaskScheduler::Init): invalid worker count (%d, max=%d)", workerCount_, MAX_WORKERS);
+		return false;
+	}
+
+	workerCount = workerCount_;
+	running = true;
+	nextWorker.SetValue(0);
+
+	for(i32 i = 0; i < workerCount; i++) {
+		Worker& w = workers[i];
+		w.scheduler = this;
+		w.index = i;
+		w.coreID = firstCoreID + i;
+		w.thread.Begin(ThreadTaskWorker, &w);
+	}
+
+	return true;
+}
+
+void TaskScheduler::Cleanup()
+{
+	if(!running) return;
+	running = false;
+
+	semaphore.Post(workerCount);
+	for(i32 i = 0; i < workerCount; i++) {
+		workers[i].thread.WaitForEnd();
+	}
+	workerCount = 0;
+}
+
+void TaskScheduler::Submit(Batch* batch, void (*func)(void*,void*), void* object, void* context, i32* affinity)
+{
+	ASSERT(IsEnabled());
+
+	Task task;
+	task.func = func;
+	task.object = object;
+	task.context = context;
+	task.affinity = affinity;
+	task.batch = batch;
+
+	batch->pendingCount.Increment();
+
+	// last worker first, then the next ones if its deque is full
+	i32 first;
+	if(affinity && *affinity >= 0 && *affinity < workerCount) {
+		first = *affinity;
+	}
+	else {
+		first = nextWorker.Increment() % workerCount;
+	}
+
+	for(i32 i = 0; i < workerCount; i++) {
+		if(workers[(first + i) % workerCount].PushBack(task)) {
+			semaphore.Post(1);
+			return;
+		}
+	}
+
+	// every deque is full, run it here
+	WARN("Every task deque is full (workers=%d capacity=%d)", workerCount, DEQUE_CAPACITY);
+	Execute(-1, task);
+}
+
+void TaskScheduler::Wait(Batch* batch)
+{
+	ProfileFunction();
+
+	while(batch->pendingCount.GetValue() > 0) {
+		Task task;
+		if(TryGetTask(-1, &task)) {
+			Execute(-1, task);
+		}
+		else {
+			EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+		}
+	}
+}
+
+bool TaskScheduler::TryGetTask(i32 worker, Task* out)
+{
+	if(worker >= 0 && workers[worker].PopBack(out)) return true;
+
+	const i32 start = worker >= 0 ? worker + 1 : 0;
+	for(i32 i = 0; i < workerCount; i++) {
+		const i32 victim = (start + i) % workerCount;
+		if(victim == worker) continue;
+		if(workers[victim].StealFront(out)) return true;
+	}
+	return false;
+}
+
+void TaskScheduler::Execute(i32 worker, const Task& task)
+{
+	task.func(task.object, task.context);
+
+	// tasks run by a waiting thread keep their affinity
+	if(task.affinity && worker >= 0) {
+		*task.affinity = worker;
+	}
+
+	task.batch->pendingCount.Decrement(); // the batch (and the task data) can be gone after that
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <common/base.h>
+#include <eathread/eathread_thread.h>
+#include <eathread/eathread_semaphore.h>
+#include <eathread/eathread_atomic.h>
+
+// Work stealing thread pool, used to tick instances as tasks.
+// Each worker has its own task deque: the worker pops from the back, idle workers steal from the front of the others.
+// A task is queued on the worker that ran it last when possible, so an instance stays on the same core while the load is even.
+// Any thread can submit a batch of tasks and wait on it, the waiting thread runs tasks as well until the batch is done.
+struct TaskScheduler
+{
+	enum {
+		MAX_WORKERS = 16,
+		DEQUE_CAPACITY = 512,
+	};
+
+	struct Batch
+	{
+		EA::Thread::AtomicInt32 pendingCount = 0;
+	};
+
+	struct Task
+	{
+		void (*func)(void* object, void* context);
+		void* object;
+		void* context;
+		i32* affinity; // index of the worker that last ran the task, updated by the scheduler (optional)
+		Batch* batch;
+	};
+
+	i32 workerCount = 0;
+	bool running = false;
+
+	bool Init(i32 workerCount_, i32 firstCoreID);
+	void Cleanup();
+
+	inline bool IsEnabled() const { return workerCount > 0; }
+
+	// Thread: Any
+	void Submit(Batch* batch, void (*func)(void*,void*), void* object, void* context, i32* affinity);
+	// Thread: Any
+	// returns when every task of the batch is done
+	void Wait(Batch* batch);
+
+private:
+	struct Worker
+	{
+		TaskScheduler* scheduler;
+		i32 index;
+		i32 coreID;
+		EA::Thread::Thread thread;
+
+		// ring buffer, [head, tail)
+		ProfileMutex(Mutex, mutexDeque);
+		Task deque[DEQUE_CAPACITY];
+		u32 head = 0;
+		u32 tail = 0;
+
+		bool PushBack(const Task& task);
+		bool PopBack(Task* out);
+		bool StealFront(Task* out);
+	};
+
+	eastl::array<Worker,MAX_WORKERS> workers;
+	EA::Thread::Semaphore semaphore;
+	EA::Thread::AtomicUint32 nextWorker;
+
+	// worker = -1 when the task is run by a thread outside of the pool
+	bool TryGetTask(i32 worker, Task* out);
+	void Execute(i32 worker, const Task& task);
+
+	friend intptr_t ThreadTaskWorker(void* pData);
+};
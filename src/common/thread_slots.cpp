@@ -0,0 +1,44 @@
+#include "thread_slots.h"
+
+// ThreadSlots blocks held by this thread, given back by its thread local destructor
+struct ThreadSlotReleaseList
+{
+	enum {
+		MAX_ENTRIES = 8
+	};
+
+	struct Entry
+	{
+		Func_ThreadSlotRelease func;
+		void* threadSlot;
+		void* slots;
+		i32 index;
+	};
+
+	Entry list[MAX_ENTRIES];
+	i32 count = 0;
+
+	~ThreadSlotReleaseList();
+};
+
+static thread_local ThreadSlotReleaseList t_SlotReleaseList;
+static thread_local bool t_SlotReleased = false; // the list is gone, a block taken after that would never be given back
+
+ThreadSlotReleaseList::~ThreadSlotReleaseList()
+{
+	t_SlotReleased = true;
+	for(i32 i = count - 1; i >= 0; i--) {
+		list[i].func(list[i].threadSlot, list[i].slots, list[i].index);
+	}
+	count = 0;
+}
+
+bool ThreadSlotReleaseOnExit(Func_ThreadSlotRelease func, void* threadSlot, void* slots, i32 index)
+{
+	if(t_SlotReleased) return false;
+
+	ThreadSlotReleaseList& rl = t_SlotReleaseList;
+	ASSERT(rl.count < ThreadSlotReleaseList::MAX_ENTRIES);
+	rl.list[rl.count++] = ThreadSlotReleaseList::Entry{ func, threadSlot, slots, index };
+	return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <common/base.h>
+#include <eathread/eathread_atomic.h>
+
+// Blocks of counters written by one thread each (memory tags, net stats): a thread takes a free block the first time it counts,
+// then adds to it without lock nor atomic. Readers sum the blocks while they are written, a few counts off.
+// The block is given back when its thread exits, the next thread taking it keeps adding to it so the sums stay right.
+// Threads past MAX - 1 share the last block with atomic adds, so does a thread counting after its block was given back.
+// Zero initialized statics only, they are used before the dynamic initializers (memAlloc).
+template<typename T, i32 MAX>
+struct ThreadSlots
+{
+	T list[MAX];
+	volatile int taken[MAX - 1];
+	volatile int usedCount; // blocks taken at least once, the shared one excluded
+
+	// Thread: Any
+	// threadSlot is the thread local pointer of the caller, set by the first call
+	inline T& Get(T** threadSlot)
+	{
+		if(*threadSlot) return **threadSlot;
+		return Take(threadSlot);
+	}
+
+	inline void Add(T& slot, volatile i64* counter, i64 value)
+	{
+		if(&slot == &list[MAX - 1]) {
+			EA::Thread::AtomicFetchAdd(counter, value);
+		}
+		else {
+			*counter = *counter + value;
+		}
+	}
+
+	// every block a thread wrote to
+	template<typename Callback>
+	void ForEachUsed(Callback cb) const
+	{
+		const i32 used = MIN((i32)usedCount, MAX - 1);
+		for(i32 i = 0; i < used; i++) {
+			cb(list[i]);
+		}
+		cb(list[MAX - 1]);
+	}
+
+private:
+	T& Take(T** threadSlot);
+	static void Release(void* threadSlot, void* slots, i32 index);
+};
+
+typedef void (*Func_ThreadSlotRelease)(void* threadSlot, void* slots, i32 index);
+
+// Thread: Any
+// func is called when the calling thread exits, false when it is already exiting
+bool ThreadSlotReleaseOnExit(Func_ThreadSlotRelease func, void* threadSlot, void* slots, i32 index);
+
+template<typename T, i32 MAX>
+T& ThreadSlots<T,MAX>::Take(T** threadSlot)
+{
+	for(i32 i = 0; i < MAX - 1; i++) {
+		if(taken[i] || !EA::Thread::AtomicSetValueConditional(&taken[i], 1, 0)) continue;
+
+		int used = EA::Thread::AtomicGetValue(&usedCount);
+		while(used < i + 1 && !EA::Thread::AtomicSetValueConditional(&usedCount, i + 1, used)) {
+			used = EA::Thread::AtomicGetValue(&usedCount);
+		}
+
+		if(!ThreadSlotReleaseOnExit(Release, threadSlot, this, i)) {
+			EA::Thread::AtomicSetValue(&taken[i], 0);
+			break;
+		}
+
+		*threadSlot = &list[i];
+		return list[i];
+	}
+
+	*threadSlot = &list[MAX - 1];
+	return list[MAX - 1];
+}
+
+template<typename T, i32 MAX>
+void ThreadSlots<T,MAX>::Release(void* threadSlot, void* slots, i32 index)
+{
+	ThreadSlots& self = *(ThreadSlots*)slots;
+
+	// thread local destructors running after this one can still count
+	*(T**)threadSlot = &self.list[MAX - 1];
+	EA::Thread::AtomicSetValue(&self.taken[index], 0);
+}
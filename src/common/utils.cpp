@@ -74,6 +74,14 @@ u8* FileOpenAndReadAll(const wchar* filename, i32* pOutSize)
 	return nullptr;
 }
 
+bool FileMapReadOnly(const wchar* filename, FileMapping* out)
+{
+	char utf8Path[512] = {0};
+	char* dest = utf8Path;
+	eastl::DecodePart(filename, filename + EA::StdC::Strlen(filename), dest, utf8Path + sizeof(utf8Path));
+	return FileMapReadOnly(utf8Path, out);
+}
+
 static u32 g_XorShiftState = (u32)time(0);
 
 u32 RandUint()
@@ -103,3 +111,39 @@ void ThreadSetCoreAffinity(i32 coreID)
     const i32 count = EA::Thread::GetProcessorCount();
     EA::Thread::SetThreadAffinityMask(1 << (coreID % count));
 }
+
+void MemReport::Sample()
+{
+	MemStats cur;
+	MemGetStats(&cur);
+	const Time now = TimeNow();
+
+	const f64 elapsedSec = sampleTime != Time::ZERO ? TimeDurationSec(sampleTime, now) : 0;
+	for(i32 i = 0; i < (i32)MemTag::_COUNT; i++) {
+		peakLiveBytes[i] = MAX(peakLiveBytes[i], cur.tags[i].liveBytes);
+		allocPerSec[i] = elapsedSec > 0 ? (cur.tags[i].allocCount - stats.tags[i].allocCount) / elapsedSec : 0;
+	}
+
+	stats = cur;
+	sampleTime = now;
+}
+
+void MemReport::Plot() const
+{
+	for(i32 i = 0; i < (i32)MemTag::_COUNT; i++) {
+		ProfilePlotVarN(MemTagName((MemTag)i), stats.tags[i].liveBytes);
+	}
+}
+
+void MemReport::Print() const
+{
+	i64 totalLive = 0;
+	LOG("Memory = {");
+	for(i32 i = 0; i < (i32)MemTag::_COUNT; i++) {
+		const MemTagStats& t = stats.tags[i];
+		totalLive += t.liveBytes;
+		LOG("	%-12s live=%8.2fMB peak=%8.2fMB allocs=%lld (%.0f/s) allocated=%.2fMB", MemTagName((MemTag)i),
+			t.liveBytes / (1024.0*1024.0), peakLiveBytes[i] / (1024.0*1024.0), (long long)t.allocCount, allocPerSec[i], t.allocBytes / (1024.0*1024.0));
+	}
+	LOG("} (live=%.2fMB no alloc violations=%lld)", totalLive / (1024.0*1024.0), (long long)stats.noAllocViolations);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "base.h"
+#include "arena.h"
 #include <EASTL/fixed_string.h>
 #include <EASTL/fixed_list.h>
 #include <EASTL/fixed_map.h>
@@ -16,6 +17,7 @@ void PathSet(Path& path, const wchar* str);
 void PathAppend(Path& path, const wchar* app);
 
 u8* FileOpenAndReadAll(const wchar* filename, i32* pOutSize);
+bool FileMapReadOnly(const wchar* filename, FileMapping* out);
 
 u32 RandUint();
 f64 Randf01();
@@ -70,6 +72,10 @@ inline bool StringViewEquals(const eastl::string_view& sv, const char* str)
 template<typename T1, typename T2, int EXPECTED_CAPACITY, bool GrowOnOverflow = false>
 using hash_map = eastl::fixed_hash_map<T1 ,T2, EXPECTED_CAPACITY, 2, GrowOnOverflow>;
 
+// hash_map growing into a MemArena once full (ArenaHashAllocator)
+template<typename T1, typename T2, int EXPECTED_CAPACITY>
+using arena_hash_map = eastl::fixed_hash_map<T1 ,T2, EXPECTED_CAPACITY, 2, true, eastl::hash<T1>, eastl::equal_to<T1>, false, ArenaHashAllocator>;
+
 // LOCAL_MIN: included
 // LOCAL_MAX: excluded
 template<typename LocalID, typename GlobalID, LocalID LOCAL_MIN, LocalID LOCAL_MAX, LocalID LOCAL_INVALID = LocalID::INVALID>
@@ -137,3 +143,16 @@ struct LocalMapping
 };
 
 void ThreadSetCoreAffinity(i32 coreID);
+
+// Memory counters sampled over time (MemGetStats), peaks and allocation rates are measured between two samples
+struct MemReport
+{
+	MemStats stats;
+	i64 peakLiveBytes[(i32)MemTag::_COUNT] = {0};
+	f64 allocPerSec[(i32)MemTag::_COUNT] = {0};
+	Time sampleTime = Time::ZERO;
+
+	void Sample();
+	void Plot() const; // Tracy plots, live bytes per tag
+	void Print() const;
+};
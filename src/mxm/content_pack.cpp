@@ -0,0 +1,385 @@
+#include <common/utils.h>
+#include <EASTL/sort.h>
+
+#include "core.h"
+#include "game_content.h"
+
+// Baked game content pack, written by tools/contentpack and mapped at startup instead of parsing the XML files.
+// A section table followed by flat arrays of fixed size records, offsets are relative to the start of the file.
+// Records are plain copies of the in-memory structs so a pack only loads on the build (and architecture) that baked it:
+// bump PACK_VERSION when one of them changes (record sizes are checked as well, which catches most of it).
+// The pack is also the content segment: skills, actions and remotes are used in place (no pointers, only offsets and counts)
+// so every process mapping the same file shares those pages.
+
+constexpr eastl::hash<const char*> strHash;
+
+enum: u32 {
+	PACK_MAGIC = 0x5043584D, // 'MXCP'
+	PACK_VERSION = 4,
+	PACK_ALIGNMENT = 16,
+};
+
+enum class PackSection: u16
+{
+	MASTERS = 0,
+	WEAPONS,
+	SKILLS,
+	MAPLISTS,
+	LOBBY_CREATURES,
+	LOBBY_DYNAMIC,
+	LOBBY_AREAS,
+	PVP_CREATURES,
+	PVP_DYNAMIC,
+	PVP_AREAS,
+	SONGS,
+	ACTIONS,
+	ACTION_COMMANDS,
+	REMOTES,
+
+	_COUNT
+};
+
+struct PackSectionEntry
+{
+	u32 offset;
+	u32 count;
+	u32 recordSize;
+	u32 _pad;
+};
+
+struct PackHeader
+{
+	u32 magic;
+	u16 version;
+	u16 sectionCount;
+	u32 fileSize;
+	u32 checksum; // fnv1a of everything after the header
+	u32 sourcesStamp; // of the xml files it was baked from, a pack with another one is outdated
+	PackSectionEntry sections[(i32)PackSection::_COUNT];
+};
+
+struct PackMaster
+{
+	CreatureIndex ID;
+	ClassType classType;
+	char className[64];
+	u8 skillCount;
+	u8 skinCount;
+	u8 weaponCount;
+	SkillID skillIDs[decltype(GameXmlContent::Master::skillIDs)::kMaxSize];
+	SkinIndex skinIDs[decltype(GameXmlContent::Master::skinIDs)::kMaxSize];
+	WeaponIndex weaponIDs[decltype(GameXmlContent::Master::weaponIDs)::kMaxSize];
+	CharacterModel character;
+};
+
+struct PackMapList
+{
+	i32 index;
+	MapType mapType;
+	GameSubModeType gameSubModeType;
+	char levelFile[256];
+};
+
+static const u32 g_PackRecordSize[(i32)PackSection::_COUNT] = {
+	sizeof(PackMaster),
+	sizeof(WeaponModel),
+	sizeof(GameXmlContent::Skill),
+	sizeof(PackMapList),
+	sizeof(GameXmlContent::Map::Spawn),
+	sizeof(GameXmlContent::Map::Spawn),
+	sizeof(GameXmlContent::Map::Area),
+	sizeof(GameXmlContent::Map::Spawn),
+	sizeof(GameXmlContent::Map::Spawn),
+	sizeof(GameXmlContent::Map::Area),
+	sizeof(GameXmlContent::Song),
+	sizeof(GameXmlContent::Action), // actions of a class are contiguous, commands are in ACTION_COMMANDS
+	sizeof(GameXmlContent::Action::Command),
+	sizeof(Remote),
+};
+
+static const u32 g_PackRecordCapacity[(i32)PackSection::_COUNT] = {
+	decltype(GameXmlContent::masters)::kMaxSize,
+	decltype(GameXmlContent::weaponsModel)::kMaxSize,
+	500, // skills
+	decltype(GameXmlContent::maplists)::kMaxSize,
+	decltype(GameXmlContent::Map::creatures)::kMaxSize,
+	decltype(GameXmlContent::Map::dynamic)::kMaxSize,
+	decltype(GameXmlContent::Map::areas)::kMaxSize,
+	decltype(GameXmlContent::Map::creatures)::kMaxSize,
+	decltype(GameXmlContent::Map::dynamic)::kMaxSize,
+	decltype(GameXmlContent::Map::areas)::kMaxSize,
+	decltype(GameXmlContent::jukeboxSongs)::kMaxSize,
+	2000, // actionList
+	2000 * 16, // action commands
+	1500, // remotes
+};
+
+template<typename T>
+static inline T* PackSectionData(u8* pack, const PackHeader& header, PackSection section)
+{
+	return (T*)(pack + header.sections[(i32)section].offset);
+}
+
+template<typename T>
+static inline const T* PackSectionData(const u8* pack, const PackHeader& header, PackSection section)
+{
+	return (const T*)(pack + header.sections[(i32)section].offset);
+}
+
+template<typename T, typename Container>
+static void PackCopyRecords(u8* pack, const PackHeader& header, PackSection section, const Container& list)
+{
+	T* out = PackSectionData<T>(pack, header, section);
+	foreach_const(it, list) {
+		*out++ = *it;
+	}
+}
+
+template<typename T, typename Container>
+static void UnpackCopyRecords(const u8* pack, const PackHeader& header, PackSection section, Container* list)
+{
+	const T* records = PackSectionData<T>(pack, header, section);
+	const u32 count = header.sections[(i32)section].count;
+	for(u32 i = 0; i < count; i++) {
+		list->push_back(records[i]);
+	}
+}
+
+bool GameXmlContent::BakePack(GrowableBuffer* out) const
+{
+	ASSERT(xml);
+
+	u32 counts[(i32)PackSection::_COUNT] = {0};
+	counts[(i32)PackSection::MASTERS] = masters.size();
+	counts[(i32)PackSection::WEAPONS] = weaponsModel.size();
+	counts[(i32)PackSection::SKILLS] = xml->skillMap.size();
+	counts[(i32)PackSection::MAPLISTS] = maplists.size();
+	counts[(i32)PackSection::LOBBY_CREATURES] = mapLobby.creatures.size();
+	counts[(i32)PackSection::LOBBY_DYNAMIC] = mapLobby.dynamic.size();
+	counts[(i32)PackSection::LOBBY_AREAS] = mapLobby.areas.size();
+	counts[(i32)PackSection::PVP_CREATURES] = mapPvpDeathMatch.creatures.size();
+	counts[(i32)PackSection::PVP_DYNAMIC] = mapPvpDeathMatch.dynamic.size();
+	counts[(i32)PackSection::PVP_AREAS] = mapPvpDeathMatch.areas.size();
+	counts[(i32)PackSection::SONGS] = jukeboxSongs.size();
+	counts[(i32)PackSection::ACTIONS] = xml->actionList.size();
+	counts[(i32)PackSection::REMOTES] = xml->remoteMap.size();
+	foreach_const(it, xml->actionList) {
+		counts[(i32)PackSection::ACTION_COMMANDS] += it->commands.size();
+	}
+
+	PackHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+	header.sectionCount = (u16)PackSection::_COUNT;
+	header.sourcesStamp = xml->sourcesStamp;
+
+	u32 offset = sizeof(PackHeader);
+	for(i32 s = 0; s < (i32)PackSection::_COUNT; s++) {
+		offset = (offset + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+		PackSectionEntry& entry = header.sections[s];
+		entry.offset = offset;
+		entry.count = counts[s];
+		entry.recordSize = g_PackRecordSize[s];
+		offset += entry.count * entry.recordSize;
+	}
+	header.fileSize = offset;
+
+	out->Init(header.fileSize);
+	out->size = header.fileSize;
+	u8* pack = out->data;
+	memset(pack, 0, header.fileSize); // padding bytes stay zero
+
+	// masters
+	PackMaster* packMaster = PackSectionData<PackMaster>(pack, header, PackSection::MASTERS);
+	foreach_const(it, masters) {
+		if(it->className.size() >= sizeof(packMaster->className)) {
+			LOG("ERROR(BakePack): master class name '%s' is too long", it->className.data());
+			return false;
+		}
+
+		packMaster->ID = it->ID;
+		packMaster->classType = it->classType;
+		memmove(packMaster->className, it->className.data(), it->className.size());
+		packMaster->skillCount = it->skillIDs.size();
+		packMaster->skinCount = it->skinIDs.size();
+		packMaster->weaponCount = it->weaponIDs.size();
+		eastl::copy(it->skillIDs.begin(), it->skillIDs.end(), packMaster->skillIDs);
+		eastl::copy(it->skinIDs.begin(), it->skinIDs.end(), packMaster->skinIDs);
+		eastl::copy(it->weaponIDs.begin(), it->weaponIDs.end(), packMaster->weaponIDs);
+		packMaster->character = it->character;
+		packMaster++;
+	}
+
+	PackCopyRecords<WeaponModel>(pack, header, PackSection::WEAPONS, weaponsModel);
+
+	// hash maps are sorted by ID so the pack doesn't depend on their layout
+	Skill* packSkill = PackSectionData<Skill>(pack, header, PackSection::SKILLS);
+	foreach_const(it, xml->skillMap) {
+		packSkill->ID = it->first;
+		packSkill->model = it->second;
+		packSkill++;
+	}
+	eastl::sort(packSkill - xml->skillMap.size(), packSkill, [](const Skill& a, const Skill& b) { return a.ID < b.ID; });
+
+	PackMapList* packMapList = PackSectionData<PackMapList>(pack, header, PackSection::MAPLISTS);
+	foreach_const(it, maplists) {
+		if(it->levelFile.size() >= sizeof(packMapList->levelFile)) {
+			LOG("ERROR(BakePack): map %d level file '%s' is too long", it->index, it->levelFile.data());
+			return false;
+		}
+
+		packMapList->index = it->index;
+		packMapList->mapType = it->mapType;
+		packMapList->gameSubModeType = it->gameSubModeType;
+		memmove(packMapList->levelFile, it->levelFile.data(), it->levelFile.size());
+		packMapList++;
+	}
+
+	PackCopyRecords<Map::Spawn>(pack, header, PackSection::LOBBY_CREATURES, mapLobby.creatures);
+	PackCopyRecords<Map::Spawn>(pack, header, PackSection::LOBBY_DYNAMIC, mapLobby.dynamic);
+	PackCopyRecords<Map::Area>(pack, header, PackSection::LOBBY_AREAS, mapLobby.areas);
+	PackCopyRecords<Map::Spawn>(pack, header, PackSection::PVP_CREATURES, mapPvpDeathMatch.creatures);
+	PackCopyRecords<Map::Spawn>(pack, header, PackSection::PVP_DYNAMIC, mapPvpDeathMatch.dynamic);
+	PackCopyRecords<Map::Area>(pack, header, PackSection::PVP_AREAS, mapPvpDeathMatch.areas);
+	PackCopyRecords<Song>(pack, header, PackSection::SONGS, jukeboxSongs);
+
+	// actions, with the class of the slice they belong to
+	Action* packAction = PackSectionData<Action>(pack, header, PackSection::ACTIONS);
+	Action::Command* packCommand = PackSectionData<Action::Command>(pack, header, PackSection::ACTION_COMMANDS);
+	u32 commandCount = 0;
+	foreach_const(it, xml->actionList) {
+		packAction[it - xml->actionList.begin()].classType = ClassType::NONE; // not part of a class slice
+	}
+	foreach_const(it, xml->actionListMap) {
+		foreach_const(action, it->second) {
+			packAction[action - xml->actionList.begin()].classType = it->first;
+		}
+	}
+	foreach_const(it, xml->actionList) {
+		packAction->ID = it->ID;
+		packAction->seqLength = it->seqLength;
+		packAction->commandStart = commandCount;
+		packAction->commandCount = it->commands.size();
+		foreach_const(cmd, it->commands) {
+			packCommand[commandCount++] = *cmd;
+		}
+		packAction++;
+	}
+
+	Remote* packRemote = PackSectionData<Remote>(pack, header, PackSection::REMOTES);
+	foreach_const(it, xml->remoteMap) {
+		*packRemote++ = it->second;
+	}
+	eastl::sort(packRemote - xml->remoteMap.size(), packRemote, [](const Remote& a, const Remote& b) { return a.ID < b.ID; });
+
+	header.checksum = hash_fnv1a(pack + sizeof(PackHeader), header.fileSize - sizeof(PackHeader));
+	memmove(pack, &header, sizeof(header));
+	return true;
+}
+
+u32 GameXmlContent::ReadPackSourcesStamp(const u8* data, i32 size)
+{
+	if(size < (i32)sizeof(PackHeader)) return 0;
+	return ((const PackHeader*)data)->sourcesStamp;
+}
+
+bool GameXmlContent::BindSegment(const u8* data, i32 size, bool loadTables)
+{
+	ProfileFunction();
+
+	// validate everything first, nothing is loaded from an invalid pack
+	if(size < (i32)sizeof(PackHeader)) {
+		LOG("ERROR(BindSegment): file is too small (%d)", size);
+		return false;
+	}
+
+	const PackHeader& header = *(const PackHeader*)data;
+	if(header.magic != PACK_MAGIC || header.version != PACK_VERSION || header.sectionCount != (u16)PackSection::_COUNT) {
+		LOG("ERROR(BindSegment): unexpected header (magic=%#x version=%d sectionCount=%d)", header.magic, header.version, header.sectionCount);
+		return false;
+	}
+
+	if(header.fileSize != (u32)size) {
+		LOG("ERROR(BindSegment): size mismatch (header=%u file=%d)", header.fileSize, size);
+		return false;
+	}
+
+	for(i32 s = 0; s < (i32)PackSection::_COUNT; s++) {
+		const PackSectionEntry& entry = header.sections[s];
+		if(entry.recordSize != g_PackRecordSize[s]) {
+			LOG("ERROR(BindSegment): section %d record size mismatch (pack=%u build=%u)", s, entry.recordSize, g_PackRecordSize[s]);
+			return false;
+		}
+		if(entry.count > g_PackRecordCapacity[s] || entry.offset % PACK_ALIGNMENT != 0 ||
+		   (u64)entry.offset + (u64)entry.count * entry.recordSize > header.fileSize) {
+			LOG("ERROR(BindSegment): section %d is out of bounds (offset=%u count=%u)", s, entry.offset, entry.count);
+			return false;
+		}
+	}
+
+	const u32 checksum = hash_fnv1a(data + sizeof(PackHeader), header.fileSize - sizeof(PackHeader));
+	if(checksum != header.checksum) {
+		LOG("ERROR(BindSegment): checksum mismatch (%#x != %#x)", checksum, header.checksum);
+		return false;
+	}
+
+	const Action* packAction = PackSectionData<Action>(data, header, PackSection::ACTIONS);
+	const u32 actionCount = header.sections[(i32)PackSection::ACTIONS].count;
+	const u32 commandTotal = header.sections[(i32)PackSection::ACTION_COMMANDS].count;
+	for(u32 i = 0; i < actionCount; i++) {
+		if(packAction[i].commandCount > decltype(XmlStaging::Action::commands)::kMaxSize ||
+		   (u64)packAction[i].commandStart + packAction[i].commandCount > commandTotal) {
+			LOG("ERROR(BindSegment): action %d commands are out of bounds", i);
+			return false;
+		}
+	}
+
+	// small tables are copied, the rest is used in place
+	if(loadTables) {
+		// masters
+		const PackMaster* packMaster = PackSectionData<PackMaster>(data, header, PackSection::MASTERS);
+		for(u32 i = 0; i < header.sections[(i32)PackSection::MASTERS].count; i++) {
+			const PackMaster& pm = packMaster[i];
+			Master& master = masters.push_back();
+			master.ID = pm.ID;
+			master.classType = pm.classType;
+			master.className.assign(pm.className, strnlen(pm.className, sizeof(pm.className)));
+			master.skillIDs.assign(pm.skillIDs, pm.skillIDs + MIN(pm.skillCount, (u8)decltype(master.skillIDs)::kMaxSize));
+			master.skinIDs.assign(pm.skinIDs, pm.skinIDs + MIN(pm.skinCount, (u8)decltype(master.skinIDs)::kMaxSize));
+			master.weaponIDs.assign(pm.weaponIDs, pm.weaponIDs + MIN(pm.weaponCount, (u8)decltype(master.weaponIDs)::kMaxSize));
+			master.character = pm.character;
+
+			masterClassStringMap.emplace(strHash(master.className.data()), &master);
+			masterClassTypeMap.emplace(master.classType, &master);
+		}
+
+		UnpackCopyRecords<WeaponModel>(data, header, PackSection::WEAPONS, &weaponsModel);
+
+		const PackMapList* packMapList = PackSectionData<PackMapList>(data, header, PackSection::MAPLISTS);
+		for(u32 i = 0; i < header.sections[(i32)PackSection::MAPLISTS].count; i++) {
+			MapList& ml = maplists.push_back();
+			ml.index = packMapList[i].index;
+			ml.mapType = packMapList[i].mapType;
+			ml.gameSubModeType = packMapList[i].gameSubModeType;
+			ml.levelFile.assign(packMapList[i].levelFile, strnlen(packMapList[i].levelFile, sizeof(packMapList[i].levelFile)));
+		}
+
+		UnpackCopyRecords<Map::Spawn>(data, header, PackSection::LOBBY_CREATURES, &mapLobby.creatures);
+		UnpackCopyRecords<Map::Spawn>(data, header, PackSection::LOBBY_DYNAMIC, &mapLobby.dynamic);
+		UnpackCopyRecords<Map::Area>(data, header, PackSection::LOBBY_AREAS, &mapLobby.areas);
+		UnpackCopyRecords<Map::Spawn>(data, header, PackSection::PVP_CREATURES, &mapPvpDeathMatch.creatures);
+		UnpackCopyRecords<Map::Spawn>(data, header, PackSection::PVP_DYNAMIC, &mapPvpDeathMatch.dynamic);
+		UnpackCopyRecords<Map::Area>(data, header, PackSection::PVP_AREAS, &mapPvpDeathMatch.areas);
+		UnpackCopyRecords<Song>(data, header, PackSection::SONGS, &jukeboxSongs);
+	}
+
+	segment = Slice<const u8>(data, size);
+	skillList = Slice<const Skill>(PackSectionData<Skill>(data, header, PackSection::SKILLS), header.sections[(i32)PackSection::SKILLS].count);
+	actionList = Slice<const Action>(packAction, actionCount);
+	actionCommandList = Slice<const Action::Command>(PackSectionData<Action::Command>(data, header, PackSection::ACTION_COMMANDS), commandTotal);
+	remoteList = Slice<const Remote>(PackSectionData<Remote>(data, header, PackSection::REMOTES), header.sections[(i32)PackSection::REMOTES].count);
+
+	LOG("Content segment bound (%d bytes, masters=%d skills=%d actions=%d remotes=%d)", size, (i32)masters.size(), (i32)skillList.size(), (i32)actionList.size(), (i32)remoteList.size());
+	return true;
+}
@@ -1,6 +1,7 @@
 #include <common/utils.h>
 #include <EAStdC/EAString.h>
 #include <EAStdC/EASprintf.h>
+#include <EASTL/sort.h>
 #include <tinyxml2.h>
 
 #include "core.h"
@@ -16,10 +17,10 @@ static Path gameDataDir = L"../gamedata";
 bool GameXmlContent::LoadMasterDefinitions()
 {
 	// Parse CREATURE_CHARACTER.xml once
-	if(!LoadXMLFile(L"/CREATURE_CHARACTER.xml", xmlCREATURECHARACTER)) return false;
+	if(!LoadXMLFile(L"/CREATURE_CHARACTER.xml", xml->xmlCREATURECHARACTER)) return false;
 
 	// get master IDs
-	for(XMLElement* pNodeMaster = xmlCREATURECHARACTER.FirstChildElement()->FirstChildElement();
+	for(XMLElement* pNodeMaster = xml->xmlCREATURECHARACTER.FirstChildElement()->FirstChildElement();
 		pNodeMaster;
 		pNodeMaster = pNodeMaster->NextSiblingElement()) {
 		masters.push_back();
@@ -86,9 +87,9 @@ bool GameXmlContent::LoadMasterSkinsDefinitions()
 bool GameXmlContent::LoadMasterWeaponDefinitions()
 {
 	// Parse WEAPON.xml once
-	if(!LoadXMLFile(L"/WEAPON.xml", xmlWEAPON)) return false;
+	if(!LoadXMLFile(L"/WEAPON.xml", xml->xmlWEAPON)) return false;
 
-	XMLElement* pWeapElt = xmlWEAPON.FirstChildElement()->FirstChildElement();
+	XMLElement* pWeapElt = xml->xmlWEAPON.FirstChildElement()->FirstChildElement();
 	do {
 		i32 ID;
 		pWeapElt->QueryAttribute("ID", &ID);
@@ -148,15 +149,15 @@ bool GameXmlContent::LoadXMLFile(const wchar* fileName, tinyxml2::XMLDocument& x
 bool GameXmlContent::LoadMasterDefinitionsModel()
 {
 	// Parse SKILLS.xml once
-	if(!LoadXMLFile(L"/SKILL.xml", xmlSKILL)) return false;
+	if(!LoadXMLFile(L"/SKILL.xml", xml->xmlSKILL)) return false;
 
 	// Parse SKILL_PROPERTY.xml once
-	if(!LoadXMLFile(L"/SKILL_PROPERTY.xml", xmlSKILLPROPERTY)) return false;
+	if(!LoadXMLFile(L"/SKILL_PROPERTY.xml", xml->xmlSKILLPROPERTY)) return false;
 
 	LoadAllSkills(); // TODO: move
 
 	// get master IDs
-	XMLElement* pNodeMaster = xmlCREATURECHARACTER.FirstChildElement()->FirstChildElement();
+	XMLElement* pNodeMaster = xml->xmlCREATURECHARACTER.FirstChildElement()->FirstChildElement();
 	do {
 		i32 masterID;
 		pNodeMaster->QueryAttribute("ID", &masterID);
@@ -261,7 +262,7 @@ bool GameXmlContent::LoadMasterDefinitionsModel()
 
 void GameXmlContent::LoadAllSkills()
 {
-	XMLElement* pNodeSkill = xmlSKILL.FirstChildElement()->FirstChildElement();
+	XMLElement* pNodeSkill = xml->xmlSKILL.FirstChildElement()->FirstChildElement();
 
 	static const eastl::hash_map<eastl::string, SkillType> skillTypeMap = {
 		{"SKILL_TYPE_PASSIVE", SkillType::PASSIVE},
@@ -307,7 +308,7 @@ void GameXmlContent::LoadAllSkills()
 		// TODO: slow
 		LoadMasterSkillPropertyWithID(skill, skillID);
 
-		skillMap.emplace(SkillID(skillID), skill);
+		xml->skillMap.emplace(SkillID(skillID), skill);
 
 		pNodeSkill = pNodeSkill->NextSiblingElement();
 	} while (pNodeSkill);
@@ -315,7 +316,7 @@ void GameXmlContent::LoadAllSkills()
 
 bool GameXmlContent::LoadMasterSkillWithID(SkillNormalModel& SkillNormal, i32 skillID)
 {
-	XMLElement* pNodeSkill = xmlSKILL.FirstChildElement()->FirstChildElement();
+	XMLElement* pNodeSkill = xml->xmlSKILL.FirstChildElement()->FirstChildElement();
 
 	do {
 		i32 _skillID;
@@ -348,7 +349,7 @@ bool GameXmlContent::LoadMasterSkillWithID(SkillNormalModel& SkillNormal, i32 sk
 
 bool GameXmlContent::LoadMasterSkillPropertyWithID(SkillNormalModel& SkillNormal, i32 skillID)
 {
-	XMLElement* pNodeInfo = xmlSKILLPROPERTY.FirstChildElement()->FirstChildElement();
+	XMLElement* pNodeInfo = xml->xmlSKILLPROPERTY.FirstChildElement()->FirstChildElement();
 
 	do {
 		i32 _skillID;
@@ -385,7 +386,7 @@ bool GameXmlContent::LoadMasterSkillPropertyWithID(SkillNormalModel& SkillNormal
 bool GameXmlContent::LoadWeaponModelDefinitions()
 {
 	//get weapon IDS
-	XMLElement* pNodeWeapon = xmlWEAPON.FirstChildElement()->FirstChildElement();
+	XMLElement* pNodeWeapon = xml->xmlWEAPON.FirstChildElement()->FirstChildElement();
 	do {
 		//weaponModel.push_back();
 		//WeaponModel& weapon = weaponModel.back();
@@ -778,31 +779,256 @@ static bool FileLoad(FileBuffer* out, const wchar* path)
 	return true;
 }
 
+static u32 ContentSourcesStamp();
+
+// One file per version of the xml: a rebake never replaces a pack mapped by a running process
+// (windows can't replace a mapped file), processes on the new xml map the new one.
+static const char* PackFileName(u32 sourcesStamp)
+{
+	return FMT("content.%08x.pack", sourcesStamp);
+}
+
+static void PackPath(eastl::fixed_string<char,512,false>* out, u32 sourcesStamp)
+{
+	StrConv(out, gameDataDir);
+	out->append_sprintf("/%s", PackFileName(sourcesStamp));
+}
+
+bool GameXmlContent::LoadPackFile(u32 sourcesStamp)
+{
+	eastl::fixed_string<char,512,false> path;
+	PackPath(&path, sourcesStamp);
+
+	if(!FileMapReadOnly(path.data(), &segmentMapping)) {
+		LOG("No baked content pack ('%s'), loading xml", path.data());
+		return false;
+	}
+
+	if(ReadPackSourcesStamp(segmentMapping.data, segmentMapping.size) != sourcesStamp) {
+		FileUnmap(&segmentMapping);
+		LOG("Content xml changed since '%s' was baked, loading xml", path.data());
+		return false;
+	}
+
+	if(!BindSegment(segmentMapping.data, segmentMapping.size, true)) {
+		FileUnmap(&segmentMapping);
+		WARN("Baked content pack '%s' is invalid or outdated, loading xml (rebake it with tools/contentpack)", path.data());
+		return false;
+	}
+	return true;
+}
+
+bool GameXmlContent::SavePack() const
+{
+	ASSERT(segment.size() > 0);
+
+	const u32 sourcesStamp = ReadPackSourcesStamp(segment.data(), segment.size());
+	eastl::fixed_string<char,512,false> path;
+	PackPath(&path, sourcesStamp);
+
+	// written next to it then renamed, processes starting at the same time never map a partial file
+	const char* tmpPath = FMT("%s.%u.tmp", path.data(), GetProcessID());
+	if(!fileSaveBuff(tmpPath, segment.data(), segment.size())) return false;
+
+	if(!FileReplace(tmpPath, path.data())) {
+		remove(tmpPath);
+		WARN("Failed to replace '%s'", path.data());
+		return false;
+	}
+
+	LOG("Baked content pack saved to '%s' (%d bytes)", path.data(), (i32)segment.size());
+
+	// packs of older xml, the ones still mapped stay until the next bake (windows)
+	struct Stale
+	{
+		eastl::fixed_string<char,512,false> dir;
+		FixedStr64 keep; // FMT gets reused below
+	} stale;
+	StrConv(&stale.dir, gameDataDir);
+	stale.keep = PackFileName(sourcesStamp);
+	FileListMatching(stale.dir.data(), "content.*.pack", [](const char* name, void* user) {
+		const Stale& stale = *(Stale*)user;
+		if(stale.keep == name) return;
+		remove(FMT("%s/%s", stale.dir.data(), name));
+	}, &stale);
+	return true;
+}
+
+bool GameXmlContent::SaveAndMapPack()
+{
+	if(!SavePack()) return false;
+
+	eastl::fixed_string<char,512,false> path;
+	PackPath(&path, ReadPackSourcesStamp(segment.data(), segment.size()));
+
+	FileMapping mapping;
+	if(!FileMapReadOnly(path.data(), &mapping)) return false;
+
+	// another process can have replaced it in between, only switch to it when it is the same content
+	if(mapping.size != (i32)segment.size() || memcmp(mapping.data, segment.data(), mapping.size) != 0 ||
+	   !BindSegment(mapping.data, mapping.size, false)) {
+		FileUnmap(&mapping);
+		return false;
+	}
+
+	segmentMapping = mapping;
+	segmentHeap.Release();
+	return true;
+}
+
 bool GameXmlContent::LoadCollisionMeshes()
 {
 	Path path = gameDataDir;
-	PathAppend(path, L"/PVP_DeathMatch01_Collision.physx_static");
-	bool r = FileLoad(&filePvpDeathmatch01Collision, path.data());
+	PathAppend(path, L"/cylinder.physx_dynamic");
+	bool r = FileLoad(&fileCylinderCollision, path.data());
 	if(!r) return false;
 
-	path = gameDataDir;
-	PathAppend(path, L"/PVP_DeathMatch01_Env.physx_static");
-	r = FileLoad(&filePvpDeathmatch01CollisionWalls, path.data());
-	if(!r) return false;
+	return true;
+}
 
-	path = gameDataDir;
-	PathAppend(path, L"/PvP_Death_NM_Wall04.physx_static");
-	r = FileLoad(&filePvpDeathNmWall04, path.data());
-	if(!r) return false;
+// level name (last part of MapList::levelFile) -> baked navmesh
+static const struct { const char* level; const wchar_t* file; } g_MapNavMeshDescList[] = {
+	{ "PVP_DeathMatch", L"/PVP_DeathMatch01.navmesh" },
+};
 
-	path = gameDataDir;
-	PathAppend(path, L"/cylinder.physx_dynamic");
-	r = FileLoad(&fileCylinderCollision, path.data());
-	if(!r) return false;
+bool GameXmlContent::LoadNavMeshes()
+{
+	STATIC_ASSERT(ARRAY_COUNT(g_MapNavMeshDescList) == decltype(navMeshList)::count);
+
+	for(int i = 0; i < (int)navMeshList.size(); i++) {
+		MapNavMesh& nav = navMeshList[i];
+		nav.level = g_MapNavMeshDescList[i].level;
+
+		Path path = gameDataDir;
+		PathAppend(path, g_MapNavMeshDescList[i].file);
+		bool r = FileLoad(&nav.file, path.data());
+		if(!r) return false;
+
+		r = nav.mesh.Load(nav.file);
+		if(!r) {
+			LOG("ERROR: failed to load navmesh '%ls'", path.data());
+			return false;
+		}
+	}
 
 	return true;
 }
 
+// Design/Level/PVP/PVP_DeathMatch -> PVP_DeathMatch
+static const char* LevelName(const char* levelFile)
+{
+	const char* slash = strrchr(levelFile, '/');
+	return slash ? slash + 1 : levelFile;
+}
+
+static void MapCollisionAddFile(GameXmlContent::MapCollisionFiles* out, const char* name, i32 len)
+{
+	foreach_const(it, out->files) {
+		if(EA::StdC::Strnicmp(it->data(), name, len) == 0 && (i32)it->size() == len) return;
+	}
+
+	if(out->files.full()) {
+		WARN("Level '%s' has more than %d collision files, '%.*s' ignored", out->level.data(), (i32)out->files.max_size(), len, name);
+		return;
+	}
+	out->files.push_back().assign(name, len);
+}
+
+// The map list only names the level of a map, its collision files are found in gamedata:
+// - the meshes of the level itself: <level><number>_<part> (PVP_DeathMatch01_Collision)
+// - the dynamic props the level preloads (<level file>/PreLoad.xml) under their key name (PvP_Death_NM_Wall04)
+bool GameXmlContent::LoadMapCollisionList()
+{
+	eastl::fixed_string<char,512,false> dir;
+	StrConv(&dir, gameDataDir);
+
+	// every collision file of gamedata (.msh and .physx_static of the same mesh once), listed once
+	typedef eastl::fixed_vector<FixedStr64,64,true> FileNameList;
+	FileNameList meshFiles;
+	FileListMatching(dir.data(), "*", [](const char* name, void* user) {
+		const char* ext = strrchr(name, '.');
+		if(!ext || (strcmp(ext, ".physx_static") != 0 && strcmp(ext, ".msh") != 0)) return;
+
+		FileNameList& list = *(FileNameList*)user;
+		const FixedStr64 baseName(name, ext - name);
+		if(eastl::find(list.begin(), list.end(), baseName) == list.end()) {
+			list.push_back(baseName);
+		}
+	}, &meshFiles);
+
+	mapCollisionList.clear();
+	eastl::fixed_vector<const char*,decltype(maplists)::kMaxSize,false> levelsDone; // map list entries share levels
+	foreach_const(ml, maplists) {
+		const char* level = LevelName(ml->levelFile.data());
+		if(level[0] == 0) continue;
+
+		bool done = false;
+		foreach_const(it, levelsDone) {
+			if(EA::StdC::Stricmp(*it, level) == 0) {
+				done = true;
+				break;
+			}
+		}
+		if(done) continue;
+		levelsDone.push_back(level);
+
+		MapCollisionFiles coll;
+		coll.level = level;
+
+		foreach_const(it, meshFiles) {
+			if(EA::StdC::Strnicmp(it->data(), level, coll.level.size()) != 0) continue;
+			if(!isdigit((u8)(*it)[coll.level.size()])) continue; // PVP_DeathMatch_bush is another level
+			MapCollisionAddFile(&coll, it->data(), it->size());
+		}
+		if(coll.files.empty()) continue; // not playable, its props don't matter
+
+		// the directory order is the file system's
+		eastl::sort(coll.files.begin(), coll.files.end());
+
+		i32 preloadSize;
+		u8* preloadData = fileOpenAndReadAll(FMT("%s/%s/PreLoad.xml", dir.data(), ml->levelFile.data()), &preloadSize);
+		if(preloadData) {
+			defer(memFree(preloadData));
+
+			XMLDocument doc;
+			if(doc.Parse((const char*)preloadData, preloadSize) != XML_SUCCESS) {
+				WARN("Level '%s': failed to parse PreLoad.xml (%s), its props have no collision", level, doc.ErrorStr());
+			}
+
+			XMLElement* pInfo = doc.FirstChildElement("MAP_INFO");
+			pInfo = pInfo ? pInfo->FirstChildElement("PRE_LOAD_INFO") : nullptr;
+			for(XMLElement* pSet = pInfo ? pInfo->FirstChildElement("PreLoadSet") : nullptr; pSet; pSet = pSet->NextSiblingElement("PreLoadSet")) {
+				const char* type = pSet->Attribute("Type");
+				if(!type || strcmp(type, "ENTITY_TYPE_DYNAMIC") != 0) continue;
+
+				XMLElement* pKeyNames = pSet->FirstChildElement("KeyNameList");
+				for(XMLElement* pKey = pKeyNames ? pKeyNames->FirstChildElement("_keyname") : nullptr; pKey; pKey = pKey->NextSiblingElement("_keyname")) {
+					const char* keyname = pKey->Attribute("keyname");
+					if(!keyname) continue;
+
+					// props without collision (the start gate) have no file
+					foreach_const(it, meshFiles) {
+						if(EA::StdC::Stricmp(it->data(), keyname) == 0) {
+							MapCollisionAddFile(&coll, it->data(), it->size());
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		if(coll.files.empty()) continue;
+		if(mapCollisionList.full()) {
+			WARN("More than %d levels with collision files, '%s' ignored", (i32)mapCollisionList.max_size(), level);
+			continue;
+		}
+
+		LOG("Level '%s': %d collision files", level, (i32)coll.files.size());
+		mapCollisionList.push_back(coll);
+	}
+	return true;
+}
+
 bool GameXmlContent::LoadAnimationData()
 {
 	XMLDocument xmlAniLength;
@@ -858,7 +1084,7 @@ bool GameXmlContent::LoadAnimationData()
 	ActionStateID prevActionID = ActionStateID::INVALID;
 	i32 actionSliceStart = 0;
 	i32 actionSliceCount = 0;
-	Action* curAction = nullptr;
+	XmlStaging::Action* curAction = nullptr;
 	f32 accumulatedDelay = 0;
 
 	for(XMLElement* pActionBase = xmlActionBase.FirstChildElement()->FirstChildElement();
@@ -875,11 +1101,11 @@ bool GameXmlContent::LoadAnimationData()
 			LOG("%s:", classStr.data());
 
 			if(actionSliceCount > 0) {
-				actionListMap.emplace(prevMasterClassType, Slice<Action>(&actionList[actionSliceStart], actionSliceCount));
+				xml->actionListMap.emplace(prevMasterClassType, Slice<XmlStaging::Action>(&xml->actionList[actionSliceStart], actionSliceCount));
 			}
 
 			prevMasterClassType = masterClassType;
-			actionSliceStart = actionList.size();
+			actionSliceStart = xml->actionList.size();
 			actionSliceCount = 0;
 			prevActionID = ActionStateID::INVALID;
 		}
@@ -897,16 +1123,16 @@ bool GameXmlContent::LoadAnimationData()
 
 			bool foundAction = false;
 			for(int i = actionSliceStart; i < actionSliceStart+actionSliceCount; i++) {
-				if(actionList[i].ID == actionID) {
-					curAction = &actionList[i];
+				if(xml->actionList[i].ID == actionID) {
+					curAction = &xml->actionList[i];
 					foundAction = true;
 					break;
 				}
 			}
 
 			if(!foundAction) {
-				actionList.push_back();
-				curAction = &actionList.back();
+				xml->actionList.push_back();
+				curAction = &xml->actionList.back();
 				actionSliceCount++;
 				curAction->ID = actionID;
 				auto foundSeq = aniLenListMap.find(masterClassType);
@@ -933,7 +1159,7 @@ bool GameXmlContent::LoadAnimationData()
 			continue;
 		}
 
-		Action::Command cmd;
+		Action::Command cmd = {}; // zero the unused union bytes, the command is baked as is
 		cmd.type = ActionCommand::TypeFromString(CommandType);
 		if(pActionBase->QueryAttribute("Delay", &cmd.delay) != XMLError::XML_SUCCESS) {
 			cmd.delay = 0.0f;
@@ -982,6 +1208,8 @@ bool GameXmlContent::LoadAnimationData()
 			case ActionCommand::Type::ROTATESPEED: {
 				pActionBase->QueryAttribute("Param1", &cmd.rotateSpeed.speed);
 			} break;
+
+			default: break; // no parameters read yet
 		}
 
 		curAction->commands.push_back(cmd);
@@ -1004,16 +1232,95 @@ bool GameXmlContent::LoadAnimationData()
 			case ActionCommand::Type::ROTATESPEED: {
 				LOG("		  speed=%d", cmd.rotateSpeed.speed);
 			} break;
+
+			default: break;
 		}
 	}
 
 	if(actionSliceCount > 0) {
-		actionListMap.emplace(prevMasterClassType, Slice<Action>(&actionList[actionSliceStart], actionSliceCount));
+		xml->actionListMap.emplace(prevMasterClassType, Slice<XmlStaging::Action>(&xml->actionList[actionSliceStart], actionSliceCount));
 	}
 
 	return true;
 }
 
+bool GameXmlContent::CompileSkillActions()
+{
+	// Actions never change once loaded, so resolve everything the skill programs need here:
+	// - one flat op list (no per tick hash lookup + linear search in the class action slice)
+	// - a (class, action) -> compiled action table
+	// - move distance/duration precomputed for the cast
+	foreach(row, compiledActionTable) {
+		row->fill(CompiledActionIdx::INVALID);
+	}
+
+	foreach_const(action, actionList) {
+		const ClassType classType = action->classType;
+		if(classType == ClassType::NONE) continue;
+		ASSERT((i32)classType > 0 && classType < ClassType::MAX);
+
+		{
+			ASSERT(action->ID != ActionStateID::INVALID && action->ID < ActionStateID::ACTION_STATE_TYPE_MAX);
+
+			CompiledAction& ca = compiledActionList.push_back();
+			ca.ID = action->ID;
+			ca.classType = classType;
+			ca.opStart = skillOpList.size();
+			ca.opCount = action->commandCount;
+			ca.seqLength = action->seqLength;
+			ca.moveDistance = 0;
+			ca.moveDuration = 0;
+
+			foreach_const(cmd, GetActionCommands(*action)) {
+				SkillOp& op = skillOpList.push_back();
+				op.code = SkillOp::Code::NOP;
+				op.chain = cmd->delay == 0;
+				op.delay = cmd->delay;
+				op.endTime = cmd->relativeEndTimeFromStart;
+
+				switch(cmd->type) {
+					case ActionCommand::Type::STATE_BLOCK: {
+						op.code = SkillOp::Code::LOCK_MOVE;
+					} break;
+
+					case ActionCommand::Type::GRAPH_MOVE_HORZ: {
+						op.move.distance = cmd->graphMoveHorz.distance;
+						op.move.duration = action->seqLength;
+						op.code = SkillOp::Code::MOVE;
+					} break;
+
+					case ActionCommand::Type::MOVE: {
+						if(cmd->move.preset == ActionCommand::MovePreset::WARP) {
+							op.move.distance = (f32)cmd->move.param2;
+							op.move.duration = 0.01f; // warping
+							op.code = SkillOp::Code::MOVE;
+						}
+					} break;
+
+					case ActionCommand::Type::REMOTE: {
+						op.remote.idx = cmd->remote.idx;
+						op.remote.targetPreset = cmd->remote.targetPreset;
+						op.code = SkillOp::Code::REMOTE;
+					} break;
+
+					default: break; // ROTATESPEED and the others don't affect the cast yet, NOP
+				}
+
+				if(op.code == SkillOp::Code::MOVE) {
+					ca.moveDistance = op.move.distance;
+					ca.moveDuration = op.move.duration;
+					if(op.move.distance == 0) op.code = SkillOp::Code::NOP; // nothing to move, but the cast still reports it
+				}
+			}
+
+			compiledActionTable[(i32)classType][(i32)action->ID] = CompiledActionIdx(compiledActionList.size() - 1);
+		}
+	}
+
+	LOG("Skill actions compiled (actions=%d ops=%d)", (i32)compiledActionList.size(), (i32)skillOpList.size());
+	return true;
+}
+
 bool GameXmlContent::LoadRemoteData()
 {
 	// TODO: use these everywhere?
@@ -1025,10 +1332,10 @@ bool GameXmlContent::LoadRemoteData()
 	T V = V_DEFAULT;\
 	pComp->QueryAttribute(#V, &V)\
 
-	XMLDocument xml;
-	if(!LoadXMLFile(L"/REMOTE_PC.xml", xml)) return false;
+	XMLDocument xmlRemote;
+	if(!LoadXMLFile(L"/REMOTE_PC.xml", xmlRemote)) return false;
 
-	for(XMLElement* pEntityInfo = xml.FirstChildElement()->FirstChildElement();
+	for(XMLElement* pEntityInfo = xmlRemote.FirstChildElement()->FirstChildElement();
 		pEntityInfo;
 		pEntityInfo = pEntityInfo->NextSiblingElement()) {
 
@@ -1058,6 +1365,7 @@ bool GameXmlContent::LoadRemoteData()
 				ELT_GET(pComp, bool, _VsNPC_Monster, false);
 				ELT_GET(pComp, bool, _VsPC, false);
 
+				remote.boundSize = { (u16)_LengthX, (u16)_LengthY, (u16)_LengthZ };
 				remote.boundType = Remote::BoundTypeFromString(_Type);
 				remote.damageGroup = Remote::DamageGroupFromString(_DamageGroup);
 				remote.vs =
@@ -1071,7 +1379,13 @@ bool GameXmlContent::LoadRemoteData()
 
 			else if((EA::StdC::Strcmp("RemoteComData2", compName) == 0)) {
 				ELT_GET(pComp, i32, _ActivateCount, 0);
-				ELT_GET(pComp, i32, _AttackMultiplier, 0);
+				ELT_GET(pComp, f32, _AttackMultiplier, 0);
+				ELT_GET(pComp, f32, _LifeTime, 0);
+				ELT_GET(pComp, i32, _PenetrationCount, 0);
+
+				remote.attackMultiplier = _AttackMultiplier;
+				remote.lifeTime = _LifeTime;
+				remote.penetrationCount = _PenetrationCount;
 
 				const char* _BehaviorType = 0;
 				pComp->QueryStringAttribute("_BehaviorType", &_BehaviorType);
@@ -1079,54 +1393,73 @@ bool GameXmlContent::LoadRemoteData()
 					remote.behaviorType = Remote::BehaviourTypeFromString(_BehaviorType);
 				}
 
-				LOG("	_ActivateCount=%d _ActivateMultiplier=%d", _ActivateCount, _AttackMultiplier);
+				LOG("	_ActivateCount=%d _AttackMultiplier=%g", _ActivateCount, _AttackMultiplier);
 				LOG("	_BehaviorType=%s", Remote::BehaviourTypeToString(remote.behaviorType));
+				LOG("	_LifeTime=%g _PenetrationCount=%d", _LifeTime, _PenetrationCount);
+			}
+
+			else if((EA::StdC::Strcmp("RemoteTargetComData", compName) == 0)) {
+				ELT_GET(pComp, f32, _HitInvalidTime, 0);
+				remote.hitInvalidTime = _HitInvalidTime;
+			}
+
+			else if((EA::StdC::Strcmp("RemoteGraphComData", compName) == 0)) {
+				ELT_GET(pComp, i32, _FixedGraphLength, 0);
+				remote.graphLength = (u16)_FixedGraphLength;
+			}
+
+			else if((EA::StdC::Strcmp("SteeringBehaviorsComData", compName) == 0)) {
+				ELT_GET(pComp, f32, _MaxSpeed, 0);
+				ELT_GET(pComp, f32, _AngularVel, 0);
+				remote.maxSpeed = _MaxSpeed;
+				remote.angularVel = _AngularVel;
 			}
 		}
 
-		remoteMap.emplace(remote.ID, remote);
+		xml->remoteMap.emplace(remote.ID, remote);
 	}
 
 	return true;
 }
 
-bool GameXmlContent::Load()
+bool GameXmlContent::LoadPackOrStageXml()
 {
-	LOG("Loading GameContent...");
-
-	bool r = LoadMasterDefinitions();
-	if(!r) return false;
-
-	r = LoadMasterSkinsDefinitions();
-	if(!r) return false;
-
-	r = LoadMasterWeaponDefinitions();
-	if(!r) return false;
-
-	r = LoadMasterDefinitionsModel();
-	if (!r) return false;
-
-	r = LoadMapList();
-	if (!r) return false;
+	// taken before reading anything, a file modified while loading makes the pack outdated
+	const u32 sourcesStamp = ContentSourcesStamp();
 
-	r = LoadLobby(160000042);
-	if (!r) return false;
+	if(loadSource == Source::ANY || loadSource == Source::PACK) {
+		loadedFromPack = LoadPackFile(sourcesStamp);
+		if(loadedFromPack) return true;
+		if(loadSource == Source::PACK) return false;
+	}
 
-	r = LoadPvpDeathmach();
-	if (!r) return false;
+	// the xml stages only run when there is staging data
+	xml = new XmlStaging();
+	xml->sourcesStamp = sourcesStamp;
+	return true;
+}
 
-	r = LoadJukeboxSongs();
-	if(!r) return false;
+bool GameXmlContent::BakeXml()
+{
+	if(!xml) return true; // loaded from the pack
 
-	r = LoadCollisionMeshes();
+	bool r = BakePack(&segmentHeap);
+	delete xml;
+	xml = nullptr;
 	if(!r) return false;
 
-	r = LoadAnimationData();
+	r = BindSegment(segmentHeap.data, segmentHeap.size, false);
 	if(!r) return false;
 
-	r = LoadRemoteData();
-	if(!r) return false;
+	// first process of the host to get here, the next ones will map the pack
+	if((loadSource == Source::ANY || loadSource == Source::XML_REBAKE) && !SaveAndMapPack()) {
+		WARN("Content pack could not be saved, the content segment is private to this process");
+	}
+	return true;
+}
 
+bool GameXmlContent::FinishLoad()
+{
 	/*
 	LOG("Masters:");
 	eastl::fixed_string<char,1024> buff;
@@ -1163,10 +1496,102 @@ bool GameXmlContent::Load()
 	}
 	*/
 
-	LOG("GameContent successfully loaded.");
+	LOG("GameContent successfully loaded from %s (%.2fms, segment=%d bytes %s)", loadedFromPack ? "baked pack" : "xml",
+		TimeDurationSinceMs(loadStart), (i32)segment.size(), segmentMapping.data ? "shared" : "private");
 	return true;
 }
 
+void GameXmlContent::AddLoadStages(StartupGraph* graph, Source source, LoadStages* out)
+{
+	MEM_TAG(MemTag::CONTENT); // stages allocate under it
+	LOG("Loading GameContent...");
+	loadSource = source;
+	loadStart = TimeNow();
+
+#define STAGE(NAME, CALL) graph->AddStage(NAME, [](void* object) { return ((GameXmlContent*)object)->CALL; }, this)
+	// skipped when loaded from the pack
+#define XML_STAGE(NAME, CALL) graph->AddStage(NAME, [](void* object) { GameXmlContent& c = *(GameXmlContent*)object; return !c.xml || c.CALL; }, this)
+
+	const auto pack = STAGE("content pack", LoadPackOrStageXml());
+
+	const auto masters = XML_STAGE("xml masters", LoadMasterDefinitions());
+	const auto skins = XML_STAGE("xml skins", LoadMasterSkinsDefinitions());
+	const auto weapons = XML_STAGE("xml weapons", LoadMasterWeaponDefinitions());
+	const auto skills = XML_STAGE("xml skills", LoadMasterDefinitionsModel());
+	const auto maplist = XML_STAGE("xml map list", LoadMapList());
+	const auto lobby = XML_STAGE("xml lobby", LoadLobby(160000042));
+	const auto pvp = XML_STAGE("xml pvp deathmatch", LoadPvpDeathmach());
+	const auto jukebox = XML_STAGE("xml jukebox", LoadJukeboxSongs());
+	const auto animation = XML_STAGE("xml animation", LoadAnimationData());
+	const auto remotes = XML_STAGE("xml remotes", LoadRemoteData());
+	const auto bake = STAGE("bake content", BakeXml());
+
+	// already binary, not part of the pack
+	const auto collision = STAGE("collision files", LoadCollisionMeshes());
+	const auto navmesh = STAGE("navmesh", LoadNavMeshes());
+	const auto mapCollision = STAGE("map collision files", LoadMapCollisionList());
+
+	const auto compile = STAGE("compile skill actions", CompileSkillActions());
+	const auto done = STAGE("content done", FinishLoad());
+
+#undef STAGE
+#undef XML_STAGE
+
+	// masters first, skins/weapons/skills each fill their own fields of the masters
+	graph->DependsOn(masters, pack);
+	graph->DependsOn(skins, masters);
+	graph->DependsOn(weapons, masters);
+	graph->DependsOn(skills, masters);
+	graph->DependsOn(maplist, pack);
+	graph->DependsOn(lobby, maplist);
+	graph->DependsOn(pvp, maplist);
+	graph->DependsOn(jukebox, pack);
+	graph->DependsOn(animation, pack);
+	graph->DependsOn(remotes, pack);
+
+	const StartupGraph::StageID xmlStages[] = { skins, weapons, skills, lobby, pvp, jukebox, animation, remotes };
+	for(StartupGraph::StageID stage : xmlStages) {
+		graph->DependsOn(bake, stage);
+	}
+
+	graph->DependsOn(compile, bake);
+	graph->DependsOn(mapCollision, bake); // the map list
+	graph->DependsOn(done, compile);
+	graph->DependsOn(done, collision);
+	graph->DependsOn(done, navmesh);
+	graph->DependsOn(done, mapCollision);
+
+	out->collisionFiles = collision;
+	out->done = done;
+}
+
+GameXmlContent::~GameXmlContent()
+{
+	delete xml;
+
+	if(fileCylinderCollision.data) memFree(fileCylinderCollision.data);
+	foreach(nav, navMeshList) {
+		if(nav->file.data) memFree(nav->file.data);
+	}
+
+	FileUnmap(&segmentMapping);
+}
+
+bool GameXmlContent::Load(Source source)
+{
+	MEM_TAG(MemTag::CONTENT);
+	StartupGraph graph;
+	LoadStages stages;
+	AddLoadStages(&graph, source, &stages);
+
+	const bool r = graph.Run(nullptr);
+	if(!r) {
+		delete xml;
+		xml = nullptr;
+	}
+	return r;
+}
+
 Faction GameXmlContent::StringToFaction(const char* s)
 {
 	static const eastl::hash_map<eastl::string, Faction> factionMap = {
@@ -1269,6 +1694,35 @@ const GameXmlContent::MapList* GameXmlContent::FindMapListByID(i32 index) const
 	return nullptr;
 }
 
+const NavMesh* GameXmlContent::FindNavMesh(MapIndex mapIndex) const
+{
+	const MapList* mapList = FindMapListByID((i32)mapIndex);
+	if(!mapList) return nullptr;
+
+	const char* level = LevelName(mapList->levelFile.data());
+
+	foreach_const(nav, navMeshList) {
+		if(nav->level && nav->mesh.IsLoaded() && EA::StdC::Stricmp(nav->level, level) == 0) {
+			return &nav->mesh;
+		}
+	}
+	return nullptr;
+}
+
+const GameXmlContent::MapCollisionFiles* GameXmlContent::FindMapCollision(MapIndex mapIndex) const
+{
+	const MapList* mapList = FindMapListByID((i32)mapIndex);
+	if(!mapList) return nullptr;
+
+	const char* level = LevelName(mapList->levelFile.data());
+	foreach_const(it, mapCollisionList) {
+		if(EA::StdC::Stricmp(it->level.data(), level) == 0) {
+			return &(*it);
+		}
+	}
+	return nullptr;
+}
+
 const GameXmlContent::Song* GameXmlContent::FindJukeboxSongByID(SongID songID) const
 {
 	foreach(it, jukeboxSongs) {
@@ -1286,40 +1740,279 @@ const GameXmlContent::Master& GameXmlContent::GetMaster(ClassType classType) con
 	return *found->second;
 }
 
-const GameXmlContent::Action& GameXmlContent::GetSkillAction(ClassType classType, ActionStateID actionID) const
+const SkillNormalModel& GameXmlContent::GetSkill(SkillID skillID) const
 {
-	auto found = actionListMap.find(classType);
-	ASSERT(found != actionListMap.end());
+	const SkillNormalModel* skill = FindSkill(skillID);
+	ASSERT(skill);
+	return *skill;
+}
+
+const SkillNormalModel* GameXmlContent::FindSkill(SkillID skillID) const
+{
+	auto found = eastl::lower_bound(skillList.begin(), skillList.end(), skillID, [](const Skill& s, SkillID id) { return s.ID < id; });
+	if(found == skillList.end() || found->ID != skillID) return nullptr;
+	return &found->model;
+}
 
-	foreach_const(it, found->second) {
-		if(it->ID == actionID) {
+const GameXmlContent::Action& GameXmlContent::GetSkillAction(ClassType classType, ActionStateID actionID) const
+{
+	foreach_const(it, actionList) {
+		if(it->classType == classType && it->ID == actionID) {
 			return *it;
 		}
 	}
 
 	ASSERT(0); // not found
-	return actionListMap.cbegin()->second.front(); // unreachable
+	return actionList.front(); // unreachable
+}
+
+GameXmlContent::CompiledActionIdx GameXmlContent::FindCompiledAction(ClassType classType, ActionStateID actionID) const
+{
+	if((i32)classType <= 0 || classType >= ClassType::MAX) return CompiledActionIdx::INVALID;
+	if(actionID <= ActionStateID::INVALID || actionID >= ActionStateID::ACTION_STATE_TYPE_MAX) return CompiledActionIdx::INVALID;
+	return compiledActionTable[(i32)classType][(i32)actionID];
 }
 
 const Remote& GameXmlContent::GetRemote(RemoteIdx remoteID) const
 {
-	auto found = remoteMap.find(remoteID);
-	ASSERT(found != remoteMap.end());
-	return found->second;
+	const Remote* remote = FindRemote(remoteID);
+	ASSERT(remote);
+	return *remote;
+}
+
+const Remote* GameXmlContent::FindRemote(RemoteIdx remoteID) const
+{
+	auto found = eastl::lower_bound(remoteList.begin(), remoteList.end(), remoteID, [](const Remote& r, RemoteIdx id) { return r.ID < id; });
+	if(found == remoteList.end() || found->ID != remoteID) return nullptr;
+	return found;
+}
+
+struct ContentGeneration
+{
+	GameXmlContent* content;
+	u32 version;
+	EA::Thread::AtomicInt32 refCount; // the current generation holds one
+};
+
+// xml files a reload is triggered by (the maps are not reloaded)
+static const wchar* g_ContentSourceFiles[] = {
+	L"/CREATURE_CHARACTER.xml",
+	L"/CHARACTERSKIN.xml",
+	L"/WEAPON.xml",
+	L"/SKILL.xml",
+	L"/SKILL_PROPERTY.xml",
+	L"/MAPLIST.xml",
+	L"/JUKEBOX.xml",
+	L"/AniLength.xml",
+	L"/ActionBase.xml",
+	L"/REMOTE_PC.xml",
+};
+
+enum class ContentReloadState: i32
+{
+	IDLE = 0,
+	RUNNING,
+	DONE,
+	FAILED
+};
+
+static struct ContentGenerations
+{
+	ProfileMutex(Mutex, mutexList);
+	eastl::fixed_vector<ContentGeneration*,16,false> list; // every generation alive, current included
+	ContentGeneration* current = nullptr;
+	u32 nextVersion = 1;
+	u64 sourcesTime = 0; // newest source file at the last load or reload attempt
+
+	EA::Thread::Thread reloadThread;
+	EA::Thread::AtomicInt32 reloadState = (i32)ContentReloadState::IDLE;
+	GameXmlContent* reloaded = nullptr; // set by the reload thread before DONE
+} g_Generations;
+
+static u64 ContentSourcesTime()
+{
+	u64 newest = 0;
+	for(const wchar* file : g_ContentSourceFiles) {
+		Path path = gameDataDir;
+		PathAppend(path, file);
+		eastl::fixed_string<char,512,false> pathUtf8;
+		StrConv(&pathUtf8, path);
+		newest = MAX(newest, FileModifiedTime(pathUtf8.data()));
+	}
+	return newest;
+}
+
+// modification times of every source file, missing ones included
+static u32 ContentSourcesStamp()
+{
+	u64 timeList[ARRAY_COUNT(g_ContentSourceFiles)];
+	for(i32 i = 0; i < (i32)ARRAY_COUNT(g_ContentSourceFiles); i++) {
+		Path path = gameDataDir;
+		PathAppend(path, g_ContentSourceFiles[i]);
+		eastl::fixed_string<char,512,false> pathUtf8;
+		StrConv(&pathUtf8, path);
+		timeList[i] = FileModifiedTime(pathUtf8.data());
+	}
+
+	return hash_fnv1a(timeList, sizeof(timeList));
+}
+
+static void ContentPushGeneration(GameXmlContent* content)
+{
+	ContentGeneration* generation = new ContentGeneration();
+	generation->content = content;
+	generation->refCount.SetValue(1);
+
+	ContentGeneration* previous;
+	{ LOCK_MUTEX(g_Generations.mutexList);
+		generation->version = g_Generations.nextVersion++;
+		previous = g_Generations.current;
+		g_Generations.list.push_back(generation);
+		g_Generations.current = generation;
+		g_GameXmlContent = content;
+	}
+
+	if(previous) {
+		previous->refCount.Decrement();
+		LOG("Content generation %u is current (generation %u still used by %d games)", generation->version, previous->version, previous->refCount.GetValue());
+	}
 }
 
 bool GameXmlContentLoad()
 {
+	g_Generations.sourcesTime = ContentSourcesTime();
+
+	MEM_TAG(MemTag::CONTENT);
 	GameXmlContent* content = new GameXmlContent();
-	g_GameXmlContent = content;
+	ContentPushGeneration(content);
 	return content->Load();
 }
 
+void GameXmlContentAddLoadStages(StartupGraph* graph, GameXmlContent::LoadStages* out)
+{
+	g_Generations.sourcesTime = ContentSourcesTime();
+
+	MEM_TAG(MemTag::CONTENT);
+	GameXmlContent* content = new GameXmlContent();
+	ContentPushGeneration(content);
+	content->AddLoadStages(graph, GameXmlContent::Source::ANY, out);
+}
+
 const GameXmlContent& GetGameXmlContent()
 {
 	return *g_GameXmlContent;
 }
 
+ContentRef ContentAcquire()
+{
+	LOCK_MUTEX(g_Generations.mutexList);
+	ContentGeneration* generation = g_Generations.current;
+	ASSERT(generation);
+	generation->refCount.Increment();
+
+	ContentRef ref;
+	ref.content = generation->content;
+	ref.generation = generation;
+	ref.version = generation->version;
+	return ref;
+}
+
+void ContentRelease(ContentRef* ref)
+{
+	if(!ref->generation) return;
+
+	// freed by ContentUpdate, never on the releasing thread
+	ref->generation->refCount.Decrement();
+	ref->content = nullptr;
+	ref->generation = nullptr;
+}
+
+u32 ContentCurrentVersion()
+{
+	LOCK_MUTEX(g_Generations.mutexList);
+	ASSERT(g_Generations.current);
+	return g_Generations.current->version;
+}
+
+static intptr_t ThreadContentReload(void* pData)
+{
+	ProfileSetThreadName("ContentReload");
+	EA::Thread::SetThreadPriority(EA::Thread::kThreadPriorityMin); // lanes first
+	MEM_TAG(MemTag::CONTENT);
+
+	GameXmlContent* content = new GameXmlContent();
+	if(!content->Load(GameXmlContent::Source::XML_REBAKE)) {
+		delete content;
+		g_Generations.reloadState.SetValue((i32)ContentReloadState::FAILED);
+		return 0;
+	}
+
+	g_Generations.reloaded = content;
+	g_Generations.reloadState.SetValue((i32)ContentReloadState::DONE);
+	return 0;
+}
+
+bool ContentReloadStart()
+{
+	if(g_Generations.reloadState.GetValue() != (i32)ContentReloadState::IDLE) return false;
+
+	// taken before loading, files modified while loading trigger another reload
+	g_Generations.sourcesTime = ContentSourcesTime();
+
+	LOG("Reloading content in the background...");
+	g_Generations.reloadState.SetValue((i32)ContentReloadState::RUNNING);
+	g_Generations.reloadThread.Begin(ThreadContentReload, nullptr);
+	return true;
+}
+
+bool ContentSourcesChanged()
+{
+	return ContentSourcesTime() != g_Generations.sourcesTime;
+}
+
+void ContentUpdate()
+{
+	const ContentReloadState state = (ContentReloadState)g_Generations.reloadState.GetValue();
+	if(state == ContentReloadState::DONE || state == ContentReloadState::FAILED) {
+		g_Generations.reloadThread.WaitForEnd(); // already returned
+
+		if(state == ContentReloadState::DONE) {
+			ContentPushGeneration(g_Generations.reloaded);
+			g_Generations.reloaded = nullptr;
+		}
+		else {
+			WARN("Content reload failed, generation %u stays current", g_Generations.current->version);
+		}
+
+		g_Generations.reloadState.SetValue((i32)ContentReloadState::IDLE);
+	}
+
+	// free the generations no game uses anymore, outside of the lock
+	eastl::fixed_vector<ContentGeneration*,16,false> freeList;
+	{ LOCK_MUTEX(g_Generations.mutexList);
+		for(auto it = g_Generations.list.begin(); it != g_Generations.list.end();) {
+			if(*it != g_Generations.current && (*it)->refCount.GetValue() == 0) {
+				freeList.push_back(*it);
+				it = g_Generations.list.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+
+	foreach_const(it, freeList) {
+		LOG("Content generation %u freed", (*it)->version);
+		delete (*it)->content;
+		delete *it;
+	}
+}
+
+const Path& GameDataDir()
+{
+	return gameDataDir;
+}
+
 bool OpenMeshFile(const char* path, MeshFile* out)
 {
 	struct MeshFileHeader
@@ -3,6 +3,7 @@
 #include <tinyxml2.h>
 #include <common/protocol.h>
 #include <common/utils.h>
+#include <common/startup_graph.h>
 #include <EASTL/fixed_list.h>
 #include <EASTL/fixed_hash_map.h>
 #include <EASTL/fixed_map.h>
@@ -10,6 +11,7 @@
 #include "model/character_model.h"
 #include "model/weapon_model.h"
 #include "model/weapon_spec.h"
+#include "navmesh.h"
 
 namespace ActionCommand {
 
@@ -166,9 +168,16 @@ struct Remote
 	DamageGroup damageGroup = DamageGroup::INVALID;
 	BehaviorType behaviorType = BehaviorType::INVALID;
 
-	eastl::array<u16,3> boundSize;
+	eastl::array<u16,3> boundSize = { 0, 0, 0 };
 	u8 vs = 0;
 
+	f32 lifeTime = 0;
+	i32 penetrationCount = 0;
+	f32 hitInvalidTime = 0; // an actor can't be hit again by the same remote before this much time has passed
+	u16 graphLength = 0; // RemoteGraphComData _FixedGraphLength
+	f32 attackMultiplier = 0; // damage = caster attack * attackMultiplier
+	f32 maxSpeed = 0; // SteeringBehaviorsComData, homing remotes
+	f32 angularVel = 0; // radians per second, 0 turns instantly
 };
 
 struct GameXmlContent
@@ -272,8 +281,63 @@ struct GameXmlContent
 		};
 
 		ActionStateID ID;
-		f32 seqLength = 0.0f; // seconds
-		eastl::fixed_vector<Command,16,false> commands;
+		ClassType classType; // NONE when the action is not used by a class
+		f32 seqLength; // seconds
+		u32 commandStart; // in actionCommandList
+		u32 commandCount;
+	};
+
+	struct Skill
+	{
+		SkillID ID;
+		SkillNormalModel model;
+	};
+
+	// Action commands compiled to a flat instruction stream at load time (see CompileSkillActions)
+	// One op per command so op indices match the action command indices
+	struct SkillOp
+	{
+		enum class Code: u8
+		{
+			NOP = 0, // command we don't simulate (yet), still takes time
+			LOCK_MOVE, // STATE_BLOCK
+			MOVE, // GRAPH_MOVE_HORZ, MOVE (WARP)
+			REMOTE,
+		};
+
+		Code code;
+		u8 chain; // next op is executed on the same tick (Delay=0)
+		f32 delay;
+		f32 endTime; // seconds, relative to program start
+
+		union {
+			struct {
+				f32 distance;
+				f32 duration;
+			} move;
+
+			struct {
+				RemoteIdx idx;
+				ActionCommand::TargetPreset targetPreset;
+			} remote;
+		};
+	};
+
+	enum class CompiledActionIdx: u16 {
+		INVALID = 0xFFFF
+	};
+
+	struct CompiledAction
+	{
+		ActionStateID ID;
+		ClassType classType;
+		u16 opStart;
+		u16 opCount;
+		f32 seqLength;
+
+		// last move of the program, used to compute the end position when casting
+		f32 moveDistance;
+		f32 moveDuration;
 	};
 
 	eastl::fixed_vector<Master,100,false> masters;
@@ -281,29 +345,130 @@ struct GameXmlContent
 	eastl::fixed_hash_map<size_t,Master*,100> masterClassStringMap;
 	eastl::fixed_hash_map<ClassType,Master*,100> masterClassTypeMap;
 	eastl::fixed_vector<MapList, 500, false> maplists;
-	eastl::fixed_hash_map<SkillID, SkillNormalModel, 500> skillMap;
-	eastl::fixed_vector<Action, 2000, false> actionList;
-	eastl::fixed_hash_map<ClassType, Slice<Action>, 800> actionListMap;
+
+	// Content segment: the baked pack (see content_pack.cpp) the big read-only tables point into.
+	// Mapped from gamedata/content.<xml stamp>.pack it is shared by every server process of the host,
+	// it is a private copy when the content had to be loaded from the xml and the pack could not be saved.
+	Slice<const u8> segment;
+	Slice<const Skill> skillList; // sorted by ID
+	Slice<const Action> actionList; // actions of a class are contiguous
+	Slice<const Action::Command> actionCommandList;
+
+	eastl::fixed_vector<SkillOp, 4096, false> skillOpList;
+	eastl::fixed_vector<CompiledAction, 2000, false> compiledActionList;
+	eastl::array<eastl::array<CompiledActionIdx, (i32)ActionStateID::ACTION_STATE_TYPE_MAX>, (i32)ClassType::MAX> compiledActionTable;
 
 	Map mapLobby;
 	Map mapPvpDeathMatch;
 
 	eastl::fixed_vector<Song,60,false> jukeboxSongs;
 
-	FileBuffer filePvpDeathmatch01Collision;
-	FileBuffer filePvpDeathmatch01CollisionWalls;
-	FileBuffer filePvpDeathNmWall04;
-	FileBuffer fileCylinderCollision;
+	FileBuffer fileCylinderCollision; // map collision meshes are loaded on demand, see PhysicsContext::AcquireMapCollision
+
+	// one per level, shared by every game played on it (see FindNavMesh)
+	struct MapNavMesh
+	{
+		const char* level;
+		FileBuffer file;
+		NavMesh mesh;
+	};
+
+	eastl::array<MapNavMesh,1> navMeshList;
+
+	// collision files of a level, found in gamedata from the map list (see LoadMapCollisionList), loaded by the game server physics
+	struct MapCollisionFiles
+	{
+		FixedStr64 level;
+		eastl::fixed_vector<FixedStr64,8,false> files; // gamedata/<file>.physx_static (or .msh)
+	};
 
-	bool Load();
+	eastl::fixed_vector<MapCollisionFiles,16,false> mapCollisionList;
+
+	enum class Source: u8
+	{
+		ANY = 0, // baked pack when there is a valid one baked from the current xml, XML otherwise (and the pack is rebaked)
+		XML,
+		PACK,
+		XML_REBAKE, // XML, then replaces the pack with it (the xml changed)
+	};
+
+	~GameXmlContent();
+
+	// Content load as startup stages, loaders that don't depend on each other run in parallel when the graph has a scheduler
+	struct LoadStages
+	{
+		StartupGraph::StageID collisionFiles; // body collision mesh file is in memory
+		StartupGraph::StageID done;
+	};
+
+	void AddLoadStages(StartupGraph* graph, Source source, LoadStages* out);
+	bool Load(Source source = Source::ANY); // every stage on the calling thread
+
+	// Baked content pack (tools/contentpack), see content_pack.cpp
+	bool SavePack() const; // writes the content segment to gamedata/content.<xml stamp>.pack, removes the older ones
 
 	const MapList* FindMapListByID(i32 index) const;
+	const NavMesh* FindNavMesh(MapIndex mapIndex) const;
+	const MapCollisionFiles* FindMapCollision(MapIndex mapIndex) const; // null when the level has no collision file
 	const Song* FindJukeboxSongByID(SongID songID) const;
 	const Master& GetMaster(ClassType classType) const;
+	const SkillNormalModel& GetSkill(SkillID skillID) const;
+	const SkillNormalModel* FindSkill(SkillID skillID) const;
 	const Action& GetSkillAction(ClassType classType, ActionStateID actionID) const;
+	CompiledActionIdx FindCompiledAction(ClassType classType, ActionStateID actionID) const;
 	const Remote& GetRemote(RemoteIdx remoteID) const;
+	const Remote* FindRemote(RemoteIdx remoteID) const;
+	inline Slice<const Remote> GetRemoteList() const { return remoteList; } // sorted by ID
+
+	inline Slice<const Action::Command> GetActionCommands(const Action& action) const { return actionCommandList.subspan(action.commandStart, action.commandCount); }
+	inline const CompiledAction& GetCompiledAction(CompiledActionIdx idx) const { return compiledActionList[(i32)idx]; }
+	inline const SkillOp* GetSkillOps(const CompiledAction& action) const { return &skillOpList[action.opStart]; }
 
 private:
+	// only alive while loading the xml, baked into the content segment afterwards
+	struct XmlStaging
+	{
+		struct Action
+		{
+			ActionStateID ID;
+			f32 seqLength = 0.0f; // seconds
+			eastl::fixed_vector<GameXmlContent::Action::Command,16,false> commands;
+		};
+
+		tinyxml2::XMLDocument xmlSKILL;
+		tinyxml2::XMLDocument xmlSKILLPROPERTY;
+		tinyxml2::XMLDocument xmlCREATURECHARACTER;
+		tinyxml2::XMLDocument xmlWEAPON;
+		tinyxml2::XMLDocument xmlWEAPONTT;
+
+		eastl::fixed_hash_map<SkillID, SkillNormalModel, 500> skillMap;
+		eastl::fixed_vector<Action, 2000, false> actionList;
+		eastl::fixed_hash_map<ClassType, Slice<Action>, 800> actionListMap;
+		eastl::fixed_hash_map<RemoteIdx, Remote, 1500> remoteMap;
+
+		u32 sourcesStamp; // taken before reading the files, stored in the pack
+	};
+
+	XmlStaging* xml = nullptr;
+	FileMapping segmentMapping = {};
+	GrowableBuffer segmentHeap;
+	Slice<const Remote> remoteList; // sorted by ID
+
+	Source loadSource = Source::ANY;
+	bool loadedFromPack = false;
+	Time loadStart = Time::ZERO;
+
+	bool LoadPackFile(u32 sourcesStamp); // false when there is none, it is invalid or the xml changed since it was baked
+	bool LoadPackOrStageXml();
+	bool BakeXml();
+	bool FinishLoad();
+	bool SaveAndMapPack();
+
+	// content_pack.cpp
+	bool BakePack(GrowableBuffer* out) const; // from the xml staging data
+	bool BindSegment(const u8* data, i32 size, bool loadTables);
+	static u32 ReadPackSourcesStamp(const u8* data, i32 size); // 0 when it is not a pack
+
 	bool LoadXMLFile(const wchar* fileName, tinyxml2::XMLDocument& xmlData);
 
 	bool LoadMasterDefinitions();
@@ -322,7 +487,10 @@ private:
 	bool LoadPvpDeathmach();
 	bool LoadJukeboxSongs();
 	bool LoadCollisionMeshes();
+	bool LoadNavMeshes(); // baked with tools/navmesh
+	bool LoadMapCollisionList();
 	bool LoadAnimationData();
+	bool CompileSkillActions();
 	bool LoadRemoteData(); // Any object created by skills (projectiles, explosions, etc): a "remote"
 
 	// helper functions
@@ -333,19 +501,36 @@ private:
 	GameSubModeType StringToGameSubModeType(const char* s);
 	MapType StringToMapType(const char* s);
 	SkillType StringToSkillType(const char* s);
-	
-	tinyxml2::XMLDocument xmlSKILL;
-	tinyxml2::XMLDocument xmlSKILLPROPERTY;
-	tinyxml2::XMLDocument xmlCREATURECHARACTER;
-	tinyxml2::XMLDocument xmlWEAPON;
-	tinyxml2::XMLDocument xmlWEAPONTT;
-
-	eastl::fixed_hash_map<RemoteIdx, Remote, 1500> remoteMap;
 };
 
 bool GameXmlContentLoad();
-const GameXmlContent& GetGameXmlContent();
+void GameXmlContentAddLoadStages(StartupGraph* graph, GameXmlContent::LoadStages* out);
+const GameXmlContent& GetGameXmlContent(); // current generation, see ContentRef
+
+// Content generations, the content can be reloaded without restarting the server.
+// A reload loads a new generation in the background, ContentUpdate then makes it the current one.
+// A game holds a reference on the generation it started with until it ends, so it never sees the content change.
+// A generation is freed (by ContentUpdate) once it is not the current one and not referenced anymore.
+struct ContentGeneration;
+
+struct ContentRef
+{
+	const GameXmlContent* content = nullptr;
+	ContentGeneration* generation = nullptr;
+	u32 version = 0;
+};
+
+// Thread: Any
+ContentRef ContentAcquire(); // current generation
+void ContentRelease(ContentRef* ref);
+u32 ContentCurrentVersion();
+
+// Thread: Owner (the thread calling GetGameXmlContent without a reference, the coordinator)
+bool ContentReloadStart(); // false when a reload is already running
+bool ContentSourcesChanged(); // an xml file was modified since the current generation was loaded
+void ContentUpdate(); // publishes a finished reload, frees unreferenced generations
 
+const Path& GameDataDir();
 bool OpenMeshFile(const char* path, MeshFile* out);
 
 constexpr const char* g_ResultErrorString[] = {
@@ -41,6 +41,7 @@ public:
 private:
 	i32 _SkillIndex = 0;
 	i8 _Level = 0;
+	i8 _pad[3] = {}; // explicit so copies are byte identical (baked content pack)
 	float _BaseDamage = 0.0f; //int?
 	float _AttackMultiplier = 0.0f;
 	float _CoolTime = 0.0f; //int?
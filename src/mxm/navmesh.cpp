@@ -0,0 +1,525 @@
+#include "navmesh.h"
+#include <EASTL/heap.h>
+#include <glm/geometric.hpp>
+#include <float.h>
+
+inline f32 Cross2(const vec2& u, const vec2& v)
+{
+	return u.x * v.y - u.y * v.x;
+}
+
+// bigger than the bake weld distance
+static const f32 RAYCAST_MAX_HEIGHT_GAP = 10;
+
+inline bool VecEqual2(const vec2& a, const vec2& b)
+{
+	const vec2 d = b - a;
+	return glm::dot(d, d) < 0.0001f;
+}
+
+bool NavMesh::Load(const FileBuffer& file)
+{
+	STATIC_ASSERT(sizeof(vec3) == sizeof(f32) * 3);
+
+	ConstBuffer buff(file.data, file.size);
+	if(!buff.CanRead(sizeof(NavMeshFile::Header))) {
+		LOG("ERROR(NavMesh): file is too small (%d)", file.size);
+		return false;
+	}
+
+	const NavMeshFile::Header& header = buff.Read<NavMeshFile::Header>();
+	if(header.magic != NavMeshFile::MAGIC) {
+		LOG("ERROR(NavMesh): not a navmesh file");
+		return false;
+	}
+	if(header.version != NavMeshFile::VERSION) {
+		LOG("ERROR(NavMesh): version not supported (%d)", header.version);
+		return false;
+	}
+
+	const i32 verticesSize = sizeof(vec3) * header.vertexCount;
+	const i32 polysSize = sizeof(NavMeshFile::Poly) * header.polyCount;
+	if(header.polyCount == 0 || !buff.CanRead(verticesSize + polysSize)) {
+		LOG("ERROR(NavMesh): invalid size (vertexCount=%u polyCount=%u fileSize=%d)", header.vertexCount, header.polyCount, file.size);
+		return false;
+	}
+
+	vertices = (const vec3*)buff.ReadRaw(verticesSize);
+	polys = (const NavMeshFile::Poly*)buff.ReadRaw(polysSize);
+	vertexCount = header.vertexCount;
+	polyCount = header.polyCount;
+
+	vec2 bmin = vec2(vertices[0]);
+	vec2 bmax = bmin;
+
+	polyCenter.resize(polyCount);
+	for(u32 p = 0; p < polyCount; p++) {
+		const NavMeshFile::Poly& poly = polys[p];
+		vec3 center = vec3(0);
+		for(int i = 0; i < 3; i++) {
+			if(poly.verts[i] >= vertexCount || (poly.neighbours[i] != NavMeshFile::NONE && poly.neighbours[i] >= polyCount)) {
+				LOG("ERROR(NavMesh): poly %u is invalid", p);
+				polyCount = 0;
+				return false;
+			}
+
+			const vec3& v = vertices[poly.verts[i]];
+			center += v;
+			bmin = glm::min(bmin, vec2(v));
+			bmax = glm::max(bmax, vec2(v));
+		}
+		polyCenter[p] = center / 3.f;
+	}
+
+	// grid
+	gridOrigin = bmin;
+	gridWidth = GridX(bmax.x) + 1;
+	gridHeight = GridY(bmax.y) + 1;
+
+	const i32 cellCount = gridWidth * gridHeight;
+	gridCellStart.clear();
+	gridCellStart.resize(cellCount + 1, 0);
+
+	// count, then fill
+	for(int pass = 0; pass < 2; pass++) {
+		if(pass == 1) {
+			for(i32 c = 1; c <= cellCount; c++) {
+				gridCellStart[c] += gridCellStart[c-1];
+			}
+			gridPolyList.resize(gridCellStart[cellCount]);
+		}
+
+		for(u32 p = 0; p < polyCount; p++) {
+			const NavMeshFile::Poly& poly = polys[p];
+			const vec2 v0 = vec2(vertices[poly.verts[0]]);
+			const vec2 v1 = vec2(vertices[poly.verts[1]]);
+			const vec2 v2 = vec2(vertices[poly.verts[2]]);
+			const vec2 pmin = glm::min(v0, glm::min(v1, v2));
+			const vec2 pmax = glm::max(v0, glm::max(v1, v2));
+
+			for(i32 y = GridY(pmin.y); y <= GridY(pmax.y); y++) {
+				for(i32 x = GridX(pmin.x); x <= GridX(pmax.x); x++) {
+					const i32 c = y * gridWidth + x;
+					if(pass == 0) {
+						gridCellStart[c + 1]++;
+					}
+					else {
+						// cell start is used as a cursor, it gets shifted back below
+						gridPolyList[gridCellStart[c]++] = p;
+					}
+				}
+			}
+		}
+	}
+
+	for(i32 c = cellCount; c > 0; c--) {
+		gridCellStart[c] = gridCellStart[c-1];
+	}
+	gridCellStart[0] = 0;
+
+	LOG("NavMesh loaded (vertices=%u polys=%u grid=%dx%d)", vertexCount, polyCount, gridWidth, gridHeight);
+	return true;
+}
+
+NavPolyRef NavMesh::FindPoly(const vec3& pos, f32 maxHeightDiff, vec3* outPos) const
+{
+	const i32 x = GridX(pos.x);
+	const i32 y = GridY(pos.y);
+	if(x < 0 || y < 0 || x >= gridWidth || y >= gridHeight) return NavPolyRef::INVALID;
+
+	const vec2 p = vec2(pos);
+	const i32 c = y * gridWidth + x;
+
+	NavPolyRef best = NavPolyRef::INVALID;
+	f32 bestDiff = maxHeightDiff;
+	f32 bestHeight = 0;
+
+	for(u32 i = gridCellStart[c]; i < gridCellStart[c+1]; i++) {
+		const NavPolyRef ref = (NavPolyRef)gridPolyList[i];
+		if(!PointInPoly2D(ref, p)) continue;
+
+		const f32 h = PolyHeightAt(ref, p);
+		const f32 diff = fabsf(h - pos.z);
+		if(diff <= bestDiff) {
+			best = ref;
+			bestDiff = diff;
+			bestHeight = h;
+		}
+	}
+
+	if(best != NavPolyRef::INVALID && outPos) {
+		*outPos = vec3(pos.x, pos.y, bestHeight);
+	}
+	return best;
+}
+
+NavPolyRef NavMesh::FindNearestPoly(const vec3& pos, f32 searchRadius, vec3* outPos) const
+{
+	const i32 x0 = MAX(0, GridX(pos.x - searchRadius));
+	const i32 y0 = MAX(0, GridY(pos.y - searchRadius));
+	const i32 x1 = MIN(gridWidth - 1, GridX(pos.x + searchRadius));
+	const i32 y1 = MIN(gridHeight - 1, GridY(pos.y + searchRadius));
+
+	NavPolyRef best = NavPolyRef::INVALID;
+	f32 bestDistSq = searchRadius * searchRadius;
+	vec3 bestPos = pos;
+
+	for(i32 y = y0; y <= y1; y++) {
+		for(i32 x = x0; x <= x1; x++) {
+			const i32 c = y * gridWidth + x;
+			for(u32 i = gridCellStart[c]; i < gridCellStart[c+1]; i++) {
+				const NavPolyRef ref = (NavPolyRef)gridPolyList[i];
+				const vec3 closest = ClosestPointOnPoly(ref, pos);
+				const vec3 d = closest - pos;
+				const f32 distSq = glm::dot(d, d);
+				if(distSq <= bestDistSq) {
+					best = ref;
+					bestDistSq = distSq;
+					bestPos = closest;
+				}
+			}
+		}
+	}
+
+	if(best != NavPolyRef::INVALID && outPos) {
+		*outPos = bestPos;
+	}
+	return best;
+}
+
+bool NavMesh::Raycast(NavPolyRef startRef, const vec3& start, const vec3& end, f32* outT, NavPolyRef* outLastRef) const
+{
+	ASSERT(startRef != NavPolyRef::INVALID);
+
+	const vec2 s = vec2(start);
+	const vec2 e = vec2(end);
+	const vec2 d = e - s;
+
+	u32 cur = (u32)startRef;
+
+	// a straight line can't cross more polygons than there are
+	for(u32 iter = 0; iter < polyCount; iter++) {
+		*outLastRef = (NavPolyRef)cur;
+
+		if(PointInPoly2D((NavPolyRef)cur, e)) {
+			*outT = 1;
+			return true;
+		}
+
+		// exit edge of a convex polygon is the closest one we are moving out of
+		const NavMeshFile::Poly& poly = polys[cur];
+		f32 tExit = FLT_MAX;
+		i32 exitEdge = -1;
+		for(int i = 0; i < 3; i++) {
+			const vec2 a = vec2(vertices[poly.verts[i]]);
+			const vec2 b = vec2(vertices[poly.verts[(i+1)%3]]);
+			const vec2 edge = b - a;
+
+			const f32 denom = Cross2(edge, d);
+			if(denom >= 0) continue; // moving inwards or parallel
+
+			const f32 t = -Cross2(edge, s - a) / denom;
+			if(t < tExit) {
+				tExit = t;
+				exitEdge = i;
+			}
+		}
+
+		if(exitEdge == -1 || tExit >= 1) {
+			*outT = 1;
+			return true;
+		}
+
+		const u32 next = poly.neighbours[exitEdge];
+		if(next == NavMeshFile::NONE) {
+			*outT = MAX(0.0f, tExit);
+			return false;
+		}
+
+		// links (steps, jumps, drops) join surfaces that don't share the edge, walking can't go over them
+		const u32 ea = poly.verts[exitEdge];
+		const u32 eb = poly.verts[(exitEdge+1)%3];
+		const NavMeshFile::Poly& nextPoly = polys[next];
+		const bool sharesEdge = (nextPoly.verts[0] == ea || nextPoly.verts[1] == ea || nextPoly.verts[2] == ea) &&
+								(nextPoly.verts[0] == eb || nextPoly.verts[1] == eb || nextPoly.verts[2] == eb);
+
+		// neither can a change of height on the edge
+		const vec2 crossing = s + d * MAX(0.0f, tExit);
+		const f32 heightGap = fabsf(PolyHeightAt((NavPolyRef)cur, crossing) - PolyHeightAt((NavPolyRef)next, crossing));
+
+		if(!sharesEdge || heightGap > RAYCAST_MAX_HEIGHT_GAP) {
+			*outT = MAX(0.0f, tExit);
+			return false;
+		}
+		cur = next;
+	}
+
+	*outT = 0;
+	return false;
+}
+
+void NavMesh::InitScratch(Scratch* scratch) const
+{
+	scratch->nodeList.clear();
+	scratch->nodeList.resize(polyCount);
+	foreach(n, scratch->nodeList) {
+		n->stamp = 0;
+	}
+	scratch->openHeap.clear();
+	scratch->openHeap.reserve(polyCount);
+	scratch->stamp = 0;
+}
+
+bool NavMesh::FindCorridor(NavPolyRef startRef, NavPolyRef endRef, const vec3& start, const vec3& end, Scratch* scratch, Corridor* out) const
+{
+	ProfileFunction();
+
+	out->clear();
+	if(startRef == NavPolyRef::INVALID || endRef == NavPolyRef::INVALID) return false;
+
+	if(startRef == endRef) {
+		out->push_back(startRef);
+		return true;
+	}
+
+	DBG_ASSERT(scratch->nodeList.size() == polyCount);
+
+	scratch->stamp++;
+	if(scratch->stamp == 0) { // wrapped around
+		InitScratch(scratch);
+		scratch->stamp = 1;
+	}
+
+	const u32 stamp = scratch->stamp;
+	auto& nodes = scratch->nodeList;
+	auto& heap = scratch->openHeap;
+	heap.clear();
+
+	auto cmp = [&nodes](u32 a, u32 b) {
+		return nodes[a].total > nodes[b].total;
+	};
+
+	const f32 climbCost = 4.0f;
+
+	auto PolyPos = [&](u32 p) -> vec3 {
+		if(p == (u32)startRef) return start;
+		if(p == (u32)endRef) return end;
+		return polyCenter[p];
+	};
+
+	{
+		Scratch::Node& n = nodes[(u32)startRef];
+		n.cost = 0;
+		n.total = glm::distance(start, end);
+		n.parent = NavMeshFile::NONE;
+		n.stamp = stamp;
+		n.closed = 0;
+		heap.push_back((u32)startRef);
+	}
+
+	bool found = false;
+	while(!heap.empty()) {
+		eastl::pop_heap(heap.begin(), heap.end(), cmp);
+		const u32 cur = heap.back();
+		heap.pop_back();
+
+		Scratch::Node& node = nodes[cur];
+		if(node.closed) continue; // stale entry
+		node.closed = 1;
+
+		if(cur == (u32)endRef) {
+			found = true;
+			break;
+		}
+
+		const vec3 curPos = PolyPos(cur);
+		const NavMeshFile::Poly& poly = polys[cur];
+		for(int i = 0; i < 3; i++) {
+			const u32 next = poly.neighbours[i];
+			if(next == NavMeshFile::NONE) continue;
+
+			Scratch::Node& nn = nodes[next];
+			if(nn.stamp != stamp) {
+				nn.cost = FLT_MAX;
+				nn.stamp = stamp;
+				nn.closed = 0;
+			}
+			if(nn.closed) continue;
+
+			// climbing (jump links) costs extra so we don't hop over every cover on the way
+			const vec3 nextPos = PolyPos(next);
+			const f32 cost = node.cost + glm::distance(curPos, nextPos) + MAX(0.0f, nextPos.z - curPos.z) * climbCost;
+			if(cost < nn.cost) {
+				nn.cost = cost;
+				nn.total = cost + glm::distance(nextPos, end);
+				nn.parent = cur;
+				heap.push_back(next);
+				eastl::push_heap(heap.begin(), heap.end(), cmp);
+			}
+		}
+	}
+
+	if(!found) return false;
+
+	i32 count = 0;
+	for(u32 p = (u32)endRef; p != NavMeshFile::NONE; p = nodes[p].parent) {
+		count++;
+	}
+
+	if(count > MAX_CORRIDOR) {
+		WARN("Corridor too long (%d > %d)", count, MAX_CORRIDOR);
+		return false;
+	}
+
+	out->resize(count);
+	i32 i = count - 1;
+	for(u32 p = (u32)endRef; p != NavMeshFile::NONE; p = nodes[p].parent) {
+		(*out)[i--] = (NavPolyRef)p;
+	}
+	return true;
+}
+
+void NavMesh::StringPull(const Corridor& corridor, const vec3& start, const vec3& end, Path* out) const
+{
+	out->clear();
+
+	const i32 portalCount = corridor.size() + 1;
+	eastl::fixed_vector<vec3,MAX_CORRIDOR+1,false> portalLeft;
+	eastl::fixed_vector<vec3,MAX_CORRIDOR+1,false> portalRight;
+
+	portalLeft.push_back(start);
+	portalRight.push_back(start);
+	for(i32 i = 0; i < (i32)corridor.size() - 1; i++) {
+		vec3 left, right;
+		GetPortal(corridor[i], corridor[i+1], &left, &right);
+		portalLeft.push_back(left);
+		portalRight.push_back(right);
+	}
+	portalLeft.push_back(end);
+	portalRight.push_back(end);
+
+	vec2 apex = vec2(start);
+	vec2 left = apex;
+	vec2 right = apex;
+	i32 leftID = 0;
+	i32 rightID = 0;
+
+	for(i32 i = 1; i < portalCount; i++) {
+		if(out->size() >= MAX_PATH_POINTS - 1) break; // keep room for the end point
+
+		const vec2 pl = vec2(portalLeft[i]);
+		const vec2 pr = vec2(portalRight[i]);
+
+		// tighten right side
+		if(Cross2(right - apex, pr - apex) >= 0) {
+			if(VecEqual2(apex, right) || Cross2(left - apex, pr - apex) < 0) {
+				right = pr;
+				rightID = i;
+			}
+			else {
+				// right went over left, left is a corner
+				out->push_back(portalLeft[leftID]);
+				apex = left;
+				right = left;
+				rightID = leftID;
+				i = leftID;
+				continue;
+			}
+		}
+
+		// tighten left side
+		if(Cross2(left - apex, pl - apex) <= 0) {
+			if(VecEqual2(apex, left) || Cross2(right - apex, pl - apex) > 0) {
+				left = pl;
+				leftID = i;
+			}
+			else {
+				// left went over right, right is a corner
+				out->push_back(portalRight[rightID]);
+				apex = right;
+				left = right;
+				leftID = rightID;
+				i = rightID;
+				continue;
+			}
+		}
+	}
+
+	out->push_back(end);
+}
+
+void NavMesh::GetPortal(NavPolyRef from, NavPolyRef to, vec3* outLeft, vec3* outRight) const
+{
+	const NavMeshFile::Poly& poly = polys[(u32)from];
+	for(int i = 0; i < 3; i++) {
+		if(poly.neighbours[i] == (u32)to) {
+			// polygons are counter clockwise, going out through an edge the second vertex is on the left
+			*outRight = vertices[poly.verts[i]];
+			*outLeft = vertices[poly.verts[(i+1)%3]];
+			return;
+		}
+	}
+
+	ASSERT_MSG(0, "polygons are not neighbours");
+}
+
+vec3 NavMesh::ClosestPointOnPoly(NavPolyRef ref, const vec3& p) const
+{
+	// Real-Time Collision Detection (Ericson), 5.1.5
+	const NavMeshFile::Poly& poly = polys[(u32)ref];
+	const vec3& a = vertices[poly.verts[0]];
+	const vec3& b = vertices[poly.verts[1]];
+	const vec3& c = vertices[poly.verts[2]];
+
+	const vec3 ab = b - a;
+	const vec3 ac = c - a;
+	const vec3 ap = p - a;
+	const f32 d1 = glm::dot(ab, ap);
+	const f32 d2 = glm::dot(ac, ap);
+	if(d1 <= 0 && d2 <= 0) return a;
+
+	const vec3 bp = p - b;
+	const f32 d3 = glm::dot(ab, bp);
+	const f32 d4 = glm::dot(ac, bp);
+	if(d3 >= 0 && d4 <= d3) return b;
+
+	const f32 vc = d1*d4 - d3*d2;
+	if(vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+
+	const vec3 cp = p - c;
+	const f32 d5 = glm::dot(ab, cp);
+	const f32 d6 = glm::dot(ac, cp);
+	if(d6 >= 0 && d5 <= d6) return c;
+
+	const f32 vb = d5*d2 - d1*d6;
+	if(vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+
+	const f32 va = d3*d6 - d5*d4;
+	if(va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	const f32 denom = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+bool NavMesh::PointInPoly2D(NavPolyRef ref, const vec2& p) const
+{
+	const NavMeshFile::Poly& poly = polys[(u32)ref];
+	for(int i = 0; i < 3; i++) {
+		const vec2 a = vec2(vertices[poly.verts[i]]);
+		const vec2 b = vec2(vertices[poly.verts[(i+1)%3]]);
+		if(Cross2(b - a, p - a) < -0.01f) return false;
+	}
+	return true;
+}
+
+f32 NavMesh::PolyHeightAt(NavPolyRef ref, const vec2& p) const
+{
+	const NavMeshFile::Poly& poly = polys[(u32)ref];
+	const vec3& a = vertices[poly.verts[0]];
+	const vec3& b = vertices[poly.verts[1]];
+	const vec3& c = vertices[poly.verts[2]];
+
+	const vec3 n = glm::cross(b - a, c - a);
+	if(fabsf(n.z) < 0.0001f) return polyCenter[(u32)ref].z; // vertical, should not be in a navmesh
+	return a.z - (n.x * (p.x - a.x) + n.y * (p.y - a.y)) / n.z;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <common/base.h>
+#include <common/arena.h>
+#include <common/vector_math.h>
+#include <EASTL/fixed_vector.h>
+#include <EASTL/vector.h>
+
+// Baked navmesh file (.navmesh), produced by tools/navmesh from a collision mesh
+// Layout: Header | vec3 vertices[vertexCount] | Poly polys[polyCount]
+struct NavMeshFile
+{
+	enum: u32 {
+		MAGIC = 0x4D56414E, // NAVM
+		VERSION = 1,
+		NONE = 0xFFFFFFFF
+	};
+
+	struct Header
+	{
+		u32 magic;
+		u16 version;
+		u16 reserved;
+		u32 vertexCount;
+		u32 polyCount;
+	};
+
+	// triangles, counter clockwise when seen from above
+	struct Poly
+	{
+		u32 verts[3];
+		u32 neighbours[3]; // polygon across edge (verts[i], verts[(i+1)%3]), NONE on borders
+	};
+};
+
+enum class NavPolyRef: u32
+{
+	INVALID = NavMeshFile::NONE
+};
+
+// Read-only navigation mesh, shared by every game of the same map.
+// Queries don't touch the mesh state, anything they need to write goes in a Scratch owned by the caller.
+struct NavMesh
+{
+	enum {
+		MAX_CORRIDOR = 256,
+		MAX_PATH_POINTS = 64,
+	};
+
+	typedef eastl::fixed_vector<NavPolyRef,MAX_CORRIDOR,false> Corridor;
+	typedef eastl::fixed_vector<vec3,MAX_PATH_POINTS,false> Path;
+
+	struct Scratch
+	{
+		struct Node
+		{
+			f32 cost;
+			f32 total;
+			u32 parent;
+			u32 stamp; // node is valid for this search only when stamp == Scratch::stamp
+			u8 closed;
+		};
+
+		eastl::vector<Node,ArenaAllocator> nodeList;
+		eastl::vector<u32,ArenaAllocator> openHeap;
+		u32 stamp = 0;
+	};
+
+	const vec3* vertices = nullptr;
+	const NavMeshFile::Poly* polys = nullptr;
+	u32 vertexCount = 0;
+	u32 polyCount = 0;
+
+	eastl::vector<vec3> polyCenter;
+
+	// 2D grid of polygons, used to find the polygon under a point
+	vec2 gridOrigin;
+	f32 gridCellSize = 512;
+	i32 gridWidth = 0;
+	i32 gridHeight = 0;
+	eastl::vector<u32> gridCellStart; // gridWidth * gridHeight + 1
+	eastl::vector<u32> gridPolyList;
+
+	// file has to outlive the navmesh
+	bool Load(const FileBuffer& file);
+
+	inline bool IsLoaded() const { return polyCount > 0; }
+
+	// polygon right under (or above) pos, within maxHeightDiff
+	NavPolyRef FindPoly(const vec3& pos, f32 maxHeightDiff, vec3* outPos) const;
+	// closest point on the mesh within searchRadius
+	NavPolyRef FindNearestPoly(const vec3& pos, f32 searchRadius, vec3* outPos) const;
+
+	// walk the mesh in a straight line, returns true if end was reached
+	// outT is the fraction of the segment walked before hitting a border, a link or a change of height
+	// end is tested in 2D, check outLastRef to know which floor it was reached on
+	bool Raycast(NavPolyRef startRef, const vec3& start, const vec3& end, f32* outT, NavPolyRef* outLastRef) const;
+
+	// A* over polygons
+	bool FindCorridor(NavPolyRef startRef, NavPolyRef endRef, const vec3& start, const vec3& end, Scratch* scratch, Corridor* out) const;
+	// straight path through the corridor (funnel algorithm)
+	void StringPull(const Corridor& corridor, const vec3& start, const vec3& end, Path* out) const;
+
+	void InitScratch(Scratch* scratch) const;
+
+private:
+	void GetPortal(NavPolyRef from, NavPolyRef to, vec3* outLeft, vec3* outRight) const;
+	vec3 ClosestPointOnPoly(NavPolyRef ref, const vec3& pos) const;
+	bool PointInPoly2D(NavPolyRef ref, const vec2& p) const;
+	f32 PolyHeightAt(NavPolyRef ref, const vec2& p) const;
+
+	inline i32 GridX(f32 x) const { return (i32)floorf((x - gridOrigin.x) / gridCellSize); }
+	inline i32 GridY(f32 y) const { return (i32)floorf((y - gridOrigin.y) / gridCellSize); }
+};
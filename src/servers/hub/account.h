@@ -9,6 +9,7 @@ struct Account
 	WideString nickname;
 	WideString guildTag;
 	i32 leaderMasterID;
+	u16 rating; // matchmaking
 
 	// TODO: add to this
 
@@ -102,6 +102,11 @@ void HubPacketHandler::OnMatchmakerPacket(const NetHeader& header, const u8* pac
 			const In::MN_MatchingPartyFound resp = SafeCast<In::MN_MatchingPartyFound>(packetData, packetSize);
 			game->MmOnMatchFound(resp);
 		} break;
+
+		case In::MN_PartyDequeued::NET_ID: {
+			const In::MN_PartyDequeued resp = SafeCast<In::MN_PartyDequeued>(packetData, packetSize);
+			game->MmOnPartyDequeued(resp.partyUID, resp.leftAccountUID);
+		} break;
 	}
 }
 
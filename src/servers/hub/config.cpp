@@ -5,10 +5,35 @@
 bool CConfigHub::ParseLine(const char* line)
 {
 	if(EA::StdC::Sscanf(line, "ListenPort=%d", &ListenPort) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MetricsPort=%d", &MetricsPort) == 1) return true;
+	if(EA::StdC::Sscanf(line, "NetStatsIntervalSec=%d", &NetStatsIntervalSec) == 1) return true;
+	if(EA::StdC::Sscanf(line, "NetStatsTop=%d", &NetStatsTop) == 1) return true;
 	if(EA::StdC::Sscanf(line, "DevMode=%d", &DevMode) == 1) return true;
 	if(EA::StdC::Sscanf(line, "DevQuickConnect=%d", &DevQuickConnect) == 1) return true;
 	if(EA::StdC::Sscanf(line, "TraceNetwork=%d", &TraceNetwork) == 1) return true;
+	if(EA::StdC::Sscanf(line, "SendCoalesceKB=%d", &SendCoalesceKB) == 1) return true;
+	if(EA::StdC::Sscanf(line, "SendMaxKB=%d", &SendMaxKB) == 1) return true;
 	if(EA::StdC::Sscanf(line, "LobbyMap=%d", &LobbyMap) == 1) return true;
+	i32 ip[4];
+	if(EA::StdC::Sscanf(line, "PublicIP=%d.%d.%d.%d", &ip[0], &ip[1], &ip[2], &ip[3]) == 4) {
+		PublicIP[0] = ip[0];
+		PublicIP[1] = ip[1];
+		PublicIP[2] = ip[2];
+		PublicIP[3] = ip[3];
+		return true;
+	}
+	if(EA::StdC::Sscanf(line, "LoginIP=%d.%d.%d.%d", &ip[0], &ip[1], &ip[2], &ip[3]) == 4) {
+		LoginIP[0] = ip[0];
+		LoginIP[1] = ip[1];
+		LoginIP[2] = ip[2];
+		LoginIP[3] = ip[3];
+		return true;
+	}
+	if(EA::StdC::Sscanf(line, "LoginInnerPort=%d", &LoginInnerPort) == 1) return true;
+	if(EA::StdC::Sscanf(line, "InstanceWorkers=%d", &InstanceWorkers) == 1) return true;
+	if(EA::StdC::Sscanf(line, "ReplicationTaskObservers=%d", &ReplicationTaskObservers) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MatchRegion=%d", &MatchRegion) == 1) return true;
+	if(EA::StdC::Sscanf(line, "StartRating=%d", &StartRating) == 1) return true;
 	return false;
 }
 
@@ -63,10 +88,22 @@ bool CConfigHub::SaveConfigFile()
 {
 	eastl::fixed_string<char,4096,false> out;
 	out.append_sprintf("ListenPort=%d\n", ListenPort);
+	out.append_sprintf("MetricsPort=%d\n", MetricsPort);
+	out.append_sprintf("NetStatsIntervalSec=%d\n", NetStatsIntervalSec);
+	out.append_sprintf("NetStatsTop=%d\n", NetStatsTop);
 	out.append_sprintf("DevMode=%d\n", DevMode);
 	out.append_sprintf("DevQuickConnect=%d\n", DevQuickConnect);
 	out.append_sprintf("TraceNetwork=%d\n", TraceNetwork);
+	out.append_sprintf("SendCoalesceKB=%d\n", SendCoalesceKB);
+	out.append_sprintf("SendMaxKB=%d\n", SendMaxKB);
 	out.append_sprintf("LobbyMap=%d\n", LobbyMap);
+	out.append_sprintf("PublicIP=%d.%d.%d.%d\n", PublicIP[0], PublicIP[1], PublicIP[2], PublicIP[3]);
+	out.append_sprintf("LoginIP=%d.%d.%d.%d\n", LoginIP[0], LoginIP[1], LoginIP[2], LoginIP[3]);
+	out.append_sprintf("LoginInnerPort=%d\n", LoginInnerPort);
+	out.append_sprintf("InstanceWorkers=%d\n", InstanceWorkers);
+	out.append_sprintf("ReplicationTaskObservers=%d\n", ReplicationTaskObservers);
+	out.append_sprintf("MatchRegion=%d\n", MatchRegion);
+	out.append_sprintf("StartRating=%d\n", StartRating);
 
 	bool r = fileSaveBuff(CONFIG_PATH, out.data(), out.size());
 	if(!r) {
@@ -80,10 +117,22 @@ void CConfigHub::Print() const
 {
 	LOG("Config = {");
 	LOG("	ListenPort=%d", ListenPort);
+	LOG("	MetricsPort=%d", MetricsPort);
+	LOG("	NetStatsIntervalSec=%d", NetStatsIntervalSec);
+	LOG("	NetStatsTop=%d", NetStatsTop);
 	LOG("	DevMode=%d", DevMode);
 	LOG("	DevQuickConnect=%d", DevQuickConnect);
 	LOG("	TraceNetwork=%d", TraceNetwork);
+	LOG("	SendCoalesceKB=%d", SendCoalesceKB);
+	LOG("	SendMaxKB=%d", SendMaxKB);
 	LOG("	LobbyMap=%d", LobbyMap);
+	LOG("	PublicIP=%d.%d.%d.%d", PublicIP[0], PublicIP[1], PublicIP[2], PublicIP[3]);
+	LOG("	LoginIP=%d.%d.%d.%d", LoginIP[0], LoginIP[1], LoginIP[2], LoginIP[3]);
+	LOG("	LoginInnerPort=%d", LoginInnerPort);
+	LOG("	InstanceWorkers=%d", InstanceWorkers);
+	LOG("	ReplicationTaskObservers=%d", ReplicationTaskObservers);
+	LOG("	MatchRegion=%d", MatchRegion);
+	LOG("	StartRating=%d", StartRating);
 	LOG("}");
 }
 
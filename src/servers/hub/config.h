@@ -4,10 +4,22 @@
 struct CConfigHub
 {
 	i32 ListenPort = 11900;
+	i32 MetricsPort = 11990; // http://127.0.0.1:port/metrics, 0 to disable
+	i32 NetStatsIntervalSec = 30; // logs the top netIDs by bandwidth at that interval, 0 only plots them
+	i32 NetStatsTop = 10;
 	i32 DevMode = false;
 	i32 DevQuickConnect = false;
 	i32 TraceNetwork = false;
+	i32 SendCoalesceKB = 64; // queued bytes per client before moves/rotations only keep the latest state
+	i32 SendMaxKB = 4096; // queued bytes per client before disconnecting it
 	i32 LobbyMap = 160000042; // TODO: restore
+	u8 PublicIP[4] = { 127, 0, 0, 1 }; // sent to the login server, clients connect to this
+	u8 LoginIP[4] = { 127, 0, 0, 1 }; // login server inner address (its InnerListenIP)
+	i32 LoginInnerPort = 10901;
+	i32 InstanceWorkers = 0; // 0: instances tick on their lane thread, N: instances tick as tasks on N work stealing threads
+	i32 ReplicationTaskObservers = 64; // hub replication is split into tasks of N observers (needs InstanceWorkers), 0: never split
+	i32 MatchRegion = 0; // sent to the matchmaker, parties are only matched within a region
+	i32 StartRating = 1000; // TODO: store ratings with the accounts, everyone starts here for now
 
 	bool ParseLine(const char* line);
 	// returns false on failing to open the config file
@@ -1,6 +1,7 @@
 #include <common/packet_serialize.h>
 #include <common/inner_protocol.h>
 #include <mxm/game_content.h>
+#include <EASTL/sort.h>
 #include <zlib.h>
 #include <EAStdC/EAString.h>
 #include <EAStdC/EASprintf.h>
@@ -33,6 +34,7 @@ intptr_t ThreadLane(void* pData)
 		if (delta >= UPDATE_RATE_MS) {
 			ProfileNewFrame(name);
 			lane.Update();
+			lane.RecordTick(TimeDurationSinceMs(t1));
 			t0 = Time((u64)t0 + (u64)TimeMsToTime(UPDATE_RATE_MS));
 		}
 		else {
@@ -92,17 +94,37 @@ intptr_t ThreadCoordinator(void* pData)
 
 static EA::Thread::AtomicUint32 g_NextInstanceUID = 1;
 
+static void TaskUpdateHubInstance(void* object, void* context)
+{
+	HubInstance& instance = *(HubInstance*)object;
+	const InstancePool::Lane& lane = *(const InstancePool::Lane*)context;
+	instance.Update(lane.localTime);
+}
+
+static void TaskUpdateRoomInstance(void* object, void* context)
+{
+	RoomInstance& instance = *(RoomInstance*)object;
+	const InstancePool::Lane& lane = *(const InstancePool::Lane*)context;
+	instance.Update(lane.localTime);
+}
+
+static MetricGauge* LaneQueueMetric(i32 laneIndex, const char* queue)
+{
+	return MetricsAddGauge("lane_queue_depth", "Items waiting in a lane queue when the lane tick starts", FMT("lane=\"%d\",queue=\"%s\"", laneIndex, queue));
+}
+
 void InstancePool::Lane::Update()
 {
-	// on disconnected clients
-	decltype(clientDisconnectQueue) disconnectedList;
-	{ LOCK_MUTEX(mutexClientDisconnectQueue);
-		disconnectedList = clientDisconnectQueue;
-		clientDisconnectQueue.clear();
-	}
+	metrics.mmPacketQueue->Set(mmPacketQueue.Size());
+	metrics.roguePacketQueue->Set(roguePacketQueue.Size());
+	metrics.clientDisconnectQueue->Set(clientDisconnectQueue.Size());
+	metrics.clientTransferOutQueue->Set(clientTransferOutQueue.Size());
+	metrics.createRoomQueue->Set(createRoomQueue.Size());
+	metrics.hubPushPlayerQueue->Set(hubPushPlayerQueue.Size());
 
-	foreach_const(tr, disconnectedList) {
-		auto client = clientMap.at(*tr);
+	// on disconnected clients
+	clientDisconnectQueue.Drain([this](ClientHandle clientHd) {
+		auto client = clientMap.at(clientHd);
 
 		switch(client->instanceType) {
 			case InstanceType::HUB: {
@@ -121,20 +143,14 @@ void InstancePool::Lane::Update()
 		}
 
 		clientList.erase(client);
-		clientMap.erase(*tr);
-		clientHandleSet.erase(*tr);
-		LOG("[Lane_%d][client%x] client disconnected", laneIndex, *tr);
-	}
+		clientMap.erase(clientHd);
+		clientHandleSet.erase(clientHd);
+		LOG("[Lane_%d][client%x] client disconnected", laneIndex, clientHd);
+	});
 
 	// transfer clients out of instances
-	decltype(clientTransferOutQueue) transferOutList;
-	{ LOCK_MUTEX(mutexClientTransferOutQueue);
-		transferOutList = clientTransferOutQueue;
-		clientTransferOutQueue.clear();
-	}
-
-	foreach_const(tr, transferOutList) {
-		auto client = clientMap.at(*tr);
+	clientTransferOutQueue.Drain([this](ClientHandle clientHd) {
+		auto client = clientMap.at(clientHd);
 
 		switch(client->instanceType) {
 			case InstanceType::HUB: {
@@ -154,23 +170,17 @@ void InstancePool::Lane::Update()
 
 		client->instanceType = InstanceType::NONE;
 		client->instanceUID = HubInstanceUID::INVALID;
-		LOG("[Lane_%d][client%x] client transfered out", laneIndex, *tr);
-	}
+		LOG("[Lane_%d][client%x] client transfered out", laneIndex, clientHd);
+	});
 
 	// create rooms
-	decltype(createRoomQueue) createRoomList;
-	{ LOCK_MUTEX(mutexCreateRoomQueue);
-		createRoomList = createRoomQueue;
-		createRoomQueue.clear();
-	}
-
-	foreach_const(cr, createRoomList) {
+	createRoomQueue.Drain([this](const CreateRoomEntry& cr) {
 		const HubInstanceUID instUID = HubInstanceUID(g_NextInstanceUID++);
-		instanceRoomList.emplace_back(instUID, cr->sortieUID);
+		instanceRoomList.emplace_back(instUID, cr.sortieUID);
 		instanceRoomMap.emplace(instUID, --instanceRoomList.end());
 		RoomInstance& room = *(--instanceRoomList.end());
 
-		foreach_const(u, cr->users) {
+		foreach_const(u, cr.users) {
 			if(u->clientHd != ClientHandle::INVALID) {
 				Client& client = *clientMap.at(u->clientHd);
 				client.instanceType = InstanceType::ROOM;
@@ -178,15 +188,8 @@ void InstancePool::Lane::Update()
 			}
 		}
 
-		room.Init(server, cr->users.data(), cr->users.size());
-	}
-
-	// push players to hubs
-	decltype(hubPushPlayerQueue) hubPlayerList;
-	{ LOCK_MUTEX(mutexHubPushPlayerQueue);
-		hubPlayerList = hubPushPlayerQueue;
-		hubPushPlayerQueue.clear();
-	}
+		room.Init(server, cr.users.data(), cr.users.size());
+	});
 
 	// TODO: only one hub ever?
 	if(instanceHubList.empty()) {
@@ -195,37 +198,46 @@ void InstancePool::Lane::Update()
 		instanceHubMap.emplace(instUID, --instanceHubList.end());
 
 		HubInstance& hub = *(--instanceHubList.end());
-		hub.Init(server);
+		hub.Init(server, scheduler);
 	}
 
 	HubInstance& hub = *(--instanceHubList.end());
 
-	eastl::fixed_vector<HubInstance::NewUser,128> hubNewUsers;
-	foreach_const(hp, hubPlayerList) {
-		// create client entry
-		clientList.push_back();
-		Client& client = *(--clientList.end());
-		client.clientHd = hp->clientHd;
-		client.accountUID = hp->accountUID;
-		client.instanceType = InstanceType::HUB;
-		client.instanceUID = hub.UID;
-		clientMap.emplace(client.clientHd, --clientList.end());
-		clientHandleSet.insert(client.clientHd);
-
-		HubInstance::NewUser nu;
-		nu.clientHd = hp->clientHd;
-		nu.accountUID = hp->accountUID;
-		hubNewUsers.push_back(nu);
-
-		LOG("[Lande_%d][client%x] client joins hub", laneIndex, client.clientHd);
+	// push players to hubs, in batches
+	HubPlayerEntry hubPlayerList[128];
+	i32 hubPlayerCount;
+	while((hubPlayerCount = hubPushPlayerQueue.PopBatch(hubPlayerList, ARRAY_COUNT(hubPlayerList))) > 0) {
+		eastl::fixed_vector<HubInstance::NewUser,128> hubNewUsers;
+
+		for(i32 i = 0; i < hubPlayerCount; i++) {
+			const HubPlayerEntry& hp = hubPlayerList[i];
+
+			// create client entry
+			clientList.push_back();
+			Client& client = *(--clientList.end());
+			client.clientHd = hp.clientHd;
+			client.accountUID = hp.accountUID;
+			client.instanceType = InstanceType::HUB;
+			client.instanceUID = hub.UID;
+			clientMap.emplace(client.clientHd, --clientList.end());
+			clientHandleSet.insert(client.clientHd);
+
+			HubInstance::NewUser nu;
+			nu.clientHd = hp.clientHd;
+			nu.accountUID = hp.accountUID;
+			hubNewUsers.push_back(nu);
+
+			LOG("[Lande_%d][client%x] client joins hub", laneIndex, client.clientHd);
+		}
+
+		hub.OnClientsConnected(hubNewUsers.data(), hubNewUsers.size());
 	}
-	hub.OnClientsConnected(hubNewUsers.data(), hubNewUsers.size());
 
 	// handle client packets
-	{ LOCK_MUTEX(mutexRoguePacketsQueue);
-		recvDataBuff.Append(roguePacketsQueue.data, roguePacketsQueue.size);
-		roguePacketsQueue.Clear();
-	}
+	roguePacketQueue.Drain([this](QueueBlob& blob) {
+		recvDataBuff.Append(blob.data, blob.size);
+		blob.Free();
+	});
 
 	eastl::fixed_vector<ClientHandle,MAX_CLIENTS> clientList;
 	eastl::copy(clientHandleSet.begin(), clientHandleSet.end(), eastl::back_inserter(clientList));
@@ -240,10 +252,11 @@ void InstancePool::Lane::Update()
 	ConstBuffer buff(recvDataBuff.data, recvDataBuff.size);
 	while(buff.CanRead(sizeof(Server::RecvChunkHeader))) {
 		const Server::RecvChunkHeader& chunkInfo = buff.Read<Server::RecvChunkHeader>();
-		const u8* data = buff.ReadRaw(chunkInfo.len);
+		u8* data = (u8*)buff.ReadRaw(chunkInfo.len);
 
 		// handle each packet in chunk
-		ConstBuffer reader(data, chunkInfo.len);
+		const i32 len = inputCoalescer.Coalesce(data, chunkInfo.len);
+		ConstBuffer reader(data, len);
 		if(!reader.CanRead(sizeof(NetHeader))) {
 			WARN("Packet too small (clientHd=%u size=%d)", chunkInfo.clientHd, chunkInfo.len);
 			server->DisconnectClient(chunkInfo.clientHd);
@@ -301,10 +314,12 @@ void InstancePool::Lane::Update()
 
 	recvDataBuff.Clear();
 
+	ProfilePlotVarN("Input packets", (i64)inputCoalescer.packetCount);
+	ProfilePlotVarN("Input packets coalesced", (i64)inputCoalescer.coalescedCount);
+
 	// matchmaker packets
-	GrowableBuffer& backQueue = mmPacketQueues[!mmPacketQueueFront];
-	if(backQueue.size > 0) {
-		ConstBuffer reader(backQueue.data, backQueue.size);
+	mmPacketQueue.Drain([this](QueueBlob& blob) {
+		ConstBuffer reader(blob.data, blob.size);
 		while(reader.CanRead(sizeof(NetHeader))) {
 			const NetHeader& header = reader.Read<NetHeader>();
 			const i32 packetDataSize = header.size - sizeof(NetHeader);
@@ -319,17 +334,8 @@ void InstancePool::Lane::Update()
 				room->OnMatchmakerPacket(header, packetData);
 			}
 		}
-		backQueue.Clear();
-	}
-
-	{ LOCK_MUTEX(mutexMatchmakerPacketsQueue);
-		mmPacketQueueFront ^= 1;
-	}
-
-	// update instances
-	foreach(hub, instanceHubList) {
-		hub->Update(localTime);
-	}
+		blob.Free();
+	});
 
 	// delete rooms
 	for(auto room = instanceRoomList.begin(); room != instanceRoomList.end(); ) {
@@ -342,28 +348,86 @@ void InstancePool::Lane::Update()
 		}
 	}
 
-	// update rooms
-	foreach(room, instanceRoomList) {
-		room->Update(localTime);
+	// update instances
+	// packets have all been handled above, instances only send from now on (send buffers are locked per client)
+	if(scheduler->IsEnabled()) {
+		TaskScheduler::Batch batch;
+		foreach(hub, instanceHubList) {
+			scheduler->Submit(&batch, TaskUpdateHubInstance, &*hub, this, &hub->workerAffinity);
+		}
+		foreach(room, instanceRoomList) {
+			scheduler->Submit(&batch, TaskUpdateRoomInstance, &*room, this, &room->workerAffinity);
+		}
+		scheduler->Wait(&batch);
+	}
+	else {
+		foreach(hub, instanceHubList) {
+			hub->Update(localTime);
+		}
+		foreach(room, instanceRoomList) {
+			room->Update(localTime);
+		}
 	}
 }
 
 void InstancePool::Lane::Cleanup()
 {
+	mmPacketQueue.Drain([](QueueBlob& blob) { blob.Free(); });
+	roguePacketQueue.Drain([](QueueBlob& blob) { blob.Free(); });
+}
+
+void InstancePool::Lane::RecordTick(f64 durationMs)
+{
+	metrics.tickMs->Observe(durationMs);
+	metrics.hubInstances->Set(instanceHubList.size());
+	metrics.roomInstances->Set(instanceRoomList.size());
+	metrics.clients->Set(clientList.size());
+
+	tickDurationList.push_back((f32)durationMs);
+	if(!tickDurationList.full()) return;
+
+	const i32 p99 = (tickDurationList.size() * 99) / 100;
+	eastl::nth_element(tickDurationList.begin(), tickDurationList.begin() + p99, tickDurationList.end());
+	const f32 ms = tickDurationList[p99];
+	tickDurationList.clear();
 
+	LOCK_MUTEX(mutexLoadStats);
+	tickP99Ms = ms;
 }
 
 bool InstancePool::Init(Server* server_)
 {
 	server = server_;
 
+	bool r = scheduler.Init(Config().InstanceWorkers, (i32)CoreAffinity::LANES + CPU_COUNT);
+	if(!r) return false;
+
 	int laneIndex = 0;
 	foreach(l, lanes) {
 		l->server = server_;
+		l->scheduler = &scheduler;
 		l->laneIndex = laneIndex++;
-		l->mmPacketQueues[0].Init(1 * (1024*1024)); // 1 MB
-		l->mmPacketQueues[1].Init(1 * (1024*1024)); // 1 MB
+		l->mmPacketQueue.Init(64);
+		l->roguePacketQueue.Init(4096);
+		l->clientDisconnectQueue.Init(MAX_CLIENTS);
+		l->clientTransferOutQueue.Init(MAX_CLIENTS);
+		l->createRoomQueue.Init(128);
+		l->hubPushPlayerQueue.Init(MAX_CLIENTS);
 		l->recvDataBuff.Init(10 * (1024*1024)); // 10MB
+		l->inputCoalescer.AddInputType(Cl::CN_UpdatePosition::NET_ID);
+
+		Lane::Metrics& m = l->metrics;
+		m.tickMs = MetricsAddHistogram("lane_tick_ms", "Lane tick duration", METRICS_TICK_MS_BOUNDS, ARRAY_COUNT(METRICS_TICK_MS_BOUNDS), FMT("lane=\"%d\"", l->laneIndex));
+		m.hubInstances = MetricsAddGauge("lane_instances", "Instances on the lane", FMT("lane=\"%d\",type=\"hub\"", l->laneIndex));
+		m.roomInstances = MetricsAddGauge("lane_instances", "Instances on the lane", FMT("lane=\"%d\",type=\"room\"", l->laneIndex));
+		m.clients = MetricsAddGauge("lane_clients", "Clients in the lane instances", FMT("lane=\"%d\"", l->laneIndex));
+		m.mmPacketQueue = LaneQueueMetric(l->laneIndex, "matchmaker_packets");
+		m.roguePacketQueue = LaneQueueMetric(l->laneIndex, "rogue_packets");
+		m.clientDisconnectQueue = LaneQueueMetric(l->laneIndex, "client_disconnect");
+		m.clientTransferOutQueue = LaneQueueMetric(l->laneIndex, "client_transfer_out");
+		m.createRoomQueue = LaneQueueMetric(l->laneIndex, "create_room");
+		m.hubPushPlayerQueue = LaneQueueMetric(l->laneIndex, "hub_push_player");
+
 		l->thread.Begin(ThreadLane, &*l);
 	}
 
@@ -375,6 +439,17 @@ void InstancePool::Cleanup()
 	foreach(l, lanes) {
 		l->thread.WaitForEnd();
 	}
+	scheduler.Cleanup();
+}
+
+f32 InstancePool::GetTickP99Ms()
+{
+	f32 ms = 0;
+	foreach(l, lanes) {
+		LOCK_MUTEX(l->mutexLoadStats);
+		ms = MAX(ms, l->tickP99Ms);
+	}
+	return ms;
 }
 
 void InstancePool::QueuePushPlayerToHub(ClientHandle clientHd, AccountUID accountUID)
@@ -390,8 +465,7 @@ void InstancePool::QueuePushPlayerToHub(ClientHandle clientHd, AccountUID accoun
 	player.clientHd = clientHd;
 	player.accountUID = accountUID;
 
-	LOCK_MUTEX(l.mutexHubPushPlayerQueue);
-	l.hubPushPlayerQueue.push_back(player);
+	l.hubPushPlayerQueue.Push(player);
 }
 
 void InstancePool::QueueCreateRoom(SortieUID sortieUID, const RoomUser* userList, const i32 userCount)
@@ -413,10 +487,7 @@ void InstancePool::QueueCreateRoom(SortieUID sortieUID, const RoomUser* userList
 
 		Lane& l = lanes[loc.lane];
 		loc.lane = roomLane.laneIndex;
-
-		// TODO: very inneficient locking, we lock for EVERY client
-		LOCK_MUTEX(l.mutexClientTransferOutQueue);
-		l.clientTransferOutQueue.push_back(user.clientHd);
+		l.clientTransferOutQueue.Push(user.clientHd);
 	}
 
 	Lane::CreateRoomEntry create;
@@ -435,8 +506,7 @@ void InstancePool::QueueCreateRoom(SortieUID sortieUID, const RoomUser* userList
 		create.users.push_back(user);
 	}
 
-	LOCK_MUTEX(roomLane.mutexCreateRoomQueue);
-	roomLane.createRoomQueue.push_back(create);
+	roomLane.createRoomQueue.Push(create);
 }
 
 void InstancePool::QueuePopPlayers(const ClientHandle* clientList, const i32 count)
@@ -449,10 +519,7 @@ void InstancePool::QueuePopPlayers(const ClientHandle* clientList, const i32 cou
 		clientHandle[clientID] = ClientHandle::INVALID;
 		Lane& l = lanes[clientLocation[clientID].lane];
 		clientLocation[clientID] = ClientLocation::Null();
-
-		// TODO: very bad locking
-		LOCK_MUTEX(l.mutexClientDisconnectQueue);
-		l.clientDisconnectQueue.push_back(clientHd);
+		l.clientDisconnectQueue.Push(clientHd);
 	}
 }
 
@@ -462,23 +529,27 @@ void InstancePool::QueueRogueCoordinatorPacket(ClientHandle clientHd, const NetH
 	const ClientLocation& loc = clientLocation[clientID];
 	Lane& l = lanes[loc.lane];
 
-	LOCK_MUTEX(l.mutexRoguePacketsQueue);
 	Server::RecvChunkHeader ch;
 	ch.clientHd = clientHd;
 	ch.len = header.size;
-	l.roguePacketsQueue.Append(&ch, sizeof(ch));
-	l.roguePacketsQueue.Append(&header, sizeof(header));
-	l.roguePacketsQueue.Append(packetData, header.size - sizeof(header));
+
+	QueueBlob blob;
+	blob.size = sizeof(ch) + header.size;
+	blob.data = (u8*)memAlloc(blob.size);
+	memmove(blob.data, &ch, sizeof(ch));
+	memmove(blob.data + sizeof(ch), &header, sizeof(header));
+	memmove(blob.data + sizeof(ch) + sizeof(header), packetData, header.size - sizeof(header));
+	l.roguePacketQueue.Push(blob);
 }
 
 void InstancePool::QueueMatchmakerPackets(const u8* buffer, u32 bufferSize)
 {
 	// TODO: filter packets here as well?
 
+	if(bufferSize == 0) return;
+
 	foreach(l, lanes) {
-		Lane& lane = *l;
-		LOCK_MUTEX(lane.mutexMatchmakerPacketsQueue);
-		lane.mmPacketQueues[lane.mmPacketQueueFront].Append(buffer, bufferSize);
+		l->mmPacketQueue.Push(QueueBlob::Copy(buffer, bufferSize));
 	}
 }
 
@@ -492,6 +563,8 @@ bool Coordinator::Init(Server* server_)
 	bool r = matchmaker.Init();
 	if(!r) return false;
 
+	login.Init(); // hub still works without it
+
 	r = instancePool.Init(server);
 	if(!r) return false;
 
@@ -505,12 +578,15 @@ void Coordinator::Cleanup()
 
 	instancePool.Cleanup();
 	thread.WaitForEnd();
+	login.Cleanup();
 }
 
 void Coordinator::Update(f64 delta)
 {
 	ProfileFunction();
 
+	login.Update(localTime, accChdMap.size(), instancePool.GetTickP99Ms());
+
 	matchmaker.Update();
 	instancePool.QueueMatchmakerPackets(matchmaker.packetQueue.data, matchmaker.packetQueue.size);
 
@@ -687,6 +763,7 @@ void Coordinator::HandlePacket_CQ_Authenticate(ClientHandle clientHd, const NetH
 	account.nickname.assign(nick, nickLen);
 	account.guildTag = L"Alpha";
 	account.leaderMasterID = 0; // Lua
+	account.rating = (u16)Config().StartRating;
 
 	// remove the @plaync... part
 	i64 f = account.nickname.find(L'@');
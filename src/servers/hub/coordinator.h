@@ -3,9 +3,14 @@
 #include <common/network.h>
 #include <common/utils.h>
 #include <common/protocol.h>
+#include <common/mpsc_queue.h>
+#include <common/metrics.h>
+#include <common/task_scheduler.h>
+#include <common/input_coalescer.h>
 #include <EASTL/fixed_set.h>
 
 #include "matchmaker_connector.h"
+#include "login_connector.h"
 #include "instance.h"
 #include "account.h"
 
@@ -70,42 +75,35 @@ struct InstancePool
 		};
 
 		Server* server;
+		TaskScheduler* scheduler; // instances are ticked on the lane thread when disabled
 		EA::Thread::Thread thread;
 		i32 laneIndex;
 		Time localTime = Time::ZERO;
 
 		GrowableBuffer recvDataBuff;
+		InputCoalescer inputCoalescer; // superseded movement packets are dropped before handling
 
 		eastl::fixed_list<Client, MAX_CLIENTS, false> clientList;
 		hash_map<ClientHandle, decltype(clientList)::iterator, MAX_CLIENTS> clientMap;
 		eastl::fixed_set<ClientHandle,MAX_CLIENTS> clientHandleSet;
 
-		ProfileMutex(Mutex, mutexMatchmakerPacketsQueue);
-		GrowableBuffer mmPacketQueues[2];
-		u8 mmPacketQueueFront = 0; // being pushed to by coordinator
+		// coordinator -> lane handoff, the lane is the only consumer
+		MPSCQueue<QueueBlob> mmPacketQueue; // one blob per coordinator tick
+		MPSCQueue<QueueBlob> roguePacketQueue; // one blob per packet (RecvChunkHeader + packet)
+		MPSCQueue<ClientHandle> clientDisconnectQueue;
+		MPSCQueue<ClientHandle> clientTransferOutQueue;
 
-		ProfileMutex(Mutex, mutexRoguePacketsQueue);
-		GrowableBuffer roguePacketsQueue;
-
-		ProfileMutex(Mutex, mutexClientDisconnectQueue);
-		eastl::fixed_vector<ClientHandle,128> clientDisconnectQueue;
-
-		ProfileMutex(Mutex, mutexClientTransferOutQueue);
-		eastl::fixed_vector<ClientHandle,128> clientTransferOutQueue;
-
-		ProfileMutex(Mutex, mutexCreateRoomQueue);
 		struct CreateRoomEntry {
 			SortieUID sortieUID;
 			eastl::fixed_vector<RoomUser,16> users;
 		};
-		eastl::fixed_vector<CreateRoomEntry,128> createRoomQueue;
+		MPSCQueue<CreateRoomEntry> createRoomQueue;
 
-		ProfileMutex(Mutex, mutexHubPushPlayerQueue);
 		struct HubPlayerEntry {
 			ClientHandle clientHd;
 			AccountUID accountUID;
 		};
-		eastl::fixed_vector<HubPlayerEntry,128> hubPushPlayerQueue;
+		MPSCQueue<HubPlayerEntry> hubPushPlayerQueue;
 
 		eastl::list<HubInstance> instanceHubList;
 		eastl::list<RoomInstance> instanceRoomList;
@@ -113,9 +111,36 @@ struct InstancePool
 		hash_map<HubInstanceUID,decltype(instanceHubList)::iterator,128> instanceHubMap;
 		hash_map<HubInstanceUID,decltype(instanceRoomList)::iterator,128> instanceRoomMap;
 
+		enum {
+			LOAD_WINDOW = 128
+		};
+
+		// tick p99 over the last LOAD_WINDOW ticks
+		ProfileMutex(Mutex, mutexLoadStats);
+		f32 tickP99Ms = 0;
+		eastl::fixed_vector<f32,LOAD_WINDOW,false> tickDurationList;
+
+		// lane="N", queue depths are taken before the queues are handled
+		struct Metrics
+		{
+			MetricHistogram* tickMs;
+			MetricGauge* hubInstances;
+			MetricGauge* roomInstances;
+			MetricGauge* clients;
+			MetricGauge* mmPacketQueue;
+			MetricGauge* roguePacketQueue;
+			MetricGauge* clientDisconnectQueue;
+			MetricGauge* clientTransferOutQueue;
+			MetricGauge* createRoomQueue;
+			MetricGauge* hubPushPlayerQueue;
+		};
+
+		Metrics metrics;
+
 		// Thread: Lane
 		void Update();
 		void Cleanup();
+		void RecordTick(f64 durationMs);
 
 		void ClientHandlePacket();
 	};
@@ -136,6 +161,7 @@ struct InstancePool
 	};
 
 	Server* server;
+	TaskScheduler scheduler; // shared by every lane
 	eastl::array<Lane,CPU_COUNT> lanes;
 
 	ClientLocalMapping plidMap; // only modified on Coordinator Thread
@@ -156,6 +182,9 @@ struct InstancePool
 	void QueueRogueCoordinatorPacket(ClientHandle clientHd, const NetHeader& header, const u8* packetData);
 	void QueueMatchmakerPackets(const u8* buffer, u32 bufferSize);
 
+	// worst lane
+	f32 GetTickP99Ms();
+
 	inline bool IsClientInsideAnInstance(ClientHandle clientHd) const {
 		return plidMap.TryGet(clientHd) != -1;
 	}
@@ -179,6 +208,7 @@ struct Coordinator
 	Time localTime;
 
 	MatchmakerConnector matchmaker;
+	LoginConnector login;
 
 	bool Init(Server* server_);
 	void Cleanup();
@@ -4,10 +4,11 @@
 #include "config.h"
 #include <EAStdC/EAString.h>
 
-void HubGame::Init(Server* server_, const ClientLocalMapping* plidMap_)
+void HubGame::Init(Server* server_, const GameXmlContent* content_, const ClientLocalMapping* plidMap_)
 {
+	content = content_;
 	plidMap = plidMap_;
-	replication.Init(server_);
+	replication.Init(server_, content);
 	replication.plidMap = plidMap_;
 	world.Init(&replication);
 
@@ -66,7 +67,7 @@ bool HubGame::JukeboxQueueSong(i32 userID, SongID songID)
 		return false;
 	}
 
-	const GameXmlContent::Song* xmlSong = GetGameXmlContent().FindJukeboxSongByID(songID);
+	const GameXmlContent::Song* xmlSong = content->FindJukeboxSongByID(songID);
 	if(!xmlSong) {
 		SendDbgMsg(clientHd, LFMT(L"ERROR: Jukebox song not found (%d)", songID));
 		return false;
@@ -82,7 +83,7 @@ bool HubGame::JukeboxQueueSong(i32 userID, SongID songID)
 
 bool HubGame::LoadMap()
 {
-	const GameXmlContent& content = GetGameXmlContent();
+	const GameXmlContent& content = *this->content;
 
 	foreach(it, content.mapLobby.creatures) {
 		// don't spawn "spawn points"
@@ -132,6 +133,29 @@ void HubGame::OnPlayerDisconnect(ClientHandle clientHd)
 	playerActorUID[userID] = ActorUID::INVALID;
 
 	if(playerMap[userID] != playerList.end()) {
+		// leave the party, which takes it out of the match queue
+		const PartyUID partyUID = playerMap[userID]->partyUID;
+		if(partyUID != PartyUID::INVALID) {
+			const AccountUID accountUID = playerAccountData[userID]->UID;
+			matchmaker->QueryPartyLeave(partyUID, accountUID);
+
+			auto found = partyMap.find(partyUID);
+			if(found != partyMap.end()) {
+				Party& party = *found->second;
+				for(auto m = party.memberList.begin(); m != party.memberList.end(); ++m) {
+					if(m->accountUID == accountUID) {
+						party.memberList.erase(m);
+						break;
+					}
+				}
+
+				if(party.memberList.empty()) {
+					partyList.erase(found->second);
+					partyMap.erase(found);
+				}
+			}
+		}
+
 		playerList.erase(playerMap[userID]);
 	}
 	playerMap[userID] = playerList.end();
@@ -243,7 +267,7 @@ void HubGame::OnPlayerSetLeaderCharacter(ClientHandle clientHd, LocalActorID cha
 	const Account* account = playerAccountData[userID];
 
 	// TODO: tie in account->leaderMasterID,skinIndex with class and model
-	const ClassType classType = GetGameXmlContent().masters[leaderMasterContentID].classType;
+	const ClassType classType = content->masters[leaderMasterContentID].classType;
 	ASSERT((i32)classType == leaderMasterContentID+1);
 
 	WorldHub::ActorPlayer& actor = world.SpawnPlayerActor(userID, classType, skinIndex, account->nickname.data(), account->guildTag.data());
@@ -303,16 +327,50 @@ void HubGame::OnCreateParty(ClientHandle clientHd, EntrySystemID entry, StageTyp
 		replication.server->SendPacket(clientHd, packet);
 	}
 	else {
+		playerMap[userID]->partyEntry = entry;
+		playerMap[userID]->partyStageType = stageType;
 		matchmaker->QueryPartyCreate(acc.nickname, acc.UID);
 	}
 }
 
+static MatchMode MatchModeFromEntry(EntrySystemID entry)
+{
+	switch(entry) {
+		case EntrySystemID::ARENA_3v3: return MatchMode::ARENA_3V3;
+	}
+	return MatchMode::INVALID;
+}
+
 void HubGame::OnEnqueueGame(ClientHandle clientHd)
 {
 	const i32 userID = plidMap->Get(clientHd);
 
-	// TODO: validate args
-	matchmaker->QueryPartyEnqueue(playerMap[userID]->partyUID);
+	auto found = partyMap.find(playerMap[userID]->partyUID);
+	if(found == partyMap.end()) {
+		WARN("[client%x] Can't enqueue, not in a party", clientHd);
+		return;
+	}
+	const Party& party = *found->second;
+
+	const MatchMode mode = MatchModeFromEntry(party.entry);
+	if(mode == MatchMode::INVALID) {
+		WARN("[client%x] Can't enqueue, no match mode for entry %d", clientHd, (i32)party.entry);
+		return;
+	}
+
+	// average of the members
+	i32 ratingSum = 0;
+	i32 ratingCount = 0;
+	foreach_const(m, party.memberList) {
+		auto chd = accountClientHandleMap.find(m->accountUID);
+		if(chd == accountClientHandleMap.end()) continue; // TODO: members on other hubs
+
+		ratingSum += playerAccountData[plidMap->Get(chd->second)]->rating;
+		ratingCount++;
+	}
+	const u16 rating = (u16)(ratingCount > 0 ? ratingSum / ratingCount : Config().StartRating);
+
+	matchmaker->QueryPartyEnqueue(party.UID, mode, (u8)Config().MatchRegion, rating);
 }
 
 void HubGame::OnSortieRoomFound(ClientHandle clientHd, SortieUID sortieID)
@@ -341,6 +399,8 @@ void HubGame::MmOnPartyCreated(PartyUID partyUID, AccountUID leader)
 	ASSERT(partyMap.find(partyUID) == partyMap.end());
 	partyList.emplace_back(partyUID);
 	Party& party = *(--partyList.end());
+	party.entry = playerMap[userID]->partyEntry;
+	party.stageType = playerMap[userID]->partyStageType;
 	Party::Member member;
 	member.accountUID = leader;
 	party.memberList.push_back(member);
@@ -375,6 +435,24 @@ void HubGame::MmOnMatchFound(const In::MN_MatchingPartyFound& matchingParty)
 	}
 }
 
+void HubGame::MmOnPartyDequeued(PartyUID partyUID, AccountUID leftAccountUID)
+{
+	auto found = partyMap.find(partyUID);
+	if(found == partyMap.end()) return; // everyone here left already
+
+	// the member that left was on another hub
+	Party& party = *found->second;
+	for(auto m = party.memberList.begin(); m != party.memberList.end(); ++m) {
+		if(m->accountUID == leftAccountUID) {
+			party.memberList.erase(m);
+			break;
+		}
+	}
+
+	// TODO: tell the clients they are out of the queue (SN_EnqueueMatchingQueue has no cancel counterpart yet)
+	LOG("[MM] Party dequeued, a member left (partyUID=%u accountUID=%u members=%d)", (u32)partyUID, (u32)leftAccountUID, (i32)party.memberList.size());
+}
+
 bool HubGame::ParseChatCommand(ClientHandle clientHd, const wchar* msg, const i32 len)
 {
 	if(!Config().DevMode) return false; // don't allow command when dev mode is not enabled
@@ -26,6 +26,8 @@ struct HubGame
 		const ClientHandle clientHd;
 		PartyUID partyUID = PartyUID::INVALID;
 		SortieUID sortieUID = SortieUID::INVALID;
+		EntrySystemID partyEntry = EntrySystemID::ARENA_3v3; // requested, the party is created by the matchmaker
+		StageType partyStageType = StageType::PVP_GAME;
 
 		Player(): clientHd(ClientHandle::INVALID) {}
 
@@ -49,6 +51,7 @@ struct HubGame
 		Party(PartyUID UID_): UID(UID_) {}
 	};
 
+	const GameXmlContent* content; // generation of the instance
 	const ClientLocalMapping* plidMap;
 	eastl::array<const Account*,MAX_PLAYERS> playerAccountData;
 
@@ -70,7 +73,7 @@ struct HubGame
 	Time localTime;
 	MatchmakerConnector* matchmaker;
 
-	void Init(Server* server_, const ClientLocalMapping* plidMap_);
+	void Init(Server* server_, const GameXmlContent* content_, const ClientLocalMapping* plidMap_);
 	void Update(Time localTime_);
 
 	bool JukeboxQueueSong(i32 userID, SongID songID);
@@ -95,6 +98,7 @@ struct HubGame
 	void MmOnPartyCreated(PartyUID partyUID, AccountUID leader);
 	void MmOnPartyEnqueued(PartyUID partyUID);
 	void MmOnMatchFound(const In::MN_MatchingPartyFound& matchingParty);
+	void MmOnPartyDequeued(PartyUID partyUID, AccountUID leftAccountUID);
 
 	bool ParseChatCommand(ClientHandle clientHd, const wchar* msg, const i32 len);
 	void SendDbgMsg(ClientHandle clientHd, const wchar* msg);
@@ -1,4 +1,5 @@
 #include <common/platform.h>
+#include <common/net_stats.h>
 #include <mxm/game_content.h>
 
 #include "coordinator.h"
@@ -40,6 +41,9 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
+	static NetStatsReporter netStats;
+	netStats.Init(NetRole::HUB, Config().NetStatsIntervalSec, Config().NetStatsTop);
+
 	static Server server;
 	r = server.Init();
 	if(!r) {
@@ -48,6 +52,8 @@ int main(int argc, char** argv)
 	}
 	g_Server = &server;
 	server.doTraceNetwork = Config().TraceNetwork;
+	server.sendCoalesceThreshold = Config().SendCoalesceKB * 1024;
+	server.sendDisconnectThreshold = Config().SendMaxKB * 1024;
 
 	Listener listenLobby(&server);
 	g_Listener = &listenLobby;
@@ -66,11 +72,16 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
+	MetricsServer metrics;
+	metrics.Init(Config().MetricsPort);
+
 	// listen on main thread
 	listenLobby.Listen();
 
 	LOG("Cleaning up...");
 
+	metrics.Cleanup();
+	netStats.Cleanup();
 	coordinator.Cleanup();
 	server.Cleanup();
 
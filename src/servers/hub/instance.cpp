@@ -3,9 +3,16 @@
 #include "account.h"
 #include "matchmaker_connector.h"
 
-bool HubInstance::Init(Server* server_)
+HubInstance::~HubInstance()
 {
-	game.Init(server_, &plidMap);
+	ContentRelease(&content);
+}
+
+bool HubInstance::Init(Server* server_, TaskScheduler* scheduler)
+{
+	content = ContentAcquire();
+	game.Init(server_, content.content, &plidMap);
+	game.replication.scheduler = scheduler;
 	packetHandler.Init(&game);
 	return true;
 }
@@ -63,9 +70,15 @@ void HubInstance::OnMatchmakerPacket(const NetHeader& header, const u8* packetDa
 const i32 PICKING_TIME = 60;
 const i32 MATCH_WAIT_TIME = 10;
 
+RoomInstance::~RoomInstance()
+{
+	ContentRelease(&content);
+}
+
 void RoomInstance::Init(Server* server_, const NewUser* userlist, const i32 userCount)
 {
 	server = server_;
+	content = ContentAcquire();
 
 	teamMasterPickCount[Team::RED].fill(0);
 	teamMasterPickCount[Team::BLUE].fill(0);
@@ -111,7 +124,7 @@ void RoomInstance::Init(Server* server_, const NewUser* userlist, const i32 user
 		gathered.allConfirmed = 1;
 		SendPacket(user.clientHd, gathered);
 
-		const GameXmlContent& content = GetGameXmlContent();
+		const GameXmlContent& content = *this->content.content;
 
 		// SN_ProfileCharacters
 		{
@@ -613,7 +626,7 @@ RoomInstance::User* RoomInstance::FindUser(ClientHandle clientHd)
 bool RoomInstance::TryPickMaster(User* user, ClassType classType)
 {
 	if(teamMasterPickCount[user->team][(i32)classType] < 2) {
-		const GameXmlContent& content = GetGameXmlContent();
+		const GameXmlContent& content = *this->content.content;
 		const GameXmlContent::Master& master = *content.masterClassTypeMap.at(classType);
 
 		if(user->Main().classType == ClassType::NONE) {
@@ -1,4 +1,5 @@
 #pragma once
+#include <mxm/game_content.h>
 #include "channel.h"
 #include "game.h"
 
@@ -15,13 +16,16 @@ struct HubInstance
 	};
 
 	const HubInstanceUID UID;
+	ContentRef content; // generation the instance was created with, a reload doesn't change it
 	ClientLocalMapping plidMap;
 	HubPacketHandler packetHandler;
 	HubGame game;
+	i32 workerAffinity = -1; // TaskScheduler
 
 	HubInstance(HubInstanceUID UID_): UID(UID_) {}
+	~HubInstance();
 
-	bool Init(Server* server_);
+	bool Init(Server* server_, TaskScheduler* scheduler);
 	void Update(Time localTime_);
 	void OnClientsConnected(const NewUser* clientList, const i32 count);
 	void OnClientsDisconnected(const ClientHandle* clientList, const i32 count);
@@ -105,6 +109,7 @@ struct RoomInstance
 	Server* server;
 	const HubInstanceUID UID;
 	const SortieUID sortieUID;
+	ContentRef content; // generation the room was created with
 	ClientLocalMapping plidMap;
 
 	eastl::fixed_vector<User,16,false> userList;
@@ -122,6 +127,7 @@ struct RoomInstance
 
 	bool markedAsRemove = false;
 	Phase phase = Phase::Picking;
+	i32 workerAffinity = -1; // TaskScheduler
 
 	eastl::array<u8,4> matchServerIp = {0};
 	u16 matchServerPort = 0x0;
@@ -133,6 +139,7 @@ struct RoomInstance
 	{
 
 	}
+	~RoomInstance();
 
 	void Init(Server* server_, const NewUser* userlist, const i32 userCount);
 	void Update(Time localTime_);
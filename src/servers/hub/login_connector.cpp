@@ -0,0 +1,117 @@
+#include "login_connector.h"
+#include "config.h"
+
+const f64 LOAD_REPORT_INTERVAL = 1.0; // seconds
+const f64 RETRY_DELAY_MIN = 1.0; // seconds, doubles on every failure
+const f64 RETRY_DELAY_MAX = 30.0;
+
+static intptr_t ThreadLoginConnector(void* pData)
+{
+	LoginConnector& login = *(LoginConnector*)pData;
+	ProfileSetThreadName("LoginConnector");
+
+	while(login.state != (i32)LoginConnector::State::STOPPED) {
+		login.connectSignal.Wait();
+		if(login.state == (i32)LoginConnector::State::CONNECTING) {
+			login.Connect();
+		}
+	}
+	return 0;
+}
+
+bool LoginConnector::Init()
+{
+	conn.async.Init();
+	retryDelay = RETRY_DELAY_MIN;
+	thread.Begin(ThreadLoginConnector, this);
+	return true;
+}
+
+void LoginConnector::Cleanup()
+{
+	state = (i32)State::STOPPED;
+	connectSignal.Post(1);
+	thread.WaitForEnd();
+
+	if(conn.async.IsConnected()) {
+		closesocket(conn.async.sock);
+		conn.async.sock = INVALID_SOCKET;
+	}
+}
+
+void LoginConnector::Connect()
+{
+	const u8* ip = Config().LoginIP;
+	const bool r = conn.async.ConnectTo(ip, Config().LoginInnerPort);
+	if(r) {
+		conn.async.StartReceiving();
+		conn.sendQ.size = 0;
+		conn.recvCounter.Reset();
+	}
+
+	// Cleanup() may have stopped us in the meantime
+	state.SetValueConditional(r ? (i32)State::CONNECTED : (i32)State::CONNECT_FAILED, (i32)State::CONNECTING);
+}
+
+void LoginConnector::Update(Time localTime, i32 playerCount, f32 tickP99Ms)
+{
+	switch((State)(i32)state) {
+		case State::DISCONNECTED: {
+			if(localTime >= nextConnectTime) {
+				state = (i32)State::CONNECTING;
+				connectSignal.Post(1);
+			}
+		} return;
+
+		case State::CONNECT_FAILED: {
+			// not fatal, clients can still be sent here by a login server configured with our address
+			const u8* ip = Config().LoginIP;
+			WARN("Failed to connect to login server (%d.%d.%d.%d:%d), retrying in %gs", ip[0], ip[1], ip[2], ip[3], Config().LoginInnerPort, retryDelay);
+			nextConnectTime = TimeAddSec(localTime, retryDelay);
+			retryDelay = MIN(retryDelay * 2, RETRY_DELAY_MAX);
+			state = (i32)State::DISCONNECTED;
+		} return;
+
+		case State::CONNECTED: break;
+
+		default: return;
+	}
+
+	if(!registered) {
+		In::HL_Register reg;
+		reg.magic = In::MagicHandshake;
+		reg.ip = { Config().PublicIP[0], Config().PublicIP[1], Config().PublicIP[2], Config().PublicIP[3] };
+		reg.listenPort = Config().ListenPort;
+		reg.maxPlayers = MAX_CLIENTS;
+		conn.SendPacket(reg);
+
+		registered = true;
+		retryDelay = RETRY_DELAY_MIN;
+		lastReportTime = Time::ZERO;
+		LOG("Registered to login server");
+	}
+
+	if(TimeDiffSec(TimeDiff(lastReportTime, localTime)) >= LOAD_REPORT_INTERVAL) {
+		lastReportTime = localTime;
+
+		In::HL_LoadReport report;
+		report.playerCount = (u16)playerCount;
+		report.tickP99Ms = tickP99Ms;
+		conn.SendPacket(report);
+	}
+
+	conn.SendPendingData();
+
+	// nothing is expected from the login server
+	u8 recvBuff[8192];
+	i32 recvLen = 0;
+	conn.RecvPendingData(recvBuff, sizeof(recvBuff), &recvLen);
+
+	// send or recv failed, the socket is closed
+	if(!conn.async.IsConnected()) {
+		WARN("Lost connection to login server, reconnecting");
+		registered = false;
+		nextConnectTime = localTime;
+		state = (i32)State::DISCONNECTED;
+	}
+}
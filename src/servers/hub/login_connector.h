@@ -0,0 +1,40 @@
+#pragma once
+#include <common/network.h>
+#include <common/inner_protocol.h>
+#include <eathread/eathread_atomic.h>
+#include <eathread/eathread_semaphore.h>
+#include <eathread/eathread_thread.h>
+
+// Registers this hub to the login server and keeps it updated with our load,
+// so the login server can send new clients to the least loaded hub.
+// connect() blocks so it runs on its own thread. When the connection is lost (or can't be made)
+// we try again with a growing delay and register again once connected.
+struct LoginConnector
+{
+	enum class State: i32 {
+		DISCONNECTED = 0,
+		CONNECTING, // the connector thread owns conn
+		CONNECT_FAILED,
+		CONNECTED, // the coordinator owns conn
+		STOPPED
+	};
+
+	InnerConnection conn;
+	EA::Thread::AtomicInt32 state = (i32)State::DISCONNECTED;
+	EA::Thread::Thread thread;
+	EA::Thread::Semaphore connectSignal;
+
+	bool registered = false;
+	f64 retryDelay = 0;
+	Time nextConnectTime = Time::ZERO;
+	Time lastReportTime = Time::ZERO;
+
+	bool Init();
+	void Cleanup();
+
+	// Thread: Coordinator
+	void Update(Time localTime, i32 playerCount, f32 tickP99Ms);
+
+	// Thread: LoginConnector
+	void Connect();
+};
@@ -60,6 +60,16 @@ void MatchmakerConnector::Update()
 				case Query::Type::PartyEnqueue: {
 					In::HQ_PartyEnqueue packet;
 					packet.partyUID = q->PartyEnqueue.partyUID;
+					packet.mode = (u8)q->PartyEnqueue.mode;
+					packet.region = q->PartyEnqueue.region;
+					packet.rating = q->PartyEnqueue.rating;
+					conn.SendPacket(packet);
+				} break;
+
+				case Query::Type::PartyLeave: {
+					In::HQ_PartyLeave packet;
+					packet.partyUID = q->PartyLeave.partyUID;
+					packet.accountUID = q->PartyLeave.accountUID;
 					conn.SendPacket(packet);
 				} break;
 
@@ -118,8 +128,7 @@ void MatchmakerConnector::Update()
 // Thread: Any Lane
 void MatchmakerConnector::QueryPartyCreate(const WideString& name, AccountUID leader)
 {
-	MMQueryUID queryUID = nextQueryUID;
-	nextQueryUID = MMQueryUID((u32)nextQueryUID + 1);
+	const MMQueryUID queryUID = MMQueryUID(nextQueryUID.Increment() - 1);
 
 	Query query(queryUID, Query::Type::PartyCreate);
 	query.PartyCreate.name.Copy(name);
@@ -130,15 +139,32 @@ void MatchmakerConnector::QueryPartyCreate(const WideString& name, AccountUID le
 }
 
 // Thread: Any Lane
-void MatchmakerConnector::QueryPartyEnqueue(PartyUID partyUID)
+void MatchmakerConnector::QueryPartyEnqueue(PartyUID partyUID, MatchMode mode, u8 region, u16 rating)
 {
 	DBG_ASSERT(partyUID != PartyUID::INVALID);
 
-	MMQueryUID queryUID = nextQueryUID;
-	nextQueryUID = MMQueryUID((u32)nextQueryUID + 1);
+	const MMQueryUID queryUID = MMQueryUID(nextQueryUID.Increment() - 1);
 
 	Query query(queryUID, Query::Type::PartyEnqueue);
 	query.PartyEnqueue.partyUID = partyUID;
+	query.PartyEnqueue.mode = mode;
+	query.PartyEnqueue.region = region;
+	query.PartyEnqueue.rating = rating;
+
+	LOCK_MUTEX(mutexQueries);
+	queries.push_back(query);
+}
+
+// Thread: Any Lane
+void MatchmakerConnector::QueryPartyLeave(PartyUID partyUID, AccountUID accountUID)
+{
+	DBG_ASSERT(partyUID != PartyUID::INVALID);
+
+	const MMQueryUID queryUID = MMQueryUID(nextQueryUID.Increment() - 1);
+
+	Query query(queryUID, Query::Type::PartyLeave);
+	query.PartyLeave.partyUID = partyUID;
+	query.PartyLeave.accountUID = accountUID;
 
 	LOCK_MUTEX(mutexQueries);
 	queries.push_back(query);
@@ -149,8 +175,7 @@ void MatchmakerConnector::QueryPlayerNotifyRoomFound(AccountUID playerAccountUID
 {
 	DBG_ASSERT(sortieUID != SortieUID::INVALID);
 
-	MMQueryUID queryUID = nextQueryUID;
-	nextQueryUID = MMQueryUID((u32)nextQueryUID + 1);
+	const MMQueryUID queryUID = MMQueryUID(nextQueryUID.Increment() - 1);
 
 	Query query(queryUID, Query::Type::PlayerNotifyRoomFound);
 	query.PlayerNotifyRoomFound.playerAccountUID = playerAccountUID;
@@ -165,8 +190,7 @@ void MatchmakerConnector::QueryPlayerRoomConfirm(AccountUID playerAccountUID, So
 {
 	DBG_ASSERT(sortieUID != SortieUID::INVALID);
 
-	MMQueryUID queryUID = nextQueryUID;
-	nextQueryUID = MMQueryUID((u32)nextQueryUID + 1);
+	const MMQueryUID queryUID = MMQueryUID(nextQueryUID.Increment() - 1);
 
 	Query query(queryUID, Query::Type::PlayerRoomConfirm);
 	query.PlayerRoomConfirm.playerAccountUID = playerAccountUID;
@@ -181,8 +205,7 @@ void MatchmakerConnector::QueryRoomCreateGame(SortieUID sortieUID, const RoomPla
 {
 	DBG_ASSERT(sortieUID != SortieUID::INVALID);
 
-	MMQueryUID queryUID = nextQueryUID;
-	nextQueryUID = MMQueryUID((u32)nextQueryUID + 1);
+	const MMQueryUID queryUID = MMQueryUID(nextQueryUID.Increment() - 1);
 
 	Query query(queryUID, Query::Type::RoomCreateGame);
 	query.RoomCreateGame.sortieUID = sortieUID;
@@ -1,6 +1,7 @@
 #pragma once
 #include <common/network.h>
 #include <common/inner_protocol.h>
+#include <eathread/eathread_atomic.h>
 
 enum class MMQueryUID: u32 {
 	INVALID = 0
@@ -35,6 +36,7 @@ struct MatchmakerConnector
 			Invalid = 0,
 			PartyCreate,
 			PartyEnqueue,
+			PartyLeave,
 			PlayerNotifyRoomFound,
 			PlayerRoomConfirm,
 			RoomCreateGame
@@ -51,8 +53,16 @@ struct MatchmakerConnector
 
 			struct {
 				PartyUID partyUID;
+				MatchMode mode;
+				u8 region;
+				u16 rating;
 			} PartyEnqueue;
 
+			struct {
+				PartyUID partyUID;
+				AccountUID accountUID;
+			} PartyLeave;
+
 			struct {
 				AccountUID playerAccountUID;
 				SortieUID sortieUID;
@@ -80,7 +90,7 @@ struct MatchmakerConnector
 	ProfileMutex(Mutex, mutexQueries);
 	eastl::fixed_vector<Query,2048> queries;
 
-	MMQueryUID nextQueryUID = MMQueryUID(1);
+	EA::Thread::AtomicUint32 nextQueryUID = 1; // queries come from every instance, possibly on different threads
 
 	GrowableBuffer packetQueue;
 
@@ -90,7 +100,8 @@ struct MatchmakerConnector
 	void Update();
 
 	void QueryPartyCreate(const WideString& name, AccountUID leader);
-	void QueryPartyEnqueue(PartyUID partyUID);
+	void QueryPartyEnqueue(PartyUID partyUID, MatchMode mode, u8 region, u16 rating);
+	void QueryPartyLeave(PartyUID partyUID, AccountUID accountUID);
 	void QueryPlayerNotifyRoomFound(AccountUID playerAccountUID, SortieUID sortieUID);
 	void QueryPlayerRoomConfirm(AccountUID playerAccountUID, SortieUID sortieUID, u8 confirm);
 	void QueryRoomCreateGame(SortieUID sortieUID, const RoomPlayer* playerList, u32 playerCount);
@@ -33,31 +33,60 @@ void HubReplication::PlayerLocalInfo::Reset()
 	isFirstLoad = true;
 }
 
-void HubReplication::Init(Server* server_)
+void HubReplication::Init(Server* server_, const GameXmlContent* content_)
 {
 	server = server_;
+	content = content_;
 	memset(&playerState, 0, sizeof(playerState));
 
 	framePrev = &frames[0];
 	frameCur = &frames[1];
 }
 
+void TaskReplicateObservers(void* object, void* context)
+{
+	const HubReplication::ObserverTask& task = *(HubReplication::ObserverTask*)object;
+	HubReplication& replication = *task.replication;
+
+	ProfileBlock("HubReplication::ReplicateObservers");
+	for(i32 i = task.first; i < task.first + task.count; i++) {
+		replication.ReplicateToPlayer(replication.observerList[i]);
+	}
+}
+
 void HubReplication::FrameEnd()
 {
 	ProfileFunction();
 
-	UpdatePlayersLocalState();
-
-	FrameDifference();
+	BuildFrameDifference();
 
-	// send SN_ScanEnd if requested
+	observerList.clear();
 	for(int clientID = 0; clientID < MAX_CLIENTS; clientID++) {
 		if(playerState[clientID] != PlayerState::IN_GAME) continue;
+		observerList.push_back(clientID);
+	}
+
+	// observers only read the frames, each one writes to its own local info and send buffer
+	// so packets of a given client are in the same order whatever the task split is
+	const i32 observersPerTask = Config().ReplicationTaskObservers;
+	if(scheduler && scheduler->IsEnabled() && observersPerTask > 0 && (i32)observerList.size() > observersPerTask) {
+		observerTaskList.clear();
+		for(i32 first = 0; first < (i32)observerList.size(); first += observersPerTask) {
+			ObserverTask& task = observerTaskList.push_back();
+			task.replication = this;
+			task.first = first;
+			task.count = MIN(observersPerTask, (i32)observerList.size() - first);
+		}
 
-		if(playerLocalInfo[clientID].isFirstLoad) {
-			playerLocalInfo[clientID].isFirstLoad = false;
-
-			SendInitialFrame(playerClientHd[clientID]);
+		TaskScheduler::Batch batch;
+		foreach(task, observerTaskList) {
+			scheduler->Submit(&batch, TaskReplicateObservers, &*task, nullptr, nullptr);
+		}
+		scheduler->Wait(&batch);
+	}
+	else {
+		foreach_const(clientID, observerList) {
+			ReplicateToPlayer(*clientID);
 		}
 	}
 
@@ -449,7 +478,7 @@ void HubReplication::SendAccountDataLobby(ClientHandle clientHd, const Account&
 		SendPacket(clientHd, packet);
 	}
 
-	const GameXmlContent& content = GetGameXmlContent();
+	const GameXmlContent& content = *this->content;
 
 	// SN_ProfileCharacters
 	{
@@ -1694,120 +1723,134 @@ ActorUID HubReplication::GetWorldActorUID(ClientHandle clientHd, LocalActorID lo
 	return ActorUID::INVALID;
 }
 
-void HubReplication::UpdatePlayersLocalState()
+void HubReplication::ReplicateToPlayer(i32 clientID)
 {
-	for(int clientID = 0; clientID < MAX_CLIENTS; clientID++) {
-		if(playerState[clientID] != PlayerState::IN_GAME) continue;
+	UpdatePlayerLocalState(clientID);
+
+	SendFrameDifference(clientID);
+
+	// send SN_ScanEnd if requested
+	if(playerLocalInfo[clientID].isFirstLoad) {
+		playerLocalInfo[clientID].isFirstLoad = false;
 
-		PlayerLocalInfo& localInfo = playerLocalInfo[clientID];
-		auto& playerActorUIDSet = localInfo.actorUIDSet; // replicated actors UID set
+		SendInitialFrame(playerClientHd[clientID]);
+	}
+}
 
-		eastl::fixed_vector<ActorUID,2048,true> removedList;
-		eastl::fixed_vector<ActorUID,2048,true> addedList;
-		eastl::set_difference(playerActorUIDSet.begin(), playerActorUIDSet.end(), frameCur->actorUIDSet.begin(), frameCur->actorUIDSet.end(), eastl::back_inserter(removedList));
-		eastl::set_difference(frameCur->actorUIDSet.begin(), frameCur->actorUIDSet.end(), playerActorUIDSet.begin(), playerActorUIDSet.end(), eastl::back_inserter(addedList));
+void HubReplication::UpdatePlayerLocalState(i32 clientID)
+{
+	PlayerLocalInfo& localInfo = playerLocalInfo[clientID];
+	auto& playerActorUIDSet = localInfo.actorUIDSet; // replicated actors UID set
 
-		const ClientHandle clientHd = playerClientHd[clientID];
+	eastl::fixed_vector<ActorUID,2048,true> removedList;
+	eastl::fixed_vector<ActorUID,2048,true> addedList;
+	eastl::set_difference(playerActorUIDSet.begin(), playerActorUIDSet.end(), frameCur->actorUIDSet.begin(), frameCur->actorUIDSet.end(), eastl::back_inserter(removedList));
+	eastl::set_difference(frameCur->actorUIDSet.begin(), frameCur->actorUIDSet.end(), playerActorUIDSet.begin(), playerActorUIDSet.end(), eastl::back_inserter(addedList));
 
-		// send destroy entity for deleted actors
-		foreach(setIt, removedList) {
-			const ActorUID actorUID = *setIt;
+	const ClientHandle clientHd = playerClientHd[clientID];
+
+	// send destroy entity for deleted actors
+	foreach(setIt, removedList) {
+		const ActorUID actorUID = *setIt;
 
 #ifdef CONF_DEBUG // we don't actually need to verify the actor was in the previous frame, but do it in debug mode anyway
-			const auto actorIt = framePrev->actorUIDSet.find(actorUID);
-			ASSERT(actorIt != framePrev->actorUIDSet.end());
-			auto type = framePrev->actorType.find(actorUID);
-			ASSERT(type != framePrev->actorType.end());
-			switch(type->second) {
-				case ActorType::PLAYER: {
-					auto pm = framePrev->playerMap.find(actorUID);
-					ASSERT(pm != framePrev->playerMap.end());
-					ASSERT(pm->second->actorUID == actorUID);
-				} break;
-
-				case ActorType::NPC: {
-					auto pm = framePrev->npcMap.find(actorUID);
-					ASSERT(pm != framePrev->npcMap.end());
-					ASSERT(pm->second->actorUID == actorUID);
-				} break;
-
-				default: {
-					ASSERT_MSG(0, "case not handled");
-				} break;
-			}
+		const auto actorIt = framePrev->actorUIDSet.find(actorUID);
+		ASSERT(actorIt != framePrev->actorUIDSet.end());
+		auto type = framePrev->actorType.find(actorUID);
+		ASSERT(type != framePrev->actorType.end());
+		switch(type->second) {
+			case ActorType::PLAYER: {
+				auto pm = framePrev->playerMap.find(actorUID);
+				ASSERT(pm != framePrev->playerMap.end());
+				ASSERT(pm->second->actorUID == actorUID);
+			} break;
+
+			case ActorType::NPC: {
+				auto pm = framePrev->npcMap.find(actorUID);
+				ASSERT(pm != framePrev->npcMap.end());
+				ASSERT(pm->second->actorUID == actorUID);
+			} break;
+
+			default: {
+				ASSERT_MSG(0, "case not handled");
+			} break;
+		}
 #endif
 
-			SendActorDestroy(clientHd, actorUID);
+		SendActorDestroy(clientHd, actorUID);
+
+		// Remove LocalActorID link
+		DeleteLocalActorID(clientHd, actorUID);
+	}
 
-			// Remove LocalActorID link
-			DeleteLocalActorID(clientHd, actorUID);
+	// send new spawns
+	foreach(setIt, addedList) {
+		const ActorUID actorUID = *setIt;
+
+		// Create a LocalActorID link if none exists already
+		// If one exists already, we have pre-allocated it (like with leader master)
+		if(GetLocalActorID(clientHd, actorUID) == LocalActorID::INVALID) {
+			CreateLocalActorID(clientHd, actorUID);
 		}
 
-		// send new spawns
-		foreach(setIt, addedList) {
-			const ActorUID actorUID = *setIt;
+		auto type = frameCur->actorType.find(actorUID);
+		ASSERT(type != frameCur->actorType.end());
 
-			// Create a LocalActorID link if none exists already
-			// If one exists already, we have pre-allocated it (like with leader master)
-			if(GetLocalActorID(clientHd, actorUID) == LocalActorID::INVALID) {
-				CreateLocalActorID(clientHd, actorUID);
-			}
+		switch(type->second) {
+			case ActorType::PLAYER: {
+				const auto pm = frameCur->playerMap.find(actorUID);
+				ASSERT(pm != frameCur->playerMap.end());
+				ASSERT(pm->second->actorUID == actorUID);
+				SendActorPlayerSpawn(clientHd, *pm->second);
+			} break;
 
-			auto type = frameCur->actorType.find(actorUID);
-			ASSERT(type != frameCur->actorType.end());
-
-			switch(type->second) {
-				case ActorType::PLAYER: {
-					const auto pm = frameCur->playerMap.find(actorUID);
-					ASSERT(pm != frameCur->playerMap.end());
-					ASSERT(pm->second->actorUID == actorUID);
-					SendActorPlayerSpawn(clientHd, *pm->second);
-				} break;
-
-				case ActorType::NPC: {
-					const auto pm = frameCur->npcMap.find(actorUID);
-					ASSERT(pm != frameCur->npcMap.end());
-					ASSERT(pm->second->actorUID == actorUID);
-					SendActorNpcSpawn(clientHd, *pm->second);
-				} break;
-
-				case ActorType::JUKEBOX: {
-					ASSERT(actorUID == frameCur->jukebox.actorUID);
-					SendJukeboxSpawn(clientHd, frameCur->jukebox);
-				} break;
-
-				default: {
-					ASSERT_MSG(0, "case not handled");
-				} break;
-			}
+			case ActorType::NPC: {
+				const auto pm = frameCur->npcMap.find(actorUID);
+				ASSERT(pm != frameCur->npcMap.end());
+				ASSERT(pm->second->actorUID == actorUID);
+				SendActorNpcSpawn(clientHd, *pm->second);
+			} break;
+
+			case ActorType::JUKEBOX: {
+				ASSERT(actorUID == frameCur->jukebox.actorUID);
+				SendJukeboxSpawn(clientHd, frameCur->jukebox);
+			} break;
+
+			default: {
+				ASSERT_MSG(0, "case not handled");
+			} break;
 		}
+	}
 
-		playerActorUIDSet = frameCur->actorUIDSet;
+	playerActorUIDSet = frameCur->actorUIDSet;
 
-		// TODO: remove, extra checks
+	// TODO: remove, extra checks
 #ifdef CONF_DEBUG
-		auto& localActorIDMap = localInfo.localActorIDMap;
-		foreach(it, playerActorUIDSet) {
-			ASSERT(localActorIDMap.find(*it) != localActorIDMap.end());
-		}
-		foreach(it, localActorIDMap) {
-			ASSERT(playerActorUIDSet.find(it->first) != playerActorUIDSet.end());
-		}
-		eastl::fixed_set<LocalActorID,2048> laiSet;
-		foreach(it, localActorIDMap) {
-			ASSERT(laiSet.find(it->second) == laiSet.end());
-			laiSet.emplace(it->second);
-		}
-#endif
+	auto& localActorIDMap = localInfo.localActorIDMap;
+	foreach(it, playerActorUIDSet) {
+		ASSERT(localActorIDMap.find(*it) != localActorIDMap.end());
+	}
+	foreach(it, localActorIDMap) {
+		ASSERT(playerActorUIDSet.find(it->first) != playerActorUIDSet.end());
 	}
+	eastl::fixed_set<LocalActorID,2048> laiSet;
+	foreach(it, localActorIDMap) {
+		ASSERT(laiSet.find(it->second) == laiSet.end());
+		laiSet.emplace(it->second);
+	}
+#endif
 }
 
-void HubReplication::FrameDifference()
+void HubReplication::BuildFrameDifference()
 {
-	// send position update
+	ProfileFunction();
 
-	eastl::fixed_vector<eastl::pair<ActorUID,Frame::Transform>, 2048> tfToSendList;
-	eastl::fixed_vector<eastl::pair<ActorUID,Frame::ActionState>, 2048> atToSendList;
+	auto& tfToSendList = frameDiff.tfToSendList;
+	auto& atToSendList = frameDiff.atToSendList;
+	tfToSendList.clear();
+	atToSendList.clear();
+	frameDiff.doSendJukeboxPlay = false;
+	frameDiff.doSendJukeboxTracks = false;
 
 	// find if the position has changed since last frame
 	foreach(it, frameCur->actorUIDSet) {
@@ -1861,35 +1904,21 @@ void HubReplication::FrameDifference()
 
 					if(cur.currentSong.songID != SongID::INVALID) {
 						if(prev.currentSong.songID != cur.currentSong.songID || prev.playStartTime != cur.playStartTime) {
-
-							for(int clientID= 0; clientID < MAX_CLIENTS; clientID++) {
-								if(playerState[clientID] != PlayerState::IN_GAME) continue;
-
-								SendJukeboxPlay(playerClientHd[clientID], cur.currentSong.songID, cur.currentSong.requesterNick.data(), cur.playPosition);
-							}
+							frameDiff.doSendJukeboxPlay = true;
 						}
 					}
 
-					bool doSendTracks = false;
 					if(prev.tracks.size() == cur.tracks.size()) {
 						for(int t = 0; t < cur.tracks.size(); t++) {
 							if(prev.tracks[t].songID != cur.tracks[t].songID ||
 							   prev.tracks[t].requesterNick.compare(cur.tracks[t].requesterNick)) {
-								doSendTracks = true;
+								frameDiff.doSendJukeboxTracks = true;
 								break;
 							}
 						}
 					}
 					else {
-						doSendTracks = true;
-					}
-
-					if(doSendTracks) {
-						for(int clientID= 0; clientID < MAX_CLIENTS; clientID++) {
-							if(playerState[clientID] != PlayerState::IN_GAME) continue;
-
-							SendJukeboxQueue(playerClientHd[clientID], cur.tracks.data(), cur.tracks.size());
-						}
+						frameDiff.doSendJukeboxTracks = true;
 					}
 				}
 			} break;
@@ -1897,9 +1926,24 @@ void HubReplication::FrameDifference()
 			default: ASSERT_MSG(0, "case not handled"); break;
 		}
 	}
+}
+
+void HubReplication::SendFrameDifference(i32 clientID)
+{
+	const ClientHandle clientHd = playerClientHd[clientID];
+
+	if(frameDiff.doSendJukeboxPlay) {
+		const ActorJukebox& cur = frameCur->jukebox;
+		SendJukeboxPlay(clientHd, cur.currentSong.songID, cur.currentSong.requesterNick.data(), cur.playPosition);
+	}
+
+	if(frameDiff.doSendJukeboxTracks) {
+		const ActorJukebox& cur = frameCur->jukebox;
+		SendJukeboxQueue(clientHd, cur.tracks.data(), cur.tracks.size());
+	}
 
 	// send updates
-	foreach(it, tfToSendList) {
+	foreach_const(it, frameDiff.tfToSendList) {
 		const auto& e = *it;
 		const Frame::Transform& tf = e.second;
 
@@ -1911,17 +1955,11 @@ void HubReplication::FrameDifference()
 		sync.nSpeed = tf.speed;
 		sync.nState = -1;
 		sync.nActionIDX = -1;
-
-		for(int clientID = 0; clientID < MAX_CLIENTS; clientID++) {
-			if(playerState[clientID] != PlayerState::IN_GAME) continue;
-
-			const ClientHandle clientHd = playerClientHd[clientID];
-			sync.characterID = GetLocalActorID(clientHd, e.first);
-			SendPacket(clientHd, sync);
-		}
+		sync.characterID = GetLocalActorID(clientHd, e.first);
+		SendStatePacket(clientHd, sync, sync.characterID);
 	}
 
-	foreach(it, atToSendList) {
+	foreach_const(it, frameDiff.atToSendList) {
 		const auto& e = *it;
 		const Frame::ActionState& at = e.second;
 
@@ -1932,14 +1970,8 @@ void HubReplication::FrameDifference()
 		packet.param2 = at.actionParam2;
 		packet.rotate = at.rotate;
 		packet.upperRotate = at.upperRotate;
-
-		for(int clientID= 0; clientID < MAX_CLIENTS; clientID++) {
-			if(playerState[clientID] != PlayerState::IN_GAME) continue;
-
-			const ClientHandle clientHd = playerClientHd[clientID];
-			packet.characterID = GetLocalActorID(clientHd, e.first);
-			SendPacket(clientHd, packet);
-		}
+		packet.characterID = GetLocalActorID(clientHd, e.first);
+		SendPacket(clientHd, packet);
 	}
 }
 
@@ -2429,7 +2461,7 @@ void HubReplication::SendMasterSkillSlots(ClientHandle clientHd, const HubReplic
 	const LocalActorID localActorID = GetLocalActorID(clientHd, actor.actorUID);
 	ASSERT(localActorID != LocalActorID::INVALID);
 
-	const GameXmlContent& content = GetGameXmlContent();
+	const GameXmlContent& content = *this->content;
 
 	// SN_PlayerSkillSlot
 	{
@@ -4,6 +4,7 @@
 #include <common/utils.h>
 #include <common/protocol.h>
 #include <common/inner_protocol.h>
+#include <common/task_scheduler.h>
 #include <EASTL/array.h>
 #include <EASTL/fixed_vector.h>
 #include <EASTL/fixed_set.h>
@@ -12,6 +13,7 @@
 #include <mxm/core.h>
 
 struct Account;
+struct GameXmlContent;
 
 struct MatchingParty
 {
@@ -168,6 +170,7 @@ struct HubReplication
 	};
 
 	Server* server;
+	const GameXmlContent* content; // generation of the instance
 	Frame frames[2];
 	Frame* frameCur;
 	Frame* framePrev;
@@ -176,12 +179,13 @@ struct HubReplication
 	// Use a fixed_vector?
 
 	const ClientLocalMapping* plidMap;
+	TaskScheduler* scheduler = nullptr; // observers are split into tasks when enabled (see Config().ReplicationTaskObservers)
 
 	eastl::array<ClientHandle,MAX_CLIENTS> playerClientHd;
 	eastl::array<PlayerState,MAX_CLIENTS> playerState;
 	eastl::array<PlayerLocalInfo,MAX_CLIENTS> playerLocalInfo;
 
-	void Init(Server* server_);
+	void Init(Server* server_, const GameXmlContent* content_);
 
 	void FrameEnd();
 	void FramePushPlayerActor(const ActorPlayer& actor);
@@ -220,8 +224,36 @@ struct HubReplication
 private:
 	void PlayerForceLocalActorID(ClientHandle clientHd, ActorUID actorUID, LocalActorID localActorID);
 
-	void UpdatePlayersLocalState();
-	void FrameDifference();
+	// What changed since the last frame, built once per frame then read by every observer.
+	struct FrameDiff
+	{
+		eastl::fixed_vector<eastl::pair<ActorUID,Frame::Transform>,2048> tfToSendList;
+		eastl::fixed_vector<eastl::pair<ActorUID,Frame::ActionState>,2048> atToSendList;
+		bool doSendJukeboxPlay;
+		bool doSendJukeboxTracks;
+	};
+
+	// A range of observerList replicated by one task.
+	struct ObserverTask
+	{
+		HubReplication* replication;
+		i32 first;
+		i32 count;
+	};
+
+	FrameDiff frameDiff;
+	eastl::fixed_vector<i32,MAX_CLIENTS,false> observerList; // IN_GAME clientIDs, in clientID order
+	eastl::fixed_vector<ObserverTask,MAX_CLIENTS,false> observerTaskList;
+
+	void BuildFrameDifference();
+
+	// Everything sent to one observer for the frame, only touches that observer's local info and send buffer.
+	// Thread: Any (one task per observer at a time)
+	void ReplicateToPlayer(i32 clientID);
+	void UpdatePlayerLocalState(i32 clientID);
+	void SendFrameDifference(i32 clientID);
+
+	friend void TaskReplicateObservers(void* object, void* context);
 
 	void SendActorPlayerSpawn(ClientHandle clientHd, const ActorPlayer& actor);
 	void SendActorNpcSpawn(ClientHandle clientHd, const ActorNpc& actor);
@@ -255,4 +287,12 @@ private:
 		NT_LOG("[client%x] Replication :: %s", clientHd, PacketSerialize<Packet>(packetData, packetSize));
 		server->SendPacketData(clientHd, Packet::NET_ID, packetSize, packetData);
 	}
+
+	// latest state of an actor, can replace a queued one when the client is falling behind
+	template<typename Packet>
+	inline void SendStatePacket(ClientHandle clientHd, const Packet& packet, LocalActorID localActorID)
+	{
+		NT_LOG("[client%x] Replication :: %s", clientHd, PacketSerialize<Packet>(&packet, sizeof(packet)));
+		server->SendStatePacket(clientHd, packet, (u32)localActorID);
+	}
 };
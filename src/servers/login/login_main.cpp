@@ -3,14 +3,24 @@
 #include <common/network.h>
 #include <common/utils.h>
 #include <common/platform.h>
+#include <common/inner_protocol.h>
+#include <common/metrics.h>
+#include <common/net_stats.h>
 #include <EAStdC/EASprintf.h>
+#include <EASTL/hash_map.h>
 
 struct Config
 {
 	i32 listenPort = 10900;
 	u8 gameServerIP[4] = { 127, 0, 0, 1 };
-	i32 gameServerPort = 11900;
+	i32 gameServerPort = 11900; // used when no hub is registered
+	i32 innerListenPort = 10901; // hub servers register here
+	u8 innerListenIP[4] = { 127, 0, 0, 1 }; // only hubs should reach it: loopback or a private interface, 0.0.0.0 for every interface
+	i32 stickySec = 600; // a client reconnecting within that time goes back to the same hub
 	i32 traceNetwork = 0;
+	i32 metricsPort = 10990; // http://127.0.0.1:port/metrics, 0 to disable
+	i32 netStatsIntervalSec = 30; // logs the top netIDs by bandwidth at that interval, 0 only plots them
+	i32 netStatsTop = 10;
 
 	bool ParseLine(const char* line)
 	{
@@ -24,7 +34,19 @@ struct Config
 			return true;
 		}
 		if(EA::StdC::Sscanf(line, "GameServerPort=%d", &gameServerPort) == 1) return true;
+		if(EA::StdC::Sscanf(line, "InnerListenPort=%d", &innerListenPort) == 1) return true;
+		if(EA::StdC::Sscanf(line, "InnerListenIP=%d.%d.%d.%d", &ip[0], &ip[1], &ip[2], &ip[3]) == 4) {
+			innerListenIP[0] = ip[0];
+			innerListenIP[1] = ip[1];
+			innerListenIP[2] = ip[2];
+			innerListenIP[3] = ip[3];
+			return true;
+		}
+		if(EA::StdC::Sscanf(line, "StickySec=%d", &stickySec) == 1) return true;
 		if(EA::StdC::Sscanf(line, "TraceNetwork=%d", &traceNetwork) == 1) return true;
+		if(EA::StdC::Sscanf(line, "MetricsPort=%d", &metricsPort) == 1) return true;
+		if(EA::StdC::Sscanf(line, "NetStatsIntervalSec=%d", &netStatsIntervalSec) == 1) return true;
+		if(EA::StdC::Sscanf(line, "NetStatsTop=%d", &netStatsTop) == 1) return true;
 		return false;
 	}
 
@@ -81,13 +103,197 @@ struct Config
 		LOG("	ListenPort=%d", listenPort);
 		LOG("	GameServerIP=%d.%d.%d.%d", gameServerIP[0], gameServerIP[1], gameServerIP[2], gameServerIP[3]);
 		LOG("	GameServerPort=%d", gameServerPort);
+		LOG("	InnerListenPort=%d", innerListenPort);
+		LOG("	InnerListenIP=%d.%d.%d.%d", innerListenIP[0], innerListenIP[1], innerListenIP[2], innerListenIP[3]);
+		LOG("	StickySec=%d", stickySec);
 		LOG("	TraceNetwork=%d", traceNetwork);
+		LOG("	MetricsPort=%d", metricsPort);
+		LOG("	NetStatsIntervalSec=%d", netStatsIntervalSec);
+		LOG("	NetStatsTop=%d", netStatsTop);
 		LOG("}");
 	}
 };
 
 static Config g_Config;
 
+// Live list of hub servers, fed by the hubs themselves (HL_Register, HL_LoadReport)
+struct HubRegistry
+{
+	enum {
+		MAX_HUBS = 32,
+		STICKY_PURGE_SIZE = 4096,
+	};
+
+	struct Hub
+	{
+		u32 UID;
+		bool alive;
+		u8 ip[4];
+		u16 port;
+		i32 playerCount;
+		i32 maxPlayers;
+		f32 tickP99Ms;
+		Time lastReport;
+	};
+
+	struct Sticky
+	{
+		u32 hubUID;
+		Time time;
+	};
+
+	ProfileMutex(Mutex, mutex);
+	eastl::fixed_vector<Hub,MAX_HUBS,false> hubList;
+	eastl::hash_map<u32,Sticky> stickyMap; // login name hash -> last hub
+	u32 nextHubUID = 1;
+	MetricGauge* hubCountMetric = nullptr; // registered hubs, set by LoginServer::Init
+
+	u32 Register(const u8* ip, u16 port, i32 maxPlayers)
+	{
+		LOCK_MUTEX(mutex);
+
+		// reuse a dead slot
+		Hub* hub = nullptr;
+		foreach(h, hubList) {
+			if(!h->alive) {
+				hub = h;
+				break;
+			}
+		}
+
+		if(!hub) {
+			if(hubList.full()) {
+				WARN("Hub registry is full (%d)", MAX_HUBS);
+				return 0;
+			}
+			hub = &hubList.push_back();
+		}
+
+		hub->UID = nextHubUID++;
+		hub->alive = true;
+		memmove(hub->ip, ip, sizeof(hub->ip));
+		hub->port = port;
+		hub->playerCount = 0;
+		hub->maxPlayers = maxPlayers;
+		hub->tickP99Ms = 0;
+		hub->lastReport = TimeNow();
+
+		LOG("Hub registered (UID=%u addr=%s:%d maxPlayers=%d)", hub->UID, IpToString(hub->ip), hub->port, hub->maxPlayers);
+		UpdateMetrics();
+		return hub->UID;
+	}
+
+	void Report(u32 hubUID, i32 playerCount, f32 tickP99Ms)
+	{
+		LOCK_MUTEX(mutex);
+		Hub* hub = FindHub(hubUID);
+		if(!hub) return;
+
+		hub->playerCount = playerCount;
+		hub->tickP99Ms = tickP99Ms;
+		hub->lastReport = TimeNow();
+	}
+
+	void Unregister(u32 hubUID)
+	{
+		LOCK_MUTEX(mutex);
+		Hub* hub = FindHub(hubUID);
+		if(!hub) return;
+
+		hub->alive = false;
+		LOG("Hub unregistered (UID=%u addr=%s:%d)", hub->UID, IpToString(hub->ip), hub->port);
+		UpdateMetrics();
+	}
+
+	// least loaded hub with room to spare, the same one as last time if possible
+	// returns false when there is none
+	bool PickHub(const WideString& loginName, u8* outIp, u16* outPort)
+	{
+		const u32 key = hash_fnv1a(loginName.data(), loginName.size() * sizeof(wchar));
+		const Time now = TimeNow();
+
+		LOCK_MUTEX(mutex);
+
+		Hub* pick = nullptr;
+
+		auto sticky = stickyMap.find(key);
+		if(sticky != stickyMap.end() && TimeDiffSec(TimeDiff(sticky->second.time, now)) < g_Config.stickySec) {
+			Hub* hub = FindHub(sticky->second.hubUID);
+			if(hub && IsAlive(*hub, now) && hub->playerCount < hub->maxPlayers) {
+				pick = hub;
+			}
+		}
+
+		if(!pick) {
+			const f32 tickBudgetMs = (f32)(UPDATE_RATE * 1000.0);
+			f32 bestLoad = 0;
+
+			foreach(h, hubList) {
+				if(!IsAlive(*h, now) || h->playerCount >= h->maxPlayers) continue;
+				if(h->tickP99Ms >= tickBudgetMs * SATURATED_TICK_RATIO) continue;
+
+				const f32 load = (f32)h->playerCount / h->maxPlayers;
+				if(!pick || load < bestLoad) {
+					pick = h;
+					bestLoad = load;
+				}
+			}
+		}
+
+		if(!pick) return false;
+
+		pick->playerCount++; // until the next report
+		memmove(outIp, pick->ip, sizeof(pick->ip));
+		*outPort = pick->port;
+
+		if(stickyMap.size() >= STICKY_PURGE_SIZE) {
+			PurgeSticky(now);
+		}
+		stickyMap[key] = Sticky{ pick->UID, now };
+		return true;
+	}
+
+private:
+	const f32 SATURATED_TICK_RATIO = 0.9f;
+	const f64 REPORT_TIMEOUT = 5.0; // seconds
+
+	Hub* FindHub(u32 hubUID)
+	{
+		foreach(h, hubList) {
+			if(h->alive && h->UID == hubUID) return h;
+		}
+		return nullptr;
+	}
+
+	void UpdateMetrics()
+	{
+		if(!hubCountMetric) return;
+
+		i32 count = 0;
+		foreach_const(h, hubList) {
+			if(h->alive) count++;
+		}
+		hubCountMetric->Set(count);
+	}
+
+	bool IsAlive(const Hub& hub, Time now) const
+	{
+		return hub.alive && TimeDiffSec(TimeDiff(hub.lastReport, now)) < REPORT_TIMEOUT;
+	}
+
+	void PurgeSticky(Time now)
+	{
+		for(auto it = stickyMap.begin(); it != stickyMap.end(); ) {
+			auto sticky = it++;
+			if(TimeDiffSec(TimeDiff(sticky->second.time, now)) >= g_Config.stickySec) {
+				stickyMap.erase(sticky);
+			}
+		}
+	}
+};
+
+static HubRegistry g_HubRegistry;
+
 struct Client
 {
 	i32 clientID;
@@ -165,6 +371,7 @@ struct Client
 	void HandlePacket(const NetHeader& header, const u8* packetData)
 	{
 		const i32 packetSize = header.size - sizeof(NetHeader);
+		NetStatsCount(NetDir::RECV, header.netID, header.size);
 
 		switch(header.netID) {
 			case Cl::CQ_FirstHello::NET_ID: {
@@ -287,9 +494,18 @@ struct Client
 				LOG("Server :: Sv::SN_DoConnectChannelServer");
 				PacketWriter<Sv::SN_DoConnectChannelServer> packet;
 
+				u8 hubIp[4];
+				u16 hubPort;
+				if(!g_HubRegistry.PickHub(nickname, hubIp, &hubPort)) {
+					// no hub registered (or all full), fall back to the configured one
+					memmove(hubIp, g_Config.gameServerIP, sizeof(hubIp));
+					hubPort = g_Config.gameServerPort;
+				}
+				LOG("Client sent to hub %s:%d", IpToString(hubIp), hubPort);
+
 				packet.Write<u16>(1); // count
-				packet.Write<u8[4]>(g_Config.gameServerIP); // ip
-				packet.Write<u16>(g_Config.gameServerPort); // port
+				packet.Write<u8[4]>(hubIp); // ip
+				packet.Write<u16>(hubPort); // port
 
 				const wchar* serverName = L"XMX_SERVER";
 				packet.Write<u16>(10); // serverNamelen
@@ -323,6 +539,7 @@ struct Client
 		memmove(sendBuff, &header, sizeof(header));
 		memmove(sendBuff+sizeof(NetHeader), packetData, packetSize);
 
+		NetStatsCount(NetDir::SEND, netID, packetTotalSize);
 		int r = send(sock, (char*)sendBuff, packetTotalSize, 0);
 		if(r == SOCKET_ERROR) {
 			Disconnect();
@@ -341,68 +558,227 @@ intptr_t ThreadClient(void* pData)
 	return 0;
 }
 
-struct LoginServer
+// Connection from a hub server, packets are only received
+struct HubConnection
 {
 	SOCKET sock;
-	bool running = true;
+	u32 hubUID = 0;
 
-	bool Init()
+	u8 recvBuff[8192];
+	i32 recvLen = 0;
+
+	void Run()
 	{
-		if(!NetworkInit()) {
-			return false;
+		bool valid = true;
+		while(valid) {
+			const i32 len = recv(sock, (char*)recvBuff + recvLen, sizeof(recvBuff) - recvLen, 0);
+			if(len <= 0) break;
+			recvLen += len;
+
+			// handle complete packets, keep the rest for later
+			ConstBuffer buff(recvBuff, recvLen);
+			while(buff.CanRead(sizeof(NetHeader))) {
+				u8* start = buff.cursor;
+				const NetHeader& header = buff.Read<NetHeader>();
+				if(header.size < sizeof(NetHeader) || header.size > sizeof(recvBuff)) {
+					LOG("ERROR(HubConnection): invalid packet (netID=%d size=%d)", header.netID, header.size);
+					valid = false;
+					break;
+				}
+				if(!buff.CanRead(header.size - sizeof(NetHeader))) {
+					buff.cursor = start;
+					break;
+				}
+
+				const u8* packetData = buff.ReadRaw(header.size - sizeof(NetHeader));
+				HandlePacket(header, packetData);
+			}
+
+			const i32 consumed = (i32)(buff.cursor - recvBuff);
+			memmove(recvBuff, recvBuff + consumed, recvLen - consumed);
+			recvLen -= consumed;
 		}
 
-		struct addrinfo *result = NULL, *ptr = NULL, hints;
+		closesocket(sock);
+		if(hubUID) {
+			g_HubRegistry.Unregister(hubUID);
+		}
+	}
 
-		memset(&hints, 0, sizeof(hints));
-		hints.ai_family = AF_INET;
-		hints.ai_socktype = SOCK_STREAM;
-		hints.ai_protocol = IPPROTO_TCP;
-		hints.ai_flags = AI_PASSIVE;
+	void HandlePacket(const NetHeader& header, const u8* packetData)
+	{
+		const i32 packetSize = header.size - sizeof(NetHeader);
+		NetStatsCount(NetDir::RECV, header.netID, header.size);
+
+		switch(header.netID) {
+			case In::HL_Register::NET_ID: {
+				const In::HL_Register& packet = SafeCast<In::HL_Register>(packetData, packetSize);
+				if(packet.magic != In::MagicHandshake) {
+					WARN("Hub handshake magic mismatch (%x)", packet.magic);
+					return;
+				}
+
+				if(hubUID) {
+					g_HubRegistry.Unregister(hubUID);
+				}
+				hubUID = g_HubRegistry.Register(packet.ip.data(), packet.listenPort, packet.maxPlayers);
+			} break;
 
-		// Resolve the local address and port to be used by the server
-		i32 iResult = getaddrinfo(NULL, FMT("%d", g_Config.listenPort), &hints, &result);
-		if (iResult != 0) {
-			LOG("ERROR: getaddrinfo failed: %d", iResult);
-			return 1;
+			case In::HL_LoadReport::NET_ID: {
+				const In::HL_LoadReport& packet = SafeCast<In::HL_LoadReport>(packetData, packetSize);
+				g_HubRegistry.Report(hubUID, packet.playerCount, packet.tickP99Ms);
+			} break;
+
+			default: {
+				WARN("Unhandled hub packet (netID=%d size=%d)", header.netID, header.size);
+			}
 		}
-		defer(freeaddrinfo(result));
+	}
+};
 
-		sock = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-		if(sock == INVALID_SOCKET) {
-			LOG("ERROR(socket): %d", NetworkGetLastError());
+intptr_t ThreadHubConnection(void* pData)
+{
+	HubConnection* conn = (HubConnection*)pData;
+	defer(delete conn);
+
+	conn->Run();
+	return 0;
+}
+
+// bindIP: nullptr for every interface
+SOCKET ListenOnPort(i32 port, const u8* bindIP = nullptr)
+{
+	struct addrinfo *result = NULL, hints;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = AI_PASSIVE;
+
+	char host[16];
+	if(bindIP) {
+		snprintf(host, sizeof(host), "%d.%d.%d.%d", bindIP[0], bindIP[1], bindIP[2], bindIP[3]);
+	}
+
+	// Resolve the local address and port to be used by the server
+	i32 iResult = getaddrinfo(bindIP ? host : NULL, FMT("%d", port), &hints, &result);
+	if (iResult != 0) {
+		LOG("ERROR: getaddrinfo failed: %d", iResult);
+		return INVALID_SOCKET;
+	}
+	defer(freeaddrinfo(result));
+
+	SOCKET sock = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+	if(sock == INVALID_SOCKET) {
+		LOG("ERROR(socket): %d", NetworkGetLastError());
+		return INVALID_SOCKET;
+	}
+
+	// Setup the TCP listening socket
+	iResult = bind(sock, result->ai_addr, (int)result->ai_addrlen);
+	if(iResult == SOCKET_ERROR) {
+		LOG("ERROR(bind): failed with error: %d", NetworkGetLastError());
+		closesocket(sock);
+		return INVALID_SOCKET;
+	}
+
+	if(listen(sock, SOMAXCONN) == SOCKET_ERROR) {
+		LOG("ERROR(listen): failed with error: %d", NetworkGetLastError());
+		closesocket(sock);
+		return INVALID_SOCKET;
+	}
+
+	return sock;
+}
+
+intptr_t ThreadHubListener(void* pData);
+
+struct LoginServer
+{
+	SOCKET sock;
+	SOCKET innerSock = INVALID_SOCKET;
+	EA::Thread::Thread innerThread;
+	bool running = true;
+	MetricsServer metrics;
+	NetStatsReporter netStats;
+	MetricCounter* connectionsMetric = nullptr;
+
+	bool Init()
+	{
+		if(!NetworkInit()) {
 			return false;
 		}
 
-		// Setup the TCP listening socket
-		iResult = bind(sock, result->ai_addr, (int)result->ai_addrlen);
-		if(iResult == SOCKET_ERROR) {
-			LOG("ERROR(bind): failed with error: %d", NetworkGetLastError());
+		netStats.Init(NetRole::LOGIN, g_Config.netStatsIntervalSec, g_Config.netStatsTop);
+
+		sock = ListenOnPort(g_Config.listenPort);
+		if(sock == INVALID_SOCKET) {
 			return false;
 		}
 
-		// listen
-		if(listen(sock, SOMAXCONN) == SOCKET_ERROR) {
-			LOG("ERROR(listen): failed with error: %d", NetworkGetLastError());
+		// hubs are only checked with the magic number, don't expose this port
+		const u8* innerIP = g_Config.innerListenIP;
+		innerSock = ListenOnPort(g_Config.innerListenPort, innerIP);
+		if(innerSock == INVALID_SOCKET) {
+			LOG("ERROR: failed to listen for hub servers (%d.%d.%d.%d:%d)", innerIP[0], innerIP[1], innerIP[2], innerIP[3], g_Config.innerListenPort);
 			return false;
 		}
+		innerThread.Begin(ThreadHubListener, this);
 
+		g_HubRegistry.hubCountMetric = MetricsAddGauge("login_hubs", "Hub servers registered");
+		connectionsMetric = MetricsAddCounter("login_connections_total", "Client connections accepted");
+		metrics.Init(g_Config.metricsPort);
 		return true;
 	}
 
 	void Cleanup()
 	{
+		metrics.Cleanup();
+		netStats.Cleanup();
 		closesocket(sock);
+		if(innerSock != INVALID_SOCKET) {
+			closesocket(innerSock);
+			innerSock = INVALID_SOCKET;
+		}
+		innerThread.WaitForEnd();
 		NetworkCleanup();
 	}
 };
 
+intptr_t ThreadHubListener(void* pData)
+{
+	LoginServer& server = *(LoginServer*)pData;
+
+	while(server.running) {
+		struct sockaddr hubAddr;
+		AddrLen addrLen = sizeof(sockaddr);
+		SOCKET hubSocket = accept(server.innerSock, &hubAddr, &addrLen);
+		if(hubSocket == INVALID_SOCKET) {
+			if(server.running) {
+				LOG("ERROR(accept): hub listener failed: %d", NetworkGetLastError());
+			}
+			break;
+		}
+
+		LOG("New hub connection (%s)", GetIpString(hubAddr));
+
+		HubConnection* conn = new HubConnection;
+		conn->sock = hubSocket;
+
+		EA::Thread::Thread thread;
+		thread.Begin(ThreadHubConnection, conn);
+	}
+	return 0;
+}
+
 static LoginServer* g_LoginServer = nullptr;
 
 int main(int argc, char** argv)
 {
 	PlatformInit();
 	LogInit("login_server.log");
+	TimeInit();
 	LOG(".: Login server :.");
 
 	g_Config.LoadConfigFile();
@@ -413,6 +789,14 @@ int main(int argc, char** argv)
 		g_LoginServer->running = false;
 		closesocket(g_LoginServer->sock);
 		g_LoginServer->sock = INVALID_SOCKET;
+		// unblock the hub listener
+#ifdef CONF_WINDOWS
+		shutdown(g_LoginServer->innerSock, SD_BOTH);
+#else
+		shutdown(g_LoginServer->innerSock, SHUT_RDWR); // close alone does not on linux
+#endif
+		closesocket(g_LoginServer->innerSock);
+		g_LoginServer->innerSock = INVALID_SOCKET;
 	});
 
 	if(!r) {
@@ -453,6 +837,7 @@ int main(int argc, char** argv)
 		client.addr = clientAddr;
 
 		LOG("New connection (%s)", GetIpString(clientAddr));
+		server.connectionsMetric->Inc();
 		EA::Thread::Thread thread;
 		thread.Begin(ThreadClient, &client);
 	}
@@ -5,7 +5,15 @@
 bool CConfigGame::ParseLine(const char* line)
 {
 	if(EA::StdC::Sscanf(line, "ListenPort=%d", &ListenPort) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MetricsPort=%d", &MetricsPort) == 1) return true;
+	if(EA::StdC::Sscanf(line, "NetStatsIntervalSec=%d", &NetStatsIntervalSec) == 1) return true;
+	if(EA::StdC::Sscanf(line, "NetStatsTop=%d", &NetStatsTop) == 1) return true;
 	if(EA::StdC::Sscanf(line, "TraceNetwork=%d", &TraceNetwork) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MaxQueuedParties=%d", &MaxQueuedParties) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MatchRatingBand=%d", &MatchRatingBand) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MatchWidenSec=%f", &MatchWidenSec) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MatchMaxBandRadius=%d", &MatchMaxBandRadius) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MatchBotFillSec=%f", &MatchBotFillSec) == 1) return true;
 	return false;
 }
 
@@ -60,7 +68,15 @@ bool CConfigGame::SaveConfigFile()
 {
 	eastl::fixed_string<char,4096,false> out;
 	out.append_sprintf("ListenPort=%d\n", ListenPort);
+	out.append_sprintf("MetricsPort=%d\n", MetricsPort);
+	out.append_sprintf("NetStatsIntervalSec=%d\n", NetStatsIntervalSec);
+	out.append_sprintf("NetStatsTop=%d\n", NetStatsTop);
 	out.append_sprintf("TraceNetwork=%d\n", TraceNetwork);
+	out.append_sprintf("MaxQueuedParties=%d\n", MaxQueuedParties);
+	out.append_sprintf("MatchRatingBand=%d\n", MatchRatingBand);
+	out.append_sprintf("MatchWidenSec=%g\n", MatchWidenSec);
+	out.append_sprintf("MatchMaxBandRadius=%d\n", MatchMaxBandRadius);
+	out.append_sprintf("MatchBotFillSec=%g\n", MatchBotFillSec);
 
 	bool r = fileSaveBuff(CONFIG_PATH, out.data(), out.size());
 	if(!r) {
@@ -74,7 +90,15 @@ void CConfigGame::Print() const
 {
 	LOG("Config = {");
 	LOG("	ListenPort=%d", ListenPort);
+	LOG("	MetricsPort=%d", MetricsPort);
+	LOG("	NetStatsIntervalSec=%d", NetStatsIntervalSec);
+	LOG("	NetStatsTop=%d", NetStatsTop);
 	LOG("	TraceNetwork=%d", TraceNetwork);
+	LOG("	MaxQueuedParties=%d", MaxQueuedParties);
+	LOG("	MatchRatingBand=%d", MatchRatingBand);
+	LOG("	MatchWidenSec=%g", MatchWidenSec);
+	LOG("	MatchMaxBandRadius=%d", MatchMaxBandRadius);
+	LOG("	MatchBotFillSec=%g", MatchBotFillSec);
 	LOG("}");
 }
 
@@ -4,7 +4,15 @@
 struct CConfigGame
 {
 	i32 ListenPort = 13900;
+	i32 MetricsPort = 13990; // http://127.0.0.1:port/metrics, 0 to disable
+	i32 NetStatsIntervalSec = 30; // logs the top netIDs by bandwidth at that interval, 0 only plots them
+	i32 NetStatsTop = 10;
 	i32 TraceNetwork = false;
+	i32 MaxQueuedParties = 4096;
+	i32 MatchRatingBand = 100;
+	f32 MatchWidenSec = 3;
+	i32 MatchMaxBandRadius = 5;
+	f32 MatchBotFillSec = 10;
 
 	bool ParseLine(const char* line);
 	// returns false on failing to open the config file
@@ -0,0 +1,194 @@
+#include "matching.h"
+#include <EASTL/sort.h>
+
+bool MatchQueue::Init(const Params& params_)
+{
+	params = params_;
+
+	if(params.capacity <= 0 || params.ratingBandWidth <= 0 || params.widenSec <= 0) {
+		LOG("ERROR(MatchQueue::Init): invalid params (capacity=%d ratingBandWidth=%d widenSec=%g)", params.capacity, params.ratingBandWidth, params.widenSec);
+		return false;
+	}
+
+	ticketMap.reserve(params.capacity);
+	candidateList.reserve(64);
+	return true;
+}
+
+bool MatchQueue::Enqueue(const Ticket& ticket)
+{
+	if(ticket.size == 0 || ticket.size > TEAM_SIZE) {
+		WARN("Party can't be matched (partyUID=%u size=%d)", (u32)ticket.partyUID, ticket.size);
+		return false;
+	}
+	if(ticketMap.size() >= (u32)params.capacity) {
+		WARN("Match queue is full (%d)", params.capacity);
+		return false;
+	}
+	if(ticketMap.find(ticket.partyUID) != ticketMap.end()) {
+		WARN("Party already queued (partyUID=%u)", (u32)ticket.partyUID);
+		return false;
+	}
+
+	ticketMap.emplace(ticket.partyUID, ticket);
+
+	const u16 band = Band(ticket.rating);
+	Bucket& bucket = bucketMap[MakeKey(ticket.mode, ticket.region, ticket.size, band)];
+	bucket.queue.insert(Entry{ ticket.enqueueTime, ticket.partyUID });
+
+	// the new party can complete a match for any neighbouring bucket
+	const u16 b0 = (u16)MAX(0, (i32)band - params.maxBandRadius);
+	const u16 b1 = (u16)MIN((i32)MAX_BAND, (i32)band + params.maxBandRadius);
+	for(u8 size = 1; size <= TEAM_SIZE; size++) {
+		const BucketKey last = MakeKey(ticket.mode, ticket.region, size, b1);
+		for(auto it = bucketMap.lower_bound(MakeKey(ticket.mode, ticket.region, size, b0)); it != bucketMap.end() && it->first <= last; ++it) {
+			it->second.dirty = true;
+		}
+	}
+	return true;
+}
+
+bool MatchQueue::Remove(PartyUID partyUID)
+{
+	auto found = ticketMap.find(partyUID);
+	if(found == ticketMap.end()) return false;
+
+	const Ticket& ticket = found->second;
+	auto bucket = bucketMap.find(MakeKey(ticket.mode, ticket.region, ticket.size, Band(ticket.rating)));
+	ASSERT(bucket != bucketMap.end());
+	bucket->second.queue.erase(Entry{ ticket.enqueueTime, ticket.partyUID });
+
+	// Update() walks the buckets, it erases the empty ones itself when it is done
+	if(bucket->second.queue.empty() && !updating) {
+		bucketMap.erase(bucket);
+	}
+
+	ticketMap.erase(found);
+	return true;
+}
+
+const MatchQueue::Ticket* MatchQueue::Find(PartyUID partyUID) const
+{
+	auto found = ticketMap.find(partyUID);
+	if(found == ticketMap.end()) return nullptr;
+	return &found->second;
+}
+
+void MatchQueue::Update(Time localTime, eastl::vector<Match>* out)
+{
+	ProfileFunction();
+
+	updating = true;
+	foreach(b, bucketMap) {
+		Bucket& bucket = b->second;
+		if(bucket.queue.empty()) continue;
+		if(!bucket.dirty && localTime < bucket.recheckTime) continue;
+		bucket.dirty = false;
+
+		while(!bucket.queue.empty()) {
+			const Ticket& anchor = ticketMap.at(bucket.queue.begin()->partyUID);
+			const f32 waited = (f32)TimeDiffSec(TimeDiff(anchor.enqueueTime, localTime));
+			const i32 radius = MIN(params.maxBandRadius, (i32)(waited / params.widenSec));
+
+			Match match;
+			const bool found = BuildMatch(anchor, radius, &match);
+
+			if(!found && waited < params.botFillSec) {
+				// the search can only give a different result when the band widens or the bot fill kicks in
+				f32 next = params.botFillSec;
+				if(radius < params.maxBandRadius) {
+					next = MIN(next, (radius + 1) * params.widenSec);
+				}
+				bucket.recheckTime = TimeAddSec(anchor.enqueueTime, next);
+				break;
+			}
+
+			RemoveMatched(match);
+			out->push_back(match);
+		}
+	}
+	updating = false;
+
+	for(auto it = bucketMap.begin(); it != bucketMap.end();) {
+		auto b = it++;
+		if(b->second.queue.empty()) bucketMap.erase(b);
+	}
+}
+
+bool MatchQueue::BuildMatch(const Ticket& anchor, i32 bandRadius, Match* match)
+{
+	match->mode = anchor.mode;
+	match->region = anchor.region;
+	foreach(t, match->teams) {
+		t->clear();
+	}
+
+	eastl::array<i32,TEAM_COUNT> space;
+	space.fill(TEAM_SIZE);
+
+	match->teams[0].push_back(anchor.partyUID);
+	space[0] -= anchor.size;
+
+	// gather the oldest parties of every bucket in range, no bucket can give more than a full match
+	candidateList.clear();
+
+	const i32 band = Band(anchor.rating);
+	const u16 b0 = (u16)MAX(0, band - bandRadius);
+	const u16 b1 = (u16)MIN((i32)MAX_BAND, band + bandRadius);
+
+	for(u8 size = 1; size <= TEAM_SIZE; size++) {
+		const i32 maxTake = (TEAM_SIZE * TEAM_COUNT) / size;
+		const BucketKey last = MakeKey(anchor.mode, anchor.region, size, b1);
+
+		for(auto it = bucketMap.lower_bound(MakeKey(anchor.mode, anchor.region, size, b0)); it != bucketMap.end() && it->first <= last; ++it) {
+			i32 taken = 0;
+			foreach_const(e, it->second.queue) {
+				if(taken >= maxTake) break;
+				if(e->partyUID == anchor.partyUID) continue;
+				candidateList.push_back(&ticketMap.at(e->partyUID));
+				taken++;
+			}
+		}
+	}
+
+	eastl::sort(candidateList.begin(), candidateList.end(), [](const Ticket* a, const Ticket* b) {
+		if(a->enqueueTime != b->enqueueTime) return a->enqueueTime < b->enqueueTime;
+		return a->partyUID < b->partyUID;
+	});
+
+	// oldest first, each party goes in the fullest team it fits in
+	i32 left = 0;
+	foreach_const(s, space) {
+		left += *s;
+	}
+
+	foreach_const(c, candidateList) {
+		const Ticket& cand = **c;
+
+		i32 best = -1;
+		for(i32 t = 0; t < TEAM_COUNT; t++) {
+			if(space[t] >= cand.size && (best == -1 || space[t] < space[best])) {
+				best = t;
+			}
+		}
+
+		if(best == -1) continue;
+
+		match->teams[best].push_back(cand.partyUID);
+		space[best] -= cand.size;
+		left -= cand.size;
+		if(left == 0) break;
+	}
+
+	return left == 0;
+}
+
+void MatchQueue::RemoveMatched(const Match& match)
+{
+	foreach_const(t, match.teams) {
+		foreach_const(p, (*t)) {
+			bool r = Remove(*p);
+			ASSERT(r);
+		}
+	}
+}
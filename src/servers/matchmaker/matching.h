@@ -0,0 +1,101 @@
+#pragma once
+#include <common/base.h>
+#include <common/inner_protocol.h>
+#include <EASTL/fixed_vector.h>
+#include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+#include <EASTL/set.h>
+#include <EASTL/map.h>
+
+// Queued parties are bucketed by (mode, region, party size, rating band).
+// Each bucket is ordered by enqueue time, so the oldest party of a bucket is always the first one.
+// Every tick the oldest party of each bucket looks for opponents/team mates in the neighbouring bands,
+// the number of bands it can look into grows with the time it has been waiting.
+struct MatchQueue
+{
+	enum {
+		TEAM_SIZE = 3,
+		TEAM_COUNT = 2,
+		MAX_BAND = 0xFFF,
+	};
+
+	struct Params
+	{
+		i32 capacity = 4096; // max queued parties
+		i32 ratingBandWidth = 100;
+		f32 widenSec = 3; // band radius grows by one every widenSec
+		i32 maxBandRadius = 5;
+		f32 botFillSec = 10; // after that the oldest party gets a match anyway, missing players are bots
+	};
+
+	struct Ticket
+	{
+		PartyUID partyUID;
+		u8 mode;
+		u8 region;
+		u8 size;
+		u16 rating;
+		Time enqueueTime;
+	};
+
+	struct Match
+	{
+		u8 mode;
+		u8 region;
+		eastl::array<eastl::fixed_vector<PartyUID,TEAM_SIZE,false>,TEAM_COUNT> teams;
+	};
+
+	Params params;
+
+	bool Init(const Params& params_);
+
+	// returns false if the queue is full or the party is already queued
+	bool Enqueue(const Ticket& ticket);
+	bool Remove(PartyUID partyUID);
+
+	// run matching, append found matches to out
+	void Update(Time localTime, eastl::vector<Match>* out);
+
+	inline i32 Count() const { return ticketMap.size(); }
+	const Ticket* Find(PartyUID partyUID) const;
+
+private:
+	struct Entry
+	{
+		Time enqueueTime;
+		PartyUID partyUID;
+
+		inline bool operator<(const Entry& other) const
+		{
+			if(enqueueTime != other.enqueueTime) return enqueueTime < other.enqueueTime;
+			return partyUID < other.partyUID;
+		}
+	};
+
+	struct Bucket
+	{
+		eastl::set<Entry> queue; // oldest first
+		Time recheckTime = Time::ZERO; // nothing can change for this bucket before that, unless something is added
+		bool dirty = false;
+	};
+
+	typedef u32 BucketKey; // mode:8 | region:8 | size:4 | band:12
+
+	eastl::hash_map<PartyUID,Ticket> ticketMap;
+	eastl::map<BucketKey,Bucket> bucketMap; // empty buckets are erased
+	bool updating = false;
+
+	// reused every tick
+	eastl::vector<const Ticket*> candidateList;
+
+	inline BucketKey MakeKey(u8 mode, u8 region, u8 size, u16 band) const
+	{
+		return ((u32)mode << 24) | ((u32)region << 16) | ((u32)(size & 0xF) << 12) | (band & MAX_BAND);
+	}
+
+	inline u16 Band(u16 rating) const { return (u16)MIN((i32)MAX_BAND, rating / params.ratingBandWidth); }
+
+	// try to build a match around anchor, teams are left partially filled on failure
+	bool BuildMatch(const Ticket& anchor, i32 bandRadius, Match* match);
+	void RemoveMatched(const Match& match);
+};
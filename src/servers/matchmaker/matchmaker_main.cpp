@@ -5,9 +5,14 @@
 #include <common/inner_protocol.h>
 #include <common/protocol.h>
 #include <common/packet_serialize.h>
+#include <common/metrics.h>
+#include <common/net_stats.h>
 #include <EAStdC/EAScanf.h>
 #include <EASTL/hash_map.h>
+#include <EASTL/list.h>
+#include <EASTL/sort.h>
 #include "config.h"
+#include "matching.h"
 
 Server* g_Server = nullptr;
 Listener* g_Listener = nullptr;
@@ -20,6 +25,13 @@ inline void ShutdownServer()
 
 intptr_t ThreadMatchmaker(void* pData);
 
+// play server placement
+const f32 SATURATED_TICK_RATIO = 0.9f; // lane tick p99 over tick budget
+const u8 SATURATED_BUSY_PERCENT = 90;
+const i32 UNREPORTED_MAX_GAMES = 4; // until its first load report we know nothing about a server, don't pile games on it
+const f64 PENDING_GAME_EXPIRE_SEC = 5.0; // load reports (every second) count the game by then, or it was never created
+const f64 CREATED_GAME_EXPIRE_SEC = 120.0; // players are connected and the map is built by then, the game can't fail anymore
+
 enum class Team: u8
 {
 	RED = 0,
@@ -42,10 +54,30 @@ struct Matchmaker
 			PlayServer = 2
 		};
 
+		// play servers only, last load report
+		struct Load
+		{
+			i32 gameCount = 0;
+			i32 playerCount = 0;
+			i32 maxGames = 0;
+			f32 tickP99Ms = 0;
+			u8 busyPercent = 0;
+			bool reported = false;
+
+			struct PendingGame
+			{
+				SortieUID sortieUID;
+				Time sendTime;
+			};
+
+			eastl::fixed_vector<PendingGame,32,true> pendingGameList; // sent but not acknowledged yet
+		};
+
 		Type type; // TODO: timeout when undecided for a while
 		ClientHandle clientHd;
 		eastl::array<u8,4> ip;
 		u16 listenPort;
+		Load load;
 	};
 
 	struct Party
@@ -60,6 +92,7 @@ struct Matchmaker
 		};
 
 		eastl::fixed_vector<Member,5,false> memberList;
+		MatchQueue::Ticket ticket; // last enqueue, to queue the party again when its game fails
 
 		Party(PartyUID UID_): UID(UID_) {}
 	};
@@ -107,22 +140,48 @@ struct Matchmaker
 		eastl::fixed_vector<decltype(playerList)::iterator,5> teamRed;
 		eastl::fixed_vector<decltype(playerList)::iterator,5> teamBlue;
 		eastl::fixed_vector<decltype(playerList)::iterator,6> teamSpectators;
+		eastl::fixed_vector<PartyUID,MatchQueue::TEAM_SIZE*MatchQueue::TEAM_COUNT,false> partyList;
 
 		Room(SortieUID UID_): UID(UID_) {}
 	};
 
+	// the play server can still fail the game after creating it
+	struct CreatedGame
+	{
+		SortieUID sortieUID;
+		Time createTime;
+		decltype(Room::partyList) partyList;
+	};
+
 	eastl::fixed_list<Connection, 32> connList;
 	hash_map<ClientHandle, decltype(connList)::iterator, 32> connMap;
 
-	eastl::fixed_list<Party,2048> partyList;
-	hash_map<PartyUID, decltype(partyList)::iterator, 2048> partyMap;
-	eastl::fixed_vector<PartyUID,2048> matchingPartyList;
+	eastl::list<Party> partyList;
+	eastl::hash_map<PartyUID, decltype(partyList)::iterator> partyMap;
 
-	eastl::fixed_list<Room,2048> roomList;
-	hash_map<SortieUID, decltype(roomList)::iterator, 2048> roomMap;
+	MatchQueue matchQueue;
+	eastl::vector<MatchQueue::Match> matchList;
+
+	eastl::list<Room> roomList;
+	eastl::hash_map<SortieUID, decltype(roomList)::iterator> roomMap;
+	eastl::vector<SortieUID> roomDirtyList; // rooms where a player status changed
+	eastl::vector<SortieUID> roomWaitingServerList; // every play server was saturated when the game was created
+	eastl::vector<CreatedGame> createdGameList;
 
 	GrowableBuffer recvDataBuff;
 
+	struct Metrics
+	{
+		MetricGauge* queuedParties;
+		MetricGauge* parties;
+		MetricGauge* rooms;
+		MetricGauge* roomsWaitingServer;
+		MetricGauge* connections;
+		MetricCounter* matches;
+	};
+
+	Metrics metrics;
+
 	PartyUID nextPartyUID = PartyUID(1);
 	SortieUID nextSortieUID = SortieUID(1); // TODO: load from database
 
@@ -135,6 +194,26 @@ struct Matchmaker
 	bool Init()
 	{
 		recvDataBuff.Init(10 * (1024*1024)); // 10MB
+
+		MatchQueue::Params params;
+		params.capacity = Config().MaxQueuedParties;
+		params.ratingBandWidth = Config().MatchRatingBand;
+		params.widenSec = Config().MatchWidenSec;
+		params.maxBandRadius = Config().MatchMaxBandRadius;
+		params.botFillSec = Config().MatchBotFillSec;
+
+		bool r = matchQueue.Init(params);
+		if(!r) return false;
+
+		partyMap.reserve(params.capacity);
+		roomMap.reserve(params.capacity);
+
+		metrics.queuedParties = MetricsAddGauge("mm_queued_parties", "Parties waiting in the match queue");
+		metrics.parties = MetricsAddGauge("mm_parties", "Parties");
+		metrics.rooms = MetricsAddGauge("mm_rooms", "Rooms, from match found to game created");
+		metrics.roomsWaitingServer = MetricsAddGauge("mm_rooms_waiting_server", "Rooms waiting for a play server that is not saturated");
+		metrics.connections = MetricsAddGauge("mm_connections", "Hub and play servers connected");
+		metrics.matches = MetricsAddCounter("mm_matches_total", "Matches found");
 		return true;
 	}
 
@@ -162,6 +241,10 @@ struct Matchmaker
 		foreach_const(cl, clientDisconnectedList) {
 			const ClientHandle clientHd = *cl;
 
+			if(connMap.at(clientHd)->type == Connection::Type::HubServer) {
+				OnHubDisconnect(clientHd);
+			}
+
 			connList.erase(connMap.at(clientHd));
 			connMap.erase(clientHd);
 		}
@@ -205,6 +288,14 @@ struct Matchmaker
 
 		MatchParties();
 		UpdateRooms();
+		RetryWaitingRooms();
+		ExpireCreatedGames();
+
+		metrics.queuedParties->Set(matchQueue.Count());
+		metrics.parties->Set(partyList.size());
+		metrics.rooms->Set(roomList.size());
+		metrics.roomsWaitingServer->Set(roomWaitingServerList.size());
+		metrics.connections->Set(connList.size());
 	}
 
 	void ClientHandlePacket(ClientHandle clientHd, const NetHeader& header, const u8* packetData)
@@ -301,19 +392,61 @@ struct Matchmaker
 				const In::HQ_PartyEnqueue& packet = SafeCast<In::HQ_PartyEnqueue>(packetData, packetSize);
 
 				// TODO: validate args?
-				matchingPartyList.push_back(packet.partyUID);
+				auto found = partyMap.find(packet.partyUID);
+				if(found == partyMap.end()) {
+					WARN("Party not found (partyUID=%u)", (u32)packet.partyUID); // left before being queued
+					break;
+				}
+				Party& party = *found->second;
+
+				MatchQueue::Ticket& ticket = party.ticket;
+				ticket.partyUID = packet.partyUID;
+				ticket.mode = packet.mode;
+				ticket.region = packet.region;
+				ticket.size = (u8)party.memberList.size();
+				ticket.rating = packet.rating;
+				ticket.enqueueTime = localTime;
+				const bool queued = matchQueue.Enqueue(ticket);
+
+				In::MR_PartyEnqueued resp;
+				resp.result = queued ? 1 : 0;
+				resp.partyUID = packet.partyUID;
+				SendPartyPacket(party, resp);
+			} break;
+
+			case In::HQ_PartyLeave::NET_ID: {
+				NT_LOG("[hub%x] %s", conn.clientHd, PacketSerialize<In::HQ_PartyLeave>(packetData, packetSize));
+				const In::HQ_PartyLeave& packet = SafeCast<In::HQ_PartyLeave>(packetData, packetSize);
+
+				auto found = partyMap.find(packet.partyUID);
+				if(found == partyMap.end()) {
+					WARN("Party not found (partyUID=%u)", (u32)packet.partyUID);
+					break;
+				}
+
+				// the party changed, it has to be queued again
+				Party& party = *found->second;
+				const bool dequeued = matchQueue.Remove(party.UID);
+
+				for(auto m = party.memberList.begin(); m != party.memberList.end(); ++m) {
+					if(m->accountUID == packet.accountUID) {
+						party.memberList.erase(m);
+						break;
+					}
+				}
 
-				const Party& party = *partyMap.at(packet.partyUID);
-				eastl::fixed_set<ClientHandle,5,false> setInstance;
-				foreach_const(mem, party.memberList) {
-					setInstance.insert(mem->instanceChd);
+				if(party.memberList.empty()) {
+					partyList.erase(found->second);
+					partyMap.erase(found);
+					break;
 				}
 
-				foreach_const(it, setInstance) {
-					In::MR_PartyEnqueued resp;
-					resp.result = 1;
-					resp.partyUID = packet.partyUID;
-					SendPacket(*it, resp);
+				// the members left behind were waiting for a match
+				if(dequeued) {
+					In::MN_PartyDequeued notice;
+					notice.partyUID = party.UID;
+					notice.leftAccountUID = packet.accountUID;
+					SendPartyPacket(party, notice);
 				}
 			} break;
 
@@ -329,6 +462,7 @@ struct Matchmaker
 					if(pl->accountUID == packet.accountUID) {
 						pl->status = Room::PlayerStatus::RoomFoundAck;
 						found = true;
+						roomDirtyList.push_back(room.UID);
 					}
 				}
 
@@ -355,6 +489,7 @@ struct Matchmaker
 						}
 
 						found = true;
+						roomDirtyList.push_back(room.UID);
 					}
 				}
 
@@ -386,7 +521,9 @@ struct Matchmaker
 					p.masters[1].skills[1] = pp.skills[3];
 				}
 
-				RoomCreateGame(room);
+				if(!RoomCreateGame(room)) {
+					roomWaitingServerList.push_back(room.UID);
+				}
 			} break;
 
 			default: {
@@ -398,11 +535,44 @@ struct Matchmaker
 	void OnPacketPlay(Connection& conn, const NetHeader& header, const u8* packetData, const i32 packetSize)
 	{
 		switch(header.netID) {
+			case In::PQ_LoadReport::NET_ID: {
+				NT_LOG("[play%x] %s", conn.clientHd, PacketSerialize<In::PQ_LoadReport>(packetData, packetSize));
+				const In::PQ_LoadReport& packet = SafeCast<In::PQ_LoadReport>(packetData, packetSize);
+
+				// aggregate lanes, tick time is the worst lane
+				Connection::Load& load = conn.load;
+				load.gameCount = 0;
+				load.playerCount = 0;
+				load.maxGames = 0;
+				load.tickP99Ms = 0;
+				load.busyPercent = 0;
+				load.reported = true;
+
+				const i32 laneCount = MIN((i32)packet.laneCount, (i32)packet.lanes.size());
+				for(i32 i = 0; i < laneCount; i++) {
+					const In::PQ_LoadReport::Lane& l = packet.lanes[i];
+					load.gameCount += l.gameCount;
+					load.playerCount += l.playerCount;
+					load.maxGames += packet.maxGamesPerLane;
+					load.tickP99Ms = MAX(load.tickP99Ms, l.tickP99Ms);
+					load.busyPercent = MAX(load.busyPercent, l.busyPercent);
+				}
+
+				ExpirePendingGames(&load);
+			} break;
+
 			case In::PR_GameCreated::NET_ID: {
 				NT_LOG("[play%x] %s", conn.clientHd, PacketSerialize<In::PR_GameCreated>(packetData, packetSize));
 				const In::PR_GameCreated& packet = SafeCast<In::PR_GameCreated>(packetData, packetSize);
 
 				// TODO: validate args?
+				auto& pendingGameList = conn.load.pendingGameList;
+				for(auto pg = pendingGameList.begin(); pg != pendingGameList.end(); ++pg) {
+					if(pg->sortieUID == packet.sortieUID) {
+						pendingGameList.erase(pg);
+						break;
+					}
+				}
 
 				if(roomMap.find(packet.sortieUID) == roomMap.end()) {
 					WARN("Room not found (sortieUID=%llu) // if you run dev mode this is normal", packet.sortieUID);
@@ -428,6 +598,12 @@ struct Matchmaker
 				}
 
 				// done with the room, remove it
+				CreatedGame created;
+				created.sortieUID = room.UID;
+				created.createTime = localTime;
+				created.partyList = room.partyList;
+				createdGameList.push_back(created);
+
 				auto r = roomMap.find(room.UID);
 				roomList.erase(r->second);
 				roomMap.erase(r);
@@ -435,33 +611,137 @@ struct Matchmaker
 				// TODO: retry if this packet is never received
 			} break;
 
+			case In::PN_GameFailed::NET_ID: {
+				NT_LOG("[play%x] %s", conn.clientHd, PacketSerialize<In::PN_GameFailed>(packetData, packetSize));
+				const In::PN_GameFailed& packet = SafeCast<In::PN_GameFailed>(packetData, packetSize);
+
+				// the play server rejects its players, put their parties back in the queue
+				WARN("[play%x] Game failed to start (sortieUID=%llu)", conn.clientHd, packet.sortieUID);
+				OnGameFailed(conn, packet.sortieUID);
+			} break;
+
 			default: {
 				ASSERT_MSG(0, "case not handled");
 			}
 		}
 	}
 
+	void OnGameFailed(Connection& conn, SortieUID sortieUID)
+	{
+		auto& pendingGameList = conn.load.pendingGameList;
+		for(auto pg = pendingGameList.begin(); pg != pendingGameList.end(); ++pg) {
+			if(pg->sortieUID == sortieUID) {
+				pendingGameList.erase(pg);
+				break;
+			}
+		}
+
+		decltype(Room::partyList) failedPartyList;
+
+		auto room = roomMap.find(sortieUID);
+		if(room != roomMap.end()) {
+			failedPartyList = room->second->partyList;
+			roomList.erase(room->second);
+			roomMap.erase(room);
+		}
+		else {
+			auto created = eastl::find_if(createdGameList.begin(), createdGameList.end(), [sortieUID](const CreatedGame& cg) {
+				return cg.sortieUID == sortieUID;
+			});
+			if(created == createdGameList.end()) {
+				WARN("Failed game not found (sortieUID=%llu)", (u64)sortieUID);
+				return;
+			}
+
+			failedPartyList = created->partyList;
+			createdGameList.erase_unsorted(created);
+		}
+
+		// they keep their place in the queue
+		foreach_const(puid, failedPartyList) {
+			auto found = partyMap.find(*puid);
+			if(found == partyMap.end()) continue; // everyone left
+
+			Party& party = *found->second;
+			party.ticket.size = (u8)party.memberList.size();
+			const bool queued = matchQueue.Enqueue(party.ticket);
+
+			In::MR_PartyEnqueued resp;
+			resp.result = queued ? 1 : 0;
+			resp.partyUID = party.UID;
+			SendPartyPacket(party, resp);
+		}
+	}
+
+	void ExpireCreatedGames()
+	{
+		auto end = eastl::remove_if(createdGameList.begin(), createdGameList.end(), [this](const CreatedGame& cg) {
+			return TimeDiffSec(TimeDiff(cg.createTime, localTime)) >= CREATED_GAME_EXPIRE_SEC;
+		});
+		createdGameList.erase(end, createdGameList.end());
+	}
+
+	// members on that hub are gone, so are their parties
+	void OnHubDisconnect(ClientHandle hubHd)
+	{
+		for(auto it = partyList.begin(); it != partyList.end();) {
+			auto p = it++;
+			bool changed = false;
+			for(auto m = p->memberList.begin(); m != p->memberList.end();) {
+				if(m->instanceChd == hubHd) {
+					m = p->memberList.erase(m);
+					changed = true;
+				}
+				else {
+					++m;
+				}
+			}
+
+			if(changed) {
+				matchQueue.Remove(p->UID);
+			}
+
+			if(p->memberList.empty()) {
+				partyMap.erase(p->UID);
+				partyList.erase(p);
+			}
+		}
+
+		LOG("[hub%x] Hub disconnected (parties=%d queued=%d)", hubHd, (i32)partyList.size(), matchQueue.Count());
+	}
+
 	void MatchParties()
 	{
-		foreach_const(puid, matchingPartyList) {
-			const Party& party = *partyMap.at(*puid);
+		matchList.clear();
+		matchQueue.Update(localTime, &matchList);
+		metrics.matches->Add(matchList.size());
 
+		foreach_const(m, matchList) {
 			// create room
 			roomList.emplace_back(nextSortieUID);
 			Room& room = *(--roomList.end());
 			nextSortieUID = SortieUID((u64)nextSortieUID + 1);
 			roomMap.emplace(room.UID, --roomList.end());
 
-			foreach_const(pl, party.memberList) {
-				Room::Player player(pl->name, pl->accountUID, pl->instanceChd);
-				player.team = Team::RED;
-				room.playerList.push_back(player);
-				room.teamRed.push_back(&room.playerList.back());
+			for(i32 t = 0; t < MatchQueue::TEAM_COUNT; t++) {
+				const Team team = (Team)t;
+				auto& teamList = (team == Team::RED) ? room.teamRed : room.teamBlue;
+
+				foreach_const(puid, m->teams[t]) {
+					const Party& party = *partyMap.at(*puid);
+					room.partyList.push_back(party.UID);
+					foreach_const(pl, party.memberList) {
+						Room::Player player(pl->name, pl->accountUID, pl->instanceChd);
+						player.team = team;
+						room.playerList.push_back(player);
+						teamList.push_back(&room.playerList.back());
+					}
+				}
 			}
 
 			// fill empty slots with bots
 			i32 botID = 1;
-			while(room.teamRed.size() < 3) {
+			while(room.teamRed.size() < MatchQueue::TEAM_SIZE) {
 				Room::Player player(LFMT(L"Bot%d", botID++), AccountUID::INVALID, ClientHandle::INVALID);
 				player.team = Team::RED;
 				player.isBot = true;
@@ -469,7 +749,7 @@ struct Matchmaker
 				room.playerList.push_back(player);
 				room.teamRed.push_back(&room.playerList.back());
 			}
-			while(room.teamBlue.size() < 3) {
+			while(room.teamBlue.size() < MatchQueue::TEAM_SIZE) {
 				Room::Player player(LFMT(L"Bot%d", botID++), AccountUID::INVALID, ClientHandle::INVALID);
 				player.team = Team::BLUE;
 				player.isBot = true;
@@ -478,40 +758,48 @@ struct Matchmaker
 				room.teamBlue.push_back(&room.playerList.back());
 			}
 
-			// send 'match found' packet to all instances
-			eastl::fixed_set<ClientHandle,16,false> setInstance;
-			foreach_const(pl, room.playerList) {
-				if(pl->instanceChd != ClientHandle::INVALID) {
-					setInstance.insert(pl->instanceChd);
-				}
+			In::MN_MatchingPartyFound resp;
+			resp.sortieUID = room.UID;
+			resp.playerCount = 0;
+			foreach(pl, room.playerList) {
+				In::RoomUser player;
+				player.name.Copy(pl->name);
+				player.accountUID = pl->accountUID;
+				player.team = (u8)pl->team;
+				player.isBot = pl->isBot;
+				resp.playerList[resp.playerCount++] = player;
 			}
 
-			foreach_const(chd, setInstance) {
-				In::MN_MatchingPartyFound resp;
-				resp.partyUID = *puid;
-				resp.sortieUID = room.UID;
+			// send 'match found' packet to all instances of each party
+			foreach_const(t, m->teams) {
+				foreach_const(puid, (*t)) {
+					const Party& party = *partyMap.at(*puid);
 
-				resp.playerCount = 0;
-				foreach(pl, room.playerList) {
-					In::RoomUser player;
-					player.name.Copy(pl->name);
-					player.accountUID = pl->accountUID;
-					player.team = (u8)pl->team;
-					player.isBot = pl->isBot;
-					resp.playerList[resp.playerCount++] = player;
-				}
+					eastl::fixed_set<ClientHandle,5,false> setInstance;
+					foreach_const(pl, party.memberList) {
+						setInstance.insert(pl->instanceChd);
+					}
 
-				SendPacket(*chd, resp);
+					resp.partyUID = *puid;
+					foreach_const(chd, setInstance) {
+						SendPacket(*chd, resp);
+					}
+				}
 			}
 		}
-		matchingPartyList.clear();
 	}
 
 	void UpdateRooms()
 	{
-		eastl::fixed_vector<SortieUID,128> removeList;
+		// only rooms where a player status changed since last update
+		eastl::sort(roomDirtyList.begin(), roomDirtyList.end());
+		auto dirtyEnd = eastl::unique(roomDirtyList.begin(), roomDirtyList.end());
+
+		for(auto it = roomDirtyList.begin(); it != dirtyEnd; ++it) {
+			auto found = roomMap.find(*it);
+			if(found == roomMap.end()) continue;
+			Room* r = &*found->second;
 
-		foreach(r, roomList) {
 			// check if all players have accepted the match
 			bool allAccepted = true;
 
@@ -547,12 +835,37 @@ struct Matchmaker
 				}
 			}
 		}
+
+		roomDirtyList.clear();
+	}
+
+	void RetryWaitingRooms()
+	{
+		if(roomWaitingServerList.empty()) return;
+
+		for(auto it = roomWaitingServerList.begin(); it != roomWaitingServerList.end(); ) {
+			auto found = roomMap.find(*it);
+			if(found == roomMap.end() || RoomCreateGame(*found->second)) {
+				it = roomWaitingServerList.erase(it);
+			}
+			else {
+				break; // still saturated, keep the order
+			}
+		}
 	}
 
-	void RoomCreateGame(Room& room)
+	// returns false when every play server is saturated
+	bool RoomCreateGame(Room& room)
 	{
+		Connection* conn = GetAvailablePlayServer();
+		if(!conn) {
+			WARN("No play server available, game waiting (sortieUID=%llu)", room.UID);
+			return false;
+		}
+
 		In::MQ_CreateGame packet;
 		packet.sortieUID = room.UID;
+		packet.mapIndex = MapIndex::PVP_DEATHMATCH; // the only map the play server has
 		packet.playerCount = 0;
 		packet.spectatorCount = 0;
 
@@ -578,20 +891,61 @@ struct Matchmaker
 			}
 		}
 
-		// TODO: choose game server based on load
-		Connection* conn = GetAvailablePlayServer();
-		ASSERT(conn);
 		SendPacket(conn->clientHd, packet);
+
+		Connection::Load::PendingGame pending;
+		pending.sortieUID = room.UID;
+		pending.sendTime = localTime;
+		conn->load.pendingGameList.push_back(pending);
+		return true;
+	}
+
+	// lost acks (or failed creations) would otherwise count against the server forever
+	void ExpirePendingGames(Connection::Load* load)
+	{
+		auto& list = load->pendingGameList;
+		auto end = eastl::remove_if(list.begin(), list.end(), [this](const Connection::Load::PendingGame& pg) {
+			return TimeDiffSec(TimeDiff(pg.sendTime, localTime)) >= PENDING_GAME_EXPIRE_SEC;
+		});
+
+		if(end != list.end()) {
+			WARN("Play server never acknowledged %d games, forgetting them", (i32)(list.end() - end));
+			list.erase(end, list.end());
+		}
 	}
 
+	// least loaded play server, nullptr when they are all saturated
 	Connection* GetAvailablePlayServer()
 	{
+		const f32 tickBudgetMs = (f32)(UPDATE_RATE * 1000.0);
+
+		Connection* best = nullptr;
+		f32 bestScore = 0;
+
 		foreach(c, connList) {
-			if(c->type == Connection::Type::PlayServer) {
-				return &*c;
+			if(c->type != Connection::Type::PlayServer) continue;
+
+			ExpirePendingGames(&c->load);
+
+			const Connection::Load& load = c->load;
+			const i32 games = load.gameCount + (i32)load.pendingGameList.size();
+			const i32 maxGames = load.reported ? load.maxGames : UNREPORTED_MAX_GAMES;
+			if(maxGames <= 0) continue;
+
+			// each resource relative to its saturation point, the server is as loaded as its most used one
+			const f32 gameLoad = (f32)games / maxGames;
+			const f32 tickLoad = load.tickP99Ms / (tickBudgetMs * SATURATED_TICK_RATIO);
+			const f32 busyLoad = (f32)load.busyPercent / SATURATED_BUSY_PERCENT;
+			const f32 score = MAX(gameLoad, MAX(tickLoad, busyLoad));
+			if(score >= 1.0f) continue;
+
+			if(!best || score < bestScore) {
+				best = &*c;
+				bestScore = score;
 			}
 		}
-		return nullptr; // TODO: return nothing when all servers are under heavy load and wait?
+
+		return best;
 	}
 
 	void Cleanup()
@@ -599,6 +953,20 @@ struct Matchmaker
 
 	}
 
+	// once to every hub the members are on
+	template<typename Packet>
+	void SendPartyPacket(const Party& party, const Packet& packet)
+	{
+		eastl::fixed_set<ClientHandle,5,false> setInstance;
+		foreach_const(mem, party.memberList) {
+			setInstance.insert(mem->instanceChd);
+		}
+
+		foreach_const(it, setInstance) {
+			SendPacket(*it, packet);
+		}
+	}
+
 	template<typename Packet>
 	inline void SendPacket(ClientHandle clientHd, const Packet& packet)
 	{
@@ -686,6 +1054,9 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
+	static NetStatsReporter netStats;
+	netStats.Init(NetRole::MATCHMAKER, Config().NetStatsIntervalSec, Config().NetStatsTop);
+
 	static Server server;
 	r = server.Init();
 	if(!r) {
@@ -706,11 +1077,16 @@ int main(int argc, char** argv)
 
 	static Matchmaker matchmaker(server);
 
+	MetricsServer metrics;
+	metrics.Init(Config().MetricsPort);
+
 	// listen on main thread
 	listen.Listen();
 
 	LOG("Cleaning up...");
 
+	metrics.Cleanup();
+	netStats.Cleanup();
 	matchmaker.Cleanup();
 	server.Cleanup();
 
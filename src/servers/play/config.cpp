@@ -5,9 +5,30 @@
 bool CConfigGame::ParseLine(const char* line)
 {
 	if(EA::StdC::Sscanf(line, "ListenPort=%d", &ListenPort) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MetricsPort=%d", &MetricsPort) == 1) return true;
+	if(EA::StdC::Sscanf(line, "NetStatsIntervalSec=%d", &NetStatsIntervalSec) == 1) return true;
+	if(EA::StdC::Sscanf(line, "NetStatsTop=%d", &NetStatsTop) == 1) return true;
 	if(EA::StdC::Sscanf(line, "DevMode=%d", &DevMode) == 1) return true;
 	if(EA::StdC::Sscanf(line, "DevQuickConnect=%d", &DevQuickConnect) == 1) return true;
 	if(EA::StdC::Sscanf(line, "TraceNetwork=%d", &TraceNetwork) == 1) return true;
+	if(EA::StdC::Sscanf(line, "SendCoalesceKB=%d", &SendCoalesceKB) == 1) return true;
+	if(EA::StdC::Sscanf(line, "SendMaxKB=%d", &SendMaxKB) == 1) return true;
+	if(EA::StdC::Sscanf(line, "Lanes=%d", &Lanes) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MaxGamesPerLane=%d", &MaxGamesPerLane) == 1) return true;
+	if(EA::StdC::Sscanf(line, "ConnectTimeoutSec=%d", &ConnectTimeoutSec) == 1) return true;
+	if(EA::StdC::Sscanf(line, "LingerSec=%d", &LingerSec) == 1) return true;
+	if(EA::StdC::Sscanf(line, "DevMigrateSec=%d", &DevMigrateSec) == 1) return true;
+	if(EA::StdC::Sscanf(line, "InstanceWorkers=%d", &InstanceWorkers) == 1) return true;
+	if(EA::StdC::Sscanf(line, "StartupWorkers=%d", &StartupWorkers) == 1) return true;
+	if(EA::StdC::Sscanf(line, "PvdConnect=%d", &PvdConnect) == 1) return true;
+	if(EA::StdC::Sscanf(line, "ContentReloadPollSec=%d", &ContentReloadPollSec) == 1) return true;
+	if(EA::StdC::Sscanf(line, "CollisionCacheKB=%d", &CollisionCacheKB) == 1) return true;
+	if(EA::StdC::Sscanf(line, "WarmInstancesPerMap=%d", &WarmInstancesPerMap) == 1) return true;
+	if(EA::StdC::Sscanf(line, "LaneAllocCheck=%d", &LaneAllocCheck) == 1) return true;
+	if(EA::StdC::Sscanf(line, "MemReportIntervalSec=%d", &MemReportIntervalSec) == 1) return true;
+	if(EA::StdC::Sscanf(line, "ProfileMemory=%d", &ProfileMemory) == 1) return true;
+	if(EA::StdC::Sscanf(line, "LaneTickBudgetMs=%f", &LaneTickBudgetMs) == 1) return true;
+	if(EA::StdC::Sscanf(line, "PipelineReplication=%d", &PipelineReplication) == 1) return true;
 	if(EA::StdC::Sscanf(line, "WindowWidth=%d", &WindowWidth) == 1) return true;
 	if(EA::StdC::Sscanf(line, "WindowHeight=%d", &WindowHeight) == 1) return true;
 
@@ -71,9 +92,30 @@ bool CConfigGame::SaveConfigFile()
 {
 	eastl::fixed_string<char,4096,false> out;
 	out.append_sprintf("ListenPort=%d\n", ListenPort);
+	out.append_sprintf("MetricsPort=%d\n", MetricsPort);
+	out.append_sprintf("NetStatsIntervalSec=%d\n", NetStatsIntervalSec);
+	out.append_sprintf("NetStatsTop=%d\n", NetStatsTop);
 	out.append_sprintf("DevMode=%d\n", DevMode);
 	out.append_sprintf("DevQuickConnect=%d\n", DevQuickConnect);
 	out.append_sprintf("TraceNetwork=%d\n", TraceNetwork);
+	out.append_sprintf("SendCoalesceKB=%d\n", SendCoalesceKB);
+	out.append_sprintf("SendMaxKB=%d\n", SendMaxKB);
+	out.append_sprintf("Lanes=%d\n", Lanes);
+	out.append_sprintf("MaxGamesPerLane=%d\n", MaxGamesPerLane);
+	out.append_sprintf("ConnectTimeoutSec=%d\n", ConnectTimeoutSec);
+	out.append_sprintf("LingerSec=%d\n", LingerSec);
+	out.append_sprintf("DevMigrateSec=%d\n", DevMigrateSec);
+	out.append_sprintf("InstanceWorkers=%d\n", InstanceWorkers);
+	out.append_sprintf("StartupWorkers=%d\n", StartupWorkers);
+	out.append_sprintf("PvdConnect=%d\n", PvdConnect);
+	out.append_sprintf("ContentReloadPollSec=%d\n", ContentReloadPollSec);
+	out.append_sprintf("CollisionCacheKB=%d\n", CollisionCacheKB);
+	out.append_sprintf("WarmInstancesPerMap=%d\n", WarmInstancesPerMap);
+	out.append_sprintf("LaneAllocCheck=%d\n", LaneAllocCheck);
+	out.append_sprintf("MemReportIntervalSec=%d\n", MemReportIntervalSec);
+	out.append_sprintf("ProfileMemory=%d\n", ProfileMemory);
+	out.append_sprintf("LaneTickBudgetMs=%f\n", LaneTickBudgetMs);
+	out.append_sprintf("PipelineReplication=%d\n", PipelineReplication);
 	out.append_sprintf("WindowWidth=%d\n", WindowWidth);
 	out.append_sprintf("WindowHeight=%d\n", WindowHeight);
 	out.append_sprintf("DbgCamPosX=%f\n", DbgCamPosX);
@@ -95,9 +137,30 @@ void CConfigGame::Print() const
 {
 	LOG("Config = {");
 	LOG("	ListenPort=%d", ListenPort);
+	LOG("	MetricsPort=%d", MetricsPort);
+	LOG("	NetStatsIntervalSec=%d", NetStatsIntervalSec);
+	LOG("	NetStatsTop=%d", NetStatsTop);
 	LOG("	DevMode=%d", DevMode);
 	LOG("	DevQuickConnect=%d", DevQuickConnect);
 	LOG("	TraceNetwork=%d", TraceNetwork);
+	LOG("	SendCoalesceKB=%d", SendCoalesceKB);
+	LOG("	SendMaxKB=%d", SendMaxKB);
+	LOG("	Lanes=%d", Lanes);
+	LOG("	MaxGamesPerLane=%d", MaxGamesPerLane);
+	LOG("	ConnectTimeoutSec=%d", ConnectTimeoutSec);
+	LOG("	LingerSec=%d", LingerSec);
+	LOG("	DevMigrateSec=%d", DevMigrateSec);
+	LOG("	InstanceWorkers=%d", InstanceWorkers);
+	LOG("	StartupWorkers=%d", StartupWorkers);
+	LOG("	PvdConnect=%d", PvdConnect);
+	LOG("	ContentReloadPollSec=%d", ContentReloadPollSec);
+	LOG("	CollisionCacheKB=%d", CollisionCacheKB);
+	LOG("	WarmInstancesPerMap=%d", WarmInstancesPerMap);
+	LOG("	LaneAllocCheck=%d", LaneAllocCheck);
+	LOG("	MemReportIntervalSec=%d", MemReportIntervalSec);
+	LOG("	ProfileMemory=%d", ProfileMemory);
+	LOG("	LaneTickBudgetMs=%f", LaneTickBudgetMs);
+	LOG("	PipelineReplication=%d", PipelineReplication);
 	LOG("	WindowWidth=%d", WindowWidth);
 	LOG("	WindowHeight=%d", WindowHeight);
 	LOG("	DbgCamPosX=%f", DbgCamPosX);
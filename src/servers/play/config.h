@@ -4,9 +4,30 @@
 struct CConfigGame
 {
 	i32 ListenPort = 12900;
+	i32 MetricsPort = 12990; // http://127.0.0.1:port/metrics, 0 to disable
+	i32 NetStatsIntervalSec = 30; // logs the top netIDs by bandwidth at that interval, 0 only plots them
+	i32 NetStatsTop = 10;
 	i32 DevMode = false;
 	i32 DevQuickConnect = false;
 	i32 TraceNetwork = false;
+	i32 SendCoalesceKB = 64; // queued bytes per client before moves/rotations only keep the latest state
+	i32 SendMaxKB = 4096; // queued bytes per client before disconnecting it
+	i32 Lanes = 1; // lane threads running games, each pinned to its own core (max MAX_LANES)
+	i32 MaxGamesPerLane = 16;
+	i32 ConnectTimeoutSec = 60; // games whose clients haven't all connected by then are aborted
+	i32 LingerSec = 30; // a game keeps running that long after its last client left, clients can rejoin meanwhile
+	f32 LaneTickBudgetMs = 12; // instances are migrated off lanes with a tick p99 above that
+	i32 PipelineReplication = false; // frames are encoded and sent by a thread per lane while the lane simulates the next tick
+	i32 DevMigrateSec = 0; // DevMode: moves a game to the next lane at this interval regardless of load, 0 to disable
+	i32 InstanceWorkers = 0; // 0: instances tick on their lane thread, N: instances tick as tasks on N work stealing threads
+	i32 StartupWorkers = 4; // threads loading the content at startup, 0: everything on the main thread
+	i32 PvdConnect = false; // connect to the PhysX Visual Debugger at startup
+	i32 ContentReloadPollSec = 5; // how often the content xml files are checked for changes to reload them, 0: never
+	i32 CollisionCacheKB = 8192; // map collision meshes no game uses are kept loaded up to this size
+	i32 WarmInstancesPerMap = 8; // games built ahead of time for each map, 0 builds every game on creation
+	i32 LaneAllocCheck = 0; // allocations made by a game tick once warmed up: 0 ignored, 1 logged, 2 assert
+	i32 MemReportIntervalSec = 60; // memory per subsystem is logged at this interval, 0 to disable
+	i32 ProfileMemory = 0; // Tracy memory profiling, one pool per subsystem
 	i32 WindowWidth = 1280;
 	i32 WindowHeight = 720;
 	f32 DbgCamPosX = 0;
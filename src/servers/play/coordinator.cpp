@@ -1,6 +1,7 @@
 #include <mxm/game_content.h>
 #include <common/packet_serialize.h>
 #include <common/inner_protocol.h>
+#include <EASTL/sort.h>
 #include <zlib.h>
 
 #include "coordinator.h"
@@ -16,8 +17,8 @@ intptr_t ThreadLane(void* pData)
     ThreadSetCoreAffinity(cpuID);
 
 	const f64 UPDATE_RATE_MS = (1.0/UPDATE_TICK_RATE) * 1000.0;
-	const Time startTime = TimeNow();
-	Time t0 = startTime;
+	const Time startTime = lane.pool->startTime;
+	Time t0 = TimeNow();
 
 	char name[256];
 	snprintf(name, sizeof(name), "Lane_%d", lane.laneIndex);
@@ -33,6 +34,7 @@ intptr_t ThreadLane(void* pData)
 		if(delta > UPDATE_RATE_MS) {
 			ProfileNewFrame(name);
 			lane.Update();
+			lane.RecordTick(TimeDurationSinceMs(t1));
 			t0 = Time((u64)t0 + (u64)TimeMsToTime(UPDATE_RATE_MS));
 		}
 		/*else {
@@ -83,37 +85,54 @@ intptr_t ThreadCoordinator(void* pData)
 
 static EA::Thread::AtomicUint32 g_NextInstanceUID = 1;
 
-void InstancePool::Lane::Update()
+const f64 LOAD_REPORT_INTERVAL = 1.0; // seconds
+
+static void TaskUpdatePvpInstance(void* object, void* context)
+{
+	PvpInstance& instance = *(PvpInstance*)object;
+	const InstancePool::Lane& lane = *(const InstancePool::Lane*)context;
+	instance.Update(lane.localTime);
+}
+
+const f64 MIGRATION_COOLDOWN = 5.0; // seconds, lets the load window of both lanes refresh
+
+static MetricGauge* LaneQueueMetric(i32 laneIndex, const char* queue)
+{
+	return MetricsAddGauge("lane_queue_depth", "Items waiting in a lane queue when the lane tick starts", FMT("lane=\"%d\",queue=\"%s\"", laneIndex, queue));
+}
+
+void InstancePool::Lane::HandleQueues()
 {
 	// create games
-	decltype(createGameQueue) gameList;
-	{ LOCK_MUTEX(mutexCreateGameQueue);
-		gameList = createGameQueue;
-		createGameQueue.clear();
-	}
+	createGameQueue.Drain([this](const CreateGameEntry& e) {
+		MEM_TAG(MemTag::INSTANCE);
+		PvpInstance* inst = e.instance;
+		if(!inst) {
+			inst = new PvpInstance();
+			inst->Acquire(e.info.mapIndex);
+		}
 
-	foreach_const(g, gameList) {
-		instancePvpList.emplace_back(g->sortieUID, *g, server);
-		auto inst = --instancePvpList.end();
-		instancePvpMap.emplace(inst->sortieUID, inst);
+		inst->Assign(e.info.sortieUID, e.info, server);
+		inst->game.replication.pipeline = replicationPipeline.IsEnabled() ? &replicationPipeline : nullptr;
+		instancePvpList.push_back(inst);
+		instancePvpMap.emplace(inst->sortieUID, --instancePvpList.end());
+		gameCount.SetValue(instancePvpList.size());
+		createGamePendingCount.Decrement();
 
-		LOG("[Lane_%d] Created game (sortieUID=%llu)", laneIndex, inst->sortieUID);
-	}
+		LOG("[Lane_%d] Created game (sortieUID=%llu %s %.3fms)", laneIndex, inst->sortieUID, e.instance ? "warm" : "cold", TimeDurationSinceMs(e.queueTime));
+	});
 
 	// on disconnected clients
-	decltype(clientDisconnectQueue) disconnectedList;
-	{ LOCK_MUTEX(mutexClientDisconnectQueue);
-		disconnectedList = clientDisconnectQueue;
-		clientDisconnectQueue.clear();
-	}
-
-	foreach_const(tr, disconnectedList) {
-		auto client = clientMap.at(*tr);
+	clientDisconnectQueue.Drain([this](ClientHandle clientHd) {
+		auto client = clientMap.at(clientHd);
 
 		switch(client->instanceType) {
 			case InstanceType::PVP_3V3: {
-				PvpInstance& instance = *instancePvpMap.at(client->sortieUID);
-				instance.OnClientsDisconnected(&client->clientHd, 1); // TODO: group client handles by instance
+				// the instance is gone when it was aborted
+				auto found = instancePvpMap.find(client->sortieUID);
+				if(found != instancePvpMap.end()) {
+					(*found->second)->OnClientsDisconnected(&client->clientHd, 1); // TODO: group client handles by instance
+				}
 			} break;
 
 			default: {
@@ -122,46 +141,166 @@ void InstancePool::Lane::Update()
 		}
 
 		clientList.erase(client);
-		clientMap.erase(*tr);
-		clientHandleSet.erase(*tr);
-		LOG("[Lane_%d][client%x] client disconnected", laneIndex, *tr);
-	}
+		clientMap.erase(clientHd);
+		clientHandleSet.erase(clientHd);
+		LOG("[Lane_%d][client%x] client disconnected", laneIndex, clientHd);
+	});
 
 	// on connected clients
-	decltype(clientConnectQueue) connectedList;
-	{ LOCK_MUTEX(mutexClientConnectQueue);
-		connectedList = clientConnectQueue;
-		clientConnectQueue.clear();
-	}
-
-	foreach_const(e, connectedList) {
+	clientConnectQueue.Drain([this](const ClientConnectEntry& e) {
 		clientList.push_back();
 		auto cit = --clientList.end();
 		Client& client = *cit;
-		clientMap.emplace(e->clientHd, cit);
-		clientHandleSet.insert(e->clientHd);
+		clientMap.emplace(e.clientHd, cit);
+		clientHandleSet.insert(e.clientHd);
 
-		client.clientHd = e->clientHd;
+		client.clientHd = e.clientHd;
 		client.instanceType = InstanceType::PVP_3V3;
-		client.sortieUID = e->sortieUID;
+		client.sortieUID = e.sortieUID;
+
+		// the game ended after the coordinator queued the client, its disconnect is handled like any other
+		auto found = instancePvpMap.find(client.sortieUID);
+		if(found == instancePvpMap.end()) {
+			WARN("[Lane_%d][client%x] Game has ended (sortieUID=%llu)", laneIndex, client.clientHd, client.sortieUID);
+			server->DisconnectClient(e.clientHd);
+			return;
+		}
 
-		PvpInstance& instance = *instancePvpMap.at(client.sortieUID);
-		eastl::pair<ClientHandle,AccountUID> list(e->clientHd, e->accountUID);
-		instance.OnClientsConnected(&list, 1); // TODO: group by instance
+		eastl::pair<ClientHandle,AccountUID> list(e.clientHd, e.accountUID);
+		(*found->second)->OnClientsConnected(&list, 1); // TODO: group by instance
 
 		LOG("[Lane_%d][client%x] client connected to sortie (sortieUID=%llu)", laneIndex, client.clientHd, client.sortieUID);
+	});
+}
+
+void InstancePool::Lane::RemoveFinishedInstances()
+{
+	for(auto it = instancePvpList.begin(); it != instancePvpList.end();) {
+		PvpInstance* inst = *it;
+		if(!inst->IsFinished()) {
+			++it;
+			continue;
+		}
+
+		LOG("[Lane_%d] Game ended (sortieUID=%llu arena used=%lluKB peak=%lluKB reserved=%lluKB chunks=%d)", laneIndex, inst->sortieUID,
+			(unsigned long long)inst->arena.usedBytes / 1024, (unsigned long long)inst->arena.peakBytes / 1024, (unsigned long long)inst->arena.reservedBytes / 1024, inst->arena.chunkCount);
+		pool->gameEndedQueue.Push(InstancePool::GameEndedEntry{ inst->sortieUID, (u8)laneIndex });
+		instancePvpMap.erase(inst->sortieUID);
+		auto cur = it++;
+		instancePvpList.erase(cur);
+		pool->warmer.Recycle(inst);
+	}
+}
+
+void InstancePool::Lane::DrainRoguePackets(MigrationHandoff* handoff)
+{
+	roguePacketQueue.Drain([this, handoff](QueueBlob& blob) {
+		if(handoff) {
+			const Server::RecvChunkHeader& ch = *(const Server::RecvChunkHeader*)blob.data;
+			foreach_const(c, handoff->clients) {
+				if(c->clientHd == ch.clientHd) {
+					handoff->roguePackets.push_back(blob);
+					return;
+				}
+			}
+		}
+
+		recvDataBuff.Append(blob.data, blob.size);
+		blob.Free();
+	});
+}
+
+void InstancePool::Lane::DetachInstance(SortieUID sortieUID, u8 toLane)
+{
+	auto found = instancePvpMap.find(sortieUID);
+	if(found == instancePvpMap.end()) {
+		LOG("[Lane_%d] Game ended before migrating (sortieUID=%llu)", laneIndex, sortieUID);
+		return;
 	}
 
-	// handle client packets
-	{ LOCK_MUTEX(mutexRoguePacketsQueue);
-		recvDataBuff.Append(roguePacketsQueue.data, roguePacketsQueue.size);
-		roguePacketsQueue.Clear();
+	MigrationHandoff* handoff = new MigrationHandoff;
+	handoff->instance = *found->second;
+	handoff->instance->workerAffinity = -1;
+	instancePvpList.erase(found->second);
+	instancePvpMap.erase(found);
+
+	// clients go with their instance
+	for(auto c = clientList.begin(); c != clientList.end();) {
+		if(c->sortieUID == sortieUID) {
+			handoff->clients.push_back(*c);
+			clientMap.erase(c->clientHd);
+			clientHandleSet.erase(c->clientHd);
+			auto cur = c++;
+			clientList.erase(cur);
+		}
+		else {
+			++c;
+		}
+	}
+
+	DrainRoguePackets(handoff);
+
+	LOG("[Lane_%d] Game migrating to Lane_%d (sortieUID=%llu clients=%d)", laneIndex, toLane, sortieUID, (i32)handoff->clients.size());
+	pool->lanes[toLane].migrateInQueue.Push(handoff);
+}
+
+void InstancePool::Lane::AttachInstance(MigrationHandoff* handoff)
+{
+	PvpInstance* inst = handoff->instance;
+	inst->game.replication.pipeline = replicationPipeline.IsEnabled() ? &replicationPipeline : nullptr; // waits on the other lane pipeline for the frame in flight
+	instancePvpList.push_back(inst);
+	instancePvpMap.emplace(inst->sortieUID, --instancePvpList.end());
+
+	foreach_const(c, handoff->clients) {
+		clientList.push_back(*c);
+		auto cit = --clientList.end();
+		clientMap.emplace(c->clientHd, cit);
+		clientHandleSet.insert(c->clientHd);
+	}
+
+	foreach(b, handoff->roguePackets) {
+		recvDataBuff.Append(b->data, b->size);
+		b->Free();
 	}
 
+	LOG("[Lane_%d] Game migrated in (sortieUID=%llu clients=%d)", laneIndex, inst->sortieUID, (i32)handoff->clients.size());
+	pool->migrationDoneQueue.Push(inst->sortieUID);
+	delete handoff;
+}
+
+void InstancePool::Lane::Update()
+{
+	metrics.mmPacketQueue->Set(mmPacketQueue.Size());
+	metrics.roguePacketQueue->Set(roguePacketQueue.Size());
+	metrics.clientConnectQueue->Set(clientConnectQueue.Size());
+	metrics.clientDisconnectQueue->Set(clientDisconnectQueue.Size());
+	metrics.createGameQueue->Set(createGameQueue.Size());
+
+	// instances migrated from another lane
+	migrateInQueue.Drain([this](MigrationHandoff* handoff) {
+		AttachInstance(handoff);
+	});
+
+	HandleQueues();
+
+	// instances whose clients all left, before migrations so an ended game never moves
+	RemoveFinishedInstances();
+
+	// instances migrating to another lane
+	migrateOutQueue.Drain([this](const MigrateRequest& req) {
+		// everything queued for the instance before the request is visible now, handle it before it leaves
+		HandleQueues();
+		DetachInstance(req.sortieUID, req.toLane);
+	});
+
+	// handle client packets
+	DrainRoguePackets(nullptr);
+
 	eastl::fixed_vector<ClientHandle,MAX_CLIENTS> clientList;
 	eastl::copy(clientHandleSet.begin(), clientHandleSet.end(), eastl::back_inserter(clientList));
 
-	server->TransferReceivedData(&recvDataBuff, clientList.data(), clientList.size());
+	Time inputRecvTime = Time::ZERO;
+	server->TransferReceivedData(&recvDataBuff, clientList.data(), clientList.size(), &inputRecvTime);
 
 	ClientHandle curClientHd = ClientHandle::INVALID;
 	PvpInstance* curPvpInstance = nullptr;
@@ -170,10 +309,11 @@ void InstancePool::Lane::Update()
 	ConstBuffer buff(recvDataBuff.data, recvDataBuff.size);
 	while(buff.CanRead(sizeof(Server::RecvChunkHeader))) {
 		const Server::RecvChunkHeader& chunkInfo = buff.Read<Server::RecvChunkHeader>();
-		const u8* data = buff.ReadRaw(chunkInfo.len);
+		u8* data = (u8*)buff.ReadRaw(chunkInfo.len);
 
 		// handle each packet in chunk
-		ConstBuffer reader(data, chunkInfo.len);
+		const i32 len = inputCoalescer.Coalesce(data, chunkInfo.len);
+		ConstBuffer reader(data, len);
 		if(!reader.CanRead(sizeof(NetHeader))) {
 			WARN("Packet too small (clientHd=%u size=%d)", chunkInfo.clientHd, chunkInfo.len);
 			server->DisconnectClient(chunkInfo.clientHd);
@@ -203,7 +343,10 @@ void InstancePool::Lane::Update()
 				const Client& client = *clientMap.at(curClientHd);
 				switch(client.instanceType) {
 					case InstanceType::PVP_3V3: {
-						curPvpInstance = &*instancePvpMap.at(client.sortieUID);
+						auto found = instancePvpMap.find(client.sortieUID);
+						if(found != instancePvpMap.end()) {
+							curPvpInstance = *found->second;
+						}
 					} break;
 
 					default: {
@@ -212,21 +355,21 @@ void InstancePool::Lane::Update()
 				}
 			}
 
+			// packets of clients whose game has ended are dropped
 			if(curPvpInstance) {
 				curPvpInstance->OnClientPacket(curClientHd, header, packetData);
 			}
-			else {
-				ASSERT_MSG(0, "case not handled");
-			}
 		}
 	}
 
 	recvDataBuff.Clear();
 
+	ProfilePlotVarN("Input packets", (i64)inputCoalescer.packetCount);
+	ProfilePlotVarN("Input packets coalesced", (i64)inputCoalescer.coalescedCount);
+
 	// matchmaker packets
-	GrowableBuffer& backQueue = mmPacketQueues[!mmPacketQueueFront];
-	if(backQueue.size > 0) {
-		ConstBuffer reader(backQueue.data, backQueue.size);
+	mmPacketQueue.Drain([this](QueueBlob& blob) {
+		ConstBuffer reader(blob.data, blob.size);
 		while(reader.CanRead(sizeof(NetHeader))) {
 			const NetHeader& header = reader.Read<NetHeader>();
 			const i32 packetDataSize = header.size - sizeof(NetHeader);
@@ -235,41 +378,195 @@ void InstancePool::Lane::Update()
 
 			// TODO: filter packets so we don't send everything everywhere
 			foreach(room, instancePvpList) {
-				room->OnMatchmakerPacket(header, packetData);
+				(*room)->OnMatchmakerPacket(header, packetData);
 			}
 		}
-		backQueue.Clear();
+		blob.Free();
+	});
+
+	// update instances
+	// packets have all been handled above, instances only send from now on (send buffers are locked per client)
+	if(scheduler->IsEnabled()) {
+		TaskScheduler::Batch batch;
+		foreach(room, instancePvpList) {
+			scheduler->Submit(&batch, TaskUpdatePvpInstance, *room, this, &(*room)->workerAffinity);
+		}
+		scheduler->Wait(&batch);
+	}
+	else {
+		foreach(room, instancePvpList) {
+			(*room)->Update(localTime);
+		}
 	}
 
-	{ LOCK_MUTEX(mutexMatchmakerPacketsQueue);
-		mmPacketQueueFront ^= 1;
+	// measured from the oldest input the instances got this tick to every frame queued for sending: now, or when the pipeline is done with the tick
+	if(inputRecvTime != Time::ZERO) {
+		if(replicationPipeline.IsEnabled()) {
+			replicationPipeline.SubmitTickEnd(inputRecvTime);
+		}
+		else {
+			metrics.inputToFrameMs->Observe(TimeDurationSinceMs(inputRecvTime));
+		}
 	}
+}
 
-	// update instances
-	foreach(room, instancePvpList) {
-		room->Update(localTime);
+void InstancePool::Lane::RecordTick(f64 durationMs)
+{
+	metrics.tickMs->Observe(durationMs);
+	metrics.instances->Set(instancePvpList.size());
+	metrics.clients->Set(clientList.size());
+	gameCount.SetValue(instancePvpList.size());
+	playerCount.SetValue(clientList.size());
+
+	if(tickDurationList.empty()) {
+		loadWindowStart = TimeNow();
+		loadWindowBusyMs = 0;
+	}
+
+	tickDurationList.push_back((f32)durationMs);
+	loadWindowBusyMs += durationMs;
+
+	if(!tickDurationList.full()) return;
+
+	const f64 windowMs = TimeDurationSinceMs(loadWindowStart);
+
+	// 99th percentile of the window
+	const i32 p99 = (tickDurationList.size() * 99) / 100;
+	eastl::nth_element(tickDurationList.begin(), tickDurationList.begin() + p99, tickDurationList.end());
+
+	LoadStats stats;
+	stats.tickP99Ms = tickDurationList[p99];
+	stats.busyPercent = (u8)MIN(100.0, windowMs > 0 ? (loadWindowBusyMs / windowMs) * 100.0 : 0.0);
+
+	tickDurationList.clear();
+
+	InstanceCostList costList;
+	foreach(inst, instancePvpList) {
+		PvpInstance::CostAccumulator& cost = (*inst)->cost;
+		if(cost.tickCount > 0) {
+			InstanceCost ic;
+			ic.sortieUID = (*inst)->sortieUID;
+			ic.totalMs = (f32)(cost.totalMs / cost.tickCount);
+			ic.worldMs = (f32)(cost.worldMs / cost.tickCount);
+			ic.replicationMs = (f32)(cost.replicationMs / cost.tickCount);
+			costList.push_back(ic);
+		}
+		cost = PvpInstance::CostAccumulator();
 	}
+
+	LOCK_MUTEX(mutexLoadStats);
+	loadStats = stats;
+	instanceCostList = costList;
+}
+
+i32 InstancePool::Lane::GetGameCount()
+{
+	// pending first: a game created in between is counted twice rather than not at all
+	const i32 pending = (i32)createGamePendingCount.GetValue();
+	return pending + (i32)gameCount.GetValue();
+}
+
+InstancePool::Lane::LoadStats InstancePool::Lane::GetLoadStats()
+{
+	LOCK_MUTEX(mutexLoadStats);
+	return loadStats;
+}
+
+void InstancePool::Lane::GetInstanceCosts(InstanceCostList* out)
+{
+	LOCK_MUTEX(mutexLoadStats);
+	*out = instanceCostList;
 }
 
 void InstancePool::Lane::Cleanup()
 {
+	replicationPipeline.Cleanup();
+
 	foreach(inst, instancePvpList) {
-		inst->game.Cleanup();
+		(*inst)->game.Cleanup();
+		delete *inst;
 	}
+	instancePvpList.clear();
+	instancePvpMap.clear();
+
+	migrateInQueue.Drain([](MigrationHandoff* handoff) {
+		handoff->instance->game.Cleanup();
+		delete handoff->instance;
+		foreach(b, handoff->roguePackets) {
+			b->Free();
+		}
+		delete handoff;
+	});
+
+	mmPacketQueue.Drain([](QueueBlob& blob) { blob.Free(); });
+	roguePacketQueue.Drain([](QueueBlob& blob) { blob.Free(); });
 }
 
 bool InstancePool::Init(Server* server_)
 {
 	server = server_;
 
-	int laneIndex = 0;
-	foreach(l, lanes) {
+	laneCount = Config().Lanes;
+	if(laneCount < 1 || laneCount > MAX_LANES) {
+		WARN("Lanes=%d out of range, clamped to [1, %d]", laneCount, MAX_LANES);
+		laneCount = clamp(laneCount, 1, MAX_LANES);
+	}
+
+	bool r = scheduler.Init(Config().InstanceWorkers, (i32)CoreAffinity::LANES + laneCount);
+	if(!r) return false;
+
+	startTime = TimeNow();
+	clientSortie.fill(SortieUID::INVALID);
+	migrationDoneQueue.Init();
+	gameEndedQueue.Init();
+
+	const MapIndex warmMapList[] = { MapIndex::PVP_DEATHMATCH };
+	r = warmer.Init(warmMapList, ARRAY_COUNT(warmMapList), Config().WarmInstancesPerMap);
+	if(!r) return false;
+
+	metrics.migrationDoneQueue = MetricsAddGauge("coordinator_queue_depth", "Items waiting in a coordinator queue", "queue=\"migration_done\"");
+	metrics.gameEndedQueue = MetricsAddGauge("coordinator_queue_depth", "Items waiting in a coordinator queue", "queue=\"game_ended\"");
+	metrics.migrations = MetricsAddGauge("instance_migrations", "Instances moving between lanes");
+	for(i32 i = 0; i < warmer.mapCount; i++) {
+		metrics.warmReady[i] = MetricsAddGauge("warm_instances_ready", "Instances built ahead of time, ready to be handed to a lane", FMT("map=\"%d\"", (i32)warmer.mapPoolList[i].mapIndex));
+	}
+
+	for(i32 i = 0; i < laneCount; i++) {
+		Lane* l = &lanes[i];
+		l->pool = this;
 		l->server = server_;
-		l->laneIndex = laneIndex++;
-		l->mmPacketQueues[0].Init(1 * (1024*1024)); // 1 MB
-		l->mmPacketQueues[1].Init(1 * (1024*1024)); // 1 MB
+		l->scheduler = &scheduler;
+		l->laneIndex = i;
+		l->mmPacketQueue.Init(64);
+		l->roguePacketQueue.Init(4096);
+		l->clientDisconnectQueue.Init(MAX_CLIENTS);
+		l->clientConnectQueue.Init(MAX_CLIENTS);
+		l->createGameQueue.Init();
+		l->createGamePendingCount.SetValue(0);
+		l->gameCount.SetValue(0);
+		l->playerCount.SetValue(0);
+		l->migrateOutQueue.Init(16);
+		l->migrateInQueue.Init(16);
 		l->recvDataBuff.Init(10 * (1024*1024)); // 10MB
-		l->thread.Begin(ThreadLane, &*l);
+		l->inputCoalescer.AddInputType(Cl::CN_GameUpdatePosition::NET_ID);
+		l->inputCoalescer.AddInputType(Cl::CN_GameUpdateRotation::NET_ID);
+
+		Lane::Metrics& m = l->metrics;
+		m.tickMs = MetricsAddHistogram("lane_tick_ms", "Lane tick duration", METRICS_TICK_MS_BOUNDS, ARRAY_COUNT(METRICS_TICK_MS_BOUNDS), FMT("lane=\"%d\"", l->laneIndex));
+		m.inputToFrameMs = MetricsAddHistogram("lane_input_to_frame_ms", "Client input received to the frame it changed queued for sending", METRICS_TICK_MS_BOUNDS, ARRAY_COUNT(METRICS_TICK_MS_BOUNDS), FMT("lane=\"%d\"", l->laneIndex));
+		m.instances = MetricsAddGauge("lane_instances", "Instances on the lane", FMT("lane=\"%d\"", l->laneIndex));
+		m.clients = MetricsAddGauge("lane_clients", "Clients in the lane instances", FMT("lane=\"%d\"", l->laneIndex));
+		m.mmPacketQueue = LaneQueueMetric(l->laneIndex, "matchmaker_packets");
+		m.roguePacketQueue = LaneQueueMetric(l->laneIndex, "rogue_packets");
+		m.clientConnectQueue = LaneQueueMetric(l->laneIndex, "client_connect");
+		m.clientDisconnectQueue = LaneQueueMetric(l->laneIndex, "client_disconnect");
+		m.createGameQueue = LaneQueueMetric(l->laneIndex, "create_game");
+
+		if(Config().PipelineReplication) {
+			l->replicationPipeline.Init(l->laneIndex, m.inputToFrameMs);
+		}
+
+		l->thread.Begin(ThreadLane, l);
 	}
 
 	return true;
@@ -277,17 +574,200 @@ bool InstancePool::Init(Server* server_)
 
 void InstancePool::Cleanup()
 {
-	foreach(l, lanes) {
-		l->thread.WaitForEnd();
+	for(i32 i = 0; i < laneCount; i++) {
+		lanes[i].thread.WaitForEnd();
+	}
+	scheduler.Cleanup();
+	warmer.Cleanup();
+
+	foreach(m, migrationList) {
+		foreach(b, m->heldRoguePackets) {
+			b->Free();
+		}
+	}
+	migrationList.clear();
+}
+
+void InstancePool::Update(Time localTime)
+{
+	metrics.migrationDoneQueue->Set(migrationDoneQueue.Size());
+	metrics.gameEndedQueue->Set(gameEndedQueue.Size());
+	metrics.migrations->Set(migrationList.size());
+	for(i32 i = 0; i < warmer.mapCount; i++) {
+		metrics.warmReady[i]->Set(warmer.mapPoolList[i].readyCount.GetValue());
+	}
+
+	// migrations done, route the instance to its new lane
+	SortieUID sortieUID;
+	while(migrationDoneQueue.TryPop(&sortieUID)) {
+		Migration* m = FindMigration(sortieUID);
+		if(!m) continue; // the game already ended on its new lane, see below
+
+		LOG("[InstancePool] Game migrated from Lane_%d to Lane_%d (sortieUID=%llu)", m->fromLane, m->toLane, sortieUID);
+		FinishMigration(m, m->toLane, false);
+	}
+
+	// ended games, a migration requested after the game ended never happens
+	GameEndedEntry ended;
+	while(gameEndedQueue.TryPop(&ended)) {
+		// the game ended on either lane before the migration was done, its clients are still on that lane
+		Migration* m = FindMigration(ended.sortieUID);
+		if(m) {
+			LOG("[InstancePool] Game ended while migrating from Lane_%d to Lane_%d (sortieUID=%llu lane=%d)", m->fromLane, m->toLane, ended.sortieUID, ended.lane);
+			FinishMigration(m, ended.lane, true);
+		}
+
+		sortieLocation.erase(ended.sortieUID);
+	}
+
+	BalanceLanes(localTime);
+	DevMigrate(localTime);
+}
+
+bool InstancePool::MigrateInstance(SortieUID sortieUID, u8 toLane)
+{
+	ASSERT(toLane < laneCount);
+
+	auto found = sortieLocation.find(sortieUID);
+	if(found == sortieLocation.end()) {
+		WARN("Game not found (sortieUID=%llu)", sortieUID);
+		return false;
+	}
+
+	const u8 fromLane = found->second;
+	if(fromLane == toLane) return false;
+	if(FindMigration(sortieUID)) return false;
+	if(migrationList.full()) return false;
+
+	Migration& m = migrationList.push_back();
+	m.sortieUID = sortieUID;
+	m.fromLane = fromLane;
+	m.toLane = toLane;
+
+	Lane::MigrateRequest req;
+	req.sortieUID = sortieUID;
+	req.toLane = toLane;
+	lanes[fromLane].migrateOutQueue.Push(req);
+	return true;
+}
+
+InstancePool::Migration* InstancePool::FindMigration(SortieUID sortieUID)
+{
+	foreach(m, migrationList) {
+		if(m->sortieUID == sortieUID) return &*m;
+	}
+	return nullptr;
+}
+
+void InstancePool::FinishMigration(Migration* m, u8 lane, bool gameEnded)
+{
+	sortieLocation.at(m->sortieUID) = lane;
+	for(i32 clientID = 0; clientID < MAX_CLIENTS; clientID++) {
+		if(clientHandle[clientID] != ClientHandle::INVALID && clientSortie[clientID] == m->sortieUID) {
+			clientLocation[clientID].lane = lane;
+		}
+	}
+
+	// a client that connected then left during the migration was taken off heldConnects (QueuePopPlayers)
+	Lane& l = lanes[lane];
+	foreach_const(e, m->heldConnects) {
+		l.clientConnectQueue.Push(*e);
+	}
+	foreach_const(hd, m->heldDisconnects) {
+		l.clientDisconnectQueue.Push(*hd);
 	}
+	foreach(b, m->heldRoguePackets) {
+		if(gameEnded) {
+			b->Free();
+		}
+		else {
+			l.roguePacketQueue.Push(*b);
+		}
+	}
+
+	migrationList.erase_unsorted(m);
 }
 
-void InstancePool::QueuePushPlayerToGame(ClientHandle clientHd, AccountUID accountUID, SortieUID sortieUID)
+void InstancePool::BalanceLanes(Time localTime)
 {
+	if(laneCount < 2) return;
+	if(!migrationList.empty()) return; // one at a time
+	if(lastMigrationTime != Time::ZERO && TimeDiffSec(TimeDiff(lastMigrationTime, localTime)) < MIGRATION_COOLDOWN) return;
+
+	const f32 budgetMs = Config().LaneTickBudgetMs;
+
+	i32 heavy = -1;
+	i32 light = -1;
+	eastl::array<Lane::LoadStats,MAX_LANES> stats;
+	for(i32 i = 0; i < laneCount; i++) {
+		stats[i] = lanes[i].GetLoadStats();
+		if(heavy == -1 || stats[i].tickP99Ms > stats[heavy].tickP99Ms) heavy = i;
+		if(light == -1 || stats[i].tickP99Ms < stats[light].tickP99Ms) light = i;
+	}
+
+	if(heavy == light) return;
+	if(stats[heavy].tickP99Ms <= budgetMs) return;
+	if(lanes[light].GetGameCount() >= Config().MaxGamesPerLane) return;
+
+	// the instance has to fit in the light lane budget, and moving it must narrow the gap between both lanes
+	const f32 excessMs = stats[heavy].tickP99Ms - budgetMs;
+	const f32 roomMs = budgetMs - stats[light].tickP99Ms;
+	const f32 gapMs = stats[heavy].tickP99Ms - stats[light].tickP99Ms;
+
+	Lane::InstanceCostList costList;
+	lanes[heavy].GetInstanceCosts(&costList);
+
+	// closest to the excess
+	const Lane::InstanceCost* best = nullptr;
+	foreach_const(c, costList) {
+		if(c->totalMs <= 0 || c->totalMs > roomMs || c->totalMs >= gapMs) continue;
+		if(!best || fabs(c->totalMs - excessMs) < fabs(best->totalMs - excessMs)) {
+			best = &*c;
+		}
+	}
+
+	if(!best) return;
+
+	LOG("[InstancePool] Lane_%d over budget (p99=%.2fms budget=%.2fms), migrating game to Lane_%d (sortieUID=%llu cost=%.2fms world=%.2fms replication=%.2fms)",
+		heavy, stats[heavy].tickP99Ms, budgetMs, light, best->sortieUID, best->totalMs, best->worldMs, best->replicationMs);
+
+	if(MigrateInstance(best->sortieUID, (u8)light)) {
+		lastMigrationTime = localTime;
+	}
+}
+
+void InstancePool::DevMigrate(Time localTime)
+{
+	// moves games around so the migration handoff runs without having to overload a lane
+	if(!Config().DevMode || Config().DevMigrateSec <= 0) return;
+	if(laneCount < 2) return;
+	if(!migrationList.empty() || sortieLocation.empty()) return;
+	if(TimeDiffSec(TimeDiff(lastDevMigrationTime, localTime)) < Config().DevMigrateSec) return;
+
+	lastDevMigrationTime = localTime;
+
+	// a different game each time
+	auto s = sortieLocation.begin();
+	eastl::advance(s, devMigrationCount++ % (i32)sortieLocation.size());
+
+	const u8 toLane = (u8)((s->second + 1) % laneCount);
+	LOG("[InstancePool] DevMigrateSec: migrating game from Lane_%d to Lane_%d (sortieUID=%llu)", s->second, toLane, s->first);
+	MigrateInstance(s->first, toLane);
+}
+
+bool InstancePool::QueuePushPlayerToGame(ClientHandle clientHd, AccountUID accountUID, SortieUID sortieUID)
+{
+	auto found = sortieLocation.find(sortieUID);
+	if(found == sortieLocation.end()) {
+		WARN("Game not found, it has ended (clientHd=%u sortieUID=%llu)", clientHd, sortieUID);
+		return false;
+	}
+
 	const i32 clientID = plidMap.Push(clientHd);
 	clientHandle[clientID] = clientHd;
+	clientSortie[clientID] = sortieUID;
 
-	u8 laneID = sortieLocation.at(sortieUID);
+	const u8 laneID = found->second;
 	clientLocation[clientID].lane = laneID;
 
 	Lane& l = lanes[laneID];
@@ -297,8 +777,14 @@ void InstancePool::QueuePushPlayerToGame(ClientHandle clientHd, AccountUID accou
 	entry.accountUID = accountUID;
 	entry.sortieUID = sortieUID;
 
-	LOCK_MUTEX(l.mutexClientConnectQueue);
-	l.clientConnectQueue.push_back(entry);
+	Migration* m = FindMigration(sortieUID);
+	if(m) {
+		m->heldConnects.push_back(entry);
+		return true;
+	}
+
+	l.clientConnectQueue.Push(entry);
+	return true;
 }
 
 void InstancePool::QueuePopPlayers(const ClientHandle* clientList, const i32 count)
@@ -312,21 +798,76 @@ void InstancePool::QueuePopPlayers(const ClientHandle* clientList, const i32 cou
 		Lane& l = lanes[clientLocation[clientID].lane];
 		clientLocation[clientID] = ClientLocation::Null();
 
-		// TODO: very bad locking
-		LOCK_MUTEX(l.mutexClientDisconnectQueue);
-		l.clientDisconnectQueue.push_back(clientHd);
+		Migration* m = FindMigration(clientSortie[clientID]);
+		clientSortie[clientID] = SortieUID::INVALID;
+		if(m) {
+			// never reached a lane, the lane drains disconnects before connects
+			auto held = eastl::find_if(m->heldConnects.begin(), m->heldConnects.end(), [clientHd](const Lane::ClientConnectEntry& e) { return e.clientHd == clientHd; });
+			if(held != m->heldConnects.end()) {
+				m->heldConnects.erase(held);
+				continue;
+			}
+
+			m->heldDisconnects.push_back(clientHd);
+			continue;
+		}
+
+		l.clientDisconnectQueue.Push(clientHd);
 	}
 }
 
 void InstancePool::QueueCreateGame(const In::MQ_CreateGame& gameInfo)
 {
-	// TODO: choose lane based on load
-	Lane& l = lanes.front();
+	// pick the lane with the fewest games, counting the ones not created yet
+	// tick time breaks ties
+	u8 laneID = 0;
+	i32 bestGameCount = INT32_MAX;
+	f32 bestTickMs = 0;
+
+	for(i32 i = 0; i < laneCount; i++) {
+		Lane& l = lanes[i];
+		const Lane::LoadStats stats = l.GetLoadStats();
+
+		const i32 gameCount = l.GetGameCount();
+
+		if(gameCount < bestGameCount || (gameCount == bestGameCount && stats.tickP99Ms < bestTickMs)) {
+			laneID = (u8)i;
+			bestGameCount = gameCount;
+			bestTickMs = stats.tickP99Ms;
+		}
+	}
 
-	sortieLocation.emplace(gameInfo.sortieUID, 0);
+	if(bestGameCount >= Config().MaxGamesPerLane) {
+		WARN("Every lane is full, creating game anyway (sortieUID=%llu lane=%d games=%d)", gameInfo.sortieUID, laneID, bestGameCount);
+	}
 
-	LOCK_MUTEX(l.mutexCreateGameQueue);
-	l.createGameQueue.push_back(gameInfo);
+	Lane& l = lanes[laneID];
+	sortieLocation.emplace(gameInfo.sortieUID, laneID);
+
+	Lane::CreateGameEntry entry;
+	entry.info = gameInfo;
+	entry.instance = warmer.Take(gameInfo.mapIndex);
+	entry.queueTime = TimeNow();
+
+	l.createGamePendingCount.Increment();
+	l.createGameQueue.Push(entry);
+}
+
+void InstancePool::GetLoadReport(In::PQ_LoadReport* out)
+{
+	STATIC_ASSERT(MAX_LANES <= sizeof(out->lanes)/sizeof(out->lanes[0]));
+
+	out->maxGamesPerLane = (u16)Config().MaxGamesPerLane;
+	out->laneCount = (u8)laneCount;
+
+	for(i32 i = 0; i < laneCount; i++) {
+		const Lane::LoadStats stats = lanes[i].GetLoadStats();
+		In::PQ_LoadReport::Lane& l = out->lanes[i];
+		l.gameCount = (u16)lanes[i].gameCount.GetValue();
+		l.playerCount = (u16)lanes[i].playerCount.GetValue();
+		l.tickP99Ms = stats.tickP99Ms;
+		l.busyPercent = stats.busyPercent;
+	}
 }
 
 void InstancePool::QueueRogueCoordinatorPacket(ClientHandle clientHd, const NetHeader& header, const u8* packetData)
@@ -335,23 +876,34 @@ void InstancePool::QueueRogueCoordinatorPacket(ClientHandle clientHd, const NetH
 	const ClientLocation& loc = clientLocation[clientID];
 	Lane& l = lanes[loc.lane];
 
-	LOCK_MUTEX(l.mutexRoguePacketsQueue);
 	Server::RecvChunkHeader ch;
 	ch.clientHd = clientHd;
 	ch.len = header.size;
-	l.roguePacketsQueue.Append(&ch, sizeof(ch));
-	l.roguePacketsQueue.Append(&header, sizeof(header));
-	l.roguePacketsQueue.Append(packetData, header.size - sizeof(header));
+
+	QueueBlob blob;
+	blob.size = sizeof(ch) + header.size;
+	blob.data = (u8*)memAlloc(blob.size);
+	memmove(blob.data, &ch, sizeof(ch));
+	memmove(blob.data + sizeof(ch), &header, sizeof(header));
+	memmove(blob.data + sizeof(ch) + sizeof(header), packetData, header.size - sizeof(header));
+
+	Migration* m = FindMigration(clientSortie[clientID]);
+	if(m) {
+		m->heldRoguePackets.push_back(blob);
+		return;
+	}
+
+	l.roguePacketQueue.Push(blob);
 }
 
 void InstancePool::QueueMatchmakerPackets(const u8* buffer, u32 bufferSize)
 {
 	// TODO: filter packets here as well?
 
-	foreach(l, lanes) {
-		Lane& lane = *l;
-		LOCK_MUTEX(lane.mutexMatchmakerPacketsQueue);
-		lane.mmPacketQueues[lane.mmPacketQueueFront].Append(buffer, bufferSize);
+	if(bufferSize == 0) return;
+
+	for(i32 i = 0; i < laneCount; i++) {
+		lanes[i].mmPacketQueue.Push(QueueBlob::Copy(buffer, bufferSize));
 	}
 }
 
@@ -361,6 +913,7 @@ bool Coordinator::Init(Server* server_)
 	recvDataBuff.Init(10 * (1024*1024)); // 10 MB
 
 	clientHandle.fill(ClientHandle::INVALID);
+	pendingClientsMetric = MetricsAddGauge("coordinator_pending_clients", "Clients expected by a game that have not connected yet");
 
 	bool r = matchmaker.Init();
 	if(!r) return false;
@@ -382,15 +935,63 @@ void Coordinator::Cleanup()
 
 	instancePool.Cleanup();
 	thread.WaitForEnd();
+
+	memReport.Sample();
+	memReport.Print();
 }
 
 void Coordinator::Update()
 {
 	ProfileFunction();
 
+	// report load to the matchmaker
+	if(TimeDiffSec(TimeDiff(lastLoadReportTime, localTime)) >= LOAD_REPORT_INTERVAL) {
+		lastLoadReportTime = localTime;
+
+		In::PQ_LoadReport report;
+		instancePool.GetLoadReport(&report);
+		matchmaker.QueryLoadReport(report);
+
+		memReport.Sample();
+		memReport.Plot();
+
+		// drop the entries of ended games
+		i32 pendingCount = 0;
+		for(auto e = pendingClientQueue.begin(); e != pendingClientQueue.end();) {
+			if(!instancePool.IsGameRunning(e->sortieUID)) {
+				e = pendingClientQueue.erase(e);
+				continue;
+			}
+			if(!e->authenticated) pendingCount++;
+			++e;
+		}
+		pendingClientsMetric->Set(pendingCount);
+
+		// the quick connect game times out or ends like any other, keep one around
+		if(Config().DevMode && Config().DevQuickConnect && !instancePool.IsGameRunning(SortieUID(1))) {
+			CreateDevGame();
+		}
+	}
+
+	if(Config().MemReportIntervalSec > 0 && TimeDiffSec(TimeDiff(lastMemReportTime, localTime)) >= Config().MemReportIntervalSec) {
+		lastMemReportTime = localTime;
+		memReport.Print();
+	}
+
+	// content hot reload, games created after the swap get the new generation
+	if(Config().ContentReloadPollSec > 0 && TimeDiffSec(TimeDiff(lastContentCheckTime, localTime)) >= Config().ContentReloadPollSec) {
+		lastContentCheckTime = localTime;
+		if(ContentSourcesChanged()) {
+			ContentReloadStart();
+		}
+	}
+	ContentUpdate();
+
 	matchmaker.Update();
 	ProcessMatchmakerPackets();
 
+	instancePool.Update(localTime);
+
 	// handle client connections
 	eastl::fixed_vector<ClientHandle,128> clientConnectedList;
 	server->TransferConnectedClientList(&clientConnectedList);
@@ -578,7 +1179,7 @@ void Coordinator::HandlePacket_CQ_AuthenticateGameServer(ClientHandle clientHd,
 		if(e->instantKey == instantKey) {
 			accountUID = e->accountUID;
 			sortieUID = e->sortieUID;
-			pendingClientQueue.erase(e);
+			e->authenticated = true;
 			break;
 		}
 	}
@@ -600,7 +1201,9 @@ void Coordinator::HandlePacket_CQ_AuthenticateGameServer(ClientHandle clientHd,
 	SendPacket(clientHd, auth);
 
 	LOG("[client%x] Client authenticated (accountuID=%u sortieUID=%llu)", clientHd, accountUID, sortieUID);
-	instancePool.QueuePushPlayerToGame(clientHd, accountUID, sortieUID);
+	if(!instancePool.QueuePushPlayerToGame(clientHd, accountUID, sortieUID)) {
+		server->DisconnectClient(clientHd);
+	}
 }
 
 void Coordinator::CreateDevGame()
@@ -623,6 +1226,7 @@ void Coordinator::CreateDevGame()
 
 	In::MQ_CreateGame game;
 	game.sortieUID = SortieUID(1);
+	game.mapIndex = MapIndex::PVP_DEATHMATCH;
 	game.playerCount = 6;
 	game.spectatorCount = 0;
 
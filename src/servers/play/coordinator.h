@@ -4,6 +4,10 @@
 #include <common/utils.h>
 #include <common/protocol.h>
 #include <common/inner_protocol.h>
+#include <common/mpsc_queue.h>
+#include <common/metrics.h>
+#include <common/task_scheduler.h>
+#include <common/input_coalescer.h>
 
 #include "instance.h"
 #include "matchmaker_connector.h"
@@ -14,7 +18,7 @@ enum class InstanceType: u8
 	PVP_3V3,
 };
 
-const int CPU_COUNT = 1;
+const int MAX_LANES = 8; // Config().Lanes are running
 
 struct InstancePool
 {
@@ -27,44 +31,126 @@ struct InstancePool
 			SortieUID sortieUID;
 		};
 
+		InstancePool* pool;
 		Server* server;
+		TaskScheduler* scheduler; // instances are ticked on the lane thread when disabled
 		EA::Thread::Thread thread;
 		i32 laneIndex;
 		Time localTime = Time::ZERO;
 
 		GrowableBuffer recvDataBuff;
+		InputCoalescer inputCoalescer; // superseded movement packets are dropped before handling
 
 		eastl::fixed_list<Client, MAX_CLIENTS, false> clientList;
 		hash_map<ClientHandle, decltype(clientList)::iterator, MAX_CLIENTS> clientMap;
 		eastl::fixed_set<ClientHandle,MAX_CLIENTS> clientHandleSet;
 
-		ProfileMutex(Mutex, mutexMatchmakerPacketsQueue);
-		GrowableBuffer mmPacketQueues[2];
-		u8 mmPacketQueueFront = 0; // being pushed to by coordinator
+		// coordinator -> lane handoff, the lane is the only consumer
+		MPSCQueue<QueueBlob> mmPacketQueue; // one blob per coordinator tick
+		MPSCQueue<QueueBlob> roguePacketQueue; // one blob per packet (RecvChunkHeader + packet)
+		MPSCQueue<ClientHandle> clientDisconnectQueue;
 
-		ProfileMutex(Mutex, mutexRoguePacketsQueue);
-		GrowableBuffer roguePacketsQueue;
-
-		ProfileMutex(Mutex, mutexClientDisconnectQueue);
-		eastl::fixed_vector<ClientHandle,128> clientDisconnectQueue;
-
-		ProfileMutex(Mutex, mutexClientConnectQueue);
 		struct ClientConnectEntry {
 			ClientHandle clientHd;
 			AccountUID accountUID;
 			SortieUID sortieUID;
 		};
-		eastl::fixed_vector<ClientConnectEntry,128> clientConnectQueue;
+		MPSCQueue<ClientConnectEntry> clientConnectQueue;
+
+		struct CreateGameEntry {
+			In::MQ_CreateGame info;
+			PvpInstance* instance; // built by the warmer, null when the lane has to build it
+			Time queueTime;
+		};
+		// unbounded: a burst of game creations must not stall the coordinator until the lane drained 128 of them
+		MPSCQueueUnbounded<CreateGameEntry> createGameQueue;
+		EA::Thread::AtomicUint32 createGamePendingCount; // queued but not created yet
+
+		// instance migration, the instance is moved between ticks with its clients and pending packets
+		struct MigrateRequest {
+			SortieUID sortieUID;
+			u8 toLane;
+		};
+
+		struct MigrationHandoff {
+			PvpInstance* instance;
+			eastl::fixed_vector<Client,Game::MAX_PLAYERS,false> clients;
+			eastl::fixed_vector<QueueBlob,64> roguePackets;
+		};
 
-		ProfileMutex(Mutex, mutexCreateGameQueue);
-		eastl::fixed_vector<In::MQ_CreateGame,128> createGameQueue;
+		ReplicationPipeline replicationPipeline; // idle unless Config().PipelineReplication
 
-		eastl::list<PvpInstance> instancePvpList;
+		MPSCQueue<MigrateRequest> migrateOutQueue; // from coordinator
+		MPSCQueue<MigrationHandoff*> migrateInQueue; // from the other lanes
+
+		eastl::fixed_list<PvpInstance*,128,true> instancePvpList; // instances are heap allocated so they can move to another lane
 		hash_map<SortieUID,decltype(instancePvpList)::iterator,128> instancePvpMap;
 
+		// published by the lane every tick, a new game counts as soon as it leaves createGamePendingCount
+		EA::Thread::AtomicUint32 gameCount;
+		EA::Thread::AtomicUint32 playerCount;
+
+		// tick stats, published by the lane every LOAD_WINDOW ticks
+		struct LoadStats
+		{
+			f32 tickP99Ms = 0;
+			u8 busyPercent = 0;
+		};
+
+		enum {
+			LOAD_WINDOW = 128
+		};
+
+		// average cost per tick of each instance over the load window
+		struct InstanceCost
+		{
+			SortieUID sortieUID;
+			f32 totalMs;
+			f32 worldMs;
+			f32 replicationMs;
+		};
+
+		typedef eastl::fixed_vector<InstanceCost,128,false> InstanceCostList;
+
+		ProfileMutex(Mutex, mutexLoadStats);
+		LoadStats loadStats;
+		InstanceCostList instanceCostList;
+
+		eastl::fixed_vector<f32,LOAD_WINDOW,false> tickDurationList;
+		f64 loadWindowBusyMs = 0;
+		Time loadWindowStart = Time::ZERO;
+
+		// lane="N", queue depths are taken before the queues are handled
+		struct Metrics
+		{
+			MetricHistogram* tickMs;
+			MetricHistogram* inputToFrameMs;
+			MetricGauge* instances;
+			MetricGauge* clients;
+			MetricGauge* mmPacketQueue;
+			MetricGauge* roguePacketQueue;
+			MetricGauge* clientConnectQueue;
+			MetricGauge* clientDisconnectQueue;
+			MetricGauge* createGameQueue;
+		};
+
+		Metrics metrics;
+
 		// Thread: Lane
 		void Update();
 		void Cleanup();
+		void RecordTick(f64 durationMs);
+
+		void HandleQueues();
+		void RemoveFinishedInstances();
+		void DrainRoguePackets(MigrationHandoff* handoff); // packets of the handoff clients go with the handoff
+		void DetachInstance(SortieUID sortieUID, u8 toLane);
+		void AttachInstance(MigrationHandoff* handoff);
+
+		// Thread: Any
+		i32 GetGameCount(); // created and queued
+		LoadStats GetLoadStats();
+		void GetInstanceCosts(InstanceCostList* out);
 
 		void ClientHandlePacket();
 	};
@@ -85,24 +171,71 @@ struct InstancePool
 	};
 
 	Server* server;
-	eastl::array<Lane,CPU_COUNT> lanes;
+	TaskScheduler scheduler; // shared by every lane
+	eastl::array<Lane,MAX_LANES> lanes;
+	i32 laneCount;
+	Time startTime; // shared by lanes so instances keep the same clock when migrating
 
 	ClientLocalMapping plidMap; // only modified on Coordinator Thread
 	eastl::array<ClientHandle, MAX_CLIENTS> clientHandle;
 	eastl::array<ClientLocation, MAX_CLIENTS> clientLocation;
 
-	// FIXME: pop when game is destroyed
 	hash_map<SortieUID,u8,4096> sortieLocation;
+	eastl::array<SortieUID, MAX_CLIENTS> clientSortie;
+
+	// Packets for an instance being migrated are held until the destination lane has it.
+	struct Migration
+	{
+		SortieUID sortieUID;
+		u8 fromLane;
+		u8 toLane;
+		eastl::fixed_vector<Lane::ClientConnectEntry,Game::MAX_PLAYERS,false> heldConnects;
+		eastl::fixed_vector<ClientHandle,Game::MAX_PLAYERS,false> heldDisconnects;
+		eastl::fixed_vector<QueueBlob,64> heldRoguePackets;
+	};
+
+	struct GameEndedEntry
+	{
+		SortieUID sortieUID;
+		u8 lane; // where the game ended, either end of a migration
+	};
+
+	eastl::fixed_vector<Migration,4,false> migrationList;
+	// lane -> coordinator, unbounded: the coordinator may itself be waiting for room in a lane queue
+	MPSCQueueUnbounded<SortieUID> migrationDoneQueue;
+	MPSCQueueUnbounded<GameEndedEntry> gameEndedQueue;
+
+	InstanceWarmer warmer;
+	Time lastMigrationTime = Time::ZERO;
+	Time lastDevMigrationTime = Time::ZERO; // DevMigrateSec
+	i32 devMigrationCount = 0;
+
+	struct Metrics
+	{
+		MetricGauge* migrationDoneQueue;
+		MetricGauge* gameEndedQueue;
+		MetricGauge* migrations;
+		MetricGauge* warmReady[InstanceWarmer::MAX_MAPS];
+	};
+
+	Metrics metrics;
 
 	// Thread: Coordinator
 	bool Init(Server* server_);
 	void Cleanup();
+	void Update(Time localTime); // finish migrations, forget ended games, move instances off overloaded lanes
+
+	// returns false if the instance is already migrating
+	bool MigrateInstance(SortieUID sortieUID, u8 toLane);
 
 	// Thread: Coordinator
-	void QueuePushPlayerToGame(ClientHandle clientHd, AccountUID accountUID, SortieUID sortieUID);
+	bool QueuePushPlayerToGame(ClientHandle clientHd, AccountUID accountUID, SortieUID sortieUID); // false when the game has ended
+	inline bool IsGameRunning(SortieUID sortieUID) const { return sortieLocation.find(sortieUID) != sortieLocation.end(); }
 	void QueuePopPlayers(const ClientHandle* clientList, const i32 count); // on disconnect
 	void QueueCreateGame(const In::MQ_CreateGame& gameInfo);
 
+	void GetLoadReport(In::PQ_LoadReport* out);
+
 	// packets piped to coordinator before player is assigned to an instance
 	void QueueRogueCoordinatorPacket(ClientHandle clientHd, const NetHeader& header, const u8* packetData);
 	void QueueMatchmakerPackets(const u8* buffer, u32 bufferSize);
@@ -110,6 +243,12 @@ struct InstancePool
 	inline bool IsClientInsideAnInstance(ClientHandle clientHd) const {
 		return plidMap.TryGet(clientHd) != -1;
 	}
+
+private:
+	Migration* FindMigration(SortieUID sortieUID);
+	void FinishMigration(Migration* m, u8 lane, bool gameEnded); // routes what was held to the lane that has the instance's clients
+	void BalanceLanes(Time localTime);
+	void DevMigrate(Time localTime);
 };
 
 // Responsible for managing Account data and dispatching client to game channels/instances
@@ -126,6 +265,11 @@ struct Coordinator
 
 	EA::Thread::Thread thread;
 	Time localTime;
+	Time lastLoadReportTime = Time::ZERO;
+	Time lastContentCheckTime = Time::ZERO;
+	Time lastMemReportTime = Time::ZERO;
+	MemReport memReport;
+	MetricGauge* pendingClientsMetric;
 
 	bool Init(Server* server_);
 	void Cleanup();
@@ -141,9 +285,10 @@ private:
 		u32 instantKey;
 		SortieUID sortieUID;
 		Time time;
+		bool authenticated = false; // the entry stays until the game ends so the client can rejoin
 	};
 
-	eastl::fixed_vector<PendingClientEntry,2048> pendingClientQueue; // TODO: timeout entries eventually if client does not connect
+	eastl::fixed_vector<PendingClientEntry,2048> pendingClientQueue;
 
 	void ProcessMatchmakerPackets();
 	void HandleMatchmakerPacket(const NetHeader& header, const u8* packetData, const i32 packetSize);
@@ -1,4 +1,5 @@
 #include "window.h"
+#include "game.h" // map colliders
 
 #include <config.h>
 #include <common/vector_math.h>
@@ -96,6 +97,7 @@ struct Window
 	ShapeMesh mapWalls;
 
 	PhysicsScene testScene;
+	PhysicsContext::MapCollision testMapCollision;
 	bool bFreezeTestPhysics = false;
 
 	struct TestSubject
@@ -203,8 +205,17 @@ bool Window::Init()
 	// create map scene, add ground and wall static meshes
 	phys.CreateScene(&testScene);
 
-	testScene.CreateStaticCollider("PVP_DeathMatch01_Collision", vec3(0));
-	testScene.CreateStaticCollider("PVP_Deathmatch01_GuardrailMob", vec3(0));
+	{ ContentRef content = ContentAcquire();
+		r = phys.AcquireMapCollision(*content.content, MapIndex::PVP_DEATHMATCH, &testMapCollision);
+		ContentRelease(&content);
+		if(!r) return false;
+	}
+
+	while(testMapCollision.GetLoadState() == PhysicsContext::MapCollision::LoadState::LOADING) {
+		EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+	}
+
+	Game::CreateMapColliders(&testScene);
 
 	testSubject.actor = testScene.CreateDynamicBody(100, 300, vec3(0));
 	testSubject.Reset();
@@ -527,8 +538,9 @@ void Window::WindowPhysicsTest()
 
 void Window::WindowAreas()
 {
-	const GameXmlContent& xml = GetGameXmlContent();
-	const auto& map = xml.mapPvpDeathMatch;
+	ContentRef content = ContentAcquire(); // not the coordinator thread, the generation could be freed while drawing
+	defer(ContentRelease(&content));
+	const auto& map = content.content->mapPvpDeathMatch;
 
 	const eastl::array<vec3,5> color = {
 		vec3(1, 1, 1),
@@ -771,6 +783,7 @@ void Window::OnEvent(const sapp_event& event)
 
 void Window::Cleanup()
 {
+	PhysContext().ReleaseMapCollision(&testMapCollision);
 	rdr.Cleanup();
 	simgui_shutdown();
 	sg_shutdown();
@@ -10,14 +10,23 @@
 const CreatureIndex CI_DOOR = CreatureIndex(110040546);
 const CreatureIndex CI_WALL = CreatureIndex(110042602);
 
-void Game::Init(Server* server_, const In::MQ_CreateGame& gameInfo, const eastl::array<ClientHandle, MAX_PLAYERS>& playerClientHdList)
+bool Game::Prepare(const GameXmlContent* content_, const PhysicsContext::MapCollision& collision, MemArena* arena_)
 {
-	replication.Init(server_);
-	world.Init(&replication);
+	ProfileFunction();
+
+	content = content_;
+	arena = arena_;
+	world.Init(&replication, content, collision.mapIndex, arena);
+
+	return LoadMap(collision);
+}
 
-	LoadMap();
+void Game::Init(Server* server_, const In::MQ_CreateGame& gameInfo, const eastl::array<ClientHandle, MAX_PLAYERS>& playerClientHdList)
+{
+	ASSERT(content); // prepared
+	replication.Init(server_, content, arena);
 
-	const GameXmlContent& xml = GetGameXmlContent();
+	const GameXmlContent& xml = *content;
 
 	// create players
 	i32 spawnPointIndex[2] = { 0 };
@@ -71,12 +80,14 @@ void Game::Init(Server* server_, const In::MQ_CreateGame& gameInfo, const eastl:
 
 void Game::Cleanup()
 {
+	replication.WaitEncoded(); // its last frame can still be on the lane pipeline
 	world.Cleanup();
 }
 
 void Game::Update(Time localTime_)
 {
 	ProfileFunction();
+	const Time tickStart = TimeNow();
 	localTime = localTime_;
 	Dbg::PushNewFrame(dbgGameUID);
 
@@ -194,7 +205,16 @@ void Game::Update(Time localTime_)
 							f32 angle = Randf01() * 2*PI;
 							f32 dist = (f32)RandInt(250, 1000);
 							vec2 off = vec2(cosf(angle) * dist, sinf(angle) * dist);
-							wpl.input.moveTo = wpl.body->GetWorldPos() + vec3(off, 0);
+							const vec3 dest = wpl.body->GetWorldPos() + vec3(off, 0);
+
+							// walk there following the navmesh when we can
+							if(world.nav.ProjectPoint(dest, 500, &bot->destination)) {
+								bot->wantsPath = true;
+								break;
+							}
+
+							bot->path.clear();
+							wpl.input.moveTo = dest;
 							wpl.input.rot.upperYaw = angle;
 							wpl.input.rot.upperPitch = 0;
 							wpl.input.rot.bodyYaw = angle;
@@ -210,6 +230,40 @@ void Game::Update(Time localTime_)
 						} break;
 					}
 				}
+
+				// follow path
+				World::Player& wpl = world.GetPlayer(bot->playerIndex);
+				const vec3 pos = wpl.body->GetWorldPos();
+
+				if(bot->wantsPath) {
+					const NavQuery::Result r = world.nav.FindPath(pos, bot->destination, &bot->path);
+					if(r != NavQuery::Result::DEFERRED) {
+						bot->wantsPath = false;
+						bot->pathPointID = 0;
+					}
+				}
+
+				if(bot->pathPointID < (i32)bot->path.size()) {
+					const vec3& target = bot->path[bot->pathPointID];
+					const vec2 delta = vec2(target - pos);
+
+					if(glm::length(delta) < 50.f) {
+						bot->pathPointID++;
+					}
+					else {
+						const f32 angle = atan2f(delta.y, delta.x);
+						wpl.input.moveTo = target;
+						wpl.input.rot.upperYaw = angle;
+						wpl.input.rot.upperPitch = 0;
+						wpl.input.rot.bodyYaw = angle;
+						wpl.input.speed = 600;
+
+						// jump link, too high to step on (wait to be back on the ground)
+						if(target.z - pos.z > GetGlobalTweakableVars().stepHeight && fabsf(wpl.body->vel.z) < 1.0f) {
+							wpl.input.jump = true;
+						}
+					}
+				}
 			}
 #endif
 
@@ -234,7 +288,9 @@ void Game::Update(Time localTime_)
 		} break;
 	}
 
+	const Time worldStart = TimeNow();
 	world.Update(localTime);
+	tickCost.worldMs = (f32)TimeDurationSinceMs(worldStart);
 
 	foreach_const(player, world.players) {
 		Dbg::PlayerMaster e;
@@ -267,18 +323,38 @@ void Game::Update(Time localTime_)
 
 	Dbg::PushPhysics(dbgGameUID, world.physics);
 
+	const Time replicationStart = TimeNow();
 	replication.FrameEnd();
+	tickCost.replicationMs = (f32)TimeDurationSinceMs(replicationStart);
+
+	tickCost.totalMs = (f32)TimeDurationSinceMs(tickStart);
+}
+
+// meshes of the map collision files the scene is made of, the other ones are placed by LoadMap (walls)
+bool Game::CreateMapColliders(PhysicsScene* scene)
+{
+	const char* colliders[] = {
+		"PVP_DeathMatch01_Collision",
+		"PVP_Deathmatch01_GuardrailMob",
+	};
+
+	for(const char* name : colliders) {
+		if(!scene->CreateStaticCollider(name, vec3(0))) {
+			WARN("LoadMap> static collider '%s' is not loaded", name);
+			return false;
+		}
+	}
+	return true;
 }
 
-bool Game::LoadMap()
+bool Game::LoadMap(const PhysicsContext::MapCollision& collision)
 {
 	// TODO: Should probably part of world?
-	auto& phys = PhysContext();
-	world.physics.CreateStaticCollider("PVP_DeathMatch01_Collision", vec3(0));
-	world.physics.CreateStaticCollider("PVP_Deathmatch01_GuardrailMob", vec3(0));
+	ASSERT(collision.GetLoadState() == PhysicsContext::MapCollision::LoadState::LOADED);
+	if(!CreateMapColliders(&world.physics)) return false;
 	// --------------------------------
 
-	const GameXmlContent& content = GetGameXmlContent();
+	const GameXmlContent& content = *this->content;
 
 	foreach(it, content.mapPvpDeathMatch.creatures) {
 		// don't spawn "spawn points"
@@ -340,7 +416,10 @@ bool Game::LoadMap()
 			auto& actor = world.SpawnDynamic(CI_WALL, it->ID);
 			actor.pos = it->pos;
 			actor.rot = it->rot;
-			world.physics.CreateStaticCollider("PvP_Death_NM_Wall04_GuardrailMob", it->pos, it->rot);
+			if(!world.physics.CreateStaticCollider("PvP_Death_NM_Wall04_GuardrailMob", it->pos, it->rot)) {
+				WARN("LoadMap> wall collider is not loaded");
+				return false;
+			}
 		}
 	}
 	return true;
@@ -354,6 +433,26 @@ void Game::OnPlayerDisconnect(ClientHandle clientHd)
 	replication.OnPlayerDisconnect(clientHd);
 }
 
+void Game::OnPlayerReconnect(ClientHandle clientHd, AccountUID accountUID)
+{
+	foreach(p, playerList) {
+		if(p->IsBot() || p->accountUID != accountUID) continue;
+
+		World::Player& worldPlayer = world.GetPlayer(p->playerIndex);
+		replication.OnPlayerReconnect(p->clientHd, clientHd, p->playerIndex);
+		replication.PlayerRegisterMasterActor(clientHd, worldPlayer.characters[0]->UID, worldPlayer.mainClass); // Main() changes with tagging
+		replication.PlayerRegisterMasterActor(clientHd, worldPlayer.characters[1]->UID, worldPlayer.subClass);
+
+		playerMap.erase(p->clientHd);
+		playerMap.emplace(clientHd, p);
+		p->clientHd = clientHd;
+		worldPlayer.clientHd = clientHd;
+		return;
+	}
+
+	WARN("Account is not playing in this game (accountUID=%u)", accountUID);
+}
+
 void Game::OnPlayerReadyToLoad(ClientHandle clientHd)
 {
 	replication.SendLoadPvpMap(clientHd, MapIndex::PVP_DEATHMATCH);
@@ -369,8 +468,7 @@ void Game::OnPlayerGetCharacterInfo(ClientHandle clientHd, ActorUID actorUID)
 		const World::ActorMaster& chara = **chit;
 
 		if(chara.UID == actorUID) {
-			// TODO: health
-			replication.SendCharacterInfo(clientHd, chara.UID, (CreatureIndex)(100000000 + (i32)chara.classType), chara.classType, 2400, 2400);
+			replication.SendCharacterInfo(clientHd, chara.UID, (CreatureIndex)(100000000 + (i32)chara.classType), chara.classType, chara.health, chara.healthMax);
 
 			return;
 		}
@@ -602,6 +700,14 @@ void Game::OnPlayerGameIsReady(ClientHandle clientHd)
 	else {
 		replication.SendGameReady(clientHd, READY_WAIT, MAX(0, READY_WAIT - (i32)TimeDurationMs(localTime, phaseTime)));
 	}
+
+	// late or rejoining client, it missed the phase changes
+	if(phase == Phase::PreGame || phase == Phase::Game) {
+		replication.SendPreGameLevelEvents(clientHd);
+	}
+	if(phase == Phase::Game) {
+		replication.SendGameStart(clientHd);
+	}
 }
 
 bool Game::ParseChatCommand(ClientHandle clientHd, const wchar* msg, const i32 len)
@@ -25,7 +25,7 @@ struct Game
 
 	struct Player
 	{
-		const ClientHandle clientHd;
+		ClientHandle clientHd; // changes when the player rejoins
 		const AccountUID accountUID;
 		const WideString& name;
 		const u32 playerIndex;
@@ -47,6 +47,11 @@ struct Game
 		const u32 playerIndex;
 		Time tNextAction = Time::ZERO;
 
+		vec3 destination;
+		bool wantsPath = false;
+		NavMesh::Path path;
+		i32 pathPointID = 0;
+
 		explicit Bot(u32 playerIndex_): playerIndex(playerIndex_) {}
 	};
 
@@ -58,6 +63,8 @@ struct Game
 		Game
 	};
 
+	const GameXmlContent* content; // generation the instance started with
+	MemArena* arena = nullptr; // owned by the instance
 	World world;
 	Replication replication;
 
@@ -72,6 +79,16 @@ struct Game
 	Time phaseTime = Time::ZERO;
 	Phase phase = Phase::WaitingForFirstPlayer;
 
+	// time spent in the last Update
+	struct TickCost
+	{
+		f32 totalMs = 0;
+		f32 worldMs = 0;
+		f32 replicationMs = 0;
+	};
+
+	TickCost tickCost;
+
 	Dbg::GameUID dbgGameUID;
 
 	World::Player* lego = nullptr;
@@ -83,14 +100,20 @@ struct Game
 
 	eastl::fixed_list<Bot,MAX_PLAYERS,false> botList;
 
+	// Prepare builds the map (physics scene, colliders, actors), it doesn't depend on the players and can run on any thread.
+	// Init adds the players on top of it, on the lane.
+	// Game containers overflow into the arena of the instance.
+	bool Prepare(const GameXmlContent* content_, const PhysicsContext::MapCollision& collision, MemArena* arena_); // false when the map could not be built
 	void Init(Server* server_, const In::MQ_CreateGame& gameInfo, const eastl::array<ClientHandle,MAX_PLAYERS>& playerClientHdList);
 	void Cleanup();
 
 	void Update(Time localTime_);
 
-	bool LoadMap();
+	bool LoadMap(const PhysicsContext::MapCollision& collision);
+	static bool CreateMapColliders(PhysicsScene* scene); // the deathmatch scene, false when a mesh is not loaded
 
 	void OnPlayerDisconnect(ClientHandle clientHd);
+	void OnPlayerReconnect(ClientHandle clientHd, AccountUID accountUID);
 	void OnPlayerReadyToLoad(ClientHandle clientHd);
 	void OnPlayerGetCharacterInfo(ClientHandle clientHd, ActorUID actorUID);
 	void OnPlayerUpdatePosition(ClientHandle clientHd, ActorUID actorUID, const vec3& pos, const vec2& dir, const RotationHumanoid& rot, f32 speed, ActionStateID action, f32 clientTime);
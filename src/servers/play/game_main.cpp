@@ -1,4 +1,5 @@
 #include <common/platform.h>
+#include <common/net_stats.h>
 #include <mxm/game_content.h>
 #include "debug/window.h"
 #include "coordinator.h"
@@ -24,6 +25,7 @@ int main(int argc, char** argv)
 	LOG(".: Game server :.");
 
 	Config().Print();
+	MemProfileEnable(Config().ProfileMemory != 0);
 
 	bool r = SetCloseSignalHandler([](){
 		g_Server->running = false;
@@ -38,19 +40,40 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
-	r = GameXmlContentLoad();
-	if(!r) {
-		LOG("ERROR: failed to load game xml content");
-		return 1;
-	}
-
-	r = PhysicsInit();
-	if(!r) {
-		LOG("ERROR: failed to init physics");
-		return 1;
+	// content loaders and physics run in parallel, on a scheduler that only lives during the startup
+	{
+		StartupGraph graph;
+		GameXmlContent::LoadStages content;
+		GameXmlContentAddLoadStages(&graph, &content);
+
+		// map collision meshes are not part of the startup, they are loaded when a game on the map is created
+		const auto physicsInit = graph.AddStage("physics init", [](void*) { return PhysicsInit(Config().PvdConnect, Config().CollisionCacheKB * 1024); }, nullptr, MemTag::PHYSICS);
+		const auto physicsMeshes = graph.AddStage("body collision mesh", [](void*) { return PhysContext().LoadContentMeshes(); }, nullptr, MemTag::PHYSICS);
+		graph.DependsOn(physicsMeshes, physicsInit);
+		graph.DependsOn(physicsMeshes, content.collisionFiles);
+
+		TaskScheduler* scheduler = new TaskScheduler();
+		r = scheduler->Init(Config().StartupWorkers, (i32)CoreAffinity::MAIN + 1);
+		if(!r) {
+			LOG("ERROR: failed to init the startup scheduler");
+			return 1;
+		}
+
+		r = graph.Run(scheduler);
+		scheduler->Cleanup();
+		delete scheduler;
+
+		graph.PrintTimeline();
+		if(!r) {
+			LOG("ERROR: failed to load game content or init physics");
+			return 1;
+		}
 	}
 	defer(PhysContext().Shutdown());
 
+	static NetStatsReporter netStats;
+	netStats.Init(NetRole::PLAY, Config().NetStatsIntervalSec, Config().NetStatsTop);
+
 	static Server server;
 	r = server.Init();
 	if(!r) {
@@ -59,6 +82,8 @@ int main(int argc, char** argv)
 	}
 	g_Server = &server;
 	server.doTraceNetwork = Config().TraceNetwork;
+	server.sendCoalesceThreshold = Config().SendCoalesceKB * 1024;
+	server.sendDisconnectThreshold = Config().SendMaxKB * 1024;
 
 	Listener listen(&server);
 	g_Listener = &listen;
@@ -80,6 +105,11 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
+	MetricsServer metrics;
+	metrics.Init(Config().MetricsPort);
+
+	LOG("Game server ready (%.2fms after start)", TimeDiffMs(TimeRelNow()));
+
 	// listen on main thread
 	listen.Listen();
 
@@ -89,8 +119,11 @@ int main(int argc, char** argv)
 	WindowWaitForCleanup();
 #endif
 
+	metrics.Cleanup();
+	netStats.Cleanup();
 	coordinator.Cleanup();
 	server.Cleanup();
+	MemProfileEnable(false); // frees from the static destructors are not reported
 
 	SaveConfig();
 	LOG("Done.");
@@ -1,10 +1,50 @@
 #include "instance.h"
+#include "config.h"
+#include "matchmaker_connector.h"
 
-PvpInstance::PvpInstance(SortieUID sortieUID_, const In::MQ_CreateGame& gameInfo_, Server* server_):
-	sortieUID(sortieUID_),
-	gameInfo(gameInfo_),
-	server(server_)
+PvpInstance::PvpInstance()
 {
+	arena.Init("PvpInstance", ARENA_CHUNK_SIZE);
+}
+
+PvpInstance::~PvpInstance()
+{
+	PhysContext().ReleaseMapCollision(&collision);
+	ContentRelease(&content);
+}
+
+void PvpInstance::Acquire(MapIndex mapIndex)
+{
+	content = ContentAcquire();
+
+	// starts loading the map collision meshes now, off the lane
+	if(!PhysContext().AcquireMapCollision(*content.content, mapIndex, &collision)) {
+		WARN("Unknown map %d, playing on deathmatch", (i32)mapIndex);
+		PhysContext().AcquireMapCollision(*content.content, MapIndex::PVP_DEATHMATCH, &collision);
+	}
+}
+
+PvpInstance::PrepareResult PvpInstance::PrepareGame()
+{
+	if(prepared) return PrepareResult::READY;
+
+	switch(collision.GetLoadState()) {
+		case PhysicsContext::MapCollision::LoadState::LOADING: return PrepareResult::PENDING;
+		case PhysicsContext::MapCollision::LoadState::FAILED: return PrepareResult::FAILED;
+		case PhysicsContext::MapCollision::LoadState::LOADED: break;
+	}
+
+	if(!game.Prepare(content.content, collision, &arena)) return PrepareResult::FAILED;
+	prepared = true;
+	return PrepareResult::READY;
+}
+
+void PvpInstance::Assign(SortieUID sortieUID_, const In::MQ_CreateGame& gameInfo_, Server* server_)
+{
+	sortieUID = sortieUID_;
+	gameInfo = gameInfo_;
+	server = server_;
+
 	clientAccountLink.fill(ClientHandle::INVALID);
 	remainingLinks = 0;
 
@@ -17,42 +57,147 @@ PvpInstance::PvpInstance(SortieUID sortieUID_, const In::MQ_CreateGame& gameInfo
 
 void PvpInstance::Update(Time localTime_)
 {
+	MEM_TAG(MemTag::INSTANCE);
 	localTime = localTime_;
+	if(connectStartTime == Time::ZERO) {
+		connectStartTime = localTime;
+	}
+
+	if(startPending) {
+		TryStartGame();
+	}
+	else if(phase == Phase::PlayerConnecting && !prepared && collision.GetLoadState() == PhysicsContext::MapCollision::LoadState::FAILED) {
+		Abort("the map could not be built"); // don't wait for the clients to find out
+	}
+	else if(phase == Phase::PlayerConnecting && remainingLinks > 0 && TimeDiffSec(TimeDiff(connectStartTime, localTime)) > Config().ConnectTimeoutSec) {
+		Abort(FMT("%d/%d clients connected", connectedCount, connectedCount + remainingLinks));
+	}
+
+	if(phase == Phase::PlayingGame) {
+		if(connectedCount > 0) {
+			emptyTime = Time::ZERO;
+		}
+		else if(emptyTime == Time::ZERO) {
+			LOG("[Inst_%llu] Every client left, ending the game in %ds unless one comes back", sortieUID, Config().LingerSec);
+			emptyTime = localTime;
+		}
+		else if(TimeDiffSec(TimeDiff(emptyTime, localTime)) > Config().LingerSec) {
+			LOG("[Inst_%llu] No client came back, ending the game", sortieUID);
+			phase = Phase::Ended;
+		}
+	}
 
 	if(phase == Phase::PlayingGame) {
+		// containers and physx pools grow during the first ticks, after that a tick shouldn't allocate
+		const bool warmedUp = playingTickCount >= ALLOC_CHECK_WARMUP_TICKS;
+		const MemNoAllocScope noAlloc(warmedUp ? (MemNoAllocMode)Config().LaneAllocCheck : MemNoAllocMode::OFF);
+		playingTickCount++;
+
 		game.Update(localTime);
+
+		cost.totalMs += game.tickCost.totalMs;
+		cost.worldMs += game.tickCost.worldMs;
+		cost.replicationMs += game.tickCost.replicationMs;
 	}
+	cost.tickCount++;
 }
 
 void PvpInstance::OnClientsConnected(const eastl::pair<ClientHandle,AccountUID>* clientList, const i32 count)
 {
 	for(int ci = 0; ci < count; ci++) {
-		bool found = false;
+		const ClientHandle clientHd = clientList[ci].first;
+		const AccountUID accountUID = clientList[ci].second;
+
+		i32 playerID = -1;
 		for(int p = 0; p < gameInfo.playerCount; p++) {
-			if(gameInfo.players[p].accountUID == clientList[ci].second) {
-				clientAccountLink[p] = clientList[ci].first;
-				found = true;
+			if(!gameInfo.players[p].isBot && gameInfo.players[p].accountUID == accountUID) {
+				playerID = p;
+				break;
 			}
 		}
-		ASSERT(found);
-		remainingLinks--;
+
+		// the account is not in this game or is already connected with another client
+		if(playerID == -1 || clientAccountLink[playerID] != ClientHandle::INVALID || IsFinished()) {
+			WARN("[Inst_%llu][client%x] Client rejected (accountUID=%u)", sortieUID, clientHd, accountUID);
+			server->DisconnectClient(clientHd);
+			continue;
+		}
+
+		clientAccountLink[playerID] = clientHd;
+		connectedCount++;
+
+		if(phase == Phase::PlayerConnecting) {
+			remainingLinks--;
+		}
+		else if(phase == Phase::PlayingGame) {
+			LOG("[Inst_%llu][client%x] Client rejoined the game (accountUID=%u)", sortieUID, clientHd, accountUID);
+			game.OnPlayerReconnect(clientHd, accountUID);
+		}
 	}
 
 	// create game
-	if(remainingLinks <= 0) {
-		LOG("[Inst_%llu] All client connected, starting game...", sortieUID);
-		phase = Phase::PlayingGame;
+	if(phase == Phase::PlayerConnecting && remainingLinks <= 0) {
+		TryStartGame();
+
+		if(startPending) {
+			LOG("[Inst_%llu] All client connected, waiting for the map collision...", sortieUID);
+		}
+	}
+}
+
+void PvpInstance::TryStartGame()
+{
+	const PrepareResult r = PrepareGame();
+	startPending = (r == PrepareResult::PENDING);
+	if(startPending) return; // tried again next update
 
-		game.Init(server, gameInfo, clientAccountLink);
-		game.startTime = localTime;
-		packetHandler.Init(&game);
+	if(r == PrepareResult::FAILED) {
+		Abort("the map could not be built");
+		return;
 	}
+
+	LOG("[Inst_%llu] All client connected, starting game...", sortieUID);
+	phase = Phase::PlayingGame;
+
+	game.Init(server, gameInfo, clientAccountLink);
+	game.startTime = localTime;
+	packetHandler.Init(&game);
+}
+
+void PvpInstance::Abort(const char* reason)
+{
+	WARN("[Inst_%llu] Aborting the game on map %d: %s", sortieUID, (i32)gameInfo.mapIndex, reason);
+	phase = Phase::Failed;
+	startPending = false;
+
+	foreach_const(hd, clientAccountLink) {
+		if(*hd != ClientHandle::INVALID) {
+			server->DisconnectClient(*hd);
+		}
+	}
+
+	Matchmaker().QueryGameFailed(sortieUID);
 }
 
 void PvpInstance::OnClientsDisconnected(const ClientHandle* clientList, const i32 count)
 {
-	if(phase == Phase::PlayingGame) {
-		packetHandler.OnClientsDisconnected(clientList, count);
+	for(int ci = 0; ci < count; ci++) {
+		const ClientHandle clientHd = clientList[ci];
+
+		// rejected clients were never linked
+		auto link = eastl::find(clientAccountLink.begin(), clientAccountLink.end(), clientHd);
+		if(link == clientAccountLink.end()) continue;
+
+		*link = ClientHandle::INVALID;
+		connectedCount--;
+
+		if(phase == Phase::PlayerConnecting) {
+			remainingLinks++; // waits for it to connect again
+			startPending = false;
+		}
+		else if(phase == Phase::PlayingGame) {
+			packetHandler.OnClientsDisconnected(&clientHd, 1);
+		}
 	}
 }
 
@@ -77,3 +222,189 @@ void PvpInstance::OnMatchmakerPacket(const NetHeader& header, const u8* packetDa
 {
 
 }
+
+const f64 WARM_RETRY_DELAY = 10.0; // seconds
+
+intptr_t ThreadInstanceWarmer(void* pData)
+{
+	InstanceWarmer& warmer = *(InstanceWarmer*)pData;
+	ProfileSetThreadName("InstanceWarmer");
+	MEM_TAG(MemTag::INSTANCE);
+
+	while(warmer.running) {
+		PvpInstance* inst;
+		while(warmer.recycleQueue.TryPop(&inst)) {
+			warmer.Reset(inst);
+		}
+
+		if(warmer.WarmOne()) continue;
+
+		if(warmer.building) {
+			EA::Thread::ThreadSleep(1); // map collision loading
+			continue;
+		}
+
+		warmer.semaphore.Wait();
+	}
+
+	return 0;
+}
+
+bool InstanceWarmer::Init(const MapIndex* mapList, i32 count, i32 warmCount_)
+{
+	ASSERT(count <= MAX_MAPS);
+	warmCount = warmCount_;
+	if(warmCount <= 0) return true; // every game is built on creation
+
+	mapCount = count;
+	for(i32 i = 0; i < mapCount; i++) {
+		MapPool& pool = mapPoolList[i];
+		pool.mapIndex = mapList[i];
+		pool.readyQueue.Init(warmCount);
+		pool.readyCount.SetValue(0);
+	}
+
+	recycleQueue.Init(256);
+	running = true;
+	thread.Begin(ThreadInstanceWarmer, this);
+	return true;
+}
+
+void InstanceWarmer::Cleanup()
+{
+	if(!running) return;
+
+	running = false;
+	semaphore.Post(1);
+	thread.WaitForEnd();
+
+	PvpInstance* inst;
+	for(i32 i = 0; i < mapCount; i++) {
+		while(mapPoolList[i].readyQueue.TryPop(&inst)) {
+			inst->game.Cleanup();
+			delete inst;
+		}
+	}
+	while(recycleQueue.TryPop(&inst)) {
+		inst->game.Cleanup();
+		delete inst;
+	}
+	foreach(it, freeList) {
+		delete *it;
+	}
+	freeList.clear();
+
+	if(building) {
+		building->game.Cleanup();
+		delete building;
+		building = nullptr;
+	}
+}
+
+PvpInstance* InstanceWarmer::Take(MapIndex mapIndex)
+{
+	for(i32 i = 0; i < mapCount; i++) {
+		MapPool& pool = mapPoolList[i];
+		if(pool.mapIndex != mapIndex) continue;
+
+		PvpInstance* inst;
+		while(pool.readyQueue.TryPop(&inst)) {
+			pool.readyCount.Decrement();
+			semaphore.Post(1); // build a replacement
+
+			// built before a content reload, games get the current generation
+			if(inst->content.version != ContentCurrentVersion()) {
+				Recycle(inst);
+				continue;
+			}
+			return inst;
+		}
+
+		semaphore.Post(1); // the pool can be waiting on a retry
+		return nullptr;
+	}
+	return nullptr;
+}
+
+void InstanceWarmer::Recycle(PvpInstance* inst)
+{
+	if(!running) {
+		inst->game.Cleanup();
+		delete inst;
+		return;
+	}
+
+	recycleQueue.Push(inst);
+	semaphore.Post(1);
+}
+
+bool InstanceWarmer::WarmOne()
+{
+	if(!building) {
+		// fill the emptiest pool first
+		i32 best = -1;
+		for(i32 i = 0; i < mapCount; i++) {
+			const i32 readyCount = mapPoolList[i].readyCount.GetValue();
+			if(readyCount >= warmCount) continue;
+			if(TimeNow() < mapPoolList[i].retryTime) continue;
+			if(best == -1 || readyCount < mapPoolList[best].readyCount.GetValue()) best = i;
+		}
+		if(best == -1) return false;
+
+		if(!freeList.empty()) {
+			building = freeList.back();
+			freeList.pop_back();
+		}
+		else {
+			building = new PvpInstance();
+		}
+
+		buildingPool = best;
+		building->Acquire(mapPoolList[best].mapIndex);
+	}
+
+	const PvpInstance::PrepareResult r = building->PrepareGame();
+	if(r == PvpInstance::PrepareResult::PENDING) return false;
+
+	if(r == PvpInstance::PrepareResult::FAILED) {
+		// games on this map are built (and fail) on creation until the retry
+		MapPool& pool = mapPoolList[buildingPool];
+		WARN("[InstanceWarmer] Map %d could not be built, retrying in %gs", (i32)pool.mapIndex, WARM_RETRY_DELAY);
+		pool.retryTime = TimeAddSec(TimeNow(), WARM_RETRY_DELAY);
+		Reset(building);
+		building = nullptr;
+		buildingPool = -1;
+		return true;
+	}
+
+	MapPool& pool = mapPoolList[buildingPool];
+	pool.readyCount.Increment();
+	pool.readyQueue.Push(building);
+	building = nullptr;
+	buildingPool = -1;
+	return true;
+}
+
+void InstanceWarmer::Reset(PvpInstance* inst)
+{
+	ProfileFunction();
+
+	// releases the scene, the content and the map collision, the collision meshes stay cached for the next build
+	inst->game.Cleanup();
+
+	if(freeList.full()) {
+		delete inst;
+		return;
+	}
+
+	// the arena memory is kept for the next game, the blocks are dropped at once
+	MemArena arena;
+	arena.Swap(&inst->arena);
+
+	inst->~PvpInstance();
+	new(inst) PvpInstance();
+
+	inst->arena.Swap(&arena);
+	inst->arena.Reset();
+	freeList.push_back(inst);
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <common/mpsc_queue.h>
+#include <eathread/eathread_semaphore.h>
 #include "channel.h"
 #include "game.h"
 
@@ -6,7 +8,15 @@ struct PvpInstance
 {
 	enum class Phase: u8 {
 		PlayerConnecting = 0,
-		PlayingGame
+		PlayingGame,
+		Failed, // the map could not be built or the clients didn't connect in time, clients are disconnected
+		Ended // every client left and none came back within Config().LingerSec
+	};
+
+	enum class PrepareResult: u8 {
+		PENDING = 0, // the map collision is loading
+		READY,
+		FAILED
 	};
 
 	struct AccountLink {
@@ -14,23 +24,103 @@ struct PvpInstance
 		ClientHandle clientHd;
 	};
 
-	const SortieUID sortieUID;
-	const In::MQ_CreateGame gameInfo;
-	Server* server;
+	enum {
+		ARENA_CHUNK_SIZE = 256 * 1024,
+		ALLOC_CHECK_WARMUP_TICKS = 10 * UPDATE_TICK_RATE, // see Config().LaneAllocCheck
+	};
+
+	MemArena arena; // game memory outside the fixed containers, first so it's destroyed last
+	SortieUID sortieUID = SortieUID::INVALID;
+	In::MQ_CreateGame gameInfo;
+	Server* server = nullptr;
 	Time localTime;
+	Time connectStartTime = Time::ZERO; // first update, Config().ConnectTimeoutSec counts from there
+	Time emptyTime = Time::ZERO; // the last client left, Time::ZERO while someone is connected
 
+	ContentRef content; // the game keeps the content generation it was created with, even when the content is reloaded
+	PhysicsContext::MapCollision collision; // loaded by the physics loader thread, the game starts once it is
+	bool prepared = false; // map built in the game (Game::Prepare), done by the warmer for pooled instances
 	Phase phase = Phase::PlayerConnecting;
+	i32 workerAffinity = -1; // TaskScheduler
 	eastl::array<ClientHandle, Game::MAX_PLAYERS> clientAccountLink;
-	i32 remainingLinks;
+	i32 remainingLinks = 0;
+	i32 connectedCount = 0; // human clients in the game
+	i32 playingTickCount = 0;
+	bool startPending = false; // every client is linked, the map collision is still loading
 
 	GamePacketHandler packetHandler;
 	Game game;
 
-	PvpInstance(SortieUID sortieUID_, const In::MQ_CreateGame& gameInfo_, Server* server_);
+	// summed over the lane load window
+	struct CostAccumulator
+	{
+		f64 totalMs = 0;
+		f64 worldMs = 0;
+		f64 replicationMs = 0;
+		i32 tickCount = 0;
+	};
+
+	CostAccumulator cost;
 
+	PvpInstance();
+	~PvpInstance();
+
+	// Thread: Any
+	void Acquire(MapIndex mapIndex); // content and map collision, the collision starts loading
+	PrepareResult PrepareGame();
+
+	// Thread: Lane
+	void Assign(SortieUID sortieUID_, const In::MQ_CreateGame& gameInfo_, Server* server_);
 	void Update(Time localTime_);
+	void TryStartGame(); // every client is linked, waits for the map collision
+	void Abort(const char* reason); // the game can't be played, reported to the matchmaker
 	void OnClientsConnected(const eastl::pair<ClientHandle,AccountUID>* clientList, const i32 count);
 	void OnClientsDisconnected(const ClientHandle* clientList, const i32 count);
 	void OnClientPacket(ClientHandle clientHd, const NetHeader& header, const u8* packetData);
 	void OnMatchmakerPacket(const NetHeader& header, const u8* packetData);
+
+	inline bool IsFinished() const { return phase == Phase::Failed || phase == Phase::Ended; }
+};
+
+// Instances built in the background (physics scene, map colliders, actors) for each map, so creating a game only hands one to a lane.
+// Finished instances come back to be reset and built again, they keep their memory.
+struct InstanceWarmer
+{
+	enum {
+		MAX_MAPS = 4,
+		MAX_FREE = 64
+	};
+
+	struct MapPool
+	{
+		MapIndex mapIndex;
+		MPSCQueue<PvpInstance*> readyQueue; // warmer -> coordinator
+		EA::Thread::AtomicInt32 readyCount = 0;
+		Time retryTime = Time::ZERO; // warmer only, the map failed to build, not tried again before that
+	};
+
+	eastl::array<MapPool,MAX_MAPS> mapPoolList;
+	i32 mapCount = 0;
+	i32 warmCount = 0; // ready instances per map
+
+	MPSCQueue<PvpInstance*> recycleQueue; // -> warmer
+	eastl::fixed_vector<PvpInstance*,MAX_FREE,false> freeList; // warmer only, reset instances
+	PvpInstance* building = nullptr; // warmer only, waiting on its map collision
+	i32 buildingPool = -1;
+
+	EA::Thread::Semaphore semaphore;
+	EA::Thread::Thread thread;
+	bool running = false;
+
+	// Thread: Coordinator
+	bool Init(const MapIndex* mapList, i32 count, i32 warmCount_);
+	void Cleanup();
+	PvpInstance* Take(MapIndex mapIndex); // null when none is ready, the lane builds the game itself then
+
+	// Thread: Any
+	void Recycle(PvpInstance* inst);
+
+	// Thread: Warmer
+	bool WarmOne(); // false when every map pool is full (or waiting to retry) or the collision is still loading
+	void Reset(PvpInstance* inst);
 };
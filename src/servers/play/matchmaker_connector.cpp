@@ -58,6 +58,12 @@ void MatchmakerConnector::Update()
 					conn.SendPacket(packet);
 				} break;
 
+				case Query::Type::GameFailed: {
+					In::PN_GameFailed packet;
+					packet.sortieUID = q->GameFailed.sortieUID;
+					conn.SendPacket(packet);
+				} break;
+
 				default: {
 					ASSERT_MSG(0, "case not handled");
 				}
@@ -65,6 +71,11 @@ void MatchmakerConnector::Update()
 		}
 
 		queries.clear();
+
+		if(loadReportPending) {
+			conn.SendPacket(loadReport);
+			loadReportPending = false;
+		}
 	}
 }
 
@@ -77,6 +88,22 @@ void MatchmakerConnector::QueryGameCreated(SortieUID sortieUID)
 	queries.push_back(query);
 }
 
+void MatchmakerConnector::QueryGameFailed(SortieUID sortieUID)
+{
+	Query query(Query::Type::GameFailed);
+	query.GameFailed.sortieUID = sortieUID;
+
+	LOCK_MUTEX(mutexQueries);
+	queries.push_back(query);
+}
+
+void MatchmakerConnector::QueryLoadReport(const In::PQ_LoadReport& report)
+{
+	LOCK_MUTEX(mutexQueries);
+	loadReport = report;
+	loadReportPending = true;
+}
+
 MatchmakerConnector& Matchmaker()
 {
 	return *g_connector;
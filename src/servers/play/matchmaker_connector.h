@@ -9,6 +9,7 @@ struct MatchmakerConnector
 		enum class Type: u8 {
 			Invalid = 0,
 			GameCreated,
+			GameFailed,
 		};
 
 		const Type type;
@@ -17,6 +18,10 @@ struct MatchmakerConnector
 			struct {
 				SortieUID sortieUID;
 			} GameCreated;
+
+			struct {
+				SortieUID sortieUID;
+			} GameFailed;
 		};
 
 		explicit Query(Type type_): type(type_) {}
@@ -27,6 +32,8 @@ struct MatchmakerConnector
 
 	ProfileMutex(Mutex, mutexQueries);
 	eastl::fixed_vector<Query,2048> queries;
+	In::PQ_LoadReport loadReport; // only the last one is sent
+	bool loadReportPending = false;
 
 	MatchmakerConnector();
 
@@ -34,6 +41,8 @@ struct MatchmakerConnector
 	void Update();
 
 	void QueryGameCreated(SortieUID sortieUID);
+	void QueryGameFailed(SortieUID sortieUID);
+	void QueryLoadReport(const In::PQ_LoadReport& report);
 };
 
 MatchmakerConnector& Matchmaker();
@@ -0,0 +1,91 @@
+#include "navigation.h"
+
+// how far from the mesh an actor can be and still be considered on it (jumping, stepping on props)
+static const f32 PROJECT_RADIUS = 300;
+
+void NavQuery::Init(const NavMesh* mesh_, MemArena* arena)
+{
+	mesh = mesh_;
+	scratch.nodeList.set_allocator(ArenaAllocator(arena));
+	scratch.openHeap.set_allocator(ArenaAllocator(arena));
+	foreach(it, cache) {
+		it->startRef = NavPolyRef::INVALID;
+		it->endRef = NavPolyRef::INVALID;
+		it->corridor.clear();
+	}
+
+	if(IsReady()) {
+		mesh->InitScratch(&scratch);
+	}
+	NewTick();
+}
+
+void NavQuery::NewTick()
+{
+	searchBudget = MAX_SEARCHES_PER_TICK;
+}
+
+bool NavQuery::ProjectPoint(const vec3& pos, f32 searchRadius, vec3* outPos) const
+{
+	if(!IsReady()) return false;
+	return mesh->FindNearestPoly(pos, searchRadius, outPos) != NavPolyRef::INVALID;
+}
+
+bool NavQuery::Raycast(const vec3& start, const vec3& end, vec3* outHitPos) const
+{
+	if(!IsReady()) return false;
+
+	const NavPolyRef startRef = mesh->FindNearestPoly(start, PROJECT_RADIUS, nullptr);
+	if(startRef == NavPolyRef::INVALID) return false;
+
+	f32 t;
+	NavPolyRef lastRef;
+	const bool clear = mesh->Raycast(startRef, start, end, &t, &lastRef);
+	if(outHitPos) {
+		*outHitPos = start + (end - start) * t;
+	}
+	return clear;
+}
+
+NavQuery::Result NavQuery::FindPath(const vec3& start, const vec3& end, NavMesh::Path* out)
+{
+	ProfileFunction();
+
+	out->clear();
+	if(!IsReady()) return Result::FAILED;
+
+	vec3 startPos, endPos;
+	const NavPolyRef startRef = mesh->FindNearestPoly(start, PROJECT_RADIUS, &startPos);
+	const NavPolyRef endRef = mesh->FindNearestPoly(end, PROJECT_RADIUS, &endPos);
+	if(startRef == NavPolyRef::INVALID || endRef == NavPolyRef::INVALID) return Result::FAILED;
+
+	// straight line, no search needed
+	// the raycast is 2D, it has to end on the end polygon and not on a floor above or below it
+	f32 t = 0;
+	NavPolyRef lastRef = NavPolyRef::INVALID;
+	const bool straight = startRef == endRef || (mesh->Raycast(startRef, startPos, endPos, &t, &lastRef) && lastRef == endRef && t >= 1);
+	if(straight) {
+		out->push_back(endPos);
+		return Result::SUCCESS;
+	}
+
+	CacheEntry& entry = cache[((u32)startRef * 31 + (u32)endRef) & (CACHE_SIZE - 1)];
+	if(entry.startRef == startRef && entry.endRef == endRef) {
+		mesh->StringPull(entry.corridor, startPos, endPos, out);
+		return Result::SUCCESS;
+	}
+
+	if(searchBudget <= 0) return Result::DEFERRED;
+	searchBudget--;
+
+	if(!mesh->FindCorridor(startRef, endRef, startPos, endPos, &scratch, &entry.corridor)) {
+		entry.startRef = NavPolyRef::INVALID;
+		entry.endRef = NavPolyRef::INVALID;
+		return Result::FAILED;
+	}
+
+	entry.startRef = startRef;
+	entry.endRef = endRef;
+	mesh->StringPull(entry.corridor, startPos, endPos, out);
+	return Result::SUCCESS;
+}
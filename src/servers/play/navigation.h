@@ -0,0 +1,42 @@
+#pragma once
+#include <common/base.h>
+#include <common/vector_math.h>
+#include <mxm/navmesh.h>
+#include <EASTL/array.h>
+
+// Per game navigation queries on a shared NavMesh
+// A* searches are limited to a few per tick and their corridors are cached by (start poly, end poly)
+struct NavQuery
+{
+	enum {
+		CACHE_SIZE = 32, // power of 2
+		MAX_SEARCHES_PER_TICK = 4,
+	};
+
+	enum class Result: u8 {
+		SUCCESS = 0,
+		FAILED,
+		DEFERRED, // out of budget this tick, ask again next tick
+	};
+
+	struct CacheEntry
+	{
+		NavPolyRef startRef = NavPolyRef::INVALID;
+		NavPolyRef endRef = NavPolyRef::INVALID;
+		NavMesh::Corridor corridor;
+	};
+
+	const NavMesh* mesh = nullptr;
+	NavMesh::Scratch scratch;
+	eastl::array<CacheEntry,CACHE_SIZE> cache;
+	i32 searchBudget = 0;
+
+	void Init(const NavMesh* mesh_, MemArena* arena); // scratch lives in the game arena
+	void NewTick();
+
+	inline bool IsReady() const { return mesh && mesh->IsLoaded(); }
+
+	bool ProjectPoint(const vec3& pos, f32 searchRadius, vec3* outPos) const;
+	bool Raycast(const vec3& start, const vec3& end, vec3* outHitPos) const; // true when nothing is in the way
+	Result FindPath(const vec3& start, const vec3& end, NavMesh::Path* out);
+};
@@ -57,15 +57,42 @@ struct CCT_CollisionFilterCallback: PxControllerFilterCallback
 	*/
 	virtual bool filter(const PxController& a, const PxController& b) override
 	{
-		// TODO: true for rozark and sutff?
-		return false;
+		const PhysicsDynamicBody* bodyA = (PhysicsDynamicBody*)a.getUserData();
+		const PhysicsDynamicBody* bodyB = (PhysicsDynamicBody*)b.getUserData();
+		if(!bodyA || !bodyB) return false;
+		return CollisionGroupsCollide(bodyA->group, bodyA->mask, bodyB->group, bodyB->mask);
 	}
 };
 
 static CCT_CollisionFilterCallback g_cctCollisionFilterCallback; // weird that we have to instantiate this but ok
 
-bool PhysicsContext::Init()
+
+static intptr_t ThreadCollisionLoader(void* pData)
+{
+	PhysicsContext& ctx = *(PhysicsContext*)pData;
+	ProfileSetThreadName("CollisionLoader");
+	MEM_TAG(MemTag::PHYSICS);
+
+	while(ctx.loaderRunning) {
+		PhysicsContext::CollisionFile* file;
+		if(ctx.loadQueue.TryPop(&file)) {
+			ctx.LoadCollisionFile(file);
+			continue;
+		}
+
+		// also woken up by releases
+		ctx.TrimMeshCache();
+		ctx.loaderSemaphore.Wait();
+	}
+
+	return 0;
+}
+
+bool PhysicsContext::Init(bool connectPvd, i32 meshCacheBudget_)
 {
+	meshCacheBudget = meshCacheBudget_;
+	cooking = nullptr;
+
 	foundation = PxCreateFoundation(PX_PHYSICS_VERSION, allocatorCallback, errorCallback);
 	if(!foundation) {
 		LOG("[PhysX] ERROR: PxCreateFoundation failed");
@@ -74,11 +101,15 @@ bool PhysicsContext::Init()
 
 	bool recordMemoryAllocations = true;
 
-	pvd = PxCreatePvd(*foundation);
-	PxPvdTransport* transport = PxDefaultPvdSocketTransportCreate(PVD_HOST, 5425, 10);
-	bool connected = pvd->connect(*transport, PxPvdInstrumentationFlag::eALL);
-	if(!connected) {
-		LOG("[PhysX] WARNING: failed to connect to PVD Client");
+	// opt-in, waits on the socket connection and records the scenes while connected
+	pvd = nullptr;
+	if(connectPvd) {
+		pvd = PxCreatePvd(*foundation);
+		PxPvdTransport* transport = PxDefaultPvdSocketTransportCreate(PVD_HOST, 5425, 10);
+		bool connected = pvd->connect(*transport, PxPvdInstrumentationFlag::eALL);
+		if(!connected) {
+			LOG("[PhysX] WARNING: failed to connect to PVD Client");
+		}
 	}
 
 	physics = PxCreatePhysics(PX_PHYSICS_VERSION, *foundation, TolerancesScale(), recordMemoryAllocations, pvd);
@@ -94,9 +125,20 @@ bool PhysicsContext::Init()
 		return false;
 	}
 
-	// collision meshes
 	matMapSurface = physics->createMaterial(1.0f, 1.0f, 0.0f);
 
+	loadQueue.Init(64);
+	loaderRunning = true;
+	loaderThread.Begin(ThreadCollisionLoader, this);
+
+	LOG("PhysicsContext initialised");
+	return true;
+}
+
+bool PhysicsContext::LoadContentMeshes()
+{
+	ProfileFunction();
+
 	const GameXmlContent& gc = GetGameXmlContent();
 	bool r = LoadCollisionMesh(&cylinderMesh, gc.fileCylinderCollision);
 	if(!r) {
@@ -104,27 +146,172 @@ bool PhysicsContext::Init()
 		return false;
 	}
 
-	if(!LoadCollisionMeshes(gc.filePvpDeathmatch01Collision)) return false;
-	if(!LoadCollisionMeshes(gc.filePvpDeathmatch01CollisionWalls)) return false;
-	if(!LoadCollisionMeshes(gc.filePvpDeathNmWall04)) return false;
-
-	LOG("PhysicsContext initialised");
 	return true;
 }
 
 void PhysicsContext::Shutdown()
 {
+	if(loaderRunning) {
+		loaderRunning = false;
+		loaderSemaphore.Post(1);
+		loaderThread.WaitForEnd();
+	}
+
+	if(cooking) {
+		cooking->release();
+	}
+
 	physics->release();
 
-	PxPvdTransport* transport = pvd->getTransport();
-	pvd->release();
-	transport->release();
+	if(pvd) {
+		PxPvdTransport* transport = pvd->getTransport();
+		pvd->release();
+		transport->release();
+	}
 
 	foundation->release();
 	LOG("PhysicsContext shutdown");
 }
 
-bool PhysicsContext::LoadCollisionMeshes(const FileBuffer& file)
+PhysicsContext::MapCollision::LoadState PhysicsContext::MapCollision::GetLoadState() const
+{
+	if(fileList.empty()) return LoadState::FAILED;
+
+	LoadState result = LoadState::LOADED;
+	foreach_const(it, fileList) {
+		const CollisionFile::State state = (CollisionFile::State)(*it)->state.GetValue();
+		if(state == CollisionFile::State::FAILED) return LoadState::FAILED;
+		if(state == CollisionFile::State::LOADING) result = LoadState::LOADING;
+	}
+	return result;
+}
+
+bool PhysicsContext::AcquireMapCollision(const GameXmlContent& content, MapIndex mapIndex, MapCollision* out)
+{
+	ASSERT(out->fileList.empty());
+
+	const GameXmlContent::MapList* mapList = content.FindMapListByID((i32)mapIndex);
+	if(!mapList) {
+		WARN("Map %d is not in the map list", (i32)mapIndex);
+		return false;
+	}
+
+	const GameXmlContent::MapCollisionFiles* desc = content.FindMapCollision(mapIndex);
+	if(!desc) {
+		WARN("Map %d has no collision (level='%s')", (i32)mapIndex, mapList->levelFile.data());
+		return false;
+	}
+
+	out->mapIndex = mapIndex;
+
+	i32 queuedCount = 0;
+	{ LOCK_MUTEX(mutexMeshCache);
+		foreach_const(name, desc->files) {
+			CollisionFile* file = nullptr;
+			foreach(it, collisionFileList) {
+				if(it->name == *name) {
+					file = &(*it);
+					break;
+				}
+			}
+
+			if(!file) {
+				ASSERT(!collisionFileList.full());
+				file = &collisionFileList.push_back();
+				file->name = *name;
+			}
+
+			file->refCount++;
+			file->lastUse = TimeNow();
+
+			// failed ones are tried again, the file could be there now
+			const CollisionFile::State state = (CollisionFile::State)file->state.GetValue();
+			if(state == CollisionFile::State::UNLOADED || state == CollisionFile::State::FAILED) {
+				file->state.SetValue((i32)CollisionFile::State::LOADING);
+				loadQueue.Push(file);
+				queuedCount++;
+			}
+
+			out->fileList.push_back(file);
+		}
+	}
+
+	if(queuedCount > 0) {
+		loaderSemaphore.Post(1);
+	}
+	return true;
+}
+
+void PhysicsContext::ReleaseMapCollision(MapCollision* map)
+{
+	if(map->fileList.empty()) return;
+
+	{ LOCK_MUTEX(mutexMeshCache);
+		foreach(it, map->fileList) {
+			ASSERT((*it)->refCount > 0);
+			(*it)->refCount--;
+			(*it)->lastUse = TimeNow();
+		}
+	}
+
+	map->fileList.clear();
+	loaderSemaphore.Post(1); // evicts on the loader thread when over budget
+}
+
+void PhysicsContext::LoadCollisionFile(CollisionFile* file)
+{
+	ProfileFunction();
+	ProfileAttachStringf("%s", file->name.data());
+
+	const Time start = TimeNow();
+
+	eastl::fixed_string<char,512,false> dir;
+	StrConv(&dir, GameDataDir());
+
+	bool r;
+	const char* source;
+	FileBuffer cooked;
+	cooked.data = fileOpenAndReadAll(FMT("%s/%s.physx_static", dir.data(), file->name.data()), &cooked.size);
+	if(cooked.data) {
+		source = "physx_static";
+		r = LoadCollisionMeshes(cooked, file);
+		memFree(cooked.data);
+	}
+	else {
+		// not cooked by tools/collision, cook the mesh file
+		source = "msh";
+		MeshFile mesh;
+		mesh.fileData = nullptr;
+		defer(memFree((void*)mesh.fileData));
+		r = OpenMeshFile(FMT("%s/%s.msh", dir.data(), file->name.data()), &mesh);
+		if(r) r = CookCollisionMeshes(mesh, file);
+	}
+
+	eastl::fixed_vector<PxTriangleMesh*,64,false> releaseList;
+	{ LOCK_MUTEX(mutexMeshCache);
+		if(r) {
+			meshCacheBytes += file->sizeBytes;
+			file->state.SetValue((i32)CollisionFile::State::LOADED);
+		}
+		else {
+			UnloadCollisionFile(file, &releaseList);
+			file->state.SetValue((i32)CollisionFile::State::FAILED);
+		}
+	}
+
+	foreach(it, releaseList) {
+		(*it)->release();
+	}
+
+	if(!r) {
+		LOG("[PhysX] ERROR: failed to load collision file '%s'", file->name.data());
+		return;
+	}
+
+	LOG("[PhysX] Collision file '%s' loaded from .%s (meshes=%d size=%dKB time=%.2fms cache=%dKB)", file->name.data(), source, (i32)file->meshKeyList.size(), file->sizeBytes / 1024, TimeDurationSinceMs(start), meshCacheBytes / 1024);
+}
+
+bool PhysicsContext::LoadCollisionMeshes(const FileBuffer& file, CollisionFile* owner)
 {
 	ConstBuffer buff(file.data, file.size);
 
@@ -145,26 +332,119 @@ bool PhysicsContext::LoadCollisionMeshes(const FileBuffer& file)
 		const i32 nameLen = buff.Read<i32>();
 		const char* name = (char*)buff.ReadRaw(nameLen);
 
-		const u16 meshDataSize = buff.Read<u32>();
+		const u32 meshDataSize = buff.Read<u32>();
 		void* meshData = buff.ReadRaw(meshDataSize);
 
-		PhysxReadBuffer readBuff(meshData, meshDataSize);
-		PxTriangleMesh* tri = physics->createTriangleMesh(readBuff);
-		if(!tri) {
-			LOG("[PhysX] ERROR(LoadCollisionMeshes): createTriangleMesh failed (meshIdx=%d)", i);
+		if(!AddTriangleMesh(owner, name, nameLen, meshData, meshDataSize)) return false;
+	}
+
+	return true;
+}
+
+bool PhysicsContext::CookCollisionMeshes(const MeshFile& mesh, CollisionFile* owner)
+{
+	if(!cooking) {
+		cooking = PxCreateCooking(PX_PHYSICS_VERSION, *foundation, PxCookingParams(TolerancesScale()));
+		if(!cooking) {
+			LOG("[PhysX] ERROR: PxCreateCooking failed");
 			return false;
 		}
+	}
+
+	foreach_const(it, mesh.meshList) {
+		PxTriangleMeshDesc meshDesc;
+		meshDesc.points.count = it->vertexCount;
+		meshDesc.points.stride = sizeof(MeshFile::Vertex);
+		meshDesc.points.data = it->vertices;
 
-		const size_t key = eastl::hash<const char*>{}(FixedStr64(name, nameLen).data());
-		ASSERT(triangleMeshMap.find(key) == triangleMeshMap.end());
-		triangleMeshMap.emplace(key, tri);
+		meshDesc.triangles.count = it->indexCount / 3;
+		meshDesc.triangles.stride = 3 * sizeof(u16);
+		meshDesc.triangles.data = it->indices;
 
-		LOG("[PhysX] '%.*s' loaded", nameLen, name);
+		// tools/collision flips the triangles of the mesh file (back is culled), the .physx_static has them as is
+		meshDesc.flags = PxMeshFlag::e16_BIT_INDICES | PxMeshFlag::eFLIPNORMALS;
+
+		PxDefaultMemoryOutputStream writeBuffer;
+		if(!cooking->cookTriangleMesh(meshDesc, writeBuffer)) {
+			LOG("[PhysX] ERROR(CookCollisionMeshes): cookTriangleMesh failed (mesh='%s')", it->name.data());
+			return false;
+		}
+
+		if(!AddTriangleMesh(owner, it->name.data(), it->name.size(), writeBuffer.getData(), writeBuffer.getSize())) return false;
 	}
 
 	return true;
 }
 
+bool PhysicsContext::AddTriangleMesh(CollisionFile* owner, const char* name, i32 nameLen, void* data, u32 size)
+{
+	PhysxReadBuffer readBuff(data, size);
+	PxTriangleMesh* tri = physics->createTriangleMesh(readBuff);
+	if(!tri) {
+		LOG("[PhysX] ERROR: createTriangleMesh failed (mesh='%.*s')", nameLen, name);
+		return false;
+	}
+
+	const size_t key = eastl::hash<const char*>{}(FixedStr64(name, nameLen).data());
+
+	LOCK_MUTEX(mutexMeshCache);
+	if(triangleMeshMap.find(key) != triangleMeshMap.end()) {
+		WARN("[PhysX] '%.*s' is already loaded by another collision file, ignored", nameLen, name);
+		tri->release();
+		return true;
+	}
+
+	ASSERT(!owner->meshKeyList.full());
+	triangleMeshMap.emplace(key, tri);
+	owner->meshKeyList.push_back(key);
+	owner->sizeBytes += size;
+	return true;
+}
+
+void PhysicsContext::UnloadCollisionFile(CollisionFile* file, eastl::fixed_vector<PxTriangleMesh*,64,false>* releaseList)
+{
+	foreach_const(it, file->meshKeyList) {
+		auto found = triangleMeshMap.find(*it);
+		ASSERT(found != triangleMeshMap.end());
+		releaseList->push_back(found->second); // scenes still using it hold their own reference
+		triangleMeshMap.erase(found);
+	}
+
+	file->meshKeyList.clear();
+	file->sizeBytes = 0;
+}
+
+void PhysicsContext::TrimMeshCache()
+{
+	eastl::fixed_vector<PxTriangleMesh*,64,false> releaseList;
+
+	{ LOCK_MUTEX(mutexMeshCache);
+		while(meshCacheBytes > meshCacheBudget) {
+			// least recently used file no game uses
+			CollisionFile* oldest = nullptr;
+			foreach(it, collisionFileList) {
+				if(it->refCount > 0 || it->state.GetValue() != (i32)CollisionFile::State::LOADED) continue;
+				if(!oldest || it->lastUse < oldest->lastUse) {
+					oldest = &(*it);
+				}
+			}
+
+			if(!oldest) break; // the rest is in use
+
+			const i32 sizeBytes = oldest->sizeBytes;
+			meshCacheBytes -= sizeBytes;
+			UnloadCollisionFile(oldest, &releaseList);
+			oldest->state.SetValue((i32)CollisionFile::State::UNLOADED);
+
+			LOG("[PhysX] Collision file '%s' evicted (size=%dKB cache=%dKB budget=%dKB)", oldest->name.data(), sizeBytes / 1024, meshCacheBytes / 1024, meshCacheBudget / 1024);
+		}
+	}
+
+	foreach(it, releaseList) {
+		(*it)->release();
+	}
+}
+
 bool PhysicsContext::LoadCollisionMesh(PxConvexMesh** out, const FileBuffer& file)
 {
 	// TODO: actually properly read this file instead of skipping the header
@@ -202,10 +482,8 @@ void PhysicsContext::CreateScene(PhysicsScene* out)
 			pvdClient->setScenePvdFlag(PxPvdSceneFlag::eTRANSMIT_SCENEQUERIES, true);
 		}
 
-		PxMaterial* material = physics->createMaterial(1.0f, 1.0f, 0.0f);
-
 		// ground plane to aid with visualization (pvd)
-		PxRigidStatic* groundPlane = PxCreatePlane(*physics, PxPlane(0,0,1,0), *material);
+		PxRigidStatic* groundPlane = PxCreatePlane(*physics, PxPlane(0,0,1,0), *matMapSurface);
 		scene->addActor(*groundPlane);
 
 		out->controllerMngr = PxCreateControllerManager(*scene);
@@ -245,31 +523,60 @@ void PhysicsScene::Step()
 	// here we do nothing but wait...
 	scene->fetchResults(true);
 #endif
+	queryList.clear();
+	queryResultList.clear();
 }
 
 void PhysicsScene::Destroy()
 {
-    if(scene) {
-        scene->release();
-        scene = nullptr;
-    }
+	if(controllerMngr) {
+		controllerMngr->release(); // controllers too
+		controllerMngr = nullptr;
+	}
+
+	// the scene doesn't release its actors
+	if(scene) {
+		eastl::fixed_vector<PxActor*,256> actorList;
+		actorList.resize(scene->getNbActors(PxActorTypeFlag::eRIGID_STATIC | PxActorTypeFlag::eRIGID_DYNAMIC));
+		scene->getActors(PxActorTypeFlag::eRIGID_STATIC | PxActorTypeFlag::eRIGID_DYNAMIC, actorList.data(), actorList.size());
+		foreach(it, actorList) {
+			(*it)->release();
+		}
+
+		scene->release();
+		scene = nullptr;
+	}
+
+	colliderList.clear();
+	queryList.clear();
+	queryResultList.clear();
 }
 
-void PhysicsScene::CreateStaticCollider(const char* meshName, const vec3& pos, const vec3& rot)
+bool PhysicsScene::CreateStaticCollider(const char* meshName, const vec3& pos, const vec3& rot)
 {
 	auto& ctx = PhysContext();
 
-	PxTriangleMeshGeometry geometry = PxTriangleMeshGeometry(ctx.triangleMeshMap.at(eastl::hash<const char*>{}(meshName)));
+	PxShape* shape;
+	{ LOCK_MUTEX(ctx.mutexMeshCache);
+		auto found = ctx.triangleMeshMap.find(eastl::hash<const char*>{}(meshName));
+		if(found == ctx.triangleMeshMap.end()) {
+			WARN("[PhysX] Collision mesh '%s' is not loaded", meshName);
+			return false;
+		}
 
-	PxShape* shape = ctx.physics->createShape(geometry, *ctx.matMapSurface);
-	ASSERT(shape); // createShape failed
+		// the shape references the mesh, it stays alive even if the cache evicts it
+		shape = ctx.physics->createShape(PxTriangleMeshGeometry(found->second), *ctx.matMapSurface);
+		ASSERT(shape); // createShape failed
+	}
 
 	PxRigidStatic* ground = ctx.physics->createRigidStatic(PxTransform{PxIdentity});
 	ground->attachShape(*shape);
+	shape->release(); // owned by the actor
 
 	glm::quat quat(vec3(rot.x, rot.y, -rot.z)); // quaternion from euler angles
 	ground->setGlobalPose(PxTransform(PxVec3(pos.x, pos.y, pos.z), PxQuat(quat.x, quat.y, quat.z, quat.w)));
 	scene->addActor(*ground);
+	return true;
 }
 
 PhysicsDynamicBody* PhysicsScene::CreateDynamicBody(f32 radius, f32 height, const vec3& pos)
@@ -293,32 +600,204 @@ PhysicsDynamicBody* PhysicsScene::CreateDynamicBody(f32 radius, f32 height, cons
 	collider.radius = radius;
 
 	colliderList.push_back(collider);
+	ctrl->setUserData(&colliderList.back()); // used by the CCT filter
 	return &colliderList.back();
 }
 
 vec3 PhysicsScene::Move(PhysicsDynamicBody* body, const vec3& disp, f32 time)
 {
 	PxControllerFilters filter;
+	filter.mCCTFilterCallback = &g_cctCollisionFilterCallback;
 	//filter.mFilterFlags = PxQueryFlag::eSTATIC; // only collide with static colliders
 	PxControllerCollisionFlags collisionFlags = body->collider->move(PxVec3(disp.x, disp.y, disp.z), 0, time, filter, nullptr /* obstacles? */);
 	return body->GetWorldPos();
 }
 
-vec3 PhysicsScene::FindMovePos(PhysicsDynamicBody* body, const vec3& disp, f32 time)
+void PhysicsScene::Teleport(PhysicsDynamicBody* body, const vec3& pos)
+{
+	body->collider->setPosition(PxExtendedVec3(pos.x, pos.y, pos.z));
+	body->vel = vec3(0);
+}
+
+PhysicsScene::QueryID PhysicsScene::PushQuery(const Query& query)
+{
+	if(queryList.full()) {
+		WARN("PhysicsScene query list is full (%d)", (i32)queryList.max_size());
+		return QueryID::INVALID;
+	}
+
+	const QueryID id = (QueryID)queryList.size();
+	queryList.push_back(query);
+	return id;
+}
+
+PhysicsScene::QueryID PhysicsScene::QuerySweep(const PhysicsDynamicBody* body, const vec3& disp)
+{
+	Query q;
+	q.type = Query::Type::SWEEP_BODY;
+	q.body = body;
+	q.origin = body->GetWorldPos();
+	q.dir = disp;
+	q.maxDist = glm::length(disp);
+	q.radius = body->radius;
+	q.height = body->height;
+	return PushQuery(q);
+}
+
+vec3 PhysicsScene::SweepNow(const PhysicsDynamicBody* body, const vec3& disp) const
+{
+	Query q;
+	q.type = Query::Type::SWEEP_BODY;
+	q.body = body;
+	q.origin = body->GetWorldPos();
+	q.dir = disp;
+	q.maxDist = glm::length(disp);
+	q.radius = body->radius;
+	q.height = body->height;
+
+	QueryResult r;
+	r.hit = false;
+	r.pos = q.origin;
+	r.normal = vec3(0);
+	r.distance = 0;
+	ResolveSweep(q, &r);
+	return r.pos;
+}
+
+PhysicsScene::QueryID PhysicsScene::QueryRaycast(const vec3& origin, const vec3& dir, f32 maxDist)
+{
+	Query q;
+	q.type = Query::Type::RAYCAST;
+	q.body = nullptr;
+	q.origin = origin;
+	q.dir = NormalizeSafe(dir);
+	q.maxDist = maxDist;
+	q.radius = 0;
+	q.height = 0;
+	return PushQuery(q);
+}
+
+PhysicsScene::QueryID PhysicsScene::QueryOverlap(const vec3& pos, f32 radius, f32 height)
+{
+	Query q;
+	q.type = Query::Type::OVERLAP;
+	q.body = nullptr;
+	q.origin = pos;
+	q.dir = vec3(0);
+	q.maxDist = 0;
+	q.radius = radius;
+	q.height = height;
+	return PushQuery(q);
+}
+
+void PhysicsScene::ResolveQueries()
+{
+	ProfileFunction();
+
+	// only static geometry, queries never see the character controllers
+	const PxQueryFilterData filterData(PxQueryFlag::eSTATIC);
+
+	// resolve everything that was queued since the last call
+	for(i32 i = queryResultList.size(); i < (i32)queryList.size(); i++) {
+		const Query& q = queryList[i];
+		QueryResult& r = queryResultList.push_back();
+		r.hit = false;
+		r.pos = q.origin;
+		r.normal = vec3(0);
+		r.distance = 0;
+
+		switch(q.type) {
+			case Query::Type::SWEEP_BODY: {
+				ResolveSweep(q, &r);
+			} break;
+
+			case Query::Type::RAYCAST: {
+				r.pos = q.origin + q.dir * q.maxDist;
+				r.distance = q.maxDist;
+				if(q.maxDist <= 0) break;
+
+				PxRaycastBuffer hit;
+				if(scene->raycast(PxVec3(q.origin.x, q.origin.y, q.origin.z), PxVec3(q.dir.x, q.dir.y, q.dir.z), q.maxDist, hit, PxHitFlag::eDEFAULT, filterData) && hit.hasBlock) {
+					r.hit = true;
+					r.pos = tov3(hit.block.position);
+					r.normal = tov3(hit.block.normal);
+					r.distance = hit.block.distance;
+				}
+			} break;
+
+			case Query::Type::OVERLAP: {
+				// capsule stands on origin
+				const PxCapsuleGeometry capsule(q.radius, q.height * 0.5f);
+				const PxTransform pose(PxVec3(q.origin.x, q.origin.y, q.origin.z + q.radius + q.height * 0.5f), PxQuat(PxHalfPi, PxVec3(0, 1, 0)));
+
+				PxOverlapBuffer hit;
+				r.hit = scene->overlap(capsule, pose, hit, filterData) && hit.hasBlock;
+			} break;
+		}
+	}
+}
+
+void PhysicsScene::ResolveSweep(const Query& query, QueryResult* out) const
 {
-	const PxExtendedVec3& start = body->collider->getFootPosition();
-	vec3 end = Move(body, disp, time);
-	body->collider->setFootPosition(start);
-	return end;
+	const PxQueryFilterData filterData(PxQueryFlag::eSTATIC);
+	const f32 skin = query.body->collider->getContactOffset();
+	const f32 stepHeight = STEP_HEIGHT;
+
+	// capsule is lifted by the step height so it doesn't scrape the ground, steps are handled by the ground snap below
+	const f32 halfHeight = MAX(0.0f, query.height * 0.5f - stepHeight * 0.5f);
+	const PxCapsuleGeometry capsule(query.radius, halfHeight);
+	const PxQuat upright(PxHalfPi, PxVec3(0, 1, 0)); // capsules are along X
+	const f32 centerOffset = query.radius + query.height * 0.5f + stepHeight * 0.5f;
+
+	vec3 pos = query.origin;
+	vec3 remaining = query.dir;
+
+	// collide and slide
+	for(i32 it = 0; it < 2; it++) {
+		const f32 len = glm::length(remaining);
+		if(len < PHYS_EPSILON) break;
+
+		const vec3 dir = remaining / len;
+		const PxTransform pose(PxVec3(pos.x, pos.y, pos.z + centerOffset), upright);
+
+		PxSweepBuffer hit;
+		if(!scene->sweep(capsule, pose, PxVec3(dir.x, dir.y, dir.z), len, hit, PxHitFlag::eDEFAULT, filterData) || !hit.hasBlock) {
+			pos += remaining;
+			break;
+		}
+
+		out->hit = true;
+		out->normal = tov3(hit.block.normal);
+
+		const f32 travel = MAX(0.0f, hit.block.distance - skin);
+		pos += dir * travel;
+
+		// slide along the wall with what's left
+		vec3 normal = vec3(vec2(tov3(hit.block.normal)), 0);
+		normal = NormalizeSafe(normal);
+		remaining = dir * (len - travel);
+		remaining -= normal * glm::dot(remaining, normal);
+	}
+
+	out->distance = glm::length(vec2(pos - query.origin));
+
+	// snap to ground
+	const f32 snapDist = centerOffset + stepHeight;
+	PxRaycastBuffer ground;
+	if(scene->raycast(PxVec3(pos.x, pos.y, pos.z + centerOffset), PxVec3(0, 0, -1), snapDist, ground, PxHitFlag::eDEFAULT, filterData) && ground.hasBlock) {
+		pos.z = ground.block.position.z;
+	}
+
+	out->pos = pos;
 }
 
 static PhysicsContext* g_Context;
 
-bool PhysicsInit()
+bool PhysicsInit(bool connectPvd, i32 meshCacheBudget)
 {
 	static PhysicsContext context;
 	g_Context = &context;
-	return context.Init();
+	return context.Init(connectPvd, meshCacheBudget);
 }
 
 PhysicsContext& PhysContext()
@@ -903,6 +1382,7 @@ bool TestIntersection(const ShapeSphere& A, const PhysRect& B, PhysPenetrationVe
 
 const int SUB_STEP_COUNT = 1;
 const int COLLISION_RESOLUTION_STEP_COUNT = 4;
+const int BODY_RELAXATION_COUNT = 4;
 
 void PhysWorld::PushStaticMeshes(const ShapeMesh* meshList, const int count)
 {
@@ -913,11 +1393,13 @@ void PhysWorld::PushStaticMeshes(const ShapeMesh* meshList, const int count)
 	}
 }
 
-PhysWorld::BodyHandle PhysWorld::CreateBody(f32 radius, f32 height, vec3 pos)
+PhysWorld::BodyHandle PhysWorld::CreateBody(f32 radius, f32 height, vec3 pos, u32 group, u32 mask)
 {
 	Body body;
 
 	body.flags = 0x0;
+	body.group = group;
+	body.mask = mask;
 	body.radius = radius;
 	body.height = height;
 	body.pos = pos;
@@ -946,6 +1428,7 @@ void PhysWorld::Step()
 
 	// copy step data to continous buffers
 	bodyList.clear();
+	bodyFilterList.clear();
 	shapeCylinderList.clear();
 	foreach_const(b, dynBodyList) {
 		if(b->flags & Flags::Disabled) continue;
@@ -957,6 +1440,7 @@ void PhysWorld::Step()
 
 		shapeCylinderList.push_back(shape);
 		bodyList.push_back({ b->pos, b->vel + b->force});
+		bodyFilterList.push_back({ b->group, b->mask });
 
 		DBG_ASSERT_NONNAN(bodyList.back().pos.x);
 		DBG_ASSERT_NONNAN(bodyList.back().pos.y);
@@ -967,7 +1451,8 @@ void PhysWorld::Step()
 	}
 
 	// ASSUME NOTHING IS COLLIDING
-	// TODO: make it so (STATIC -> DYNAMIC -> STATIC -> etc algo)
+	// Each resolution step first pushes overlapping bodies apart, then fixes them against the static meshes
+	// so static geometry always has the last word
 
 	const int dynCount = bodyList.size();
 
@@ -978,7 +1463,7 @@ void PhysWorld::Step()
 		}
 
 		for(int cri = 0; cri < COLLISION_RESOLUTION_STEP_COUNT; cri++) {
-			bool collided = false;
+			bool collided = ResolveBodyCollisions();
 			movedShapeCylinderList.clear();
 			eastl::copy(shapeCylinderList.begin(), shapeCylinderList.end(), eastl::back_inserter(movedShapeCylinderList));
 
@@ -1025,7 +1510,7 @@ void PhysWorld::Step()
 						col.triangleNormal = triangleNormal;
 						col.fix = fix;
 						col.fixLenSq = LengthSq(fix);
-						colList.push_back(col);
+						if(!colList.full()) colList.push_back(col); // extra contacts are dropped
 						collided = true;
 
 						#if 1
@@ -1044,7 +1529,7 @@ void PhysWorld::Step()
 							event.fixedVel -= ProjectVecNorm(event.fixedVel, col.triangleNormal);
 						}
 						event.pen = pen;
-						lastStepEvents.push_back(event);
+						if(!lastStepEvents.full()) lastStepEvents.push_back(event);
 						#endif
 					}
 				}
@@ -1081,6 +1566,22 @@ void PhysWorld::Step()
 						body.vel -= ProjectVecNorm(body.vel, col.triangleNormal);
 					}
 
+					// walls are fixed in the same step as the ground, or bodies pushing each other go through them
+					dvec3 applied = col.fix;
+					foreach_const(w, colList) {
+						if(w == selected || abs(w->triangleNormal.z) >= 0.1) continue;
+
+						const dvec3 dir = w->triangleNormal;
+						const f64 missing = sqrt(w->fixLenSq) - glm::dot(applied, dir);
+						if(missing <= 0) continue;
+
+						body.pos += dir * missing;
+						applied += dir * missing;
+						if(glm::dot(body.vel, dir) < 0) {
+							body.vel -= dir * glm::dot(body.vel, dir);
+						}
+					}
+
 					// we are on the ground
 					if(abs(col.triangleNormal.z) > PHYS_EPSILON) {
 						body.flags |= Grounded;
@@ -1103,7 +1604,7 @@ void PhysWorld::Step()
 				rec.cylinder = s;
 				rec.pos = body.pos;
 				rec.vel = body.vel;
-				lastStepPositions.push_back(rec);
+				if(!lastStepPositions.full()) lastStepPositions.push_back(rec);
 				#endif
 			}
 
@@ -1131,6 +1632,128 @@ void PhysWorld::Step()
 	}
 }
 
+bool PhysWorld::ResolveBodyCollisions()
+{
+	ProfileFunction();
+
+	const int dynCount = bodyList.size();
+
+	// broad phase, along the axis bodies are the most spread on (a crowd in a corridor along Y would all overlap on X)
+	dvec2 sum = dvec2(0);
+	dvec2 sumSq = dvec2(0);
+	for(int i = 0; i < dynCount; i++) {
+		const dvec2 p = dvec2(bodyList[i].pos);
+		sum += p;
+		sumSq += p * p;
+	}
+	const dvec2 variance = dynCount > 0 ? sumSq / (f64)dynCount - (sum / (f64)dynCount) * (sum / (f64)dynCount) : dvec2(0);
+	const int axis = variance.y > variance.x ? 1 : 0;
+
+	sweepList.clear();
+	for(int i = 0; i < dynCount; i++) {
+		const BodyFilter& f = bodyFilterList[i];
+		if(f.group == COLGROUP_NONE || f.mask == COLGROUP_NONE) continue;
+
+		const f32 v = (f32)bodyList[i].pos[axis];
+		const f32 r = shapeCylinderList[i].radius;
+		sweepList.push_back({ v - r, v + r, (u16)i });
+	}
+
+	eastl::sort(sweepList.begin(), sweepList.end(), [](const SweepEntry& a, const SweepEntry& b) {
+		if(a.min != b.min) return a.min < b.min;
+		return a.body < b.body;
+	});
+
+	bodyPairList.clear();
+	const int sweepCount = sweepList.size();
+	for(int i = 0; i < sweepCount; i++) {
+		const SweepEntry& ea = sweepList[i];
+		const BodyFilter& fa = bodyFilterList[ea.body];
+
+		for(int j = i + 1; j < sweepCount && sweepList[j].min <= ea.max; j++) {
+			const SweepEntry& eb = sweepList[j];
+			const BodyFilter& fb = bodyFilterList[eb.body];
+			if(!CollisionGroupsCollide(fa.group, fa.mask, fb.group, fb.mask)) continue;
+
+			// and on the other axis
+			const f64 reach = shapeCylinderList[ea.body].radius + shapeCylinderList[eb.body].radius;
+			if(abs(bodyList[ea.body].pos[1-axis] - bodyList[eb.body].pos[1-axis]) >= reach) continue;
+
+			if(bodyPairList.full()) {
+				WARN("Body pair list is full (%d)", (i32)bodyPairList.size());
+				break;
+			}
+			bodyPairList.push_back({ (u16)MIN(ea.body, eb.body), (u16)MAX(ea.body, eb.body) });
+		}
+	}
+
+	// resolve in body order so the result does not depend on positions
+	eastl::sort(bodyPairList.begin(), bodyPairList.end(), [](const BodyPair& a, const BodyPair& b) {
+		if(a.a != b.a) return a.a < b.a;
+		return a.b < b.b;
+	});
+
+	bodyPrevPosList.clear();
+	foreach_const(b, bodyList) {
+		bodyPrevPosList.push_back(b->pos);
+	}
+
+	// a few relaxation passes over the pairs, pushes travel one body further each pass
+	bool collided = false;
+	for(int pass = 0; pass < BODY_RELAXATION_COUNT; pass++) {
+	bool overlapped = false;
+	foreach_const(p, bodyPairList) {
+		MoveComp& ba = bodyList[p->a];
+		MoveComp& bb = bodyList[p->b];
+		const ShapeCylinder& sa = shapeCylinderList[p->a];
+		const ShapeCylinder& sb = shapeCylinderList[p->b];
+
+		// vertical overlap
+		if(ba.pos.z >= bb.pos.z + sb.height || bb.pos.z >= ba.pos.z + sa.height) continue;
+
+		const dvec2 delta = dvec2(bb.pos - ba.pos);
+		const f64 distSq = glm::dot(delta, delta);
+		const f64 minDist = sa.radius + sb.radius;
+		if(distSq >= minDist * minDist) continue;
+
+		const f64 dist = sqrt(distSq);
+		const dvec2 n = dist > PHYS_EPSILON ? delta / dist : dvec2(1, 0);
+		const dvec2 fix = n * ((minDist - dist) * 0.5 + PHYS_EPSILON * 10.0);
+
+		ba.pos -= dvec3(fix, 0);
+		bb.pos += dvec3(fix, 0);
+
+		// cancel velocity towards each other
+		const f64 relVel = glm::dot(dvec2(bb.vel - ba.vel), n);
+		if(relVel < 0) {
+			ba.vel += dvec3(n * (relVel * 0.5), 0);
+			bb.vel -= dvec3(n * (relVel * 0.5), 0);
+		}
+
+		overlapped = true;
+	}
+
+	collided |= overlapped;
+	if(!overlapped) break;
+	}
+
+	// a crowd pushes a body by much more than its radius, it would go through walls before the static pass fixes it
+	// so a body never moves by more than half its radius in one resolution step
+	if(collided) {
+		for(int i = 0; i < dynCount; i++) {
+			const dvec2 disp = dvec2(bodyList[i].pos - bodyPrevPosList[i]);
+			const f64 maxDisp = shapeCylinderList[i].radius * 0.5;
+			const f64 lenSq = glm::dot(disp, disp);
+			if(lenSq > maxDisp * maxDisp) {
+				const dvec2 clamped = disp * (maxDisp / sqrt(lenSq));
+				bodyList[i].pos = bodyPrevPosList[i] + dvec3(clamped, bodyList[i].pos.z - bodyPrevPosList[i].z);
+			}
+		}
+	}
+
+	return collided;
+}
+
 vec3 PhysWorld::MoveUntilWall(const PhysWorld::BodyHandle handle, const vec3& dest)
 {
 	ShapeCylinder shape;
@@ -1198,7 +1821,7 @@ vec3 PhysWorld::FixCollision(const ShapeCylinder& shape, vec3 pos)
 				col.triangleNormal = triangleNormal;
 				col.fix = fix;
 				col.fixLenSq = LengthSq(fix);
-				colList.push_back(col);
+				if(!colList.full()) colList.push_back(col);
 				collided = true;
 			}
 		}
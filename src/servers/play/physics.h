@@ -1,8 +1,11 @@
 #pragma once
 #include <common/vector_math.h>
 #include <common/utils.h>
+#include <common/mpsc_queue.h>
+#include <common/protocol.h>
 #include <EASTL/array.h>
 #include <EASTL/fixed_list.h>
+#include <eathread/eathread_semaphore.h>
 
 #include <foundation/PxAllocatorCallback.h>
 #include <foundation/PxErrorCallback.h>
@@ -13,8 +16,11 @@
 #include <characterkinematic/PxBoxController.h>
 #include <characterkinematic/PxCapsuleController.h>
 #include <characterkinematic/PxControllerManager.h>
+#include <cooking/PxCooking.h>
 using namespace physx;
 
+struct GameXmlContent;
+
 // should be no-op
 inline vec3 tov3(const PxVec3& v)
 {
@@ -35,6 +41,7 @@ struct PhysicsAllocatorCallback: PxAllocatorCallback
 
 	virtual void* allocate(size_t size, const char* typeName, const char* filename, int line) override
 	{
+		MEM_TAG(MemTag::PHYSICS);
 		void* ptr = memAlloc(size);
 		DBG_ASSERT((((intptr_t)ptr) & 15) == 0); // 16 aligned
 		return ptr;
@@ -75,12 +82,28 @@ struct PhysicsCollisionMesh
 	PxShape* shape;
 };
 
+// Body <-> body collision filtering, A and B collide when (A.group & B.mask) && (B.group & A.mask)
+enum CollisionGroup: u32 {
+	COLGROUP_NONE = 0x0,
+	COLGROUP_PLAYER = 0x1,
+	COLGROUP_MOB = 0x2, // AI mobs such as rozark
+};
+
+inline bool CollisionGroupsCollide(u32 groupA, u32 maskA, u32 groupB, u32 maskB)
+{
+	return (groupA & maskB) && (groupB & maskA);
+}
+
 struct PhysicsDynamicBody
 {
 	PxCapsuleController* collider = nullptr;
 	vec3 vel = vec3(0); // actual velocity
 	Time lockedMoveUntil = Time::ZERO;
 
+	// players only collide with mobs
+	u32 group = COLGROUP_PLAYER;
+	u32 mask = COLGROUP_MOB;
+
 	inline vec3 GetWorldPos() const { return tov3(collider->getFootPosition()); }
 	inline vec2 GetBoundSize() const { return { radius, height + radius * 2 }; }
 
@@ -93,28 +116,114 @@ private:
 
 struct PhysicsScene
 {
+	// Scene queries don't move anything, they are queued during the tick and resolved together with ResolveQueries()
+	// Results are valid until the next Step()
+	enum class QueryID: u16 {
+		INVALID = 0xFFFF
+	};
+
+	struct Query
+	{
+		enum class Type: u8 {
+			SWEEP_BODY, // where does the body end up if it moves by disp (slides along walls)
+			RAYCAST,
+			OVERLAP, // upright capsule standing at origin
+		};
+
+		Type type;
+		const PhysicsDynamicBody* body;
+		vec3 origin;
+		vec3 dir; // displacement for sweeps
+		f32 maxDist;
+		f32 radius;
+		f32 height;
+	};
+
+	struct QueryResult
+	{
+		bool hit;
+		vec3 pos; // sweep: end foot position, raycast: hit position (or end of ray)
+		vec3 normal;
+		f32 distance;
+	};
+
 	Time localTime = Time::ZERO;
     PxScene* scene = nullptr;
     PxControllerManager* controllerMngr = nullptr;
 	eastl::fixed_vector<PhysicsDynamicBody,256,false> colliderList; // doesn't grow so we don't invalidate pointer
 
+	eastl::fixed_vector<Query,256,false> queryList;
+	eastl::fixed_vector<QueryResult,256,false> queryResultList;
+
 	void Step();
 	void Destroy();
 
-	void CreateStaticCollider(const char* meshName, const vec3& pos, const vec3& rot = vec3(0));
+	bool CreateStaticCollider(const char* meshName, const vec3& pos, const vec3& rot = vec3(0)); // false when the mesh is not loaded
 	PhysicsDynamicBody* CreateDynamicBody(f32 radius, f32 height, const vec3& pos);
 	vec3 Move(PhysicsDynamicBody* body, const vec3& disp, f32 time /* seconds */);
-	vec3 FindMovePos(PhysicsDynamicBody* body, const vec3& disp, f32 time);
+	void Teleport(PhysicsDynamicBody* body, const vec3& pos); // same position convention as CreateDynamicBody
+
+	QueryID QuerySweep(const PhysicsDynamicBody* body, const vec3& disp);
+	QueryID QueryRaycast(const vec3& origin, const vec3& dir, f32 maxDist);
+	QueryID QueryOverlap(const vec3& pos, f32 radius, f32 height);
+	void ResolveQueries();
+	vec3 SweepNow(const PhysicsDynamicBody* body, const vec3& disp) const; // QuerySweep resolved right away, for when the query can't be queued
+
+	inline const QueryResult& GetQueryResult(QueryID id) const
+	{
+		ASSERT((i32)id < queryResultList.size());
+		return queryResultList[(i32)id];
+	}
+
+private:
+	QueryID PushQuery(const Query& query);
+	void ResolveSweep(const Query& query, QueryResult* out) const;
 };
 
 struct PhysicsContext
 {
+	// Map collision meshes are loaded per file the first time a map needs them, by the loader thread.
+	// gamedata/<name>.physx_static is used as is when present, otherwise gamedata/<name>.msh is cooked.
+	// The meshes stay in triangleMeshMap while a game uses them, then until the cache is over budget (least recently used first).
+	struct CollisionFile
+	{
+		enum class State: i32 {
+			UNLOADED = 0,
+			LOADING,
+			LOADED,
+			FAILED
+		};
+
+		FixedStr64 name;
+		EA::Thread::AtomicInt32 state = (i32)State::UNLOADED; // set by the loader thread
+		i32 refCount = 0; // games using it
+		Time lastUse = Time::ZERO;
+		i32 sizeBytes = 0; // cooked data
+		eastl::fixed_vector<size_t,16,false> meshKeyList; // triangleMeshMap keys
+	};
+
+	// Collision of the map a game is played on, held by the game until it ends
+	struct MapCollision
+	{
+		MapIndex mapIndex = (MapIndex)0;
+		eastl::fixed_vector<CollisionFile*,8,false> fileList;
+
+		enum class LoadState: u8 {
+			LOADING = 0,
+			LOADED,
+			FAILED // a file failed to load (or the map was not acquired), the map can't be played
+		};
+
+		LoadState GetLoadState() const;
+	};
+
 	PhysicsAllocatorCallback allocatorCallback;
 	PhysicsErrorCallback errorCallback;
 	PxFoundation* foundation;
 	PxCpuDispatcher* dispatcher;
 	PxPhysics* physics;
-	PxPvd* pvd;
+	PxCooking* cooking; // loader thread only, created on the first .msh
+	PxPvd* pvd; // null unless connecting to PVD was requested
 
 	ProfileMutex(Mutex, mutexSceneCreate);
 
@@ -124,15 +233,38 @@ struct PhysicsContext
 	eastl::hash<const char*> strHash;
 	eastl::fixed_hash_map<size_t, PxTriangleMesh*, 64> triangleMeshMap;
 
-	bool Init();
+	ProfileMutex(Mutex, mutexMeshCache); // triangleMeshMap and collision files
+	eastl::fixed_list<CollisionFile,64,false> collisionFileList;
+	i32 meshCacheBytes = 0; // loaded collision files
+	i32 meshCacheBudget = 0; // bytes, unused files are evicted above it
+
+	MPSCQueue<CollisionFile*> loadQueue;
+	EA::Thread::Semaphore loaderSemaphore;
+	EA::Thread::Thread loaderThread;
+	bool loaderRunning = false;
+
+	bool Init(bool connectPvd, i32 meshCacheBudget_);
+	bool LoadContentMeshes(); // cooks the body collision mesh of the game content, needs its collision files loaded
 	void Shutdown();
 
-	bool LoadCollisionMeshes(const FileBuffer& file);
+	// Thread: Any
+	// the collision files of the map (GameXmlContent::FindMapCollision), queues the ones that are not loaded yet and returns immediately
+	bool AcquireMapCollision(const GameXmlContent& content, MapIndex mapIndex, MapCollision* out);
+	void ReleaseMapCollision(MapCollision* map);
+
 	bool LoadCollisionMesh(PxConvexMesh** out, const FileBuffer& file);
 	void CreateScene(PhysicsScene* out);
+
+	// Thread: Loader
+	void LoadCollisionFile(CollisionFile* file);
+	bool LoadCollisionMeshes(const FileBuffer& file, CollisionFile* owner); // .physx_static
+	bool CookCollisionMeshes(const MeshFile& mesh, CollisionFile* owner); // .msh
+	bool AddTriangleMesh(CollisionFile* owner, const char* name, i32 nameLen, void* data, u32 size);
+	void UnloadCollisionFile(CollisionFile* file, eastl::fixed_vector<PxTriangleMesh*,64,false>* releaseList); // needs mutexMeshCache
+	void TrimMeshCache();
 };
 
-bool PhysicsInit();
+bool PhysicsInit(bool connectPvd, i32 meshCacheBudget);
 PhysicsContext& PhysContext();
 
 constexpr f32 PHYS_EPSILON = 0.0001f; // Warning: NEVER change this value
@@ -471,6 +603,8 @@ struct PhysWorld
 	struct Body
 	{
 		u32 flags;
+		u32 group; // CollisionGroup
+		u32 mask;
 		f32 radius;
 		f32 height;
 		vec3 pos;
@@ -492,10 +626,34 @@ struct PhysWorld
 		f32 fixLenSq;
 	};
 
+	struct BodyFilter
+	{
+		u32 group;
+		u32 mask;
+	};
+
+	// broad phase: sort and sweep along X or Y
+	struct SweepEntry
+	{
+		f32 min;
+		f32 max;
+		u16 body;
+	};
+
+	struct BodyPair
+	{
+		u16 a;
+		u16 b;
+	};
+
 	eastl::fixed_vector<MoveComp, 4096, false> bodyList;
+	eastl::fixed_vector<BodyFilter, 4096, false> bodyFilterList;
 	eastl::fixed_vector<ShapeCylinder, 4096, false> shapeCylinderList;
 	eastl::fixed_vector<ShapeCylinder, 4096, false> movedShapeCylinderList;
 	eastl::fixed_vector<eastl::fixed_vector<Collision,16,false>, 4096, false> collisionList;
+	eastl::fixed_vector<SweepEntry, 4096, false> sweepList;
+	eastl::fixed_vector<BodyPair, 8192, false> bodyPairList;
+	eastl::fixed_vector<dvec3, 4096, false> bodyPrevPosList;
 
 #if 1
 	u64 step = 0;
@@ -536,10 +694,11 @@ struct PhysWorld
 #endif
 
 	void PushStaticMeshes(const ShapeMesh* meshList, const int count);
-	BodyHandle CreateBody(f32 radius, f32 height, vec3 pos);
+	BodyHandle CreateBody(f32 radius, f32 height, vec3 pos, u32 group = COLGROUP_PLAYER, u32 mask = COLGROUP_MOB);
 	void DeleteBody(BodyHandle handle);
 
 	void Step();
+	bool ResolveBodyCollisions();
 
 	vec3 MoveUntilWall(const BodyHandle handle, const vec3& dest);
 	vec3 FixCollision(const ShapeCylinder& shape, vec3 pos);
@@ -0,0 +1,349 @@
+#include "remote.h"
+#include "physics.h" // NormalizeSafe
+
+void SpatialHash::Clear()
+{
+	bucketHead.fill(NONE);
+	entryList.clear();
+	entryMap.clear();
+	maxRadius = 0;
+}
+
+void SpatialHash::Push(ActorUID actorUID, const vec3& pos, f32 radius, f32 height, Faction faction, Kind kind)
+{
+	if(entryList.full()) {
+		WARN("SpatialHash is full (%d)", MAX_ENTRIES);
+		return;
+	}
+
+	const u16 id = (u16)entryList.size();
+	Entry& e = entryList.push_back();
+	e.actorUID = actorUID;
+	e.pos = pos;
+	e.radius = radius;
+	e.height = height;
+	e.faction = faction;
+	e.kind = kind;
+	e.cellX = CellCoord(pos.x);
+	e.cellY = CellCoord(pos.y);
+
+	const u32 bucket = Bucket(e.cellX, e.cellY);
+	e.next = bucketHead[bucket];
+	bucketHead[bucket] = id;
+
+	entryMap.emplace(actorUID, id);
+	maxRadius = MAX(maxRadius, radius);
+}
+
+const SpatialHash::Entry* SpatialHash::Find(ActorUID actorUID) const
+{
+	auto found = entryMap.find(actorUID);
+	if(found == entryMap.end()) return nullptr;
+	return &entryList[found->second];
+}
+
+static RemoteSimulation::Motion MotionFromBehavior(Remote::BehaviorType behavior)
+{
+	typedef Remote::BehaviorType BT;
+	typedef RemoteSimulation::Motion M;
+
+	switch(behavior) {
+		case BT::BEAM:
+		case BT::ATTACH_MUZZLE:
+		case BT::CASTER_TARGET:
+			return M::ATTACHED;
+
+		case BT::HOMING:
+		case BT::FOLLOW_TARGET:
+			return M::HOMING;
+
+		case BT::GRAPH:
+			return M::GRAPH;
+
+		case BT::TARGET:
+		case BT::ATTACH_TARGET:
+		case BT::TARGET_GROUNDPOSITION:
+			return M::TARGET;
+
+		// TODO: RETURN, CHAIN, ORBIT
+		case BT::INVALID:
+		case BT::NONETARGET:
+		case BT::RETURN:
+		case BT::CHAIN:
+		case BT::ORBIT:
+			return M::STATIC;
+	}
+
+	return M::STATIC;
+}
+
+bool RemoteSimulation::Spawn(const SpawnDesc& desc, Time localTime)
+{
+	const Remote* found = content->FindRemote(desc.docID);
+	if(!found) {
+		WARN("Remote %d not found", (i32)desc.docID);
+		return false;
+	}
+
+	const Remote& doc = *found;
+	const Motion motion = MotionFromBehavior(doc.behaviorType);
+	auto& list = batchList[(i32)motion];
+	if(list.full()) {
+		WARN("Remote batch %d is full, remote %d not spawned", (i32)motion, (i32)desc.docID);
+		return false;
+	}
+
+	Instance& inst = list.push_back();
+	inst.doc = &doc;
+	inst.skillID = desc.skillID;
+	inst.casterUID = desc.casterUID;
+	inst.targetUID = desc.targetUID;
+	inst.faction = desc.faction;
+	inst.pos = desc.pos;
+	inst.startPos = desc.pos;
+	inst.targetPos = desc.targetPos;
+	inst.dir = vec2(cosf(desc.angle), sinf(desc.angle));
+	inst.spawnTime = localTime;
+	inst.hitCount = 0;
+	inst.hitList.clear();
+
+	if(motion == Motion::TARGET && doc.behaviorType == Remote::BehaviorType::TARGET_GROUNDPOSITION) {
+		inst.pos = desc.targetPos;
+		inst.targetUID = ActorUID::INVALID;
+	}
+	return true;
+}
+
+void RemoteSimulation::Step(Time localTime, f32 delta)
+{
+	ProfileFunction();
+
+	hitList.clear();
+
+	// move
+	MoveAttached(Slice<Instance>(batchList[(i32)Motion::ATTACHED].data(), batchList[(i32)Motion::ATTACHED].size()));
+	MoveHoming(Slice<Instance>(batchList[(i32)Motion::HOMING].data(), batchList[(i32)Motion::HOMING].size()), delta);
+	MoveGraph(Slice<Instance>(batchList[(i32)Motion::GRAPH].data(), batchList[(i32)Motion::GRAPH].size()), localTime);
+	MoveTarget(Slice<Instance>(batchList[(i32)Motion::TARGET].data(), batchList[(i32)Motion::TARGET].size()));
+
+	// hit, then remove dead remotes
+	foreach(list, batchList) {
+		for(auto it = list->begin(); it != list->end(); ) {
+			Instance& inst = *it;
+			TestHits(inst, localTime);
+
+			const bool pierced = inst.doc->penetrationCount > 0 && inst.hitCount >= inst.doc->penetrationCount;
+			const bool expired = TimeDiffSec(TimeDiff(inst.spawnTime, localTime)) >= inst.doc->lifeTime;
+			if(pierced || expired) {
+				it = list->erase_unsorted(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+}
+
+void RemoteSimulation::Clear()
+{
+	foreach(list, batchList) {
+		list->clear();
+	}
+	hitList.clear();
+	actorHash.Clear();
+}
+
+i32 RemoteSimulation::CountAlive() const
+{
+	i32 count = 0;
+	foreach_const(list, batchList) {
+		count += list->size();
+	}
+	return count;
+}
+
+void RemoteSimulation::MoveAttached(Slice<Instance> list)
+{
+	foreach(it, list) {
+		const SpatialHash::Entry* caster = actorHash.Find(it->casterUID);
+		if(caster) {
+			it->pos = caster->pos;
+		}
+	}
+}
+
+void RemoteSimulation::MoveHoming(Slice<Instance> list, f32 delta)
+{
+	foreach(it, list) {
+		const Remote& doc = *it->doc;
+
+		const SpatialHash::Entry* target = actorHash.Find(it->targetUID);
+		if(target) {
+			it->targetPos = target->pos;
+
+			// turn towards target, limited by turn rate
+			const vec2 toTarget = NormalizeSafe(vec2(target->pos - it->pos));
+			if(toTarget != vec2(0)) {
+				const f32 cur = atan2f(it->dir.y, it->dir.x);
+				f32 diff = atan2f(toTarget.y, toTarget.x) - cur;
+				if(diff > PI) diff -= 2*PI;
+				if(diff < -PI) diff += 2*PI;
+				if(doc.angularVel > 0) {
+					const f32 maxTurn = doc.angularVel * delta;
+					diff = MAX(-maxTurn, MIN(maxTurn, diff));
+				}
+				it->dir = vec2(cosf(cur + diff), sinf(cur + diff));
+			}
+		}
+
+		it->pos += vec3(it->dir * (doc.maxSpeed * delta), 0);
+	}
+}
+
+void RemoteSimulation::MoveGraph(Slice<Instance> list, Time localTime)
+{
+	foreach(it, list) {
+		const Remote& doc = *it->doc;
+
+		vec3 endPos = it->targetPos;
+		if(doc.graphLength > 0) {
+			endPos = it->startPos + vec3(it->dir * (f32)doc.graphLength, 0);
+		}
+
+		const f32 t = doc.lifeTime > 0 ? MIN(1.0f, (f32)TimeDiffSec(TimeDiff(it->spawnTime, localTime)) / doc.lifeTime) : 1.0f;
+		it->pos = glm::mix(it->startPos, endPos, t);
+	}
+}
+
+void RemoteSimulation::MoveTarget(Slice<Instance> list)
+{
+	foreach(it, list) {
+		if(it->targetUID == ActorUID::INVALID) continue; // ground position
+
+		const SpatialHash::Entry* target = actorHash.Find(it->targetUID);
+		if(target) {
+			it->pos = target->pos;
+		}
+	}
+}
+
+void RemoteSimulation::TestHits(Instance& inst, Time localTime)
+{
+	typedef Remote::BoundType BT;
+	typedef Remote::DamageGroup DG;
+
+	const Remote& doc = *inst.doc;
+	if(doc.damageGroup == DG::eNONE || doc.damageGroup == DG::INVALID) return;
+	if(doc.boundType == BT::E_BOUND_NONE || doc.boundType == BT::INVALID) return;
+
+	const f32 lenX = doc.boundSize[0];
+	const f32 lenY = doc.boundSize[1];
+	const f32 lenZ = doc.boundSize[2];
+
+	enum class Shape: u8 {
+		SPHERE,
+		SEGMENT,
+		BOX
+	};
+
+	Shape shape = Shape::BOX;
+	switch(doc.boundType) {
+		case BT::E_BOUND_SPHERE: shape = Shape::SPHERE; break;
+		case BT::E_BOUND_RAY:
+		case BT::E_BOUND_CAPSULE:
+		case BT::E_BOUND_BEAM:
+		case BT::E_BOUND_BEAM_NIF:
+		case BT::E_BOUND_LASER: shape = Shape::SEGMENT; break;
+
+		// TODO: hammer, caster move and physx prop bounds are tested as boxes
+		default: break;
+	}
+
+	// broad phase bounds
+	vec2 center = vec2(inst.pos);
+	f32 reach = lenX;
+	if(shape != Shape::SPHERE) {
+		center += inst.dir * (lenX * 0.5f);
+		reach = lenX * 0.5f + lenY;
+	}
+
+	const vec2 vmin = center - vec2(reach);
+	const vec2 vmax = center + vec2(reach);
+
+	actorHash.Query(vmin, vmax, [&](const SpatialHash::Entry& actor) {
+		if(!(doc.vs & (1 << (u8)actor.kind))) return;
+
+		switch(doc.damageGroup) {
+			case DG::eENEMY: if(actor.faction == inst.faction) return; break;
+			case DG::eFRIEND: if(actor.faction != inst.faction) return; break;
+			default: break;
+		}
+
+		// actors are vertical cylinders centered on pos
+		const f32 dz = fabsf(actor.pos.z - inst.pos.z);
+		if(lenZ > 0 && dz > (lenZ + actor.height) * 0.5f) return;
+
+		const vec2 rel = vec2(actor.pos) - vec2(inst.pos);
+		bool hit = false;
+
+		switch(shape) {
+			case Shape::SPHERE: {
+				const f32 r = lenX + actor.radius;
+				hit = glm::dot(rel, rel) <= r * r;
+			} break;
+
+			case Shape::SEGMENT: {
+				const f32 along = MAX(0.0f, MIN(lenX, glm::dot(rel, inst.dir)));
+				const vec2 closest = inst.dir * along;
+				const f32 r = lenY * 0.5f + actor.radius;
+				hit = glm::dot(rel - closest, rel - closest) <= r * r;
+			} break;
+
+			case Shape::BOX: {
+				// box starts at the remote position and extends forward
+				const f32 x = glm::dot(rel, inst.dir);
+				const f32 y = glm::dot(rel, vec2(-inst.dir.y, inst.dir.x));
+				hit = x >= -actor.radius && x <= lenX + actor.radius && fabsf(y) <= lenY * 0.5f + actor.radius;
+			} break;
+		}
+
+		if(!hit) return;
+
+		// same actor can't be hit again before hitInvalidTime
+		Instance::HitRecord* rec = nullptr;
+		foreach(h, inst.hitList) {
+			if(h->actorUID == actor.actorUID) {
+				rec = h;
+				break;
+			}
+		}
+
+		if(rec) {
+			if(TimeDiffSec(TimeDiff(rec->time, localTime)) < doc.hitInvalidTime) return;
+			rec->time = localTime;
+		}
+		else {
+			if(inst.hitList.full()) {
+				inst.hitList.erase(inst.hitList.begin()); // forget oldest
+			}
+			inst.hitList.push_back({ actor.actorUID, localTime });
+		}
+
+		if(doc.penetrationCount > 0 && inst.hitCount >= doc.penetrationCount) return;
+		inst.hitCount++;
+
+		if(hitList.full()) {
+			WARN("Remote hit list is full (%d)", MAX_HITS);
+			return;
+		}
+
+		Hit& h = hitList.push_back();
+		h.docID = doc.ID;
+		h.skillID = inst.skillID;
+		h.casterUID = inst.casterUID;
+		h.targetUID = actor.actorUID;
+		h.pos = actor.pos;
+		h.damageGroup = doc.damageGroup;
+		h.attackMultiplier = doc.attackMultiplier;
+	});
+}
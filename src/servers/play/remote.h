@@ -0,0 +1,159 @@
+#pragma once
+#include <common/base.h>
+#include <common/vector_math.h>
+#include <mxm/core.h>
+#include <mxm/game_content.h>
+
+#include <EASTL/array.h>
+#include <EASTL/fixed_vector.h>
+#include <EASTL/fixed_hash_map.h>
+
+// Uniform grid on the XY plane, rebuilt every tick from the actor positions.
+// Actors are only inserted in the cell containing their center, queries are expanded by the largest radius pushed.
+struct SpatialHash
+{
+	enum {
+		BUCKET_COUNT = 1024, // power of 2
+		MAX_ENTRIES = 2048,
+		NONE = 0xFFFF
+	};
+
+	enum class Kind: u8 {
+		DYNAMIC = Remote::VS_DYNAMIC,
+		NPC = Remote::VS_NPC_MONSTER,
+		PLAYER = Remote::VS_PLAYER_CHARACTER,
+	};
+
+	struct Entry
+	{
+		ActorUID actorUID;
+		vec3 pos;
+		f32 radius;
+		f32 height;
+		Faction faction; // remotes only hit the factions their damage group allows
+		Kind kind;
+		u16 next;
+		i32 cellX;
+		i32 cellY;
+	};
+
+	const f32 cellSize = 500;
+	f32 maxRadius = 0;
+
+	eastl::array<u16,BUCKET_COUNT> bucketHead;
+	eastl::fixed_vector<Entry,MAX_ENTRIES,false> entryList;
+	eastl::fixed_hash_map<ActorUID,u16,MAX_ENTRIES,MAX_ENTRIES+1,false> entryMap;
+
+	void Clear();
+	void Push(ActorUID actorUID, const vec3& pos, f32 radius, f32 height, Faction faction, Kind kind);
+	const Entry* Find(ActorUID actorUID) const;
+
+	// calls cb(const Entry&) for every entry whose cell overlaps [vmin, vmax] (expanded by maxRadius)
+	template<typename Callback>
+	void Query(const vec2& vmin, const vec2& vmax, Callback cb) const
+	{
+		const i32 x0 = CellCoord(vmin.x - maxRadius);
+		const i32 y0 = CellCoord(vmin.y - maxRadius);
+		const i32 x1 = CellCoord(vmax.x + maxRadius);
+		const i32 y1 = CellCoord(vmax.y + maxRadius);
+
+		for(i32 y = y0; y <= y1; y++) {
+			for(i32 x = x0; x <= x1; x++) {
+				for(u16 e = bucketHead[Bucket(x, y)]; e != NONE; e = entryList[e].next) {
+					const Entry& entry = entryList[e];
+					// several cells can land in the same bucket
+					if(entry.cellX != x || entry.cellY != y) continue;
+					cb(entry);
+				}
+			}
+		}
+	}
+
+private:
+	inline i32 CellCoord(f32 v) const { return (i32)floorf(v / cellSize); }
+	inline u32 Bucket(i32 x, i32 y) const { return ((u32)x * 73856093u ^ (u32)y * 19349663u) & (BUCKET_COUNT - 1); }
+};
+
+// Server side simulation of remotes (projectiles, explosions, beams...) spawned by skills.
+// Remotes are stored in one list per motion type and each list is advanced in a single pass,
+// then every remote is tested against the actors found in its cells.
+struct RemoteSimulation
+{
+	enum {
+		MAX_REMOTES_PER_BATCH = 256,
+		MAX_HITS = 1024,
+	};
+
+	enum class Motion: u8 {
+		STATIC = 0, // stays where spawned (most area damage)
+		ATTACHED, // follows the caster (beams, muzzle)
+		HOMING, // moves towards the target actor
+		GRAPH, // travels along a fixed path over its lifetime
+		TARGET, // sits on the target actor or the ground position
+		_COUNT
+	};
+
+	struct SpawnDesc
+	{
+		RemoteIdx docID;
+		SkillID skillID;
+		ActorUID casterUID;
+		Faction faction; // of the caster
+		vec3 pos;
+		f32 angle;
+		vec3 targetPos;
+		ActorUID targetUID = ActorUID::INVALID;
+	};
+
+	struct Hit
+	{
+		RemoteIdx docID;
+		SkillID skillID;
+		ActorUID casterUID;
+		ActorUID targetUID;
+		vec3 pos;
+		Remote::DamageGroup damageGroup;
+		f32 attackMultiplier;
+	};
+
+	struct Instance
+	{
+		struct HitRecord
+		{
+			ActorUID actorUID;
+			Time time;
+		};
+
+		const Remote* doc;
+		SkillID skillID;
+		ActorUID casterUID;
+		ActorUID targetUID;
+		Faction faction;
+		vec3 pos;
+		vec3 startPos;
+		vec3 targetPos;
+		vec2 dir;
+		Time spawnTime;
+		i32 hitCount;
+		eastl::fixed_vector<HitRecord,16,false> hitList;
+	};
+
+	const GameXmlContent* content; // set by World::Init
+	SpatialHash actorHash;
+	eastl::array<eastl::fixed_vector<Instance,MAX_REMOTES_PER_BATCH,false>,(i32)Motion::_COUNT> batchList;
+	eastl::fixed_vector<Hit,MAX_HITS,false> hitList; // hits of the last step
+
+	bool Spawn(const SpawnDesc& desc, Time localTime);
+	void Step(Time localTime, f32 delta); // actorHash has to be filled beforehand
+	void Clear();
+
+	i32 CountAlive() const;
+
+private:
+	void MoveAttached(Slice<Instance> list);
+	void MoveHoming(Slice<Instance> list, f32 delta);
+	void MoveGraph(Slice<Instance> list, Time localTime);
+	void MoveTarget(Slice<Instance> list);
+
+	void TestHits(Instance& inst, Time localTime);
+};
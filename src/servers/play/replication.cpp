@@ -4,9 +4,53 @@
 #include <EASTL/algorithm.h>
 #include <EASTL/fixed_hash_map.h>
 #include <EAStdC/EAString.h>
+#include <common/metrics.h>
 #include <mxm/game_content.h>
 #include "config.h"
 
+static thread_local bool t_Encoder = false; // set on the pipeline threads
+
+// recorded lane calls, followed by their strings (wchar, null terminated) for the chat ones
+struct CmdPacket
+{
+	ClientHandle clientHd;
+	u16 netID;
+	u16 size;
+};
+
+struct CmdPlayer
+{
+	ClientHandle clientHd;
+	ClientHandle prevClientHd;
+	u32 playerIndex;
+};
+
+struct CmdMaster
+{
+	ClientHandle clientHd;
+	ActorUID actorUID;
+	ClassType classType;
+	SkinIndex skinIndex;
+};
+
+struct CmdCharacterInfo
+{
+	ClientHandle clientHd;
+	ActorUID actorUID;
+	CreatureIndex docID;
+	ClassType classType;
+	i32 health;
+	i32 healthMax;
+};
+
+struct CmdChat
+{
+	ClientHandle toClientHd; // INVALID: to all
+	i32 chatType;
+	i32 senderLen;
+	i32 msgLen;
+};
+
 void Replication::Frame::Clear()
 {
 	playerList.clear();
@@ -24,6 +68,22 @@ void Replication::Frame::Clear()
 
 	skillCastList.clear();
 	skillExecList.clear();
+
+	commandBuff.Clear();
+	localActorIDChanges.clear();
+}
+
+void Replication::Frame::SetArena(MemArena* arena)
+{
+	masterList.set_overflow_allocator(ArenaAllocator(arena));
+	npcList.set_overflow_allocator(ArenaAllocator(arena));
+	dynamicList.set_overflow_allocator(ArenaAllocator(arena));
+	masterMap.set_overflow_allocator(ArenaHashAllocator(arena));
+	npcMap.set_overflow_allocator(ArenaHashAllocator(arena));
+	dynamicMap.set_overflow_allocator(ArenaHashAllocator(arena));
+	actorType.set_overflow_allocator(ArenaHashAllocator(arena));
+	skillCastList.set_overflow_allocator(ArenaAllocator(arena));
+	skillExecList.set_overflow_allocator(ArenaAllocator(arena));
 }
 
 void Replication::PlayerLocalInfo::Reset()
@@ -35,24 +95,64 @@ void Replication::PlayerLocalInfo::Reset()
 	nextMonsterLocalActorID = LocalActorID::INVALID;
 }
 
-void Replication::Init(Server* server_)
+void Replication::Init(Server* server_, const GameXmlContent* content_, MemArena* arena)
 {
 	server = server_;
+	content = content_;
+
+	WaitEncoded(); // a recycled game can still be sending its last frame
 
 	clientHandle.fill(ClientHandle::INVALID);
 	playerState.fill({ PlayerState::DISCONNECTED, PlayerState::DISCONNECTED });
 	foreach(p, playerLocalInfo) p->Reset();
+	playerMap.clear();
 
-	framePrev = &frames[0];
-	frameCur = &frames[1];
+	laneView.playerMap.clear();
+	laneView.clientHandle.fill(ClientHandle::INVALID);
+	foreach(m, laneView.worldActorUID) m->clear();
 
-	framePrev->Clear();
-	frameCur->Clear();
+	framePrev = &frames[0];
+	frameBuild = &frames[1];
+	frameFree = &frames[2];
+	frameCur = nullptr;
+
+	for(Frame& f : frames) {
+		f.Clear();
+		f.SetArena(arena);
+		if(!f.commandBuff.data) {
+			f.commandBuff.Init(4096);
+		}
+	}
 }
 
 void Replication::FrameEnd()
 {
 	ProfileFunction();
+	MEM_TAG(MemTag::REPLICATION);
+
+	// the frame before has to be sent before its frame can be reused
+	SyncLaneView();
+
+	frameCur = frameBuild;
+	frameBuild = frameFree;
+	frameFree = nullptr;
+	frameBuild->Clear();
+
+	if(pipeline) {
+		pipeline->Submit(this);
+		return;
+	}
+
+	Encode();
+	SyncLaneView();
+}
+
+void Replication::Encode()
+{
+	ProfileFunction();
+	MEM_TAG(MemTag::REPLICATION);
+
+	ReplayCommands();
 
 	UpdatePlayersLocalState();
 
@@ -75,20 +175,143 @@ void Replication::FrameEnd()
 		state.prev = state.cur;
 	}
 
-	eastl::swap(frameCur, framePrev);
-	frameCur->Clear(); // clear frame
+	frameFree = framePrev;
+	framePrev = frameCur;
+}
+
+void Replication::WaitEncoded()
+{
+	if(encodePending.GetValue() != 0) {
+		ProfileBlock("wait");
+		while(encodePending.GetValue() != 0) {
+			EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+		}
+	}
+	EAReadBarrier();
+}
+
+bool Replication::Deferred() const
+{
+	return pipeline && !t_Encoder;
+}
+
+void Replication::PushCommand(CommandType type, const void* cmd, i32 size, i32 extraSize)
+{
+	const CommandHeader header = { type, size + extraSize };
+	frameBuild->commandBuff.Append(&header, sizeof(header));
+	frameBuild->commandBuff.Append(cmd, size);
+}
+
+void Replication::RecordPacket(ClientHandle clientHd, u16 netID, u16 packetSize, const void* packetData)
+{
+	const CmdPacket cmd = { clientHd, netID, packetSize };
+	PushCommand(CommandType::Packet, &cmd, sizeof(cmd), packetSize);
+	if(packetSize > 0) {
+		frameBuild->commandBuff.Append(packetData, packetSize);
+	}
+}
+
+void Replication::ReplayCommands()
+{
+	ConstBuffer buff(frameCur->commandBuff.data, frameCur->commandBuff.size);
+	while(buff.CanRead(sizeof(CommandHeader))) {
+		const CommandHeader& header = buff.Read<CommandHeader>();
+		ConstBuffer cmd(buff.ReadRaw(header.size), header.size);
+
+		switch(header.type) {
+			case CommandType::Packet: {
+				const CmdPacket& p = cmd.Read<CmdPacket>();
+				server->SendPacketData(p.clientHd, p.netID, p.size, cmd.ReadRaw(p.size));
+			} break;
+
+			case CommandType::PlayerConnect: {
+				const CmdPlayer& p = cmd.Read<CmdPlayer>();
+				ApplyPlayerConnect(p.clientHd, p.playerIndex);
+			} break;
+
+			case CommandType::PlayerDisconnect: {
+				const CmdPlayer& p = cmd.Read<CmdPlayer>();
+				ApplyPlayerDisconnect(p.clientHd);
+			} break;
+
+			case CommandType::PlayerReconnect: {
+				const CmdPlayer& p = cmd.Read<CmdPlayer>();
+				ApplyPlayerReconnect(p.prevClientHd, p.clientHd, p.playerIndex);
+			} break;
+
+			case CommandType::RegisterMasterActor: {
+				const CmdMaster& m = cmd.Read<CmdMaster>();
+				ApplyRegisterMasterActor(m.clientHd, m.actorUID, m.classType);
+			} break;
+
+			case CommandType::SetLeaderMaster: {
+				const CmdMaster& m = cmd.Read<CmdMaster>();
+				ApplySetLeaderMaster(m.clientHd, m.actorUID, m.classType, m.skinIndex);
+			} break;
+
+			case CommandType::PlayerInGame: {
+				const CmdPlayer& p = cmd.Read<CmdPlayer>();
+				ApplyPlayerState(p.clientHd, PlayerState::IN_GAME);
+			} break;
+
+			case CommandType::PlayerLoaded: {
+				const CmdPlayer& p = cmd.Read<CmdPlayer>();
+				ApplyPlayerState(p.clientHd, PlayerState::LOADED);
+			} break;
+
+			case CommandType::CharacterInfo: {
+				const CmdCharacterInfo& c = cmd.Read<CmdCharacterInfo>();
+				ApplyCharacterInfo(c.clientHd, c.actorUID, c.docID, c.classType, c.health, c.healthMax);
+			} break;
+
+			case CommandType::ChatToAll:
+			case CommandType::ChatToClient: {
+				const CmdChat& c = cmd.Read<CmdChat>();
+				const wchar* senderName = (const wchar*)cmd.ReadRaw((c.senderLen + 1) * sizeof(wchar));
+				const wchar* msg = (const wchar*)cmd.ReadRaw((c.msgLen + 1) * sizeof(wchar));
+				if(header.type == CommandType::ChatToAll) {
+					ApplyChatMessageToAll(senderName, c.chatType, msg, c.msgLen);
+				}
+				else {
+					ApplyChatMessageToClient(c.toClientHd, senderName, (EChatType)c.chatType, msg, c.msgLen);
+				}
+			} break;
+
+			default: {
+				ASSERT_MSG(0, "case not handled");
+			}
+		}
+	}
+}
+
+void Replication::SyncLaneView()
+{
+	WaitEncoded();
+
+	foreach_const(c, framePrev->localActorIDChanges) {
+		if(laneView.clientHandle[c->playerIndex] != c->clientHd) continue; // reconnected since, the view starts over
+
+		auto& map = laneView.worldActorUID[c->playerIndex];
+		if(c->created) {
+			map[c->localActorID] = c->actorUID;
+		}
+		else {
+			map.erase(c->localActorID);
+		}
+	}
+	framePrev->localActorIDChanges.clear();
 }
 
 void Replication::FramePushPlayer(const Player& player)
 {
-	ASSERT(frameCur->playerMap[player.index] == frameCur->playerList.end());
+	ASSERT(frameBuild->playerMap[player.index] == frameBuild->playerList.end());
 
-	frameCur->playerList.emplace_back(player);
-	frameCur->playerMap[player.index] = --frameCur->playerList.end();
+	frameBuild->playerList.emplace_back(player);
+	frameBuild->playerMap[player.index] = --frameBuild->playerList.end();
 
 #ifdef CONF_DEBUG
 	if(player.clientHd != ClientHandle::INVALID) {
-		ASSERT(playerMap.at(player.clientHd) == player.index);
+		ASSERT(laneView.playerMap.at(player.clientHd) == player.index);
 	}
 #endif
 }
@@ -96,50 +319,62 @@ void Replication::FramePushPlayer(const Player& player)
 void Replication::FramePushMasterActors(const Replication::ActorMaster* actorList, const i32 count)
 {
 	forarr(actor, actorList, count) {
-		ASSERT(frameCur->masterMap.find(actor->actorUID) == frameCur->masterMap.end());
-		ASSERT(frameCur->actorUIDSet.find(actor->actorUID) == frameCur->actorUIDSet.end());
+		ASSERT(frameBuild->masterMap.find(actor->actorUID) == frameBuild->masterMap.end());
+		ASSERT(frameBuild->actorUIDSet.find(actor->actorUID) == frameBuild->actorUIDSet.end());
 
-		frameCur->masterList.emplace_back(*actor);
-		frameCur->masterMap.emplace(actor->actorUID, --frameCur->masterList.end());
+		frameBuild->masterList.emplace_back(*actor);
+		frameBuild->masterMap.emplace(actor->actorUID, --frameBuild->masterList.end());
 
-		frameCur->actorUIDSet.insert(actor->actorUID);
-		frameCur->actorType.emplace(actor->actorUID, actor->Type());
+		frameBuild->actorUIDSet.insert(actor->actorUID);
+		frameBuild->actorType.emplace(actor->actorUID, actor->Type());
 	}
 }
 
 void Replication::FramePushNpcActor(const Replication::ActorNpc& actor)
 {
-	ASSERT(frameCur->npcMap.find(actor.actorUID) == frameCur->npcMap.end());
-	ASSERT(frameCur->actorUIDSet.find(actor.actorUID) == frameCur->actorUIDSet.end());
+	ASSERT(frameBuild->npcMap.find(actor.actorUID) == frameBuild->npcMap.end());
+	ASSERT(frameBuild->actorUIDSet.find(actor.actorUID) == frameBuild->actorUIDSet.end());
 
-	frameCur->npcList.emplace_back(actor);
-	frameCur->npcMap.emplace(actor.actorUID, --frameCur->npcList.end());
-	frameCur->actorUIDSet.insert(actor.actorUID);
-	frameCur->actorType.emplace(actor.actorUID, actor.Type());
+	frameBuild->npcList.emplace_back(actor);
+	frameBuild->npcMap.emplace(actor.actorUID, --frameBuild->npcList.end());
+	frameBuild->actorUIDSet.insert(actor.actorUID);
+	frameBuild->actorType.emplace(actor.actorUID, actor.Type());
 }
 
 void Replication::FramePushDynamicActor(const ActorDynamic& actor)
 {
-	ASSERT(frameCur->dynamicMap.find(actor.actorUID) == frameCur->dynamicMap.end());
-	ASSERT(frameCur->actorUIDSet.find(actor.actorUID) == frameCur->actorUIDSet.end());
+	ASSERT(frameBuild->dynamicMap.find(actor.actorUID) == frameBuild->dynamicMap.end());
+	ASSERT(frameBuild->actorUIDSet.find(actor.actorUID) == frameBuild->actorUIDSet.end());
 
-	frameCur->dynamicList.emplace_back(actor);
-	frameCur->dynamicMap.emplace(actor.actorUID, --frameCur->dynamicList.end());
-	frameCur->actorUIDSet.insert(actor.actorUID);
-	frameCur->actorType.emplace(actor.actorUID, actor.Type());
+	frameBuild->dynamicList.emplace_back(actor);
+	frameBuild->dynamicMap.emplace(actor.actorUID, --frameBuild->dynamicList.end());
+	frameBuild->actorUIDSet.insert(actor.actorUID);
+	frameBuild->actorType.emplace(actor.actorUID, actor.Type());
 }
 
 void Replication::FramePushSkillCast(const SkillCast& skillCast)
 {
-	frameCur->skillCastList.push_back(skillCast);
+	frameBuild->skillCastList.push_back(skillCast);
 }
 
 void Replication::FramePushSkillExec(const SkillExec& skillExec)
 {
-	frameCur->skillExecList.push_back(skillExec);
+	frameBuild->skillExecList.push_back(skillExec);
 }
 
 void Replication::OnPlayerConnect(ClientHandle clientHd, u32 playerIndex)
+{
+	LaneViewConnect(clientHd, playerIndex);
+
+	if(Deferred()) {
+		const CmdPlayer cmd = { clientHd, ClientHandle::INVALID, playerIndex };
+		PushCommand(CommandType::PlayerConnect, &cmd, sizeof(cmd));
+		return;
+	}
+	ApplyPlayerConnect(clientHd, playerIndex);
+}
+
+void Replication::ApplyPlayerConnect(ClientHandle clientHd, u32 playerIndex)
 {
 	playerMap[clientHd] = playerIndex;
 	playerState[playerIndex].cur = PlayerState::CONNECTED;
@@ -182,17 +417,41 @@ void Replication::SendLoadPvpMap(ClientHandle clientHd, MapIndex stageIndex)
 
 void Replication::SetPlayerAsInGame(ClientHandle clientHd)
 {
-	const i32 clientID = playerMap.at(clientHd);
-	playerState[clientID].cur = PlayerState::IN_GAME;
+	if(Deferred()) {
+		const CmdPlayer cmd = { clientHd, ClientHandle::INVALID, 0 };
+		PushCommand(CommandType::PlayerInGame, &cmd, sizeof(cmd));
+		return;
+	}
+	ApplyPlayerState(clientHd, PlayerState::IN_GAME);
 }
 
 void Replication::SetPlayerLoaded(ClientHandle clientHd)
+{
+	if(Deferred()) {
+		const CmdPlayer cmd = { clientHd, ClientHandle::INVALID, 0 };
+		PushCommand(CommandType::PlayerLoaded, &cmd, sizeof(cmd));
+		return;
+	}
+	ApplyPlayerState(clientHd, PlayerState::LOADED);
+}
+
+void Replication::ApplyPlayerState(ClientHandle clientHd, PlayerState state)
 {
 	const i32 clientID = playerMap.at(clientHd);
-	playerState[clientID].cur = PlayerState::LOADED;
+	playerState[clientID].cur = state;
 }
 
 void Replication::SendCharacterInfo(ClientHandle clientHd, ActorUID actorUID, CreatureIndex docID, ClassType classType, i32 health, i32 healthMax)
+{
+	if(Deferred()) {
+		const CmdCharacterInfo cmd = { clientHd, actorUID, docID, classType, health, healthMax };
+		PushCommand(CommandType::CharacterInfo, &cmd, sizeof(cmd));
+		return;
+	}
+	ApplyCharacterInfo(clientHd, actorUID, docID, classType, health, healthMax);
+}
+
+void Replication::ApplyCharacterInfo(ClientHandle clientHd, ActorUID actorUID, CreatureIndex docID, ClassType classType, i32 health, i32 healthMax)
 {
 	const i32 clientID = playerMap.at(clientHd);
 
@@ -212,6 +471,18 @@ void Replication::SendCharacterInfo(ClientHandle clientHd, ActorUID actorUID, Cr
 }
 
 void Replication::SendPlayerSetLeaderMaster(ClientHandle clientHd, ActorUID masterActorUID, ClassType classType, SkinIndex skinIndex)
+{
+	LaneViewRegisterMaster(clientHd, masterActorUID, classType);
+
+	if(Deferred()) {
+		const CmdMaster cmd = { clientHd, masterActorUID, classType, skinIndex };
+		PushCommand(CommandType::SetLeaderMaster, &cmd, sizeof(cmd));
+		return;
+	}
+	ApplySetLeaderMaster(clientHd, masterActorUID, classType, skinIndex);
+}
+
+void Replication::ApplySetLeaderMaster(ClientHandle clientHd, ActorUID masterActorUID, ClassType classType, SkinIndex skinIndex)
 {
 	LocalActorID laiLeader = (LocalActorID)((u32)LocalActorID::FIRST_SELF_MASTER + (i32)classType);
 	ASSERT(laiLeader >= LocalActorID::FIRST_SELF_MASTER && laiLeader < LocalActorID::LAST_SELF_MASTER);
@@ -238,6 +509,22 @@ void Replication::SendPlayerSetLeaderMaster(ClientHandle clientHd, ActorUID mast
 }
 
 void Replication::SendChatMessageToAll(const wchar* senderName, i32 chatType, const wchar* msg, i32 msgLen)
+{
+	if(msgLen == -1) msgLen = EA::StdC::Strlen(msg);
+
+	if(Deferred()) {
+		const CmdChat cmd = { ClientHandle::INVALID, chatType, (i32)EA::StdC::Strlen(senderName), msgLen };
+		PushCommand(CommandType::ChatToAll, &cmd, sizeof(cmd), (cmd.senderLen + cmd.msgLen + 2) * sizeof(wchar));
+		const wchar zero = 0;
+		frameBuild->commandBuff.Append(senderName, (cmd.senderLen + 1) * sizeof(wchar));
+		frameBuild->commandBuff.Append(msg, cmd.msgLen * sizeof(wchar));
+		frameBuild->commandBuff.Append(&zero, sizeof(zero));
+		return;
+	}
+	ApplyChatMessageToAll(senderName, chatType, msg, msgLen);
+}
+
+void Replication::ApplyChatMessageToAll(const wchar* senderName, i32 chatType, const wchar* msg, i32 msgLen)
 {
 	// TODO: restrict message length
 	PacketWriter<Sv::SN_ChatChannelMessage> packet;
@@ -255,12 +542,26 @@ void Replication::SendChatMessageToAll(const wchar* senderName, i32 chatType, co
 }
 
 void Replication::SendChatMessageToClient(ClientHandle toClientHd, const wchar* senderName, EChatType chatType, const wchar* msg, i32 msgLen)
+{
+	if(msgLen == -1) msgLen = EA::StdC::Strlen(msg);
+
+	if(Deferred()) {
+		const CmdChat cmd = { toClientHd, (i32)chatType, (i32)EA::StdC::Strlen(senderName), msgLen };
+		PushCommand(CommandType::ChatToClient, &cmd, sizeof(cmd), (cmd.senderLen + cmd.msgLen + 2) * sizeof(wchar));
+		const wchar zero = 0;
+		frameBuild->commandBuff.Append(senderName, (cmd.senderLen + 1) * sizeof(wchar));
+		frameBuild->commandBuff.Append(msg, cmd.msgLen * sizeof(wchar));
+		frameBuild->commandBuff.Append(&zero, sizeof(zero));
+		return;
+	}
+	ApplyChatMessageToClient(toClientHd, senderName, chatType, msg, msgLen);
+}
+
+void Replication::ApplyChatMessageToClient(ClientHandle toClientHd, const wchar* senderName, EChatType chatType, const wchar* msg, i32 msgLen)
 {
 	const i32 toClientID = playerMap.at(toClientHd);
 	if(playerState[toClientID].cur < PlayerState::IN_GAME) return;
 
-	if(msgLen == -1) msgLen = EA::StdC::Strlen(msg);
-
 	PacketWriter<Sv::SN_ChatChannelMessage> packet;
 
 	packet.Write<EChatType>(chatType); // chatType
@@ -324,7 +625,7 @@ void Replication::SendAccountDataPvp(ClientHandle clientHd)
 	// SN_AccountEquipmentList
 	// SN_GameFieldReady
 
-	const GameXmlContent& content = GetGameXmlContent();
+	const GameXmlContent& content = *this->content;
 
 	const u32 playerIndex = playerMap.at(clientHd);
 	const Player* player = frameCur->FindPlayer(playerIndex);
@@ -661,14 +962,14 @@ void Replication::SendPvpLoadingComplete(ClientHandle clientHd)
 				packet.Write<LocalActorID>(GetLocalActorID(clientHd, main->actorUID)); // characterID
 				packet.Write<CreatureIndex>(CreatureIndex(100000000 + (i32)main->classType)); // docID
 				packet.Write<ClassType>(main->classType); // classType
-				packet.Write<i32>(2400); // hp
-				packet.Write<i32>(2400); // maxHp
+				packet.Write<i32>(main->health); // hp
+				packet.Write<i32>(main->healthMax); // maxHp
 				// subPC
 				packet.Write<LocalActorID>(GetLocalActorID(clientHd, sub->actorUID)); // characterID
 				packet.Write<CreatureIndex>(CreatureIndex(100000000 + (i32)sub->classType)); // docID
 				packet.Write<ClassType>(sub->classType); // classType
-				packet.Write<i32>(2400); // hp
-				packet.Write<i32>(2400); // maxHp
+				packet.Write<i32>(sub->health); // hp
+				packet.Write<i32>(sub->healthMax); // maxHp
 
 				packet.Write<i32>(0); // remainTagCooltimeMS
 				packet.Write<u8>(0); // canCastSkillSlotUG
@@ -870,13 +1171,56 @@ void Replication::SendPlayerJump(ClientHandle clientHd, ActorUID mainActorUID, f
 }
 
 void Replication::OnPlayerDisconnect(ClientHandle clientHd)
+{
+	laneView.clientHandle[laneView.playerMap.at(clientHd)] = ClientHandle::INVALID;
+
+	if(Deferred()) {
+		const CmdPlayer cmd = { clientHd, ClientHandle::INVALID, 0 };
+		PushCommand(CommandType::PlayerDisconnect, &cmd, sizeof(cmd));
+		return;
+	}
+	ApplyPlayerDisconnect(clientHd);
+}
+
+void Replication::ApplyPlayerDisconnect(ClientHandle clientHd)
 {
 	const i32 clientID = playerMap.at(clientHd);
 	playerState[clientID].cur = PlayerState::DISCONNECTED;
 	clientHandle[clientID] = ClientHandle::INVALID;
 }
 
+void Replication::OnPlayerReconnect(ClientHandle prevClientHd, ClientHandle clientHd, u32 playerIndex)
+{
+	laneView.playerMap.erase(prevClientHd);
+	LaneViewConnect(clientHd, playerIndex);
+
+	if(Deferred()) {
+		const CmdPlayer cmd = { clientHd, prevClientHd, playerIndex };
+		PushCommand(CommandType::PlayerReconnect, &cmd, sizeof(cmd));
+		return;
+	}
+	ApplyPlayerReconnect(prevClientHd, clientHd, playerIndex);
+}
+
+void Replication::ApplyPlayerReconnect(ClientHandle prevClientHd, ClientHandle clientHd, u32 playerIndex)
+{
+	playerMap.erase(prevClientHd);
+	ApplyPlayerConnect(clientHd, playerIndex);
+}
+
 void Replication::PlayerRegisterMasterActor(ClientHandle clientHd, ActorUID masterActorUID, ClassType classType)
+{
+	LaneViewRegisterMaster(clientHd, masterActorUID, classType);
+
+	if(Deferred()) {
+		const CmdMaster cmd = { clientHd, masterActorUID, classType, SkinIndex::DEFAULT };
+		PushCommand(CommandType::RegisterMasterActor, &cmd, sizeof(cmd));
+		return;
+	}
+	ApplyRegisterMasterActor(clientHd, masterActorUID, classType);
+}
+
+void Replication::ApplyRegisterMasterActor(ClientHandle clientHd, ActorUID masterActorUID, ClassType classType)
 {
 	LocalActorID laiLeader = (LocalActorID)((u32)LocalActorID::FIRST_SELF_MASTER + (i32)classType);
 	ASSERT(laiLeader >= LocalActorID::FIRST_SELF_MASTER && laiLeader < LocalActorID::LAST_SELF_MASTER);
@@ -885,6 +1229,19 @@ void Replication::PlayerRegisterMasterActor(ClientHandle clientHd, ActorUID mast
 	PlayerForceLocalActorID(clientID, masterActorUID, laiLeader);
 }
 
+void Replication::LaneViewConnect(ClientHandle clientHd, u32 playerIndex)
+{
+	laneView.playerMap[clientHd] = playerIndex;
+	laneView.clientHandle[playerIndex] = clientHd;
+	laneView.worldActorUID[playerIndex].clear();
+}
+
+void Replication::LaneViewRegisterMaster(ClientHandle clientHd, ActorUID masterActorUID, ClassType classType)
+{
+	const LocalActorID laiLeader = (LocalActorID)((u32)LocalActorID::FIRST_SELF_MASTER + (i32)classType);
+	laneView.worldActorUID[laneView.playerMap.at(clientHd)][laiLeader] = masterActorUID;
+}
+
 void Replication::PlayerForceLocalActorID(i32 clientID, ActorUID actorUID, LocalActorID localActorID)
 {
 	DBG_ASSERT(actorUID != ActorUID::INVALID);
@@ -907,17 +1264,12 @@ LocalActorID Replication::GetLocalActorID(ClientHandle clientHd, ActorUID actorU
 
 ActorUID Replication::GetWorldActorUID(ClientHandle clientHd, LocalActorID localActorID) const
 {
-	ProfileFunction();
-
-	// TODO: second map, for this reverse lookup
-	const i32 clientID = playerMap.at(clientHd);
-	const auto& map = playerLocalInfo[clientID].localActorIDMap;
-	foreach(it, map) {
-		if(it->second == localActorID) {
-			return it->first;
-		}
+	const i32 clientID = laneView.playerMap.at(clientHd);
+	const auto& map = laneView.worldActorUID[clientID];
+	auto found = map.find(localActorID);
+	if(found != map.end()) {
+		return found->second;
 	}
-
 	return ActorUID::INVALID;
 }
 
@@ -1158,12 +1510,30 @@ void Replication::FrameDifference()
 	// find if the position has changed since last frame
 	foreach_const(it, frameCur->masterList) {
 		const ActorMaster& cur = *it;
-		if(cur.taggedOut) continue;
 
 		auto found = framePrev->masterMap.find(cur.actorUID);
 		if(found == framePrev->masterMap.end()) continue; // previous not found, can't diff
 		const ActorMaster& prev = *found->second;
 
+		// health, tagged out masters included (respawn) and self too
+		if(cur.health != prev.health || cur.healthMax != prev.healthMax) {
+			Sv::SN_UpdateStat stat;
+			stat.statType = 0; // hp
+			stat.cur = (f32)cur.health;
+			stat.max = (f32)cur.healthMax;
+			stat.reasonCode = 0;
+
+			for(int pi = 0; pi < MAX_PLAYERS; pi++) {
+				if(playerState[pi].cur < PlayerState::IN_GAME) continue;
+				const ClientHandle clientHd = clientHandle[pi];
+
+				stat.characterID = GetLocalActorID(clientHd, cur.actorUID);
+				SendPacket(clientHd, stat);
+			}
+		}
+
+		if(cur.taggedOut) continue;
+
 		bool rotationUpdated = false;
 		bool positionUpdated = false;
 
@@ -1198,7 +1568,7 @@ void Replication::FrameDifference()
 				const ClientHandle clientHd = clientHandle[pi];
 				if(clientHd == cur.clientHd) continue; // ignore self
 				sync.characterID = GetLocalActorID(clientHd, cur.actorUID);
-				SendPacket(clientHd, sync);
+				SendStatePacket(clientHd, sync, sync.characterID);
 			}
 
 			rotationUpdated = true;
@@ -1221,7 +1591,7 @@ void Replication::FrameDifference()
 				if(clientHd == cur.clientHd) continue; // ignore self
 
 				sync.characterID = GetLocalActorID(clientHd, cur.actorUID);
-				SendPacket(clientHd, sync);
+				SendStatePacket(clientHd, sync, sync.characterID);
 			}
 		}
 	}
@@ -1852,7 +2222,7 @@ void Replication::SendMasterSkillSlots(ClientHandle clientHd, const Replication:
 	const LocalActorID localActorID = GetLocalActorID(clientHd, actor.actorUID);
 	ASSERT(localActorID != LocalActorID::INVALID);
 
-	const GameXmlContent& content = GetGameXmlContent();
+	const GameXmlContent& content = *this->content;
 
 	// SN_PlayerSkillSlot
 	{
@@ -1952,6 +2322,7 @@ void Replication::CreateLocalActorID(i32 clientID, ActorUID actorUID)
 	PlayerLocalInfo& localInfo = playerLocalInfo[clientID];
 	auto& localActorIDMap = localInfo.localActorIDMap;
 	localActorIDMap.emplace(actorUID, localInfo.nextPlayerLocalActorID);
+	frameCur->localActorIDChanges.push_back({ (u32)clientID, clientHandle[clientID], actorUID, localInfo.nextPlayerLocalActorID, true });
 	localInfo.nextPlayerLocalActorID = (LocalActorID)((u32)localInfo.nextPlayerLocalActorID + 1);
 	// TODO: find first free LocalActorID
 
@@ -1961,7 +2332,9 @@ void Replication::CreateLocalActorID(i32 clientID, ActorUID actorUID)
 void Replication::DeleteLocalActorID(i32 clientID, ActorUID actorUID)
 {
 	auto& localActorIDMap = playerLocalInfo[clientID].localActorIDMap;
-	localActorIDMap.erase(localActorIDMap.find(actorUID));
+	auto found = localActorIDMap.find(actorUID);
+	frameCur->localActorIDChanges.push_back({ (u32)clientID, clientHandle[clientID], actorUID, found->second, false });
+	localActorIDMap.erase(found);
 }
 
 void Replication::GetPlayersInGame(ClientList* list)
@@ -1972,3 +2345,82 @@ void Replication::GetPlayersInGame(ClientList* list)
 		list->push_back(clientHd);
 	}
 }
+
+intptr_t ThreadReplicationPipeline(void* pData)
+{
+	ReplicationPipeline& pipeline = *(ReplicationPipeline*)pData;
+	ProfileSetThreadName(FMT("Replication_%d", pipeline.laneIndex));
+	t_Encoder = true;
+
+	while(pipeline.running) {
+		ReplicationPipeline::Job job;
+		if(pipeline.jobQueue.TryPop(&job)) {
+			pipeline.Run(job);
+			continue;
+		}
+
+		pipeline.semaphore.Wait();
+	}
+
+	return 0;
+}
+
+bool ReplicationPipeline::Init(i32 laneIndex_, MetricHistogram* inputToFrameMs_)
+{
+	laneIndex = laneIndex_;
+	inputToFrameMs = inputToFrameMs_;
+	jobQueue.Init(256);
+	pendingCount.SetValue(0);
+	running = true;
+	thread.Begin(ThreadReplicationPipeline, this);
+	return true;
+}
+
+void ReplicationPipeline::Cleanup()
+{
+	if(!running) return;
+
+	Sync();
+	running = false;
+	semaphore.Post(1);
+	thread.WaitForEnd();
+}
+
+void ReplicationPipeline::Submit(Replication* replication)
+{
+	replication->encodePending.SetValue(1);
+	pendingCount.Increment();
+	jobQueue.Push(Job{ replication, Time::ZERO });
+	semaphore.Post(1);
+}
+
+void ReplicationPipeline::SubmitTickEnd(Time inputRecvTime)
+{
+	pendingCount.Increment();
+	jobQueue.Push(Job{ nullptr, inputRecvTime });
+	semaphore.Post(1);
+}
+
+void ReplicationPipeline::Sync()
+{
+	ProfileFunction();
+
+	while(pendingCount.GetValue() > 0) {
+		EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+	}
+}
+
+void ReplicationPipeline::Run(const Job& job)
+{
+	if(job.replication) {
+		job.replication->Encode();
+		EAWriteBarrier();
+		job.replication->encodePending.SetValue(0); // the lane can hand it the next frame
+	}
+	else {
+		// jobs run in order: every frame of that tick is sent
+		inputToFrameMs->Observe(TimeDurationSinceMs(job.inputRecvTime));
+	}
+
+	pendingCount.Decrement();
+}
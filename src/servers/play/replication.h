@@ -4,14 +4,21 @@
 #include <common/utils.h>
 #include <common/protocol.h>
 #include <common/packet_serialize.h>
+#include <common/mpsc_queue.h>
 #include <EASTL/array.h>
 #include <EASTL/fixed_vector.h>
 #include <EASTL/fixed_set.h>
 #include <EASTL/fixed_map.h>
 #include <EASTL/fixed_list.h>
+#include <EASTL/fixed_hash_map.h>
 #include <mxm/core.h>
+#include <eathread/eathread_thread.h>
+#include <eathread/eathread_semaphore.h>
 
 struct AccountData;
+struct GameXmlContent;
+struct MetricHistogram;
+struct ReplicationPipeline;
 
 struct Replication
 {
@@ -75,6 +82,9 @@ struct Replication
 		i32 actionParam1;
 		i32 actionParam2;
 
+		i32 health;
+		i32 healthMax;
+
 		u8 taggedOut = false;
 	};
 
@@ -129,24 +139,38 @@ struct Replication
 		f32 moveDuration;
 	};
 
+	// made by the encoder, the lane applies them to its view once the frame is sent
+	struct LocalActorIDChange
+	{
+		u32 playerIndex;
+		ClientHandle clientHd;
+		ActorUID actorUID;
+		LocalActorID localActorID;
+		bool created;
+	};
+
 	struct Frame
 	{
 		eastl::fixed_list<Player,10,false> playerList;
-		eastl::fixed_list<ActorMaster,32,true> masterList;
-		eastl::fixed_list<ActorNpc,32,true> npcList;
-		eastl::fixed_list<ActorDynamic,32,true> dynamicList;
+		eastl::fixed_list<ActorMaster,32,true,ArenaAllocator> masterList;
+		eastl::fixed_list<ActorNpc,32,true,ArenaAllocator> npcList;
+		eastl::fixed_list<ActorDynamic,32,true,ArenaAllocator> dynamicList;
 
 		eastl::array<decltype(playerList)::iterator,10> playerMap;
-		hash_map<ActorUID,decltype(masterList)::iterator,128,true> masterMap;
-		hash_map<ActorUID,decltype(npcList)::iterator,128,true> npcMap;
-		hash_map<ActorUID,decltype(dynamicList)::iterator,128,true> dynamicMap;
+		arena_hash_map<ActorUID,decltype(masterList)::iterator,128> masterMap;
+		arena_hash_map<ActorUID,decltype(npcList)::iterator,128> npcMap;
+		arena_hash_map<ActorUID,decltype(dynamicList)::iterator,128> dynamicMap;
 
 		eastl::fixed_set<ActorUID,2048> actorUIDSet;
-		hash_map<ActorUID,ActorType,2048,true> actorType;
+		arena_hash_map<ActorUID,ActorType,2048> actorType;
 
-		eastl::fixed_vector<SkillCast,40,true> skillCastList;
-		eastl::fixed_vector<SkillExec,40,true> skillExecList;
+		eastl::fixed_vector<SkillCast,40,true,ArenaAllocator> skillCastList;
+		eastl::fixed_vector<SkillExec,40,true,ArenaAllocator> skillExecList;
 
+		GrowableBuffer commandBuff; // lane calls made while the frame before was encoded, replayed before the frame
+		eastl::fixed_vector<LocalActorIDChange,64,true> localActorIDChanges; // heap overflow, the encoder can't use the game arena
+
+		void SetArena(MemArena* arena); // while empty
 		void Clear();
 
 		inline Player* FindPlayer(u32 playerIndex)
@@ -190,10 +214,21 @@ struct Replication
 	};
 
 	Server* server;
-	Frame frames[2];
+	const GameXmlContent* content; // generation of the game
+	ReplicationPipeline* pipeline = nullptr; // set by the lane, FrameEnd encodes inline when null
+
+	// The lane fills frameBuild during its tick, FrameEnd hands it to the encoder as frameCur.
+	// framePrev is the last frame encoded (what frameCur is diffed against) and frameFree the next frameBuild.
+	// With a pipeline, frameCur is encoded and sent while the lane simulates the next tick.
+	Frame frames[3];
+	Frame* frameBuild;
 	Frame* frameCur;
 	Frame* framePrev;
+	Frame* frameFree;
+	EA::Thread::AtomicInt32 encodePending = 0; // frameCur is queued on the pipeline
 
+	// Encoder state, what the clients were sent so far.
+	// Thread: Encoder (the pipeline, or the lane inside FrameEnd)
 	// TODO: we propably do not need to store every possible client data here
 	// Use a fixed_vector?
 
@@ -209,7 +244,20 @@ struct Replication
 
 	hash_map<ClientHandle, i32, MAX_PLAYERS> playerMap;
 
-	void Init(Server* server_);
+	// What the packet handlers resolve local actor IDs with, while the encoder owns the maps above.
+	// Connections and self masters are applied at once, the encoder local IDs once their frame is sent.
+	// Thread: Lane
+	struct LaneView
+	{
+		hash_map<ClientHandle, i32, MAX_PLAYERS> playerMap;
+		eastl::array<ClientHandle,MAX_PLAYERS> clientHandle;
+		eastl::array<eastl::fixed_hash_map<LocalActorID,ActorUID,256,257,true>,MAX_PLAYERS> worldActorUID;
+	};
+
+	LaneView laneView;
+
+	// Thread: Lane
+	void Init(Server* server_, const GameXmlContent* content_, MemArena* arena);
 
 	void FrameEnd();
 	void FramePushPlayer(const Player& player);
@@ -235,23 +283,77 @@ struct Replication
 	void SendChatWhisperConfirmToClient(ClientHandle senderClientHd, const wchar* destNick, const wchar* msg);
 	void SendChatWhisperToClient(ClientHandle destClientHd, const wchar* destNick, const wchar* msg);
 
-	void SendAccountDataPvp(ClientHandle clientHd);
-
-	void SendPvpLoadingComplete(ClientHandle clientHd);
 	void SendGameReady(ClientHandle clientHd, i32 waitTime, i32 elapsed);
 	void SendPreGameLevelEvents(ClientHandle clientHd);
 	void SendGameStart(ClientHandle clientHd);
-	void SendPlayerTag(ClientHandle clientHd, ActorUID mainActorUID, ActorUID subActorUID);
-	void SendPlayerJump(ClientHandle clientHd, ActorUID mainActorUID, f32 rotate, f32 moveDirX, f32 moveDirY);
 
 	void OnPlayerDisconnect(ClientHandle clientHd);
+	void OnPlayerReconnect(ClientHandle prevClientHd, ClientHandle clientHd, u32 playerIndex);
 
 	void PlayerRegisterMasterActor(ClientHandle clientHd, ActorUID masterActorUID, ClassType classType); // TODO: temp, find a better solution
 
-	LocalActorID GetLocalActorID(ClientHandle clientHd, ActorUID actorUID) const; // Can return INVALID
 	ActorUID GetWorldActorUID(ClientHandle clientHd, LocalActorID localActorID) const; // Can return INVALID
 
+	// waits for the frame in flight then applies its local IDs to the lane view, FrameEnd starts with it
+	void SyncLaneView();
+
+	// Thread: Any
+	// returns once frameCur is sent, the game can be reset or deleted after that
+	void WaitEncoded();
+
 private:
+	friend struct ReplicationPipeline;
+
+	// lane calls recorded in frameBuild while a pipeline encodes the frame before
+	enum class CommandType: u8
+	{
+		Packet,
+		PlayerConnect,
+		PlayerDisconnect,
+		PlayerReconnect,
+		RegisterMasterActor,
+		SetLeaderMaster,
+		PlayerInGame,
+		PlayerLoaded,
+		CharacterInfo,
+		ChatToAll,
+		ChatToClient,
+	};
+
+	struct CommandHeader
+	{
+		CommandType type;
+		i32 size;
+	};
+
+	bool Deferred() const; // a lane call has to be recorded
+	void PushCommand(CommandType type, const void* cmd, i32 size, i32 extraSize = 0); // extraSize: appended by the caller right after
+	void RecordPacket(ClientHandle clientHd, u16 netID, u16 packetSize, const void* packetData);
+	void ReplayCommands();
+
+	// Thread: Encoder
+	void Encode();
+	void ApplyPlayerConnect(ClientHandle clientHd, u32 playerIndex);
+	void ApplyPlayerDisconnect(ClientHandle clientHd);
+	void ApplyPlayerReconnect(ClientHandle prevClientHd, ClientHandle clientHd, u32 playerIndex);
+	void ApplyRegisterMasterActor(ClientHandle clientHd, ActorUID masterActorUID, ClassType classType);
+	void ApplySetLeaderMaster(ClientHandle clientHd, ActorUID masterActorUID, ClassType classType, SkinIndex skinIndex);
+	void ApplyPlayerState(ClientHandle clientHd, PlayerState state);
+	void ApplyCharacterInfo(ClientHandle clientHd, ActorUID actorUID, CreatureIndex docID, ClassType classType, i32 health, i32 healthMax);
+	void ApplyChatMessageToAll(const wchar* senderName, i32 chatType, const wchar* msg, i32 msgLen);
+	void ApplyChatMessageToClient(ClientHandle toClientHd, const wchar* senderName, EChatType chatType, const wchar* msg, i32 msgLen);
+
+	// Thread: Lane
+	void LaneViewConnect(ClientHandle clientHd, u32 playerIndex);
+	void LaneViewRegisterMaster(ClientHandle clientHd, ActorUID masterActorUID, ClassType classType);
+
+	void SendAccountDataPvp(ClientHandle clientHd);
+	void SendPvpLoadingComplete(ClientHandle clientHd);
+	void SendPlayerTag(ClientHandle clientHd, ActorUID mainActorUID, ActorUID subActorUID);
+	void SendPlayerJump(ClientHandle clientHd, ActorUID mainActorUID, f32 rotate, f32 moveDirX, f32 moveDirY);
+
+	LocalActorID GetLocalActorID(ClientHandle clientHd, ActorUID actorUID) const; // Can return INVALID
+
 	void UpdatePlayersLocalState();
 	void FrameDifference();
 
@@ -284,9 +386,59 @@ private:
 	inline void SendPacketData(ClientHandle clientHd, u16 packetSize, const void* packetData)
 	{
 		NT_LOG("[client%x] Replication :: %s", clientHd, PacketSerialize<Packet>(packetData, packetSize));
+		if(Deferred()) {
+			RecordPacket(clientHd, Packet::NET_ID, packetSize, packetData);
+			return;
+		}
 		server->SendPacketData(clientHd, Packet::NET_ID, packetSize, packetData);
 	}
 
+	// latest state of an actor, can replace a queued one when the client is falling behind
+	template<typename Packet>
+	inline void SendStatePacket(ClientHandle clientHd, const Packet& packet, LocalActorID localActorID)
+	{
+		NT_LOG("[client%x] Replication :: %s", clientHd, PacketSerialize<Packet>(&packet, sizeof(packet)));
+		server->SendStatePacket(clientHd, packet, (u32)localActorID);
+	}
+
 	typedef eastl::fixed_vector<ClientHandle,MAX_PLAYERS,false> ClientList;
 	void GetPlayersInGame(ClientList* list);
 };
+
+// Encodes and sends the frames of a lane on its own thread, while the lane simulates the next tick.
+// A frame is sent one tick later at most: the lane waits on a replication (WaitEncoded) before handing it the next frame.
+struct ReplicationPipeline
+{
+	struct Job
+	{
+		Replication* replication; // null: end of a lane tick
+		Time inputRecvTime;
+	};
+
+	MPSCQueue<Job> jobQueue;
+	EA::Thread::AtomicInt32 pendingCount = 0;
+	EA::Thread::Semaphore semaphore;
+	EA::Thread::Thread thread;
+	MetricHistogram* inputToFrameMs = nullptr;
+	bool running = false;
+	i32 laneIndex = -1;
+
+	// Thread: Lane
+	bool Init(i32 laneIndex_, MetricHistogram* inputToFrameMs_);
+	void Cleanup();
+
+	inline bool IsEnabled() const { return running; }
+
+	// Thread: Lane (or a scheduler worker ticking one of the lane instances)
+	void Submit(Replication* replication);
+
+	// Thread: Lane
+	// inputToFrameMs is observed once every frame submitted before is sent
+	void SubmitTickEnd(Time inputRecvTime);
+
+	// Thread: Lane
+	// returns when every submitted frame has been sent
+	void Sync();
+
+	void Run(const Job& job);
+};
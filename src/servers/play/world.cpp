@@ -1,13 +1,31 @@
 #include "world.h"
 #include <mxm/game_content.h>
 
-void World::Init(Replication* replication_)
+void World::Init(Replication* replication_, const GameXmlContent* content_, MapIndex mapIndex, MemArena* arena)
 {
 	replication = replication_;
+	content = content_;
 	nextActorUID = 1;
 
+	actorMasterList.set_overflow_allocator(ArenaAllocator(arena));
+	actorNpcList.set_overflow_allocator(ArenaAllocator(arena));
+	actorDynamicList.set_overflow_allocator(ArenaAllocator(arena));
+	actorMasterMap.set_overflow_allocator(ArenaAllocator(arena));
+	actorNpcMap.set_overflow_allocator(ArenaAllocator(arena));
+	actorDynamicMap.set_overflow_allocator(ArenaAllocator(arena));
+
 	auto& ctx = PhysContext();
 	ctx.CreateScene(&physics);
+
+	remotes.Clear();
+	remotes.content = content;
+
+	// bots move straight to their destination without one
+	const NavMesh* navMesh = content->FindNavMesh(mapIndex);
+	if(!navMesh) {
+		WARN("Map %d has no navmesh", (i32)mapIndex);
+	}
+	nav.Init(navMesh, arena);
 }
 
 void World::Cleanup()
@@ -22,6 +40,7 @@ void World::Update(Time localTime_)
 	const f64 tdelta = TimeDurationSec(localTime, localTime_);
 	localTime = localTime_;
 	physics.localTime = localTime;
+	nav.NewTick();
 
 	vec3 prevPos = players.front().body->GetWorldPos();
 
@@ -31,12 +50,32 @@ void World::Update(Time localTime_)
 
 		PhysicsDynamicBody& body = *p.body;
 
+		// dead players don't act until they respawn
+		if(p.IsDead()) {
+			if(localTime < p.respawnTime) {
+				p.input.tag = 0;
+				p.input.jump = 0;
+				p.input.cast.skillID = SkillID::INVALID;
+				p.input.moveTo = body.GetWorldPos();
+				p.movement.moveDir = vec2(0);
+				p.movement.moveSpeed = 0;
+				p.movement.hasJumped = false;
+				body.vel.x = 0;
+				body.vel.y = 0;
+				continue;
+			}
+
+			RespawnPlayer(p);
+		}
+
 		p.movement.rot = p.input.rot;
 
 		// tag
 		if(p.input.tag) {
 			p.input.tag = 0;
-			p.mainCharaID ^= 1;
+			if(!p.Sub().IsDead()) {
+				p.mainCharaID ^= 1;
+			}
 		}
 
 		// cast skills
@@ -83,19 +122,17 @@ void World::Update(Time localTime_)
 		body.vel.y = p.movement.moveDir.y * s;
 	}
 
+	// scene queries issued while handling input (skill moves)
+	physics.ResolveQueries();
+	FlushPendingSkillExecs();
+
 	// execute skill programs
-	for(auto it = skillProgramList.begin(); it != skillProgramList.end(); ) {
-		if(it->IsDoneExecuting()) {
-			it = skillProgramList.erase_unsorted(it);
-		}
-		else {
-			ExecuteSkillProgram(*it);
-			++it;
-		}
-	}
+	ExecuteSkillPrograms();
 
 	physics.Step();
 
+	UpdateRemotes(tdelta);
+
 	/*
 	static f64 accumulatedDiff = 0.0;
 	if(players.front().movement.moveDir == vec2(0)) {
@@ -162,6 +199,8 @@ void World::Replicate()
 			rch.actionParam1 = chara.actionParam1;
 			rch.actionParam2 = chara.actionParam2;
 
+			rch.health = chara.health;
+			rch.healthMax = chara.healthMax;
 			rch.taggedOut = false;
 		}
 
@@ -184,6 +223,8 @@ void World::Replicate()
 			rch.actionParam1 = chara.actionParam1;
 			rch.actionParam2 = chara.actionParam2;
 
+			rch.health = chara.health;
+			rch.healthMax = chara.healthMax;
 			rch.taggedOut = true;
 		}
 	}
@@ -238,6 +279,7 @@ World::Player& World::CreatePlayer(const PlayerDescription& desc, const vec3& po
 	player.level = 1;
 	player.experience = 0;
 	player.body = physics.CreateDynamicBody(110, 70, pos); // radius 100 is found in files but 110 (_AILength) matches better
+	player.spawnPos = pos;
 
 	// clear input
 	player.input.moveTo = pos;
@@ -268,10 +310,14 @@ World::Player& World::CreatePlayer(const PlayerDescription& desc, const vec3& po
 	main.parent = &player;
 	main.classType = player.mainClass;
 	main.skinIndex = player.mainSkin;
+	main.health = MASTER_BASE_HEALTH;
+	main.healthMax = MASTER_BASE_HEALTH;
 
 	sub.parent = &player;
 	sub.classType = player.subClass;
 	sub.skinIndex = player.subSkin;
+	sub.health = MASTER_BASE_HEALTH;
+	sub.healthMax = MASTER_BASE_HEALTH;
 	return player;
 }
 
@@ -348,8 +394,8 @@ void World::PlayerCastSkill(Player& player, SkillID skillID, const vec3& castPos
 	// TODO: check if can cast
 
 	// access method is kinda convoluted
-	const auto& content = GetGameXmlContent();
-	const auto& skill = content.skillMap.at(skillID);
+	const auto& content = *this->content;
+	const auto& skill = content.GetSkill(skillID);
 	const ActionStateID actionState = skill.action;
 
 	const f32 angle = player.input.rot.upperYaw;
@@ -381,41 +427,28 @@ void World::PlayerCastSkill(Player& player, SkillID skillID, const vec3& castPos
 	// Trigger new skill execution
 	player.Main().actionState = actionState;
 
+	const GameXmlContent::CompiledActionIdx actionIdx = content.FindCompiledAction(player.Main().classType, actionState);
+	ASSERT(actionIdx != GameXmlContent::CompiledActionIdx::INVALID);
+	const GameXmlContent::CompiledAction& action = content.GetCompiledAction(actionIdx);
+
 	SkillProgram prog;
 	prog.skillID = skillID;
 	prog.actionID = actionState;
+	prog.actionIdx = actionIdx;
 	prog.castPos = castPos;
 	prog.castAngle = angle;
 	prog.casterUID = player.Main().UID;
 	eastl::copy(targets.begin(), targets.end(), eastl::back_inserter(prog.targetList));
 	prog.startTime = localTime;
 	prog.commandID = 0;
-	skillProgramList.push_back(prog);
-
-	// go through the skill program to find out how much the master moves
-	f32 distance = 0;
-	f32 moveDuration = 0;
-
-	const auto& action = content.GetSkillAction(player.Main().classType, actionState);
-
-	foreach_const(cmd, action.commands) {
-		switch(cmd->type) {
-			case ActionCommand::Type::GRAPH_MOVE_HORZ: {
-				distance = cmd->graphMoveHorz.distance;
-				moveDuration = action.seqLength;
-			} break;
-
-			case ActionCommand::Type::MOVE: {
-				switch(cmd->move.preset) {
-					case ActionCommand::MovePreset::WARP: {
-						distance = (f32)cmd->move.param2;
-						moveDuration = 0.01f; // warping
-					} break;
-				}
-			} break;
-		}
+	if(action.opCount > 0) {
+		skillProgramList.push_back(prog);
 	}
 
+	// how much the master moves is precomputed when compiling the action
+	const f32 distance = action.moveDistance;
+	const f32 moveDuration = action.moveDuration;
+
 	Replication::SkillExec rpExec;
 	rpExec.casterUID = player.Main().UID;
 	rpExec.skillID = skillID;
@@ -429,86 +462,215 @@ void World::PlayerCastSkill(Player& player, SkillID skillID, const vec3& castPos
 	rpExec.rot = { angle, 0, angle };
 	rpExec.speed = player.input.speed; // FIXME: should not come from input
 
-	if(distance != 0) {
-		const vec3 endPos = physics.FindMovePos(player.body, vec3(dir * distance, 0), moveDuration);
-		rpExec.endPos = endPos;
+	if(distance == 0) {
+		rpExec.endPos = rpExec.startPos;
+		replication->FramePushSkillExec(rpExec);
+		return;
+	}
+
+	PhysicsScene::QueryID moveQuery = PhysicsScene::QueryID::INVALID;
+	if(!pendingSkillExecList.full()) {
+		moveQuery = physics.QuerySweep(player.body, vec3(dir * distance, 0));
+	}
+
+	// can't defer it, pay for the sweep now
+	if(moveQuery == PhysicsScene::QueryID::INVALID) {
+		rpExec.endPos = physics.SweepNow(player.body, vec3(dir * distance, 0));
+		replication->FramePushSkillExec(rpExec);
+		return;
 	}
 
-	replication->FramePushSkillExec(rpExec);
+	// endPos is known once the queries are resolved
+	PendingSkillExec& pending = pendingSkillExecList.push_back();
+	pending.rpExec = rpExec;
+	pending.moveQuery = moveQuery;
 }
 
-void World::ExecuteSkillProgram(SkillProgram& prog)
+void World::FlushPendingSkillExecs()
 {
-	// TODO: each skill is executed following a list of commands from ActionBase.xml
-	// process them at runtime for now
-	// but since they never change, produce logic code from ActionBase.xml
+	foreach(it, pendingSkillExecList) {
+		it->rpExec.endPos = physics.GetQueryResult(it->moveQuery).pos;
+		replication->FramePushSkillExec(it->rpExec);
+	}
+	pendingSkillExecList.clear();
+}
 
-	ActorMaster* caster = FindMasterActor(prog.casterUID);
+void World::ExecuteSkillPrograms()
+{
+	ProfileFunction();
 
-	const vec2 dir = vec2(cosf(prog.castAngle), sinf(prog.castAngle));
+	// Each skill is executed following a list of commands from ActionBase.xml
+	// They are compiled to SkillOps when loading content, here we just step every running program in one pass
+	// and apply the resulting moves afterwards
 
-	// access method is kinda convoluted
-	const auto& content = GetGameXmlContent();
-	const auto& action = content.GetSkillAction(caster->classType, prog.actionID);
+	const auto& content = *this->content;
 
-	if(TimeDiffSec(TimeDiff(prog.startTime, localTime)) > action.commands[prog.commandID].relativeEndTimeFromStart) {
-		prog.commandID++;
+	struct MoveOrder
+	{
+		u32 playerIndex;
+		vec3 disp;
+		f32 duration;
+	};
 
-		// program is done
-		if(prog.commandID >= action.commands.size()) {
+	eastl::fixed_vector<MoveOrder,decltype(skillProgramList)::kMaxSize,false> moveOrders;
+
+	for(auto it = skillProgramList.begin(); it != skillProgramList.end(); ) {
+		if(it->IsDoneExecuting()) {
+			it = skillProgramList.erase_unsorted(it);
+			continue;
+		}
+
+		SkillProgram& prog = *it;
+		++it;
+
+		const ActorMaster* casterMaster = FindMasterActor(prog.casterUID);
+		if(!casterMaster) {
 			prog.Finish();
-			return;
+			continue;
 		}
-	}
-	else {
-		// we have not changed command / instruction, nothing to be done
-		return;
-	}
+		Player& caster = *casterMaster->parent;
+
+		const GameXmlContent::CompiledAction& action = content.GetCompiledAction(prog.actionIdx);
+		const GameXmlContent::SkillOp* ops = content.GetSkillOps(action);
 
-	bool running = true;
-	while(running) {
-		running = false;
-		const auto& cmd = action.commands[prog.commandID];
-
-		f32 distance = 0;
-		f32 moveDuration = 0;
-
-		switch(cmd.type) {
-			case ActionCommand::Type::STATE_BLOCK: {
-				// lock WASD input type movement during skill execution
-				caster->parent->body->lockedMoveUntil = TimeAddSec(localTime, cmd.delay);
-			} break
-				;
-			case ActionCommand::Type::GRAPH_MOVE_HORZ: {
-				distance = cmd.graphMoveHorz.distance;
-				moveDuration = action.seqLength;
-			} break;
-
-			case ActionCommand::Type::MOVE: {
-				switch(cmd.move.preset) {
-					case ActionCommand::MovePreset::WARP: {
-						distance = (f32)cmd.move.param2;
-						moveDuration = 0.01f; // warping
-					} break;
-				}
-			} break;
+		if(TimeDiffSec(TimeDiff(prog.startTime, localTime)) <= ops[prog.commandID].endTime) {
+			// we have not changed command / instruction, nothing to be done
+			continue;
 		}
 
-		if(distance != 0) {
-			caster->parent->input.moveTo = caster->parent->body->GetWorldPos() + vec3(dir * distance, 0);
-			caster->parent->body->vel = vec3(0);
-			physics.Move(caster->parent->body, vec3(dir * distance, 0), moveDuration);
+		prog.commandID++;
+
+		// program is done
+		if(prog.commandID >= action.opCount) {
+			prog.Finish();
+			continue;
 		}
 
-		if(cmd.delay == 0) {
-			running = true;
+		while(true) {
+			const GameXmlContent::SkillOp& op = ops[prog.commandID];
+
+			switch(op.code) {
+				case GameXmlContent::SkillOp::Code::NOP: break;
+
+				case GameXmlContent::SkillOp::Code::LOCK_MOVE: {
+					// lock WASD input type movement during skill execution
+					caster.body->lockedMoveUntil = TimeAddSec(localTime, op.delay);
+				} break;
+
+				case GameXmlContent::SkillOp::Code::MOVE: {
+					const vec2 dir = vec2(cosf(prog.castAngle), sinf(prog.castAngle));
+					moveOrders.push_back({ caster.index, vec3(dir * op.move.distance, 0), op.move.duration });
+				} break;
+
+				case GameXmlContent::SkillOp::Code::REMOTE: {
+					RemoteSimulation::SpawnDesc desc;
+					desc.docID = op.remote.idx;
+					desc.skillID = prog.skillID;
+					desc.casterUID = prog.casterUID;
+					desc.faction = PlayerFaction(caster.team);
+					desc.pos = caster.body->GetWorldPos();
+					desc.angle = prog.castAngle;
+					desc.targetPos = prog.castPos;
+					if(!prog.targetList.empty()) {
+						desc.targetUID = prog.targetList.front();
+					}
+					remotes.Spawn(desc, localTime);
+				} break;
+			}
+
+			if(!op.chain) break;
+
 			prog.commandID++;
 
 			// program is done
-			if(prog.commandID >= action.commands.size()) {
+			if(prog.commandID >= action.opCount) {
 				prog.Finish();
-				return;
+				break;
 			}
 		}
 	}
+
+	foreach_const(mo, moveOrders) {
+		Player& caster = players[mo->playerIndex];
+		caster.input.moveTo = caster.body->GetWorldPos() + mo->disp;
+		caster.body->vel = vec3(0);
+		physics.Move(caster.body, mo->disp, mo->duration);
+	}
+}
+
+void World::UpdateRemotes(f32 delta)
+{
+	ProfileFunction();
+
+	// TODO: get actual npc sizes from their creature data
+	const f32 npcRadius = 100;
+	const f32 npcHeight = 200;
+
+	SpatialHash& hash = remotes.actorHash;
+	hash.Clear();
+
+	// only the main master of a player is in the world, the sub is tagged out
+	foreach_const(it, players) {
+		const Player& player = *it;
+		if(player.IsDead()) continue;
+
+		const ColliderSize& size = player.colliderSize[player.mainCharaID];
+		hash.Push(player.Main().UID, player.body->GetWorldPos(), size.radius, size.height, PlayerFaction(player.team), SpatialHash::Kind::PLAYER);
+	}
+
+	foreach_const(it, actorNpcList) {
+		hash.Push(it->UID, it->pos, npcRadius, npcHeight, it->faction, SpatialHash::Kind::NPC);
+	}
+
+	foreach_const(it, actorDynamicList) {
+		hash.Push(it->UID, it->pos, npcRadius, npcHeight, it->faction, SpatialHash::Kind::DYNAMIC);
+	}
+
+	remotes.Step(localTime, delta);
+	ApplyRemoteHits();
+}
+
+void World::ApplyRemoteHits()
+{
+	// TODO: status effects (RemoteComData2 _Status), critical hits, npc and dynamic health
+	foreach_const(h, remotes.hitList) {
+		if(h->damageGroup == Remote::DamageGroup::eFRIEND) continue; // buffs, no damage
+		if(h->attackMultiplier <= 0) continue;
+
+		ActorMaster* target = FindMasterActor(h->targetUID);
+		if(!target || target->IsDead()) continue;
+
+		const i32 damage = (i32)(MASTER_BASE_ATTACK * h->attackMultiplier);
+		target->health = MAX(0, target->health - damage);
+		if(!target->IsDead()) continue;
+
+		Player& player = *target->parent;
+		LOG("Master %u (player %u) killed by %u (skill=%d remote=%d)", (u32)target->UID, (u32)player.index, (u32)h->casterUID, (i32)h->skillID, (i32)h->docID);
+
+		// the sub takes over, replicated as a tag
+		if(target == &player.Main() && !player.Sub().IsDead()) {
+			player.mainCharaID ^= 1;
+		}
+
+		if(player.IsDead()) {
+			player.Main().actionState = ActionStateID::DIE_BEHAVIORSTATE;
+			player.respawnTime = TimeAddSec(localTime, PLAYER_RESPAWN_DELAY);
+		}
+	}
+}
+
+void World::RespawnPlayer(Player& player)
+{
+	foreach(it, player.characters) {
+		ActorMaster& master = **it;
+		master.health = master.healthMax;
+	}
+
+	physics.Teleport(player.body, player.spawnPos);
+	player.input.moveTo = player.spawnPos;
+	player.input.speed = 0;
+	player.respawnTime = Time::ZERO;
+	player.Main().actionState = ActionStateID::RESPAWN_BEHAVIORSTATE;
+
+	LOG("Player %u respawned", player.index);
 }
@@ -3,6 +3,7 @@
 #include <common/network.h>
 #include <common/vector_math.h>
 #include <mxm/core.h>
+#include <mxm/game_content.h>
 
 #include <EASTL/array.h>
 #include <EASTL/fixed_list.h>
@@ -10,6 +11,8 @@
 
 #include "replication.h"
 #include "physics.h"
+#include "remote.h"
+#include "navigation.h"
 
 struct ColliderSize
 {
@@ -24,6 +27,14 @@ struct PlayerInputCastSkill
 	eastl::fixed_vector<ActorUID,10,false> targetList;
 };
 
+// base stats of every master, the same values are sent in SN_GameCreateActor (content has no per class stats)
+const i32 MASTER_BASE_HEALTH = 2400;
+const i32 MASTER_BASE_ATTACK = 200;
+const f32 PLAYER_RESPAWN_DELAY = 5; // seconds, once both masters are dead
+
+// players are on faction 3 + team (SN_GameCreateActor), npcs and dynamics on their content faction
+inline Faction PlayerFaction(u8 team) { return (Faction)(3 + team); }
+
 struct World
 {
 	struct Player;
@@ -65,7 +76,7 @@ struct World
 
 		const u32 index;
 		const UserID userID;
-		const ClientHandle clientHd;
+		ClientHandle clientHd; // changes when the player rejoins
 		const WideString name;
 		const WideString guildTag;
 		const u8 team;
@@ -86,6 +97,9 @@ struct World
 		Input input;
 		PhysicsDynamicBody* body = nullptr;
 
+		vec3 spawnPos;
+		Time respawnTime = Time::ZERO; // while dead
+
 		// book keeping
 		struct {
 			vec2 moveDir = vec2(0);
@@ -112,6 +126,7 @@ struct World
 
 		inline ActorMaster& Main() const { return *characters[mainCharaID]; }
 		inline ActorMaster& Sub() const { return *characters[mainCharaID ^ 1]; }
+		inline bool IsDead() const; // the sub takes over when the main dies, so both are
 	};
 
 	struct ActorMaster
@@ -125,6 +140,11 @@ struct World
 		i32 actionParam1;
 		i32 actionParam2;
 
+		i32 health;
+		i32 healthMax;
+
+		inline bool IsDead() const { return health <= 0; }
+
 		explicit ActorMaster(ActorUID UID_): UID(UID_) {}
 	};
 
@@ -158,9 +178,10 @@ struct World
 	{
 		SkillID skillID = SkillID::INVALID;
 		ActionStateID actionID;
+		GameXmlContent::CompiledActionIdx actionIdx;
 		vec3 castPos;
 		f32 castAngle;
-		ActorUID casterUID;
+		ActorUID casterUID; // resolved every step, the caster can leave or be removed while the program runs
 		eastl::fixed_vector<ActorUID,10,false> targetList;
 		Time startTime;
 		i32 commandID = 0;
@@ -169,30 +190,41 @@ struct World
 		inline void Finish() { skillID = SkillID::INVALID; }
 	};
 
+	// skill exec waiting for its move sweep to be resolved before being replicated
+	struct PendingSkillExec
+	{
+		Replication::SkillExec rpExec;
+		PhysicsScene::QueryID moveQuery;
+	};
+
 
 	Replication* replication;
+	const GameXmlContent* content; // generation of the game
 
 	eastl::fixed_vector<Player,10,false> players;
-	eastl::fixed_list<ActorMaster,512,true> actorMasterList;
-	eastl::fixed_list<ActorNpc,512,true> actorNpcList;
-	eastl::fixed_list<ActorDynamic,512,true> actorDynamicList;
+	eastl::fixed_list<ActorMaster,512,true,ArenaAllocator> actorMasterList;
+	eastl::fixed_list<ActorNpc,512,true,ArenaAllocator> actorNpcList;
+	eastl::fixed_list<ActorDynamic,512,true,ArenaAllocator> actorDynamicList;
 
 	typedef ListItT<ActorNpc> ActorNpcHandle;
 	typedef ListItT<ActorDynamic> ActorDynamicHandle;
 
 	// TODO: make those fixed_hash_maps
-	eastl::fixed_map<ActorUID, ActorMasterHandle, 2048, true> actorMasterMap;
-	eastl::fixed_map<ActorUID, ActorNpcHandle, 2048, true> actorNpcMap;
-	eastl::fixed_map<ActorUID, ActorDynamicHandle, 2048, true> actorDynamicMap;
+	eastl::fixed_map<ActorUID, ActorMasterHandle, 2048, true, eastl::less<ActorUID>, ArenaAllocator> actorMasterMap;
+	eastl::fixed_map<ActorUID, ActorNpcHandle, 2048, true, eastl::less<ActorUID>, ArenaAllocator> actorNpcMap;
+	eastl::fixed_map<ActorUID, ActorDynamicHandle, 2048, true, eastl::less<ActorUID>, ArenaAllocator> actorDynamicMap;
 
 	eastl::fixed_vector<SkillProgram,40,false> skillProgramList;
+	eastl::fixed_vector<PendingSkillExec,10,false> pendingSkillExecList;
 
 	u32 nextActorUID;
 	Time localTime = Time::ZERO;
 
 	PhysicsScene physics;
+	RemoteSimulation remotes;
+	NavQuery nav;
 
-	void Init(Replication* replication_);
+	void Init(Replication* replication_, const GameXmlContent* content_, MapIndex mapIndex, MemArena* arena); // containers overflow into the arena
 	void Cleanup();
 
 	void Update(Time localTime_);
@@ -212,5 +244,14 @@ private:
 	ActorMasterHandle MasterInvalidHandle();
 
 	void PlayerCastSkill(Player& player, SkillID skill, const vec3& castPos, Slice<const ActorUID> targets);
-	void ExecuteSkillProgram(SkillProgram& prog);
+	void ExecuteSkillPrograms();
+	void FlushPendingSkillExecs();
+	void UpdateRemotes(f32 delta);
+	void ApplyRemoteHits();
+	void RespawnPlayer(Player& player);
 };
+
+inline bool World::Player::IsDead() const
+{
+	return Main().IsDead();
+}
@@ -0,0 +1,128 @@
+#include "bench.h"
+#include <mxm/game_content.h>
+#include <EASTL/sort.h>
+
+static Bench* g_BenchFirst = nullptr;
+static Bench* g_BenchLast = nullptr;
+
+Bench::Bench(const char* name_, const char* desc_, Func func_):
+	name(name_),
+	desc(desc_),
+	func(func_),
+	next(nullptr)
+{
+	if(g_BenchLast) {
+		g_BenchLast->next = this;
+	}
+	else {
+		g_BenchFirst = this;
+	}
+	g_BenchLast = this;
+}
+
+f64 BenchSamples::Mean() const
+{
+	if(list.empty()) return 0;
+
+	f64 sum = 0;
+	foreach_const(it, list) {
+		sum += *it;
+	}
+	return sum / list.size();
+}
+
+f64 BenchSamples::Percentile(f64 p)
+{
+	if(list.empty()) return 0;
+
+	eastl::sort(list.begin(), list.end());
+	const i32 i = MIN((i32)list.size() - 1, (i32)(p / 100.0 * list.size()));
+	return list[i];
+}
+
+void BenchSamples::Print(const char* name, const char* unit)
+{
+	const f64 mean = Mean();
+	const f64 p50 = Percentile(50);
+	const f64 p99 = Percentile(99);
+	const f64 max = list.empty() ? 0 : list.back();
+	LOG("    %-32s n=%-7d mean=%.3f%s p50=%.3f%s p99=%.3f%s max=%.3f%s", name, (i32)list.size(), mean, unit, p50, unit, p99, unit, max, unit);
+}
+
+const GameXmlContent* BenchContent()
+{
+	static Mutex mutex;
+	static bool loaded = false;
+	static bool ok = false;
+
+	LOCK_MUTEX(mutex);
+	if(!loaded) {
+		loaded = true;
+		const Time t0 = TimeNow();
+		ok = GameXmlContentLoad();
+		LOG("Content loaded (%.2fms)", TimeDurationSinceMs(t0));
+	}
+	return ok ? &GetGameXmlContent() : nullptr;
+}
+
+static bool RunBench(const Bench& bench)
+{
+	LOG("[%s] %s", bench.name, bench.desc);
+	const Time t0 = TimeNow();
+	const bool r = bench.func();
+	LOG("[%s] %s (%.0fms)", bench.name, r ? "OK" : "FAILED", TimeDurationSinceMs(t0));
+	return r;
+}
+
+static void PrintUsage()
+{
+	printf("Usage: bench all | bench <name>...\n");
+	for(const Bench* b = g_BenchFirst; b; b = b->next) {
+		printf("    %-24s %s\n", b->name, b->desc);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2) {
+		PrintUsage();
+		return 1;
+	}
+
+	LogInit("bench.log");
+	LogNetTrafficInit("bench_nt.log", 0x0); // what the benches send to their clients, not printed
+	TimeInit();
+
+	i32 failed = 0;
+
+	if(strcmp(argv[1], "all") == 0) {
+		for(const Bench* b = g_BenchFirst; b; b = b->next) {
+			if(!RunBench(*b)) failed++;
+		}
+	}
+	else {
+		for(int i = 1; i < argc; i++) {
+			const Bench* found = nullptr;
+			for(const Bench* b = g_BenchFirst; b; b = b->next) {
+				if(strcmp(b->name, argv[i]) == 0) {
+					found = b;
+					break;
+				}
+			}
+
+			if(!found) {
+				printf("Unknown bench '%s'\n", argv[i]);
+				PrintUsage();
+				return 1;
+			}
+
+			if(!RunBench(*found)) failed++;
+		}
+	}
+
+	if(failed > 0) {
+		LOG("%d bench(es) FAILED", failed);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <common/base.h>
+#include <EASTL/vector.h>
+
+// Benchmarks and behavior checks of the server subsystems, outside of a running server.
+// Each one registers itself at static init (BENCH) and is run by name: bench all | bench <name>...
+// A bench logs its measurements and returns false when one of its checks failed.
+// Run from the build directory like the servers (gamedata is at ../gamedata).
+
+struct Bench
+{
+	typedef bool (*Func)();
+
+	const char* name;
+	const char* desc;
+	Func func;
+	Bench* next;
+
+	Bench(const char* name_, const char* desc_, Func func_);
+};
+
+#define BENCH(NAME, DESC)\
+	static bool Bench_##NAME();\
+	static Bench _bench_##NAME(#NAME, DESC, Bench_##NAME);\
+	static bool Bench_##NAME()
+
+// fails the bench, unlike ASSERT it does not stop the others from running
+#define CHECK(cond) do { if(!(cond)) { LOG("CHECK FAILED: %s (%s:%d)", #cond, __FILE__, __LINE__); return false; } } while(0)
+
+// Measured values (usually ms), percentiles are computed on print
+struct BenchSamples
+{
+	eastl::vector<f64> list;
+
+	inline void Push(f64 v) { list.push_back(v); }
+	inline void Clear() { list.clear(); }
+
+	f64 Mean() const;
+	f64 Percentile(f64 p); // sorts the samples, p in [0, 100]
+	void Print(const char* name, const char* unit = "ms"); // mean, p50, p99 and max
+};
+
+// Thread: Any
+// Content is loaded once, by the first bench that needs it
+struct GameXmlContent;
+const GameXmlContent* BenchContent();
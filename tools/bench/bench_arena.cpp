@@ -0,0 +1,146 @@
+#include "bench.h"
+#include <common/utils.h>
+#include <common/arena.h>
+#include <common/vector_math.h>
+#include <EASTL/fixed_list.h>
+
+// The game containers of one instance (replication actor lists and maps, navigation scratch) on a MemArena, or on the heap
+// like before (no arena set, ArenaAllocator falls back to it). Actors spawn and despawn every tick, paths are searched.
+
+static const i32 GAME_COUNT = 50;
+static const i32 TICK_COUNT = 600; // 10s at 60Hz
+static const i32 ACTOR_COUNT = 300; // alive at once, past the fixed capacity
+static const i32 CHURN_PER_TICK = 20;
+static const i32 PATH_PER_TICK = 8;
+
+struct Actor
+{
+	u32 uid;
+	vec3 pos;
+	u8 type;
+};
+
+struct GameContainers
+{
+	eastl::fixed_list<Actor,32,true,ArenaAllocator> actorList;
+	arena_hash_map<u32,decltype(actorList)::iterator,128> actorMap;
+	arena_hash_map<u32,u8,256> actorType;
+	eastl::vector<u32,ArenaAllocator> path;
+
+	explicit GameContainers(MemArena* arena)
+	{
+		actorList.set_overflow_allocator(ArenaAllocator(arena));
+		actorMap.set_overflow_allocator(ArenaHashAllocator(arena));
+		actorType.set_overflow_allocator(ArenaHashAllocator(arena));
+		path.set_allocator(ArenaAllocator(arena));
+	}
+};
+
+static u32 XorShift(u32* state)
+{
+	u32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+// returns a hash of what the game saw, the same whatever the allocator is
+static u64 PlayGame(MemArena* arena, u32 seed)
+{
+	u64 h = 14695981039346656037ull;
+	auto mix = [&h](u64 v) { h = (h ^ v) * 1099511628211ull; };
+
+	GameContainers* game = new GameContainers(arena);
+	defer(delete game);
+
+	u32 rng = seed;
+	u32 nextUID = 1;
+	auto spawn = [&]() {
+		const u32 uid = nextUID++;
+		game->actorList.push_back(Actor{ uid, vec3(XorShift(&rng) % 5000, XorShift(&rng) % 5000, 0), (u8)(uid % 3) });
+		game->actorMap.emplace(uid, --game->actorList.end());
+		game->actorType.emplace(uid, (u8)(uid % 3));
+	};
+
+	for(int i = 0; i < ACTOR_COUNT; i++) spawn();
+
+	for(int tick = 0; tick < TICK_COUNT; tick++) {
+		// the oldest ones die, as many spawn
+		for(int i = 0; i < CHURN_PER_TICK; i++) {
+			const u32 uid = game->actorList.front().uid;
+			game->actorMap.erase(uid);
+			game->actorType.erase(uid);
+			game->actorList.pop_front();
+			spawn();
+		}
+
+		for(int p = 0; p < PATH_PER_TICK; p++) {
+			game->path.clear();
+			const i32 len = 16 + XorShift(&rng) % 240;
+			for(int i = 0; i < len; i++) {
+				game->path.push_back(XorShift(&rng));
+			}
+			mix(game->path.back());
+			if(p == 0) game->path.shrink_to_fit(); // the scratch is trimmed now and then
+		}
+
+		const u32 probe = nextUID - 1 - XorShift(&rng) % ACTOR_COUNT;
+		auto found = game->actorMap.find(probe);
+		mix(found != game->actorMap.end() ? (u64)found->second->pos.x : 0);
+		mix(game->actorType.size());
+	}
+
+	foreach_const(it, game->actorList) {
+		mix(it->uid);
+	}
+	return h;
+}
+
+BENCH(instance_arena, "game containers of an instance on the heap then on its arena: churn and teardown time, reuse of freed blocks")
+{
+	BenchSamples heapMs;
+	BenchSamples arenaMs;
+
+	// one arena for every game, reset between them like a recycled PvpInstance
+	// small chunks: without the freed blocks reused, a game would allocate what it respawns in new ones
+	MemArena arena;
+	arena.Init("Bench", 16 * 1024);
+	size_t reservedAfterFirst = 0;
+	size_t peakFirst = 0;
+
+	// the same game on both, one after the other
+	for(int g = 0; g < GAME_COUNT; g++) {
+		const u32 seed = 0x9E3779B9u * (g + 1);
+
+		Time t0 = TimeNow();
+		const u64 heapHash = PlayGame(nullptr, seed);
+		heapMs.Push(TimeDurationSinceMs(t0));
+
+		t0 = TimeNow();
+		const u64 arenaHash = PlayGame(&arena, seed);
+		CHECK(arena.usedBytes == 0); // every block was freed by the containers
+		arena.Reset();
+		arenaMs.Push(TimeDurationSinceMs(t0));
+
+		CHECK(arenaHash == heapHash);
+		CHECK(arena.chunkCount == 1);
+		if(g == 0) {
+			reservedAfterFirst = arena.reservedBytes;
+			peakFirst = arena.peakBytes;
+		}
+	}
+
+	// freed blocks were reused: the region holds what one game needs at its peak, it didn't grow with the churn nor with the games
+	LOG("    %d actors alive, %d respawns per tick: peak %lluKB, reserved %lluKB after the first game, %lluKB after %d",
+		ACTOR_COUNT, CHURN_PER_TICK, (unsigned long long)peakFirst / 1024, (unsigned long long)reservedAfterFirst / 1024,
+		(unsigned long long)arena.reservedBytes / 1024, GAME_COUNT);
+	CHECK(arena.reservedBytes == reservedAfterFirst);
+	CHECK(arena.reservedBytes < peakFirst * 2);
+
+	heapMs.Print("heap game");
+	arenaMs.Print("arena game");
+	CHECK(arenaMs.Percentile(50) < heapMs.Percentile(50));
+	return true;
+}
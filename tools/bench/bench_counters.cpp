@@ -0,0 +1,194 @@
+#include "bench.h"
+#include <common/utils.h>
+#include <common/thread_slots.h>
+#include <EASTL/fixed_vector.h>
+#include <eathread/eathread_thread.h>
+
+// Per thread counters (ThreadSlots) as used by the memory tags and the net stats:
+// what a count costs against one atomic counter shared by every thread, blocks given back when threads exit.
+
+static const i32 SLOT_COUNT = 8; // 7 blocks of their own, then shared
+
+struct BenchCounters
+{
+	volatile i64 count;
+	u8 _pad[56]; // one cache line each, like the real blocks are bigger than that
+};
+
+static ThreadSlots<BenchCounters,SLOT_COUNT> g_BenchSlots;
+static thread_local BenchCounters* t_BenchCounters = nullptr;
+static volatile i64 g_BenchAtomic = 0;
+
+static i64 BenchSlotsSum()
+{
+	i64 sum = 0;
+	g_BenchSlots.ForEachUsed([&sum](const BenchCounters& c) { sum += c.count; });
+	return sum;
+}
+
+struct CountThread
+{
+	i32 count;
+	bool atomic;
+	volatile int* started; // every thread holds its block before any of them exits
+	i32 threadCount;
+	EA::Thread::Thread thread;
+};
+
+static intptr_t ThreadCount(void* pData)
+{
+	CountThread& ct = *(CountThread*)pData;
+	if(ct.atomic) {
+		EA::Thread::AtomicFetchIncrement(ct.started);
+		while(EA::Thread::AtomicGetValue(ct.started) < ct.threadCount) EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+		for(int i = 0; i < ct.count; i++) {
+			EA::Thread::AtomicFetchAdd(&g_BenchAtomic, 1);
+		}
+		return 0;
+	}
+
+	BenchCounters& c = g_BenchSlots.Get(&t_BenchCounters);
+	EA::Thread::AtomicFetchIncrement(ct.started);
+	while(EA::Thread::AtomicGetValue(ct.started) < ct.threadCount) EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+	for(int i = 0; i < ct.count; i++) {
+		g_BenchSlots.Add(c, &c.count, 1);
+	}
+	return 0;
+}
+
+// threadCount threads alive at once adding count each, returns the wall time in ms
+static f64 RunCounting(i32 threadCount, i32 count, bool atomic)
+{
+	eastl::fixed_vector<CountThread,32,false> threadList;
+	threadList.resize(threadCount);
+	volatile int started = 0;
+
+	const Time t0 = TimeNow();
+	foreach(t, threadList) {
+		t->count = count;
+		t->atomic = atomic;
+		t->started = &started;
+		t->threadCount = threadCount;
+		t->thread.Begin(ThreadCount, &*t);
+	}
+	foreach(t, threadList) {
+		t->thread.WaitForEnd();
+	}
+	return TimeDurationSinceMs(t0);
+}
+
+BENCH(thread_counters, "per thread counter blocks against one shared atomic, blocks given back by exiting threads")
+{
+	const i32 COUNT = 5000000;
+	const i32 threadCount = MIN(MAX(EA::Thread::GetProcessorCount(), 2), SLOT_COUNT - 1);
+
+	// threads one after the other take the block the previous one gave back
+	i64 expected = 0;
+	for(int i = 0; i < 100; i++) {
+		RunCounting(1, 1000, false);
+		expected += 1000;
+	}
+	CHECK(g_BenchSlots.usedCount == 1);
+	CHECK(g_BenchSlots.list[SLOT_COUNT - 1].count == 0);
+	CHECK(BenchSlotsSum() == expected);
+
+	// more threads alive than blocks: the ones left share the last block, nothing is lost
+	RunCounting(16, 10000, false);
+	expected += 16 * 10000;
+	CHECK(g_BenchSlots.usedCount == SLOT_COUNT - 1);
+	CHECK(g_BenchSlots.list[SLOT_COUNT - 1].count == (16 - (SLOT_COUNT - 1)) * 10000);
+	CHECK(BenchSlotsSum() == expected);
+
+	BenchSamples slotsMs;
+	BenchSamples atomicMs;
+	for(int r = 0; r < 5; r++) {
+		slotsMs.Push(RunCounting(threadCount, COUNT, false));
+		atomicMs.Push(RunCounting(threadCount, COUNT, true));
+	}
+	expected += 5LL * threadCount * COUNT;
+	CHECK(BenchSlotsSum() == expected);
+	CHECK(g_BenchAtomic == 5LL * threadCount * COUNT);
+
+	LOG("    %d threads counting %dM each", threadCount, COUNT / 1000000);
+	slotsMs.Print("per thread blocks");
+	atomicMs.Print("shared atomic");
+	CHECK(slotsMs.Percentile(50) < atomicMs.Percentile(50));
+	return true;
+}
+
+struct AllocThread
+{
+	i32 blockCount;
+	bool violate; // allocates once in a no allocation scope, the threads after it get its counter block
+	i64 violationsSeen; // by the thread, at its start
+	eastl::fixed_vector<void*,256,false> kept; // freed by the bench thread
+	EA::Thread::Thread thread;
+};
+
+static intptr_t ThreadAlloc(void* pData)
+{
+	AllocThread& at = *(AllocThread*)pData;
+	at.violationsSeen = MemNoAllocViolationCount();
+
+	if(at.violate) {
+		MemNoAllocScope scope(MemNoAllocMode::LOG);
+		memFree(memAlloc(16));
+	}
+
+	MEM_TAG(MemTag::NETWORK);
+	for(int i = 0; i < at.blockCount; i++) {
+		void* block = memAlloc(64);
+		if(i & 1) at.kept.push_back(block);
+		else memFree(block);
+	}
+	return 0;
+}
+
+// Memory tag counters of short lived threads, far more of them than counter blocks: the totals stay exact
+// and the no allocation violations of a thread are its own even on a block used before.
+BENCH(mem_tag_threads, "memory tag counters of 500 short lived threads, totals, frees on another thread, violations per thread")
+{
+	const i32 THREAD_COUNT = 500;
+	const i32 BLOCK_COUNT = 200;
+
+	MemStats before;
+	MemGetStats(&before);
+	const MemTagStats& b = before.tags[(i32)MemTag::NETWORK];
+
+	eastl::fixed_vector<void*,THREAD_COUNT * BLOCK_COUNT / 2,true> kept;
+	i64 violationsSeen = 0;
+	const Time t0 = TimeNow();
+	for(int t = 0; t < THREAD_COUNT; t++) {
+		AllocThread* at = new AllocThread();
+		defer(delete at);
+		at->blockCount = BLOCK_COUNT;
+		at->violate = t == 0;
+		at->thread.Begin(ThreadAlloc, at);
+		at->thread.WaitForEnd();
+
+		violationsSeen += at->violationsSeen;
+		kept.insert(kept.end(), at->kept.begin(), at->kept.end());
+	}
+	const f64 ms = TimeDurationSinceMs(t0);
+
+	MemStats after;
+	MemGetStats(&after);
+	const MemTagStats& a = after.tags[(i32)MemTag::NETWORK];
+	LOG("    %d threads (%.3fms each, start to join) allocated %lld blocks, %lld bytes live", THREAD_COUNT, ms / THREAD_COUNT,
+		(long long)(a.allocCount - b.allocCount), (long long)(a.liveBytes - b.liveBytes));
+
+	// nothing else allocates under this tag without a running server
+	CHECK(a.allocCount - b.allocCount == (i64)THREAD_COUNT * BLOCK_COUNT);
+	CHECK(a.liveBytes - b.liveBytes == (i64)kept.size() * 64);
+	CHECK(after.noAllocViolations - before.noAllocViolations == 1);
+	CHECK(violationsSeen == 0);
+
+	// freed here, counted on this thread's block against the tag they were allocated with
+	foreach(it, kept) {
+		memFree(*it);
+	}
+	kept.clear();
+	MemGetStats(&after);
+	CHECK(after.tags[(i32)MemTag::NETWORK].liveBytes == b.liveBytes);
+	return true;
+}
@@ -0,0 +1,148 @@
+#include "bench.h"
+#include <common/utils.h>
+#include <matching.h>
+
+// 60% solo, 25% duo, 15% trio
+static u8 RandPartySize()
+{
+	const f64 r = Randf01();
+	if(r < 0.6) return 1;
+	if(r < 0.85) return 2;
+	return 3;
+}
+
+// roughly normal around 1500
+static u16 RandRating()
+{
+	f64 sum = 0;
+	for(int i = 0; i < 4; i++) {
+		sum += Randf01();
+	}
+	return (u16)MAX(0.0, 1500 + (sum - 2) * 600);
+}
+
+// 100k synthetic parties through MatchQueue at the matchmaker update rate.
+// Every party has to be matched exactly once, with parties of its mode and region, in teams that are not over full.
+// Matches are full unless the oldest party waited long enough for the bot fill.
+static bool RunMatchQueue(const char* name, i32 partyCount, f64 arrivalPerSec)
+{
+	const f64 UPDATE_RATE_MS = (1.0/30.0) * 1000.0; // matchmaker
+	const i32 REGION_COUNT = 4;
+
+	MatchQueue::Params params;
+	params.capacity = partyCount;
+
+	MatchQueue* queue = new MatchQueue();
+	defer(delete queue);
+	CHECK(queue->Init(params));
+
+	eastl::vector<MatchQueue::Ticket> ticketList;
+	ticketList.resize(partyCount);
+	for(int i = 0; i < partyCount; i++) {
+		MatchQueue::Ticket& t = ticketList[i];
+		t.partyUID = (PartyUID)(i + 1);
+		t.mode = (u8)MatchMode::ARENA_3V3;
+		t.region = (u8)RandInt(0, REGION_COUNT - 1);
+		t.size = RandPartySize();
+		t.rating = RandRating();
+	}
+
+	eastl::vector<u8> matchedList;
+	matchedList.resize(partyCount, 0);
+
+	eastl::vector<MatchQueue::Match> matchList;
+	BenchSamples updateSamples;
+	BenchSamples queueSamples;
+	BenchSamples enqueueSamples;
+	i32 matchCount = 0;
+	i32 botFillCount = 0;
+	i32 maxQueued = 0;
+	f64 updateTotal = 0;
+
+	Time localTime = Time::ZERO;
+	i32 next = 0;
+	const i32 tickMax = (i32)((partyCount / arrivalPerSec + params.botFillSec * 2) * 1000 / UPDATE_RATE_MS) + 1;
+
+	for(int tick = 0; tick < tickMax && (next < partyCount || queue->Count() > 0); tick++) {
+		localTime = TimeAdd(localTime, TimeMsToTime(UPDATE_RATE_MS));
+
+		// arrivals
+		const i32 arrived = MIN(partyCount, (i32)(TimeDiffSec(localTime) * arrivalPerSec));
+		const Time t0 = TimeNow();
+		for(; next < arrived; next++) {
+			ticketList[next].enqueueTime = localTime;
+			CHECK(queue->Enqueue(ticketList[next]));
+		}
+		enqueueSamples.Push(TimeDurationSinceMs(t0));
+		maxQueued = MAX(maxQueued, queue->Count());
+
+		matchList.clear();
+		const Time t1 = TimeNow();
+		queue->Update(localTime, &matchList);
+		const f64 ms = TimeDurationSinceMs(t1);
+		updateSamples.Push(ms);
+		updateTotal += ms;
+
+		foreach_const(m, matchList) {
+			Time oldest = localTime;
+			i32 playerCount = 0;
+			u16 minRating = 0xFFFF;
+			u16 maxRating = 0;
+
+			foreach_const(team, m->teams) {
+				i32 teamSize = 0;
+				foreach_const(puid, (*team)) {
+					const i32 i = (i32)*puid - 1;
+					CHECK(i >= 0 && i < partyCount);
+					CHECK(matchedList[i] == 0);
+					matchedList[i] = 1;
+
+					const MatchQueue::Ticket& t = ticketList[i];
+					CHECK(t.mode == m->mode && t.region == m->region);
+					CHECK(queue->Find(t.partyUID) == nullptr);
+
+					teamSize += t.size;
+					oldest = MIN(oldest, t.enqueueTime);
+					minRating = MIN(minRating, t.rating);
+					maxRating = MAX(maxRating, t.rating);
+					queueSamples.Push(TimeDiffSec(TimeDiff(t.enqueueTime, localTime)));
+				}
+				CHECK(teamSize <= MatchQueue::TEAM_SIZE);
+				playerCount += teamSize;
+			}
+
+			const f64 waited = TimeDiffSec(TimeDiff(oldest, localTime));
+			if(playerCount < MatchQueue::TEAM_SIZE * MatchQueue::TEAM_COUNT) {
+				CHECK(waited >= params.botFillSec - 0.001); // the queue measures it in f32
+				botFillCount++;
+			}
+			else {
+				// every party is within the widened band of the anchor
+				const i32 bandSpread = maxRating / params.ratingBandWidth - minRating / params.ratingBandWidth;
+				CHECK(bandSpread <= params.maxBandRadius * 2);
+			}
+		}
+		matchCount += matchList.size();
+	}
+
+	CHECK(next == partyCount);
+	CHECK(queue->Count() == 0);
+	foreach_const(m, matchedList) {
+		CHECK(*m == 1);
+	}
+
+	LOG("    %s: %d parties (%.0f/sec) max queued=%d matches=%d bot filled=%d", name, partyCount, arrivalPerSec, maxQueued, matchCount, botFillCount);
+	LOG("    %s: %.0f matches/sec of Update time, %.0f matches per simulated sec", name, matchCount / (updateTotal / 1000), matchCount / TimeDiffSec(localTime));
+	updateSamples.Print("MatchQueue::Update");
+	enqueueSamples.Print("MatchQueue::Enqueue (per tick)");
+	queueSamples.Print("queue time", "s");
+	return true;
+}
+
+BENCH(match_queue, "100k parties through the match queue, matches per second and queue times")
+{
+	// steady arrivals, then every party at once (matchmaker restarted with a full queue)
+	if(!RunMatchQueue("steady", 100000, 2000)) return false;
+	if(!RunMatchQueue("burst", 100000, 100000 * 30)) return false;
+	return true;
+}
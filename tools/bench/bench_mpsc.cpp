@@ -0,0 +1,205 @@
+#include "bench.h"
+#include <common/utils.h>
+#include <common/mpsc_queue.h>
+#include <common/inner_protocol.h>
+#include <EASTL/fixed_vector.h>
+#include <eathread/eathread_thread.h>
+
+// The lane queues before MPSCQueue: a mutex and a fixed_vector of 128,
+// drained by copying the whole vector out under the lock then clearing it.
+// Pushing waits when full here, it asserted before.
+template<typename T>
+struct MutexQueue
+{
+	enum { CAPACITY = 128 };
+
+	ProfileMutex(Mutex, mutex);
+	eastl::fixed_vector<T,CAPACITY,false> list;
+
+	void Push(const T& item)
+	{
+		while(true) {
+			{ LOCK_MUTEX(mutex);
+				if(!list.full()) {
+					list.push_back(item);
+					return;
+				}
+			}
+			EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+		}
+	}
+
+	template<typename Callback>
+	i32 Drain(Callback cb)
+	{
+		decltype(list) local;
+		{ LOCK_MUTEX(mutex);
+			local = list;
+			list.clear();
+		}
+
+		foreach(it, local) {
+			cb(*it);
+		}
+		return local.size();
+	}
+};
+
+// bounded queue of the lanes, with the lane capacity
+template<typename T>
+struct BoundedQueue: MPSCQueue<T>
+{
+	BoundedQueue() { MPSCQueue<T>::Init(128); }
+};
+
+template<typename T>
+struct UnboundedQueue: MPSCQueueUnbounded<T>
+{
+	UnboundedQueue() { MPSCQueueUnbounded<T>::Init(); }
+};
+
+struct Item
+{
+	u32 producer;
+	u32 seq;
+};
+
+// Producers push itemCount items each as fast as they can, the consumer drains in a loop.
+// Every item has to arrive once, in order for each producer.
+template<typename Queue>
+static bool RunThroughput(const char* name, i32 producerCount, i32 itemCount)
+{
+	struct Context
+	{
+		Queue queue;
+		i32 itemCount;
+	};
+
+	Context* ctx = new Context();
+	defer(delete ctx);
+	ctx->itemCount = itemCount;
+
+	struct Producer
+	{
+		Context* ctx;
+		u32 index;
+		EA::Thread::Thread thread;
+	};
+	eastl::fixed_vector<Producer,8,false> producerList;
+	producerList.resize(producerCount);
+
+	const Time t0 = TimeNow();
+	for(int p = 0; p < producerCount; p++) {
+		producerList[p].ctx = ctx;
+		producerList[p].index = p;
+		producerList[p].thread.Begin([](void* pData) -> intptr_t {
+			Producer& prod = *(Producer*)pData;
+			for(int i = 0; i < prod.ctx->itemCount; i++) {
+				prod.ctx->queue.Push(Item{ prod.index, (u32)i });
+			}
+			return 0;
+		}, &producerList[p]);
+	}
+
+	eastl::fixed_vector<u32,8,false> nextSeq;
+	nextSeq.resize(producerCount, 0);
+	const i64 total = (i64)producerCount * itemCount;
+	i64 received = 0;
+	bool inOrder = true;
+
+	while(received < total) {
+		const i32 count = ctx->queue.Drain([&](Item& item) {
+			inOrder = inOrder && item.producer < (u32)producerCount && item.seq == nextSeq[item.producer];
+			nextSeq[item.producer] = item.seq + 1;
+		});
+		received += count;
+		if(count == 0) {
+			EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+		}
+	}
+	const f64 sec = TimeDurationSinceSec(t0);
+
+	foreach(p, producerList) {
+		p->thread.WaitForEnd();
+	}
+
+	LOG("    %s: %d producers x %d items, %.1fM items/sec", name, producerCount, itemCount, total / sec / 1000000.0);
+	CHECK(inOrder);
+	foreach_const(s, nextSeq) {
+		CHECK(*s == (u32)itemCount);
+	}
+	return true;
+}
+
+// A burst of 500 game creations from the coordinator, the lane drains its queue every tick then creates the games.
+// The lane tick is shortened to 1ms (sleep), the drain itself is what is measured.
+static const i32 BURST = 500;
+
+template<typename Queue>
+static bool RunBurst(const char* name)
+{
+	struct Context
+	{
+		Queue queue;
+		BenchSamples drainSamples;
+		i32 received = 0;
+		i32 ticks = 0;
+		bool inOrder = true;
+		Time lastPopTime;
+	};
+
+	Context* ctx = new Context();
+	defer(delete ctx);
+
+	EA::Thread::Thread lane;
+	lane.Begin([](void* pData) -> intptr_t {
+		Context& ctx = *(Context*)pData;
+		while(ctx.received < BURST) {
+			const Time t0 = TimeNow();
+			const i32 count = ctx.queue.Drain([&](In::MQ_CreateGame& game) {
+				ctx.inOrder = ctx.inOrder && game.sortieUID == (SortieUID)(ctx.received + 1);
+				ctx.received++;
+			});
+			if(count > 0) {
+				ctx.drainSamples.Push(TimeDurationSinceMs(t0));
+				ctx.lastPopTime = TimeNow();
+				ctx.ticks++;
+			}
+			EA::Thread::ThreadSleep(1);
+		}
+		return 0;
+	}, ctx);
+
+	In::MQ_CreateGame game;
+	memset(&game, 0, sizeof(game));
+
+	const Time t0 = TimeNow();
+	for(int i = 0; i < BURST; i++) {
+		game.sortieUID = (SortieUID)(i + 1);
+		ctx->queue.Push(game);
+	}
+	const f64 pushMs = TimeDurationSinceMs(t0);
+	lane.WaitForEnd();
+	const f64 lastMs = TimeDiffMs(TimeDiff(t0, ctx->lastPopTime));
+
+	LOG("    %s: %d x %d bytes, pushed in %.2fms, all drained after %.2fms in %d lane ticks", name, BURST, (i32)sizeof(In::MQ_CreateGame), pushMs, lastMs, ctx->ticks);
+	ctx->drainSamples.Print(FMT("%s lane drain (per tick)", name));
+	CHECK(ctx->inOrder);
+	CHECK(ctx->received == BURST);
+	return true;
+}
+
+BENCH(mpsc_burst, "MPSC queues against the mutex queues they replaced, throughput and a burst of 500 game creations")
+{
+	if(!RunBurst<MutexQueue<In::MQ_CreateGame>>("mutex")) return false;
+	if(!RunBurst<BoundedQueue<In::MQ_CreateGame>>("bounded")) return false;
+	if(!RunBurst<UnboundedQueue<In::MQ_CreateGame>>("unbounded")) return false;
+
+	const i32 ITEM_COUNT = 1000000;
+	for(int producers = 1; producers <= 4; producers *= 2) {
+		if(!RunThroughput<MutexQueue<Item>>("mutex", producers, ITEM_COUNT)) return false;
+		if(!RunThroughput<BoundedQueue<Item>>("bounded", producers, ITEM_COUNT)) return false;
+		if(!RunThroughput<UnboundedQueue<Item>>("unbounded", producers, ITEM_COUNT)) return false;
+	}
+	return true;
+}
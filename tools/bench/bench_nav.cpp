@@ -0,0 +1,141 @@
+#include "bench.h"
+#include <common/utils.h>
+#include <mxm/game_content.h>
+#include <navigation.h>
+
+// random point on a random polygon
+static vec3 RandPointOnMesh(const NavMesh& mesh)
+{
+	const NavMeshFile::Poly& poly = mesh.polys[RandInt(0, mesh.polyCount - 1)];
+	f32 u = (f32)Randf01();
+	f32 v = (f32)Randf01();
+	if(u + v > 1) {
+		u = 1 - u;
+		v = 1 - v;
+	}
+
+	const vec3& a = mesh.vertices[poly.verts[0]];
+	const vec3& b = mesh.vertices[poly.verts[1]];
+	const vec3& c = mesh.vertices[poly.verts[2]];
+	return a + (b - a) * u + (c - a) * v;
+}
+
+// Path, raycast and projection queries on the PVP_DeathMatch01 navmesh, between random points of the mesh.
+// Straight paths have to stay on the mesh without a jump or a drop on the way.
+BENCH(nav_queries, "PVP_DeathMatch01 navmesh queries per second")
+{
+	const GameXmlContent* content = BenchContent();
+	CHECK(content);
+
+	const NavMesh* mesh = content->FindNavMesh(MapIndex::PVP_DEATHMATCH);
+	CHECK(mesh);
+
+	MemArena arena;
+	arena.Init("BenchNav", 64 * 1024);
+	defer(arena.Release());
+
+	NavQuery* query = new NavQuery();
+	defer(delete query);
+	query->Init(mesh, &arena);
+	CHECK(query->IsReady());
+
+	const i32 QUERY_COUNT = 20000;
+	const f32 STEP_HEIGHT = 120; // GlobalTweakableVariables::stepHeight
+
+	eastl::vector<vec3> pointList;
+	pointList.resize(QUERY_COUNT * 2);
+	foreach(p, pointList) {
+		*p = RandPointOnMesh(*mesh);
+	}
+
+	// path searches, without the per tick budget
+	{
+		BenchSamples samples;
+		i32 success = 0;
+		i32 straight = 0;
+		f64 total = 0;
+		for(int i = 0; i < QUERY_COUNT; i++) {
+			const vec3& start = pointList[i*2];
+			const vec3& end = pointList[i*2+1];
+
+			NavMesh::Path path;
+			query->searchBudget = 1;
+			const Time t0 = TimeNow();
+			const NavQuery::Result r = query->FindPath(start, end, &path);
+			const f64 ms = TimeDurationSinceMs(t0);
+			samples.Push(ms * 1000);
+			total += ms;
+
+			CHECK(r != NavQuery::Result::DEFERRED);
+			if(r != NavQuery::Result::SUCCESS) continue;
+			success++;
+
+			CHECK(!path.empty());
+			CHECK(glm::distance(vec2(path.back()), vec2(end)) < 1);
+			if(path.size() > 1) continue;
+			straight++;
+
+			// walk the straight path following the floor: on the mesh all the way, no jump or drop
+			vec3 pos = start;
+			const i32 sampleCount = 1 + (i32)(glm::distance(vec2(start), vec2(end)) / 10);
+			for(int s = 1; s <= sampleCount; s++) {
+				const vec2 next = glm::mix(vec2(start), vec2(end), (f32)s / sampleCount);
+				const NavPolyRef ref = mesh->FindPoly(vec3(next, pos.z), STEP_HEIGHT, &pos);
+				CHECK(ref != NavPolyRef::INVALID);
+			}
+			CHECK(fabsf(pos.z - end.z) < 1);
+		}
+
+		LOG("    FindPath: %.0f queries/sec success=%d straight=%d (%d queries)", QUERY_COUNT / (total / 1000), success, straight, QUERY_COUNT);
+		samples.Print("FindPath", "us");
+		CHECK(success > QUERY_COUNT / 2);
+	}
+
+	// same pairs again, the corridors of the last ones are cached
+	{
+		BenchSamples samples;
+		const i32 first = QUERY_COUNT - NavQuery::CACHE_SIZE;
+		for(int i = first; i < QUERY_COUNT; i++) {
+			NavMesh::Path path;
+			query->searchBudget = 0; // has to come from the cache or be straight
+			const Time t0 = TimeNow();
+			query->FindPath(pointList[i*2], pointList[i*2+1], &path);
+			samples.Push(TimeDurationSinceMs(t0) * 1000);
+		}
+		samples.Print("FindPath (cached)", "us");
+	}
+
+	{
+		BenchSamples samples;
+		i32 clear = 0;
+		f64 total = 0;
+		for(int i = 0; i < QUERY_COUNT; i++) {
+			vec3 hit;
+			const Time t0 = TimeNow();
+			clear += query->Raycast(pointList[i*2], pointList[i*2+1], &hit);
+			const f64 ms = TimeDurationSinceMs(t0);
+			samples.Push(ms * 1000);
+			total += ms;
+		}
+		LOG("    Raycast: %.0f queries/sec clear=%d", QUERY_COUNT / (total / 1000), clear);
+		samples.Print("Raycast", "us");
+	}
+
+	{
+		BenchSamples samples;
+		i32 found = 0;
+		f64 total = 0;
+		for(int i = 0; i < QUERY_COUNT; i++) {
+			const vec3 pos = pointList[i] + vec3((Randf01() * 2 - 1) * 200, (Randf01() * 2 - 1) * 200, 100);
+			vec3 out;
+			const Time t0 = TimeNow();
+			found += query->ProjectPoint(pos, 500, &out);
+			const f64 ms = TimeDurationSinceMs(t0);
+			samples.Push(ms * 1000);
+			total += ms;
+		}
+		LOG("    ProjectPoint: %.0f queries/sec found=%d", QUERY_COUNT / (total / 1000), found);
+		samples.Print("ProjectPoint", "us");
+	}
+	return true;
+}
@@ -0,0 +1,184 @@
+#include "bench.h"
+#include <common/utils.h>
+#include <mxm/game_content.h>
+#include <remote.h>
+
+static vec3 RandPos(f32 halfSize)
+{
+	return vec3((Randf01() * 2 - 1) * halfSize, (Randf01() * 2 - 1) * halfSize, 0);
+}
+
+// Every entry overlapping a box has to be found by SpatialHash::Query, as with a scan of every entry
+BENCH(remote_hash, "spatial hash queries match a brute force scan")
+{
+	SpatialHash* hash = new SpatialHash();
+	defer(delete hash);
+	hash->Clear();
+
+	const i32 ENTRY_COUNT = 1000;
+	for(int i = 0; i < ENTRY_COUNT; i++) {
+		hash->Push((ActorUID)(i + 1), RandPos(10000), (f32)RandInt(50, 300), 200, (Faction)(i & 1), SpatialHash::Kind::NPC);
+	}
+
+	for(int q = 0; q < 1000; q++) {
+		const vec2 center = vec2(RandPos(11000));
+		const vec2 ext = vec2((f32)RandInt(0, 2000), (f32)RandInt(0, 2000));
+		const vec2 vmin = center - ext;
+		const vec2 vmax = center + ext;
+
+		eastl::fixed_vector<ActorUID,ENTRY_COUNT,false> found;
+		hash->Query(vmin, vmax, [&](const SpatialHash::Entry& e) {
+			found.push_back(e.actorUID);
+		});
+
+		// the query can return more (same cell), never less
+		foreach_const(e, hash->entryList) {
+			const bool overlaps = e->pos.x + e->radius >= vmin.x && e->pos.x - e->radius <= vmax.x &&
+								  e->pos.y + e->radius >= vmin.y && e->pos.y - e->radius <= vmax.y;
+			if(!overlaps) continue;
+			CHECK(eastl::find(found.begin(), found.end(), e->actorUID) != found.end());
+		}
+	}
+	return true;
+}
+
+// Live remotes of the content stepped against 10 players and 200 npcs moving around, spawned again as they expire
+BENCH(remotes, "hundreds of live remotes per match, step time and hits")
+{
+	const GameXmlContent* content = BenchContent();
+	CHECK(content);
+
+	RemoteSimulation* sim = new RemoteSimulation();
+	defer(delete sim);
+	sim->content = content;
+	sim->Clear();
+
+	// remotes that can hit something, with the batch they go to
+	struct Candidate
+	{
+		const Remote* doc;
+		i32 batch;
+	};
+
+	eastl::vector<Candidate> candidateList;
+	{
+		RemoteSimulation* probe = new RemoteSimulation();
+		defer(delete probe);
+		probe->content = content;
+
+		foreach_const(r, content->GetRemoteList()) {
+			if(r->damageGroup != Remote::DamageGroup::eENEMY) continue;
+			if(r->boundType == Remote::BoundType::E_BOUND_NONE || r->boundType == Remote::BoundType::INVALID) continue;
+			if(r->lifeTime <= 0) continue;
+
+			probe->Clear();
+			RemoteSimulation::SpawnDesc desc;
+			desc.docID = r->ID;
+			desc.skillID = SkillID::INVALID;
+			desc.casterUID = ActorUID::INVALID;
+			desc.faction = Faction::RED;
+			desc.pos = vec3(0);
+			desc.angle = 0;
+			desc.targetPos = vec3(0);
+			if(!probe->Spawn(desc, Time::ZERO)) continue;
+
+			for(int b = 0; b < (i32)probe->batchList.size(); b++) {
+				if(!probe->batchList[b].empty()) {
+					candidateList.push_back({ &(*r), b });
+				}
+			}
+		}
+	}
+	CHECK(!candidateList.empty());
+	LOG("    %d enemy remotes with a bound", (i32)candidateList.size());
+
+	struct Actor
+	{
+		ActorUID UID;
+		vec3 pos;
+		vec2 dir;
+		Faction faction;
+		SpatialHash::Kind kind;
+	};
+
+	const f32 MAP_HALF_SIZE = 4000;
+	eastl::vector<Actor> actorList;
+	for(int i = 0; i < 10; i++) {
+		actorList.push_back({ (ActorUID)(actorList.size() + 1), RandPos(MAP_HALF_SIZE), vec2(0), (Faction)(3 + (i & 1)), SpatialHash::Kind::PLAYER });
+	}
+	for(int i = 0; i < 200; i++) {
+		actorList.push_back({ (ActorUID)(actorList.size() + 1), RandPos(MAP_HALF_SIZE), vec2(0), (Faction)(i & 1), SpatialHash::Kind::NPC });
+	}
+
+	const i32 TICK_COUNT = 20 * UPDATE_TICK_RATE;
+	const i32 targetList[] = { 100, 300, 600 };
+
+	for(int ti = 0; ti < (i32)ARRAY_COUNT(targetList); ti++) {
+		const i32 target = targetList[ti];
+		sim->Clear();
+
+		BenchSamples samples;
+		i32 hitCount = 0;
+		i32 aliveSum = 0;
+		Time localTime = Time::ZERO;
+
+		for(int t = 0; t < TICK_COUNT; t++) {
+			localTime = TimeAdd(localTime, TimeMsToTime(UPDATE_RATE * 1000));
+
+			// actors wander
+			foreach(a, actorList) {
+				if(Randf01() < 0.02) {
+					const f32 angle = (f32)(Randf01() * 2*PI);
+					a->dir = vec2(cosf(angle), sinf(angle));
+				}
+				a->pos += vec3(a->dir * (f32)(600 * UPDATE_RATE), 0);
+				a->pos.x = MAX(-MAP_HALF_SIZE, MIN(MAP_HALF_SIZE, a->pos.x));
+				a->pos.y = MAX(-MAP_HALF_SIZE, MIN(MAP_HALF_SIZE, a->pos.y));
+			}
+
+			// keep the remote count up, cast by players towards random actors
+			for(int tries = 0; sim->CountAlive() < target && tries < target; tries++) {
+				const Candidate& c = candidateList[RandInt(0, candidateList.size() - 1)];
+				if(sim->batchList[c.batch].full()) continue;
+
+				const Actor& caster = actorList[RandInt(0, 9)];
+				const Actor& aim = actorList[RandInt(0, actorList.size() - 1)];
+
+				RemoteSimulation::SpawnDesc desc;
+				desc.docID = c.doc->ID;
+				desc.skillID = SkillID::INVALID;
+				desc.casterUID = caster.UID;
+				desc.faction = caster.faction;
+				desc.pos = caster.pos;
+				desc.angle = atan2f(aim.pos.y - caster.pos.y, aim.pos.x - caster.pos.x);
+				desc.targetPos = aim.pos;
+				desc.targetUID = aim.UID;
+				sim->Spawn(desc, localTime);
+			}
+
+			const Time t0 = TimeNow();
+			SpatialHash& hash = sim->actorHash;
+			hash.Clear();
+			foreach_const(a, actorList) {
+				hash.Push(a->UID, a->pos, 100, 200, a->faction, a->kind);
+			}
+			aliveSum += sim->CountAlive();
+			sim->Step(localTime, (f32)UPDATE_RATE);
+			samples.Push(TimeDurationSinceMs(t0));
+
+			// enemy remotes never hit the faction of their caster
+			foreach_const(h, sim->hitList) {
+				const SpatialHash::Entry* caster = hash.Find(h->casterUID);
+				const SpatialHash::Entry* hit = hash.Find(h->targetUID);
+				CHECK(caster && hit);
+				CHECK(caster->faction != hit->faction);
+			}
+			hitCount += sim->hitList.size();
+		}
+
+		LOG("    %d remotes: mean alive=%.0f hits/sec=%.0f", target, (f64)aliveSum / TICK_COUNT, hitCount / (TICK_COUNT * UPDATE_RATE));
+		samples.Print("step (hash build + remotes)");
+		CHECK(hitCount > 0);
+	}
+	return true;
+}
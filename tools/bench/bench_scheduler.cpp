@@ -0,0 +1,193 @@
+#include "bench.h"
+#include <common/utils.h>
+#include <common/task_scheduler.h>
+#include <eathread/eathread_thread.h>
+#include <eathread/eathread_atomic.h>
+
+// 40 games, 4 of them heavy, ticked by 4 threads: static lanes against the work stealing scheduler (InstanceWorkers).
+// The heavy games were all placed on the first lane (placement didn't know they would be heavy).
+// A game tick waits for its cost in wall time, yielding, so the comparison holds even with fewer cores than threads.
+
+static const i32 THREAD_COUNT = 4; // lanes, or workers + the thread waiting on the batch
+static const i32 TICK_COUNT = 60;
+
+struct Game
+{
+	f64 costMs;
+	i32 affinity = -1; // TaskScheduler
+	i32 lastThread = -1;
+	i32 tickCount = 0;
+	i32 sameThreadCount = 0; // ticked on the same thread as the tick before
+};
+
+static EA::Thread::AtomicInt32 g_ThreadCount;
+static thread_local i32 t_ThreadIndex = -1;
+
+static void TickGame(Game* game)
+{
+	if(t_ThreadIndex == -1) {
+		t_ThreadIndex = g_ThreadCount.Increment() - 1;
+	}
+
+	const Time t0 = TimeNow();
+	while(TimeDurationSinceMs(t0) < game->costMs) {
+		EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+	}
+
+	game->sameThreadCount += game->lastThread == t_ThreadIndex;
+	game->lastThread = t_ThreadIndex;
+	game->tickCount++;
+}
+
+static void MakeGames(eastl::vector<Game>* gameList, f64 heavyMs)
+{
+	const i32 GAME_COUNT = 40;
+	const f64 LIGHT_MS = 0.25;
+
+	gameList->resize(GAME_COUNT);
+	for(int i = 0; i < GAME_COUNT; i++) {
+		Game& g = (*gameList)[i];
+		g = Game();
+		// round-robin lanes: the heavy ones all end up on lane 0
+		g.costMs = (i % THREAD_COUNT == 0 && i < THREAD_COUNT * 4) ? heavyMs : LIGHT_MS;
+	}
+}
+
+struct StaticLanes
+{
+	struct Lane
+	{
+		StaticLanes* lanes;
+		i32 index;
+		EA::Thread::Thread thread;
+		EA::Thread::Semaphore tickSignal;
+	};
+
+	eastl::vector<Game>* gameList;
+	Lane laneList[THREAD_COUNT];
+	EA::Thread::AtomicInt32 pendingCount;
+	bool running = true;
+
+	static intptr_t ThreadLane(void* pData)
+	{
+		Lane& lane = *(Lane*)pData;
+		StaticLanes& lanes = *lane.lanes;
+
+		while(true) {
+			lane.tickSignal.Wait();
+			if(!lanes.running) break;
+
+			for(int i = lane.index; i < (i32)lanes.gameList->size(); i += THREAD_COUNT) {
+				TickGame(&(*lanes.gameList)[i]);
+			}
+			lanes.pendingCount.Decrement();
+		}
+		return 0;
+	}
+
+	void Init(eastl::vector<Game>* gameList_)
+	{
+		gameList = gameList_;
+		for(int l = 0; l < THREAD_COUNT; l++) {
+			laneList[l].lanes = this;
+			laneList[l].index = l;
+			laneList[l].thread.Begin(ThreadLane, &laneList[l]);
+		}
+	}
+
+	void Tick()
+	{
+		pendingCount.SetValue(THREAD_COUNT);
+		for(int l = 0; l < THREAD_COUNT; l++) {
+			laneList[l].tickSignal.Post(1);
+		}
+		while(pendingCount.GetValue() > 0) {
+			EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+		}
+	}
+
+	void Cleanup()
+	{
+		running = false;
+		for(int l = 0; l < THREAD_COUNT; l++) {
+			laneList[l].tickSignal.Post(1);
+			laneList[l].thread.WaitForEnd();
+		}
+	}
+};
+
+struct Stealing
+{
+	eastl::vector<Game>* gameList;
+	TaskScheduler scheduler;
+
+	void Init(eastl::vector<Game>* gameList_)
+	{
+		gameList = gameList_;
+		scheduler.Init(THREAD_COUNT - 1, 0); // the thread waiting on the batch runs tasks as well
+	}
+
+	void Tick()
+	{
+		TaskScheduler::Batch batch;
+		eastl::vector<Game>& games = *gameList;
+		foreach(g, games) {
+			scheduler.Submit(&batch, [](void* object, void*) { TickGame((Game*)object); }, g, nullptr, &g->affinity);
+		}
+		scheduler.Wait(&batch);
+	}
+
+	void Cleanup()
+	{
+		scheduler.Cleanup();
+	}
+};
+
+template<typename Runner>
+static bool RunTicks(const char* name, f64 heavyMs, f64* outP99)
+{
+	eastl::vector<Game> gameList;
+	MakeGames(&gameList, heavyMs);
+
+	Runner* runner = new Runner();
+	defer(delete runner);
+	runner->Init(&gameList);
+
+	BenchSamples samples;
+	for(int t = 0; t < TICK_COUNT; t++) {
+		const Time t0 = TimeNow();
+		runner->Tick();
+		samples.Push(TimeDurationSinceMs(t0));
+	}
+	runner->Cleanup();
+
+	f64 workMs = 0;
+	i32 sameThreadCount = 0;
+	foreach_const(g, gameList) {
+		CHECK(g->tickCount == TICK_COUNT); // every game once per tick
+		workMs += g->costMs;
+		sameThreadCount += g->sameThreadCount;
+	}
+
+	LOG("    %s: work %.1fms per tick (%.1fms on %d threads at best), ticked on the same thread as last tick %.0f%%",
+		name, workMs, workMs / THREAD_COUNT, THREAD_COUNT, 100.0 * sameThreadCount / (gameList.size() * (TICK_COUNT - 1)));
+	samples.Print(FMT("%s tick", name));
+	*outP99 = samples.Percentile(99);
+	return true;
+}
+
+BENCH(scheduler, "40 games with 4 heavy ones, static lanes against work stealing on tick p99")
+{
+	LOG("    %d cores", EA::Thread::GetProcessorCount());
+
+	// even load: stealing should keep games on their thread
+	f64 staticP99, stealingP99;
+	if(!RunTicks<StaticLanes>("even static", 0.25, &staticP99)) return false;
+	if(!RunTicks<Stealing>("even stealing", 0.25, &stealingP99)) return false;
+
+	// skewed: lane 0 has 4 heavy games and 6 light ones, the others 10 light ones
+	if(!RunTicks<StaticLanes>("skewed static", 4.0, &staticP99)) return false;
+	if(!RunTicks<Stealing>("skewed stealing", 4.0, &stealingP99)) return false;
+	CHECK(stealingP99 < staticP99);
+	return true;
+}
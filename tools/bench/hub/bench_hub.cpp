@@ -0,0 +1,230 @@
+#include "bench.h"
+#include <common/utils.h>
+#include <common/task_scheduler.h>
+#include <replication.h>
+#include <config.h>
+#include <eathread/eathread_thread.h>
+
+// One crowded hub instance: 1000 player actors, replicated to as many clients as the server holds (MAX_CLIENTS).
+// Clients are registered in a Server that never runs, what a frame sends them is hashed then dropped.
+// Per client output has to be the same whatever the worker count is.
+
+static const i32 ACTOR_COUNT = 1000;
+static const i32 OBSERVER_COUNT = MAX_CLIENTS;
+static const i32 NPC_COUNT = 50;
+static const i32 FRAME_COUNT = 60;
+static const i32 MOVING_EVERY = 10; // one actor out of 10 moves each frame
+static const i32 CHURN_EVERY = 20; // frames, 20 actors without a client leave and 20 new ones join
+static const i32 OBSERVERS_PER_TASK = 32;
+
+static const ClassType g_Classes[] = {
+	ClassType::STRIKER,
+	ClassType::ARTILLERY,
+	ClassType::ASSASSIN,
+	ClassType::ELECTRO,
+	ClassType::DEFENDER,
+	ClassType::SNIPER,
+	ClassType::LAUNCHER,
+};
+
+static ClientHandle BenchClient(i32 clientID) { return (ClientHandle)(clientID + 1); }
+
+// actors 0..OBSERVER_COUNT-1 are the clients, the others are replaced over time
+static ActorUID BenchActorUID(i32 actor, i32 frame)
+{
+	if(actor < OBSERVER_COUNT) return ActorUID(actor + 1);
+	const i32 generation = (actor % CHURN_EVERY == 0) ? frame / CHURN_EVERY : 0;
+	return ActorUID(10000 + generation * ACTOR_COUNT + actor);
+}
+
+static void PushFrame(HubReplication* rep, i32 frame)
+{
+	const f32 t = (f32)frame;
+
+	HubReplication::ActorPlayer actor;
+	actor.docID = CreatureIndex(100000001);
+	actor.parentActorUID = ActorUID::INVALID;
+	actor.skinIndex = SkinIndex::DEFAULT;
+	actor.name = L"Bench";
+	actor.guildTag = L"Bench";
+	actor.weaponID = 0;
+	actor.additionnalOverHeatGauge = 0;
+	actor.additionnalOverHeatGaugeRatio = 0;
+	actor.playerStateInTown = 0;
+	actor.actionParam1 = -1;
+	actor.actionParam2 = -1;
+
+	for(int a = 0; a < ACTOR_COUNT; a++) {
+		const bool moving = (a + frame) % MOVING_EVERY == 0;
+		const f32 phase = moving ? t : 0;
+
+		actor.actorUID = BenchActorUID(a, frame);
+		actor.classType = g_Classes[a % ARRAY_COUNT(g_Classes)];
+		actor.pos = vec3((a % 40) * 100 + cosf(phase * 0.1f) * 50, (a / 40) * 100 + sinf(phase * 0.1f) * 50, 0);
+		actor.dir = vec3(1, 0, 0);
+		actor.eye = vec3(0, 0, 0);
+		actor.rotate = phase * 0.05f;
+		actor.upperRotate = 0;
+		actor.speed = moving ? 620 : 0;
+		actor.actionState = (a % 50 == frame % 50) ? ActionStateID::EMOTION_BEHAVIORSTATE : ActionStateID::INVALID;
+		rep->FramePushPlayerActor(actor);
+	}
+
+	for(int n = 0; n < NPC_COUNT; n++) {
+		HubReplication::ActorNpc npc;
+		npc.actorUID = ActorUID(5000 + n);
+		npc.docID = CreatureIndex(110042401);
+		npc.pos = vec3(n * 100, -500, 0);
+		npc.dir = vec3(0, 1, 0);
+		npc.type = 1;
+		npc.localID = n;
+		npc.faction = 2;
+		rep->FramePushNpcActor(npc);
+	}
+}
+
+// FNV-1a over what a client was sent, actor spawns carry the server time: only their size counts
+static u64 HashStream(u64 h, const u8* data, i32 size)
+{
+	auto hashBytes = [](u64 h, const void* p, i32 len) {
+		for(int i = 0; i < len; i++) {
+			h = (h ^ ((const u8*)p)[i]) * 1099511628211ull;
+		}
+		return h;
+	};
+
+	ConstBuffer buff(data, size);
+	while(buff.CanRead(sizeof(NetHeader))) {
+		const NetHeader& header = buff.Read<NetHeader>();
+		const i32 payloadSize = header.size - sizeof(NetHeader);
+		const u8* payload = buff.ReadRaw(payloadSize);
+
+		h = hashBytes(h, &header, sizeof(header));
+		if(header.netID != Sv::SN_GameCreateActor::NET_ID) {
+			h = hashBytes(h, payload, payloadSize);
+		}
+	}
+	return h;
+}
+
+struct RunResult
+{
+	eastl::array<u64,OBSERVER_COUNT> streamHash;
+	i64 packetCount = 0;
+	i64 bytes = 0;
+	f64 spawnFrameMs = 0;
+	BenchSamples frameMs;
+};
+
+// workerCount = 0: observers replicated inline by FrameEnd
+static bool RunFrames(i32 workerCount, RunResult* out)
+{
+	Server* server = new Server();
+	defer(delete server);
+	server->running = true;
+	server->sendCoalesceThreshold = 1 << 30;
+	server->sendDisconnectThreshold = 1 << 30;
+	server->clientSocket.fill(INVALID_SOCKET);
+
+	TaskScheduler* scheduler = new TaskScheduler();
+	defer(delete scheduler);
+	CHECK(scheduler->Init(workerCount, 0));
+	defer(scheduler->Cleanup());
+
+	ClientLocalMapping* plidMap = new ClientLocalMapping();
+	defer(delete plidMap);
+
+	HubReplication* rep = new HubReplication();
+	defer(delete rep);
+	rep->Init(server, BenchContent());
+	rep->plidMap = plidMap;
+	rep->scheduler = scheduler;
+
+	for(int c = 0; c < OBSERVER_COUNT; c++) {
+		const ClientHandle clientHd = BenchClient(c);
+		server->clientSocket[c] = (SOCKET)1; // never used, the server doesn't run
+		server->clientNet[c].pendingSendBuff.Init(256 * 1024);
+		server->clientHandle2IDMap[clientHd] = c;
+		server->clientID2HandleMap[c] = clientHd;
+		out->streamHash[c] = 14695981039346656037ull;
+
+		plidMap->Push(clientHd);
+		rep->OnPlayerConnect(clientHd);
+		rep->PlayerRegisterMasterActor(clientHd, BenchActorUID(c, 0), g_Classes[c % ARRAY_COUNT(g_Classes)]);
+		rep->SetPlayerAsInGame(clientHd);
+	}
+
+	for(int frame = 0; frame < FRAME_COUNT; frame++) {
+		PushFrame(rep, frame);
+
+		const Time t0 = TimeNow();
+		rep->FrameEnd();
+		const f64 ms = TimeDurationSinceMs(t0);
+		if(frame == 0) {
+			out->spawnFrameMs = ms;
+		}
+		else {
+			out->frameMs.Push(ms);
+		}
+
+		// sent, as far as the replication is concerned
+		for(int c = 0; c < OBSERVER_COUNT; c++) {
+			Server::ClientNet& client = server->clientNet[c];
+			out->streamHash[c] = HashStream(out->streamHash[c], client.pendingSendBuff.data, client.pendingSendBuff.size);
+			out->packetCount += client.pendingSendPackets;
+			out->bytes += client.pendingSendBuff.size;
+			client.pendingSendBuff.size = 0;
+			client.pendingSendPackets = 0;
+		}
+	}
+	return true;
+}
+
+BENCH(hub_replication, "1000 players in one hub instance, observers replicated inline then on 1/2/4/8 workers: frame time, same packets per client")
+{
+	LoadConfig(); // hub.cfg when there is one, the defaults otherwise
+	CConfigHub& config = ConfigMutable();
+	const CConfigHub configSaved = config;
+	defer(ConfigMutable() = configSaved);
+	config.ReplicationTaskObservers = OBSERVERS_PER_TASK;
+
+	LOG("    %d cores, %d player actors and %d npcs, %d observers in tasks of %d, 1 actor out of %d moving",
+		EA::Thread::GetProcessorCount(), ACTOR_COUNT, NPC_COUNT, OBSERVER_COUNT, OBSERVERS_PER_TASK, MOVING_EVERY);
+
+	RunResult* serial = new RunResult();
+	defer(delete serial);
+	if(!RunFrames(0, serial)) return false;
+	LOG("    %lld packets, %lld bytes per run", (long long)serial->packetCount, (long long)serial->bytes);
+	LOG("    inline: spawn frame %.2fms", serial->spawnFrameMs);
+	serial->frameMs.Print("inline frame");
+	const f64 serialP50 = serial->frameMs.Percentile(50);
+
+	const i32 workerCounts[] = { 1, 2, 4, 8 };
+	for(int w = 0; w < (i32)ARRAY_COUNT(workerCounts); w++) {
+		RunResult* run = new RunResult();
+		defer(delete run);
+		if(!RunFrames(workerCounts[w], run)) return false;
+
+		LOG("    %d workers: spawn frame %.2fms", workerCounts[w], run->spawnFrameMs);
+		run->frameMs.Print(FMT("%d workers frame", workerCounts[w]));
+
+		CHECK(run->packetCount == serial->packetCount);
+		for(int c = 0; c < OBSERVER_COUNT; c++) {
+			if(run->streamHash[c] != serial->streamHash[c]) {
+				LOG("    client %d was sent something else with %d workers", c, workerCounts[w]);
+				return false;
+			}
+		}
+
+		// the waiting thread replicates as well: 4 workers spread the observers on 5 threads
+		if(workerCounts[w] == 4) {
+			if(EA::Thread::GetProcessorCount() >= 4) {
+				CHECK(run->frameMs.Percentile(50) < serialP50);
+			}
+			else {
+				LOG("    %d cores, scaling not checked", EA::Thread::GetProcessorCount());
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,281 @@
+#include "bench.h"
+#include <common/utils.h>
+#include <common/input_coalescer.h>
+#include <mxm/game_content.h>
+#include <instance.h>
+#include <account.h>
+#include <config.h>
+
+// The lane input stage of one hub instance: received chunks are coalesced (or not) then handled, like Lane::Update does.
+// Clients send CN_UpdatePosition at 60Hz, what a lane tick receives of it depends on the network and on the lane itself.
+// There are no sockets: the server doesn't know the clients, what the game sends them is dropped.
+
+static const i32 CLIENT_COUNT = 200;
+static const i32 TICK_COUNT = 600; // 10s at 60Hz
+static const i32 ACTION_EVERY = 20; // inputs, a CN_GamePlayerSyncActionStateOnly (not coalesced) follows
+
+enum class Arrival
+{
+	STEADY, // one input per tick
+	JITTER, // each input is 0 to 2 ticks late, in order
+	HITCH, // the lane misses 6 ticks every second, then handles it all at once
+};
+
+struct InputBench
+{
+	Server* server;
+	HubInstance* instance;
+	InputCoalescer coalescer;
+	GrowableBuffer recvDataBuff;
+
+	eastl::array<GrowableBuffer,CLIENT_COUNT> clientPending; // sent, not received by the lane yet
+	eastl::array<eastl::fixed_vector<eastl::pair<i32,i32>,8,true>,CLIENT_COUNT> inFlight; // (arrival tick, size) in clientPending
+	eastl::array<u32,CLIENT_COUNT> rng;
+	eastl::array<i32,CLIENT_COUNT> lastArrival;
+
+	i64 handledCount = 0;
+};
+
+static ClientHandle BenchClient(i32 c) { return (ClientHandle)(1000 + c); }
+static AccountUID BenchAccount(i32 c) { return AccountUID(5000 + c); }
+
+static u32 XorShift(u32* state)
+{
+	u32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static LocalActorID LeaderLocalActorID(i32 c)
+{
+	return (LocalActorID)((u32)LocalActorID::FIRST_SELF_MASTER + (i32)ClassType::STRIKER + (c % 7));
+}
+
+template<typename Packet>
+static void AppendPacket(GrowableBuffer* buff, const Packet& packet)
+{
+	NetHeader header;
+	header.size = sizeof(NetHeader) + sizeof(Packet);
+	header.netID = Packet::NET_ID;
+	buff->Append(&header, sizeof(header));
+	buff->Append(&packet, sizeof(packet));
+}
+
+// same as Lane::Update
+static void HandleInputs(InputBench* b, bool coalesce)
+{
+	ConstBuffer buff(b->recvDataBuff.data, b->recvDataBuff.size);
+	while(buff.CanRead(sizeof(Server::RecvChunkHeader))) {
+		const Server::RecvChunkHeader& chunkInfo = buff.Read<Server::RecvChunkHeader>();
+		u8* data = (u8*)buff.ReadRaw(chunkInfo.len);
+
+		const i32 len = coalesce ? b->coalescer.Coalesce(data, chunkInfo.len) : chunkInfo.len;
+		ConstBuffer reader(data, len);
+		while(reader.CanRead(sizeof(NetHeader))) {
+			const NetHeader& header = reader.Read<NetHeader>();
+			const u8* packetData = reader.ReadRaw(header.size - sizeof(NetHeader));
+			b->instance->OnClientPacket(chunkInfo.clientHd, header, packetData);
+			b->handledCount++;
+		}
+	}
+	b->recvDataBuff.Clear();
+}
+
+// what arrived by that tick, one chunk per client
+static void Receive(InputBench* b, i32 tick)
+{
+	for(int c = 0; c < CLIENT_COUNT; c++) {
+		i32 len = 0;
+		i32 count = 0;
+		foreach_const(f, b->inFlight[c]) {
+			if(f->first > tick) break;
+			len += f->second;
+			count++;
+		}
+		if(len == 0) continue;
+
+		Server::RecvChunkHeader chunk{ BenchClient(c), len };
+		b->recvDataBuff.Append(&chunk, sizeof(chunk));
+		b->recvDataBuff.Append(b->clientPending[c].data, len);
+
+		GrowableBuffer& pending = b->clientPending[c];
+		memmove(pending.data, pending.data + len, pending.size - len);
+		pending.size -= len;
+		b->inFlight[c].erase(b->inFlight[c].begin(), b->inFlight[c].begin() + count);
+	}
+}
+
+struct RunResult
+{
+	BenchSamples tickUs;
+	i64 sentCount = 0;
+	i64 handledCount = 0;
+	i64 coalescedCount = 0;
+	eastl::array<vec3,CLIENT_COUNT> finalPos;
+	eastl::array<ActionStateID,CLIENT_COUNT> finalAction;
+};
+
+static bool RunInputs(Arrival arrival, bool coalesce, RunResult* out)
+{
+	InputBench* b = new InputBench();
+	defer(delete b);
+
+	b->server = new Server();
+	defer(delete b->server);
+	b->instance = new HubInstance((HubInstanceUID)1);
+	defer(delete b->instance);
+	CHECK(b->instance->Init(b->server, nullptr));
+	b->coalescer.AddInputType(Cl::CN_UpdatePosition::NET_ID);
+	b->recvDataBuff.Init(1024 * 1024);
+
+	eastl::fixed_vector<HubInstance::NewUser,CLIENT_COUNT,false> newUsers;
+	for(int c = 0; c < CLIENT_COUNT; c++) {
+		newUsers.push_back(HubInstance::NewUser{ BenchClient(c), BenchAccount(c) });
+		b->clientPending[c].Init(4096);
+		b->rng[c] = 0x9E3779B9u * (c + 1);
+		b->lastArrival[c] = 0;
+	}
+	b->instance->OnClientsConnected(newUsers.data(), newUsers.size());
+
+	// each client picks a leader, which spawns its actor
+	for(int c = 0; c < CLIENT_COUNT; c++) {
+		Cl::CQ_SetLeaderCharacter leader;
+		leader.characterID = LeaderLocalActorID(c);
+		leader.skinIndex = SkinIndex::DEFAULT;
+		AppendPacket(&b->clientPending[c], leader);
+		Server::RecvChunkHeader chunk{ BenchClient(c), b->clientPending[c].size };
+		b->recvDataBuff.Append(&chunk, sizeof(chunk));
+		b->recvDataBuff.Append(b->clientPending[c].data, b->clientPending[c].size);
+		b->clientPending[c].Clear();
+	}
+	HandleInputs(b, false);
+	b->handledCount = 0;
+
+	i32 nextLaneTick = 0;
+	for(int tick = 0; tick < TICK_COUNT; tick++) {
+		// clients send one input per tick
+		for(int c = 0; c < CLIENT_COUNT; c++) {
+			const i32 before = b->clientPending[c].size;
+			const f32 t = (f32)tick / UPDATE_TICK_RATE + c;
+
+			Cl::CN_UpdatePosition update;
+			update.characterID = LeaderLocalActorID(c);
+			update.p3nPos = v2f(vec3(cosf(t) * 500, sinf(t) * 500, 0));
+			update.p3nDir = v2f(vec3(-sinf(t), cosf(t), 0));
+			update.p3nEye = v2f(vec3(0, 0, 0));
+			update.nRotate = t;
+			update.nSpeed = 620;
+			update.nState = ActionStateID::INVALID;
+			update.nActionIDX = -1;
+			AppendPacket(&b->clientPending[c], update);
+			out->sentCount++;
+
+			if(tick % ACTION_EVERY == c % ACTION_EVERY) {
+				Cl::CN_GamePlayerSyncActionStateOnly action;
+				memset(&action, 0, sizeof(action));
+				action.characterID = LeaderLocalActorID(c);
+				action.state = (ActionStateID)(tick % 7);
+				action.bApply = 1;
+				action.rotate = t;
+				AppendPacket(&b->clientPending[c], action);
+				out->sentCount++;
+			}
+
+			i32 arrivalTick = tick;
+			if(arrival == Arrival::JITTER) {
+				arrivalTick = MAX(b->lastArrival[c], tick + (i32)(XorShift(&b->rng[c]) % 3));
+			}
+			b->lastArrival[c] = arrivalTick;
+			b->inFlight[c].push_back({ arrivalTick, b->clientPending[c].size - before });
+		}
+
+		if(tick < nextLaneTick) continue; // the lane is late
+
+		Receive(b, tick);
+
+		const Time t0 = TimeNow();
+		HandleInputs(b, coalesce);
+		out->tickUs.Push(TimeDurationSinceMs(t0) * 1000.0);
+
+		nextLaneTick = tick + 1;
+		if(arrival == Arrival::HITCH && tick % UPDATE_TICK_RATE == 0) {
+			nextLaneTick = tick + 7;
+		}
+	}
+
+	// the lane gets what is still on the way
+	Receive(b, TICK_COUNT + 2);
+	HandleInputs(b, coalesce);
+
+	out->handledCount = b->handledCount;
+	out->coalescedCount = b->coalescer.coalescedCount;
+
+	HubGame& game = b->instance->game;
+	for(int c = 0; c < CLIENT_COUNT; c++) {
+		const i32 userID = b->instance->plidMap.Get(BenchClient(c));
+		const WorldHub::ActorPlayer* actor = game.world.FindPlayerActor(game.playerActorUID[userID]);
+		CHECK(actor);
+		out->finalPos[c] = actor->pos;
+		out->finalAction[c] = actor->actionState;
+	}
+	return true;
+}
+
+static bool CompareArrival(Arrival arrival, const char* name)
+{
+	RunResult* plain = new RunResult();
+	defer(delete plain);
+	RunResult* coalesced = new RunResult();
+	defer(delete coalesced);
+
+	if(!RunInputs(arrival, false, plain)) return false;
+	if(!RunInputs(arrival, true, coalesced)) return false;
+
+	LOG("    %s: lane input stage per tick, %lld packets sent, %lld handled as is, %lld handled coalesced (%lld dropped)", name,
+		(long long)plain->sentCount, (long long)plain->handledCount, (long long)coalesced->handledCount, (long long)coalesced->coalescedCount);
+	plain->tickUs.Print(FMT("%s as is", name), "us");
+	coalesced->tickUs.Print(FMT("%s coalesced", name), "us");
+
+	// same actors in the end
+	CHECK(plain->handledCount == plain->sentCount);
+	CHECK(coalesced->handledCount + coalesced->coalescedCount == coalesced->sentCount);
+	for(int c = 0; c < CLIENT_COUNT; c++) {
+		CHECK(plain->finalPos[c] == coalesced->finalPos[c]);
+		CHECK(plain->finalAction[c] == coalesced->finalAction[c]);
+	}
+
+	if(arrival == Arrival::STEADY) {
+		CHECK(coalesced->coalescedCount == 0);
+	}
+	else {
+		CHECK(coalesced->coalescedCount > 0);
+		CHECK(coalesced->tickUs.Mean() < plain->tickUs.Mean());
+	}
+	return true;
+}
+
+BENCH(input_coalescing, "200 hub clients sending moves at 60Hz, lane input stage with and without coalescing: steady, jittered, lane hitches")
+{
+	CHECK(BenchContent());
+	LoadConfig(); // hub.cfg when there is one, the defaults otherwise
+
+	AccountManager& am = GetAccountManager();
+	for(int c = 0; c < CLIENT_COUNT; c++) {
+		if(am.accountMap.find(BenchAccount(c)) != am.accountMap.end()) continue;
+		am.accountList.emplace_back(BenchAccount(c));
+		am.accountMap.emplace(BenchAccount(c), --am.accountList.end());
+		Account& account = am.accountList.back();
+		account.nickname = L"Bench";
+		account.guildTag = L"Bench";
+		account.leaderMasterID = 0;
+		account.rating = 1000;
+	}
+
+	if(!CompareArrival(Arrival::STEADY, "steady")) return false;
+	if(!CompareArrival(Arrival::JITTER, "jitter")) return false;
+	if(!CompareArrival(Arrival::HITCH, "hitch")) return false;
+	return true;
+}
@@ -0,0 +1,126 @@
+#include "bench_play.h"
+#include <common/utils.h>
+#include <mxm/game_content.h>
+#include <game.h>
+#include <eathread/eathread_thread.h>
+
+// Map collision files are found from the map list (GameXmlContent::LoadMapCollisionList), the physics loader thread
+// loads them the first time a game needs them and keeps them cached until the cache is over budget.
+
+BENCH(map_collision_files, "collision files of the map list levels found in gamedata: deathmatch meshes and preloaded props")
+{
+	CHECK(BenchContent());
+	const GameXmlContent& content = *BenchContent();
+
+	// the deathmatch level meshes, and the wall prop its PreLoad.xml lists (the start gate has no collision)
+	const GameXmlContent::MapCollisionFiles* deathmatch = content.FindMapCollision(MapIndex::PVP_DEATHMATCH);
+	CHECK(deathmatch);
+	const char* expected[] = { "PVP_DeathMatch01_Collision", "PVP_DeathMatch01_Env", "PvP_Death_NM_Wall04" };
+	CHECK(deathmatch->files.size() == ARRAY_COUNT(expected));
+	for(int i = 0; i < (i32)ARRAY_COUNT(expected); i++) {
+		CHECK(deathmatch->files[i] == expected[i]);
+	}
+
+	// PVP_DeathMatch_bush shares the prefix but not the files, the lobby has no collision
+	CHECK(content.FindMapCollision((MapIndex)160000098) == nullptr);
+	CHECK(content.FindMapCollision((MapIndex)160000042) == nullptr);
+
+	LOG("    %d map list entries, %d levels with collision", (i32)content.maplists.size(), (i32)content.mapCollisionList.size());
+	foreach_const(it, content.mapCollisionList) {
+		LOG("    %s: %d files", it->level.data(), (i32)it->files.size());
+	}
+	return true;
+}
+
+static bool WaitMapLoaded(const PhysicsContext::MapCollision& collision)
+{
+	while(collision.GetLoadState() == PhysicsContext::MapCollision::LoadState::LOADING) {
+		EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+	}
+	return collision.GetLoadState() == PhysicsContext::MapCollision::LoadState::LOADED;
+}
+
+static i32 MeshCacheBytes()
+{
+	PhysicsContext& phys = PhysContext();
+	LOCK_MUTEX(phys.mutexMeshCache);
+	return phys.meshCacheBytes;
+}
+
+// unused files are evicted by the loader thread after a release
+static bool WaitEvicted()
+{
+	const Time t0 = TimeNow();
+	while(MeshCacheBytes() > PhysContext().meshCacheBudget) {
+		if(TimeDurationSinceMs(t0) > 5000) return false;
+		EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+	}
+	return true;
+}
+
+// First game on a map waits for the loader, the next ones find the files cached.
+// A cache without budget drops every file no game uses.
+BENCH(map_collision_cache, "deathmatch collision acquired cold (loaded by the loader thread) then cached, eviction without budget")
+{
+	CHECK(BenchPhysicsInit());
+	const GameXmlContent& content = *BenchContent();
+	PhysicsContext& phys = PhysContext();
+
+	const i32 budgetSaved = phys.meshCacheBudget;
+	defer(phys.meshCacheBudget = budgetSaved);
+
+	const i32 RUN_COUNT = 10;
+	BenchSamples cold;
+	BenchSamples warm;
+	i32 loadedBytes = 0;
+
+	// cold: nothing is kept between games, not even what the other benches left
+	phys.meshCacheBudget = 0;
+	phys.loaderSemaphore.Post(1);
+	for(int i = 0; i < RUN_COUNT; i++) {
+		CHECK(WaitEvicted());
+		CHECK(MeshCacheBytes() == 0);
+
+		PhysicsContext::MapCollision collision;
+		const Time t0 = TimeNow();
+		CHECK(phys.AcquireMapCollision(content, MapIndex::PVP_DEATHMATCH, &collision));
+		CHECK(WaitMapLoaded(collision));
+		cold.Push(TimeDurationSinceMs(t0));
+		loadedBytes = MeshCacheBytes();
+
+		// the game builds its scene from it
+		PhysicsScene* scene = new PhysicsScene();
+		defer(delete scene);
+		phys.CreateScene(scene);
+		CHECK(Game::CreateMapColliders(scene));
+		scene->Destroy();
+
+		phys.ReleaseMapCollision(&collision);
+	}
+	CHECK(WaitEvicted());
+	CHECK(MeshCacheBytes() == 0);
+
+	// warm: the first game loads, the files stay cached for the next ones
+	phys.meshCacheBudget = 64 * 1024 * 1024;
+	{
+		PhysicsContext::MapCollision collision;
+		CHECK(phys.AcquireMapCollision(content, MapIndex::PVP_DEATHMATCH, &collision));
+		CHECK(WaitMapLoaded(collision));
+		phys.ReleaseMapCollision(&collision);
+	}
+	for(int i = 0; i < RUN_COUNT; i++) {
+		PhysicsContext::MapCollision collision;
+		const Time t0 = TimeNow();
+		CHECK(phys.AcquireMapCollision(content, MapIndex::PVP_DEATHMATCH, &collision));
+		CHECK(collision.GetLoadState() == PhysicsContext::MapCollision::LoadState::LOADED); // nothing queued
+		warm.Push(TimeDurationSinceMs(t0));
+		phys.ReleaseMapCollision(&collision);
+	}
+	CHECK(MeshCacheBytes() == loadedBytes);
+
+	LOG("    deathmatch collision: %d files, %dKB cooked", (i32)content.FindMapCollision(MapIndex::PVP_DEATHMATCH)->files.size(), loadedBytes / 1024);
+	cold.Print("cold acquire to loaded", "ms");
+	warm.Print("cached acquire", "ms");
+	CHECK(warm.Percentile(50) < cold.Percentile(50));
+	return true;
+}
@@ -0,0 +1,213 @@
+#include "bench_play.h"
+#include <common/utils.h>
+#include <mxm/game_content.h>
+#include <coordinator.h>
+#include <config.h>
+#include <eathread/eathread_thread.h>
+
+// InstancePool with 2 lanes and real games, the bench thread plays the coordinator.
+// There are no sockets: clients are handles the server doesn't know, what the games send them is dropped.
+
+static const ClassType g_MasterPicks[] = {
+	ClassType::STRIKER,
+	ClassType::ARTILLERY,
+	ClassType::ASSASSIN,
+	ClassType::ELECTRO,
+	ClassType::DEFENDER,
+	ClassType::SNIPER,
+	ClassType::LAUNCHER,
+};
+
+// one human (accountUID = sortieUID) and the rest bots
+static In::MQ_CreateGame MakeGame(const GameXmlContent& content, SortieUID sortieUID, u8 playerCount)
+{
+	In::MQ_CreateGame game;
+	memset(&game, 0, sizeof(game));
+	game.sortieUID = sortieUID;
+	game.mapIndex = MapIndex::PVP_DEATHMATCH;
+	game.playerCount = playerCount;
+	game.spectatorCount = 0;
+
+	for(int i = 0; i < playerCount; i++) {
+		auto& p = game.players[i];
+		p.name.Copy(WideString(LFMT(L"Bench%d", i)));
+		p.accountUID = i == 0 ? AccountUID((u32)sortieUID) : AccountUID::INVALID;
+		p.team = i & 1;
+		p.isBot = i != 0;
+		p.skins.fill(SkinIndex::DEFAULT);
+
+		for(int m = 0; m < 2; m++) {
+			const ClassType classType = g_MasterPicks[(i * 2 + m) % ARRAY_COUNT(g_MasterPicks)];
+			const GameXmlContent::Master& master = *content.masterClassTypeMap.at(classType);
+			p.masters[m] = classType;
+			p.skills[m * 2] = master.skillIDs[0];
+			p.skills[m * 2 + 1] = master.skillIDs[1];
+		}
+	}
+	return game;
+}
+
+struct LaneBench
+{
+	Server server;
+	InstancePool pool;
+	Time localTime = Time::ZERO;
+	Time startTime;
+	i32 endedWhileMigrating = 0;
+
+	// runs the coordinator for that long, onTick is called after each InstancePool::Update
+	template<typename Callback>
+	void Run(f64 sec, Callback onTick)
+	{
+		const f64 UPDATE_RATE_MS = (1.0/120.0) * 1000.0;
+		const Time t0 = TimeNow();
+		while(TimeDiffSec(TimeDiff(t0, TimeNow())) < sec) {
+			eastl::fixed_vector<SortieUID,4,false> migrating;
+			foreach_const(m, pool.migrationList) {
+				migrating.push_back(m->sortieUID);
+			}
+
+			localTime = TimeDiff(startTime, TimeNow());
+			pool.Update(localTime);
+
+			foreach_const(s, migrating) {
+				if(!pool.IsGameRunning(*s)) endedWhileMigrating++;
+			}
+
+			if(!onTick()) break;
+			EA::Thread::ThreadSleep((EA::Thread::ThreadTime)UPDATE_RATE_MS);
+		}
+	}
+
+	void Run(f64 sec) { Run(sec, []() { return true; }); }
+
+	// both lanes published a load window since
+	void WaitLoadWindows() { Run(2.5 * InstancePool::Lane::LOAD_WINDOW * UPDATE_RATE); }
+};
+
+// Lane 0 gets the 2 heavy games (10 players), lane 1 the 2 light ones (1 player).
+// The tick budget is put under the lane 0 p99: one heavy game has to move to lane 1 and both lanes end under budget.
+// The human of the moving game reconnects during the migration, then every game ends while migrations keep being requested:
+// no client entry may be left on a lane.
+BENCH(lane_balance, "an over budget lane gives a game to the other one, tick p99 before and after, held clients during migrations")
+{
+	CHECK(BenchPhysicsInit());
+	const GameXmlContent& content = *BenchContent();
+
+	LoadConfig(); // game.cfg when there is one, the defaults otherwise
+	CConfigGame& config = ConfigMutable();
+	const CConfigGame configSaved = config;
+	defer(ConfigMutable() = configSaved);
+	config.Lanes = 2;
+	config.InstanceWorkers = 0;
+	config.WarmInstancesPerMap = 0;
+	config.MaxGamesPerLane = 16;
+	config.LaneTickBudgetMs = 1000; // no balancing until both lanes are measured
+	config.DevMode = false;
+	config.LaneAllocCheck = 0;
+
+	LaneBench* lb = new LaneBench();
+	defer(delete lb);
+	lb->server.running = true;
+	lb->startTime = TimeNow();
+	CHECK(lb->pool.Init(&lb->server));
+	defer(lb->pool.Cleanup());
+	defer(lb->server.running = false); // lanes stop before the pool cleanup waits on them
+
+	InstancePool& pool = lb->pool;
+	const i32 GAME_COUNT = 4;
+	eastl::array<ClientHandle,GAME_COUNT + 1> humans; // by sortieUID
+	u32 nextClientHd = 100;
+
+	// placement alternates the lanes when they have as many games: odd sortieUIDs on lane 0
+	for(int i = 1; i <= GAME_COUNT; i++) {
+		const SortieUID sortieUID = (SortieUID)i;
+		pool.QueueCreateGame(MakeGame(content, sortieUID, (i & 1) ? 10 : 1));
+		humans[i] = (ClientHandle)nextClientHd++;
+		CHECK(pool.QueuePushPlayerToGame(humans[i], AccountUID((u32)sortieUID), sortieUID));
+	}
+
+	lb->WaitLoadWindows();
+	CHECK(pool.lanes[0].gameCount.GetValue() == 2 && pool.lanes[1].gameCount.GetValue() == 2);
+	CHECK(pool.migrationList.empty());
+
+	const f32 heavyP99 = pool.lanes[0].GetLoadStats().tickP99Ms;
+	const f32 lightP99 = pool.lanes[1].GetLoadStats().tickP99Ms;
+	LOG("    before: Lane_0 p99=%.3fms (2 games of 10 players) Lane_1 p99=%.3fms (2 games of 1 player)", heavyP99, lightP99);
+	CHECK(heavyP99 > lightP99 * 4); // else one heavy game moving could put lane 1 over budget
+
+	// over budget by a quarter: one heavy game moving fits the room left on lane 1
+	config.LaneTickBudgetMs = heavyP99 * 0.75f;
+	LOG("    budget=%.3fms", config.LaneTickBudgetMs);
+
+	SortieUID migrated = SortieUID::INVALID;
+	ClientHandle cancelled = ClientHandle::INVALID;
+	lb->Run(10.0, [&]() {
+		if(migrated != SortieUID::INVALID || pool.migrationList.empty()) return true;
+
+		const InstancePool::Migration& m = pool.migrationList.front();
+		migrated = m.sortieUID;
+		LOG("    migrating sortieUID=%llu from Lane_%d to Lane_%d", migrated, m.fromLane, m.toLane);
+
+		// the human of the migrating game reconnects, then a client connects and leaves at once: all held
+		const ClientHandle old = humans[(i32)migrated];
+		humans[(i32)migrated] = (ClientHandle)nextClientHd++;
+		pool.QueuePopPlayers(&old, 1);
+		pool.QueuePushPlayerToGame(humans[(i32)migrated], AccountUID((u32)migrated), migrated);
+
+		cancelled = (ClientHandle)nextClientHd++;
+		pool.QueuePushPlayerToGame(cancelled, AccountUID((u32)migrated), migrated);
+		pool.QueuePopPlayers(&cancelled, 1);
+		return false;
+	});
+	CHECK(migrated != SortieUID::INVALID);
+	CHECK(((i32)migrated & 1) == 1); // a heavy one
+
+	// lets the migration finish and both lanes measure again
+	lb->WaitLoadWindows();
+	CHECK(pool.migrationList.empty());
+
+	const f32 budget = config.LaneTickBudgetMs;
+	const InstancePool::Lane::LoadStats after0 = pool.lanes[0].GetLoadStats();
+	const InstancePool::Lane::LoadStats after1 = pool.lanes[1].GetLoadStats();
+	LOG("    after: Lane_0 p99=%.3fms games=%d Lane_1 p99=%.3fms games=%d", after0.tickP99Ms, (i32)pool.lanes[0].gameCount.GetValue(), after1.tickP99Ms, (i32)pool.lanes[1].gameCount.GetValue());
+	CHECK(pool.lanes[0].gameCount.GetValue() == 1 && pool.lanes[1].gameCount.GetValue() == 3);
+
+	// lanes sharing a core preempt each other, their p99 says little then
+	if(EA::Thread::GetProcessorCount() > 2) {
+		CHECK(after0.tickP99Ms <= budget);
+		CHECK(after1.tickP99Ms <= budget);
+	}
+	else {
+		LOG("    %d cores for 2 lanes and the coordinator, p99 under budget not checked", EA::Thread::GetProcessorCount());
+	}
+
+	// one client per game, the reconnected human followed its game and the cancelled one never reached a lane
+	CHECK(pool.lanes[0].playerCount.GetValue() == 1 && pool.lanes[1].playerCount.GetValue() == 3);
+
+	// every human leaves, games end as soon as they are empty while being moved back and forth
+	config.LaneTickBudgetMs = 1000;
+	config.LingerSec = 0;
+	for(int i = 1; i <= GAME_COUNT; i++) {
+		pool.QueuePopPlayers(&humans[i], 1);
+	}
+
+	lb->Run(10.0, [&]() {
+		for(int i = 1; i <= GAME_COUNT; i++) {
+			auto found = pool.sortieLocation.find((SortieUID)i);
+			if(found == pool.sortieLocation.end()) continue;
+			pool.MigrateInstance((SortieUID)i, (u8)(1 - found->second));
+		}
+		return !pool.sortieLocation.empty();
+	});
+	lb->Run(0.1); // the lanes publish their counts every tick
+
+	LOG("    games ended while migrating: %d", lb->endedWhileMigrating);
+	CHECK(pool.sortieLocation.empty());
+	CHECK(pool.migrationList.empty());
+	for(int l = 0; l < 2; l++) {
+		CHECK(pool.lanes[l].gameCount.GetValue() == 0);
+		CHECK(pool.lanes[l].playerCount.GetValue() == 0);
+	}
+	return true;
+}
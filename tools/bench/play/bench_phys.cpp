@@ -0,0 +1,119 @@
+#include "bench_play.h"
+#include <common/utils.h>
+
+// corridor along Y, closed at the far end, floor at z=0
+static void PushCorridor(PhysWorld* phys, f32 halfWidth, f32 length, f32 wallHeight)
+{
+	const f32 w = halfWidth;
+	const f32 l = length;
+	const f32 h = wallHeight;
+
+	ShapeMesh mesh;
+	auto Quad = [&](const vec3& a, const vec3& b, const vec3& c, const vec3& d) {
+		// a b c d counter clockwise, seen from the side the normal points to
+		ShapeTriangle t0, t1;
+		t0.p = { a, b, c };
+		t1.p = { a, c, d };
+		mesh.triangleList.push_back(t0);
+		mesh.triangleList.push_back(t1);
+	};
+
+	Quad(vec3(-w, 0, 0), vec3(w, 0, 0), vec3(w, l, 0), vec3(-w, l, 0)); // floor
+	Quad(vec3(-w, 0, 0), vec3(-w, l, 0), vec3(-w, l, h), vec3(-w, 0, h)); // left wall, facing +X
+	Quad(vec3(w, 0, 0), vec3(w, 0, h), vec3(w, l, h), vec3(w, l, 0)); // right wall, facing -X
+	Quad(vec3(-w, l, 0), vec3(w, l, 0), vec3(w, l, h), vec3(-w, l, h)); // far end, facing -Y
+
+	phys->PushStaticMeshes(&mesh, 1);
+}
+
+// 500 mobs spawned at the start of a corridor all walk to its far end and pile up against it.
+// Mobs collide with each other (PhysWorld::ResolveBodyCollisions), walls and floor have the last word.
+// The same run done twice has to end on the exact same positions.
+BENCH(phys_corridor, "500 mob bodies crowding a corridor, PhysWorld step time")
+{
+	CHECK(BenchContent()); // physics tweakables
+
+	const i32 MOB_COUNT = 500;
+	const f32 HALF_WIDTH = 600;
+	const f32 LENGTH = 8000;
+	const f32 RADIUS = 40;
+	const f32 HEIGHT = 180;
+	const f32 SPEED = 600;
+	const i32 TICK_COUNT = 20 * UPDATE_TICK_RATE;
+
+	auto Run = [&](BenchSamples* samples, eastl::vector<vec3>* outPos, i32* outMaxPairs) {
+		PhysWorld* phys = new PhysWorld();
+		defer(delete phys);
+		PushCorridor(phys, HALF_WIDTH, LENGTH, 500);
+
+		eastl::vector<PhysWorld::BodyHandle> bodyList;
+		// rows at the start of the corridor, not touching each other nor the walls
+		const f32 spacing = RADIUS * 2.5f;
+		const i32 perRow = (i32)((HALF_WIDTH - RADIUS) * 2 / spacing);
+		for(int i = 0; i < MOB_COUNT; i++) {
+			const f32 jitter = (f32)((i * 7919) % 21 - 10); // same on every run
+			const f32 x = -HALF_WIDTH + spacing + (i % perRow) * spacing + jitter;
+			const f32 y = spacing + (i / perRow) * spacing;
+			bodyList.push_back(phys->CreateBody(RADIUS, HEIGHT, vec3(x, y, 1), COLGROUP_MOB, COLGROUP_MOB | COLGROUP_PLAYER));
+		}
+
+		*outMaxPairs = 0;
+		for(int t = 0; t < TICK_COUNT; t++) {
+			foreach(b, bodyList) {
+				(*b)->force = vec3(0, SPEED, 0);
+			}
+
+			const Time t0 = TimeNow();
+			phys->Step();
+			samples->Push(TimeDurationSinceMs(t0));
+			*outMaxPairs = MAX(*outMaxPairs, (i32)phys->bodyPairList.size());
+		}
+
+		outPos->clear();
+		foreach_const(b, bodyList) {
+			outPos->push_back((*b)->pos);
+		}
+	};
+
+	BenchSamples samples;
+	eastl::vector<vec3> posList;
+	i32 maxPairs;
+	Run(&samples, &posList, &maxPairs);
+
+	LOG("    %d mobs, %d ticks, broad phase pairs max=%d", MOB_COUNT, TICK_COUNT, maxPairs);
+	samples.Print("PhysWorld::Step");
+
+	// inside the corridor, on the floor
+	f32 minY = LENGTH;
+	foreach_const(p, posList) {
+		CHECK(fabsf(p->x) <= HALF_WIDTH - RADIUS + 1);
+		CHECK(p->y >= 0 && p->y <= LENGTH - RADIUS + 1);
+		CHECK(p->z > -1 && p->z < 1);
+		minY = MIN(minY, p->y);
+	}
+
+	// the crowd is packed against the far end
+	// pushed every tick, it ends up overlapping: the resolution steps only push bodies a few ranks back
+	f64 overlapSum = 0;
+	f32 overlapMax = 0;
+	i32 overlapCount = 0;
+	for(int i = 0; i < MOB_COUNT; i++) {
+		for(int j = i + 1; j < MOB_COUNT; j++) {
+			const f32 overlap = RADIUS * 2 - glm::distance(vec2(posList[i]), vec2(posList[j]));
+			if(overlap <= 0) continue;
+			overlapSum += overlap;
+			overlapMax = MAX(overlapMax, overlap);
+			overlapCount++;
+		}
+	}
+	LOG("    crowd depth=%.0f overlapping pairs=%d mean overlap=%.2f max overlap=%.2f", LENGTH - minY, overlapCount, overlapCount ? overlapSum / overlapCount : 0.0, overlapMax);
+	CHECK(LENGTH - minY < LENGTH / 2);
+	CHECK(overlapCount == 0 || overlapSum / overlapCount < RADIUS);
+
+	// deterministic
+	BenchSamples samples2;
+	eastl::vector<vec3> posList2;
+	Run(&samples2, &posList2, &maxPairs);
+	CHECK(memcmp(posList.data(), posList2.data(), posList.size() * sizeof(vec3)) == 0);
+	return true;
+}
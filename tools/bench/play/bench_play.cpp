@@ -0,0 +1,78 @@
+#include "bench_play.h"
+#include <mxm/game_content.h>
+#include <debug/window.h>
+
+// the play server debug window is not part of the benches
+namespace Dbg {
+
+GameUID PushNewGame(const FixedStr32& mapName) { return GameUID::INVALID; }
+void PushNewFrame(GameUID gameUID) {}
+void Push(GameUID gameUID, const PlayerMaster& entity) {}
+void Push(GameUID gameUID, const Npc& entity) {}
+void Push(GameUID gameUID, const Dynamic& entity) {}
+void PushPhysics(GameUID gameUID, const PhysicsScene& scene) {}
+void PopGame(GameUID gameUID) {}
+
+}
+
+bool BenchPhysicsInit()
+{
+	static Mutex mutex;
+	static bool initialized = false;
+	static bool ok = false;
+
+	LOCK_MUTEX(mutex);
+	if(!initialized) {
+		initialized = true;
+		ok = BenchContent() && PhysicsInit(false, 64 * 1024 * 1024) && PhysContext().LoadContentMeshes();
+	}
+	return ok;
+}
+
+bool BenchWorld::Init(MapIndex mapIndex)
+{
+	if(!BenchPhysicsInit()) return false;
+
+	arena.Init("BenchWorld", 256 * 1024);
+	replication.Init(&server, BenchContent(), &arena);
+	world.Init(&replication, BenchContent(), mapIndex, &arena);
+	localTime = Time::ZERO;
+	return true;
+}
+
+void BenchWorld::Cleanup()
+{
+	world.Cleanup();
+}
+
+World::Player& BenchWorld::AddPlayer(const GameXmlContent::Master& master, u8 team, const vec3& pos)
+{
+	World::PlayerDescription desc;
+	desc.userID = UserID(world.players.size() + 1);
+	desc.clientHd = ClientHandle::INVALID;
+	desc.name = L"Bench";
+	desc.guildTag = L"Bench";
+	desc.team = team;
+	desc.masters = { master.classType, master.classType };
+	desc.skins = { master.skinIDs.empty() ? SkinIndex::DEFAULT : master.skinIDs.front(), master.skinIDs.empty() ? SkinIndex::DEFAULT : master.skinIDs.front() };
+	desc.colliderSize[0] = { (u16)master.character.getColliderRadius(), (u16)master.character.getColliderHeight() };
+	desc.colliderSize[1] = desc.colliderSize[0];
+	desc.skills.fill(SkillID::INVALID);
+	for(int i = 0; i < (i32)desc.skills.size() && i < (i32)master.skillIDs.size(); i++) {
+		desc.skills[i] = master.skillIDs[i];
+	}
+
+	return world.CreatePlayer(desc, pos, RotationHumanoid{0.f, 0.f, 0.f});
+}
+
+f64 BenchWorld::Tick()
+{
+	localTime = TimeAdd(localTime, TimeMsToTime(UPDATE_RATE * 1000));
+
+	const Time t0 = TimeNow();
+	world.Update(localTime);
+	const f64 ms = TimeDurationSinceMs(t0);
+
+	replication.FrameEnd(); // no clients, clears the frame
+	return ms;
+}
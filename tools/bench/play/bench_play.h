@@ -0,0 +1,24 @@
+#pragma once
+#include "../bench.h"
+#include <world.h>
+#include <replication.h>
+
+// Thread: Any
+// physics context and the body collision mesh, once for every play bench
+bool BenchPhysicsInit();
+
+// Standalone world on a flat scene (no map collision, no clients), the replication frames go nowhere
+struct BenchWorld
+{
+	MemArena arena;
+	Server server;
+	Replication replication;
+	World world;
+	Time localTime = Time::ZERO;
+
+	bool Init(MapIndex mapIndex);
+	void Cleanup();
+
+	World::Player& AddPlayer(const GameXmlContent::Master& master, u8 team, const vec3& pos);
+	f64 Tick(); // World::Update, returns its duration in ms
+};
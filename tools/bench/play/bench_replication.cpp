@@ -0,0 +1,416 @@
+#include "bench_play.h"
+#include <common/utils.h>
+#include <common/metrics.h>
+#include <mxm/game_content.h>
+#include <eathread/eathread_thread.h>
+
+// One lane with 20 games of 10 players, their frames encoded inline by FrameEnd, then by the lane replication pipeline.
+// There is no world: frames are scripted from the tick number and the simulation is a busy wait, no PhysX needed.
+// Clients are registered in a Server that never runs, what they are sent piles up in their send buffer.
+
+static const i32 GAME_COUNT = 20;
+static const i32 PLAYER_COUNT = 10;
+static const i32 TICK_COUNT = 360;
+static const i32 NPC_COUNT = 8;
+static const f64 SIMULATION_MS = 0.2; // world update of one game
+static const i32 RECONNECTED_PLAYER = 3; // on odd games
+
+static const ClassType g_Classes[] = {
+	ClassType::STRIKER,
+	ClassType::ARTILLERY,
+	ClassType::ASSASSIN,
+	ClassType::ELECTRO,
+	ClassType::DEFENDER,
+	ClassType::SNIPER,
+	ClassType::LAUNCHER,
+};
+
+// latency of every frame of a tick being queued for sending, in ms
+static const f64 LATENCY_BOUNDS[] = { 0.25, 0.5, 1, 1.5, 2, 3, 4, 6, 8, 12, 16, 20, 33, 50, 100 };
+
+// the server time is in these, only their size has to match between runs
+static bool HasServerTime(u16 netID)
+{
+	switch(netID) {
+		case Sv::SN_GameCreateActor::NET_ID:
+		case Sv::SN_ActionChangeLevelEvent::NET_ID:
+		case Sv::SN_CastSkill::NET_ID:
+		case Sv::SN_RunClientLevelEvent::NET_ID:
+		case Sv::SN_RunClientLevelEventSeq::NET_ID:
+		case Sv::SA_GameReady::NET_ID:
+		case Sv::SN_NotifyTimestamp::NET_ID:
+			return true;
+	}
+	return false;
+}
+
+// upper bound of the bucket the percentile falls in
+static f64 HistogramPercentile(const MetricHistogram& h, f64 p)
+{
+	i64 total = 0;
+	for(int b = 0; b <= h.boundCount; b++) total += h.buckets[b];
+
+	i64 count = 0;
+	for(int b = 0; b < h.boundCount; b++) {
+		count += h.buckets[b];
+		if(count * 100 >= (i64)(p * total)) return h.bounds[b];
+	}
+	return INFINITY;
+}
+
+static f64 HistogramMean(const MetricHistogram& h)
+{
+	i64 total = 0;
+	for(int b = 0; b <= h.boundCount; b++) total += h.buckets[b];
+	if(total == 0) return 0;
+	return (f64)h.sum / MetricHistogram::SUM_SCALE / total;
+}
+
+struct BenchGame
+{
+	MemArena arena;
+	Replication replication;
+	eastl::array<ClientHandle,PLAYER_COUNT> clients;
+};
+
+struct RunResult
+{
+	eastl::vector<eastl::vector<u8>> streams; // by server clientID
+	BenchSamples tickMs;
+	MetricHistogram latency;
+	i32 packetCount = 0;
+};
+
+static ClientHandle BenchClient(i32 clientID) { return (ClientHandle)(clientID + 1); }
+
+// one clientID per player and one for the reconnection of RECONNECTED_PLAYER
+static i32 BenchClientID(i32 game, i32 player) { return game * (PLAYER_COUNT + 1) + player; }
+
+static void PushFrame(Replication* rep, const BenchGame& game, i32 tick)
+{
+	const f32 t = (f32)tick;
+	eastl::fixed_vector<Replication::ActorMaster,PLAYER_COUNT*2,false> masterList;
+
+	for(int p = 0; p < PLAYER_COUNT; p++) {
+		Replication::Player player;
+		player.index = p;
+		player.clientHd = game.clients[p];
+		player.userID = UserID(p + 1);
+		player.name = L"Bench";
+		player.guildTag = L"Bench";
+		player.team = p & 1;
+		player.mainClass = g_Classes[p % ARRAY_COUNT(g_Classes)];
+		player.mainSkin = SkinIndex::DEFAULT;
+		player.subClass = g_Classes[(p + 1) % ARRAY_COUNT(g_Classes)];
+		player.subSkin = SkinIndex::DEFAULT;
+		player.masters = { ActorUID(1 + p * 2), ActorUID(2 + p * 2) };
+		player.mainCharaID = ((tick / 90) + p) & 1; // tags
+		player.hasJumped = p == 2 && (tick % 40) < 20;
+		rep->FramePushPlayer(player);
+
+		for(int m = 0; m < 2; m++) {
+			const bool main = m == player.mainCharaID;
+			Replication::ActorMaster& master = masterList.push_back();
+			master = Replication::ActorMaster();
+			master.actorUID = player.masters[m];
+			master.clientHd = player.clientHd;
+			master.playerIndex = p;
+			master.classType = m == 0 ? player.mainClass : player.subClass;
+			master.skinIndex = SkinIndex::DEFAULT;
+			master.pos = vec3(p * 200 + cosf(t * 0.05f) * 300 * (p % 3), sinf(t * 0.05f) * 300 * (p % 4), 0);
+			master.moveDir = vec2(-sinf(t * 0.05f), cosf(t * 0.05f));
+			master.speed = (p % 3) ? 620 : 0;
+			master.rotation = RotationHumanoid{ t * 0.02f * (p % 2), 0, t * 0.02f * (p % 5) };
+			master.weaponID = 0;
+			master.additionnalOverHeatGauge = 0;
+			master.additionnalOverHeatGaugeRatio = 0;
+			master.actionState = ActionStateID::INVALID;
+			master.actionParam1 = -1;
+			master.actionParam2 = -1;
+			master.healthMax = 1000;
+			master.health = 1000 - ((tick / 30 + p) % 10) * 50;
+			master.taggedOut = !main;
+		}
+	}
+	rep->FramePushMasterActors(masterList.data(), masterList.size());
+
+	// npcs come and go, with a new UID each time
+	for(int n = 0; n < NPC_COUNT; n++) {
+		if((tick / 60 + n) % 3 == 0) continue;
+
+		Replication::ActorNpc npc;
+		npc.actorUID = ActorUID(1000 + n + NPC_COUNT * (tick / 60));
+		npc.docID = CreatureIndex(100010001);
+		npc.localID = n;
+		npc.faction = Faction::RED;
+		npc.pos = vec3(n * 300, 1000, 0);
+		npc.dir = vec3(1, 0, 0);
+		rep->FramePushNpcActor(npc);
+	}
+
+	Replication::ActorDynamic door;
+	door.actorUID = ActorUID(5000);
+	door.docID = CreatureIndex(110040546);
+	door.localID = 0;
+	door.faction = Faction::DYNAMIC;
+	door.action = ((tick / 50) & 1) ? ActionStateID::DYNAMIC_OPEN : ActionStateID::DYNAMIC_CLOSE;
+	door.pos = vec3(0, 2000, 0);
+	door.rot = vec3(0);
+	rep->FramePushDynamicActor(door);
+
+	if(tick >= 30 && tick % 30 == 5) {
+		Replication::SkillCast cast;
+		cast.clientHd = game.clients[1];
+		cast.casterUID = ActorUID(3);
+		cast.skillID = BenchContent()->GetMaster(g_Classes[1]).skillIDs[0];
+		cast.actionID = ActionStateID::INVALID;
+		cast.castPos = vec3(100, 0, 0);
+		cast.casterPos = vec3(200, 0, 0);
+		cast.casterMoveDir = vec2(1, 0);
+		cast.casterRot = RotationHumanoid{ 0, 0, 0 };
+		cast.casterSpeed = 620;
+		cast.targetList.push_back(ActorUID(5));
+		rep->FramePushSkillCast(cast);
+	}
+
+	if(tick >= 30 && tick % 30 == 10) {
+		Replication::SkillExec exec;
+		exec.casterUID = ActorUID(3);
+		exec.skillID = BenchContent()->GetMaster(g_Classes[1]).skillIDs[0];
+		exec.actionID = ActionStateID::INVALID;
+		exec.castPos = vec3(100, 0, 0);
+		exec.targetList.push_back(ActorUID(5));
+		exec.startPos = vec3(200, 0, 0);
+		exec.endPos = vec3(400, 0, 0);
+		exec.moveDir = vec2(1, 0);
+		exec.rot = RotationHumanoid{ 0, 0, 0 };
+		exec.speed = 620;
+		exec.moveDuration = 0.5f;
+		rep->FramePushSkillExec(exec);
+	}
+}
+
+// what the packet handlers and the instance would call during that tick, before the frame ends
+static void LaneCalls(Replication* rep, BenchGame* game, i32 gameIndex, i32 tick)
+{
+	for(int p = 0; p < PLAYER_COUNT; p++) {
+		const ClientHandle clientHd = game->clients[p];
+		if(clientHd == ClientHandle::INVALID) continue;
+
+		if(tick == 0) {
+			rep->OnPlayerConnect(clientHd, p);
+			rep->PlayerRegisterMasterActor(clientHd, ActorUID(1 + p * 2), g_Classes[p % ARRAY_COUNT(g_Classes)]);
+			rep->PlayerRegisterMasterActor(clientHd, ActorUID(2 + p * 2), g_Classes[(p + 1) % ARRAY_COUNT(g_Classes)]);
+		}
+		if(tick == 2) rep->SendLoadPvpMap(clientHd, MapIndex::PVP_DEATHMATCH);
+		if(tick == 3 + p) rep->SetPlayerAsInGame(clientHd);
+		if(tick == 20) {
+			rep->SetPlayerLoaded(clientHd);
+			rep->SendGameReady(clientHd, 5000, 0);
+		}
+		if(tick == 25) rep->SendCharacterInfo(clientHd, ActorUID(1 + p * 2), CreatureIndex(100000000 + (i32)g_Classes[p % ARRAY_COUNT(g_Classes)]), g_Classes[p % ARRAY_COUNT(g_Classes)], 1000, 1000);
+		if(tick == 30) {
+			rep->SendPreGameLevelEvents(clientHd);
+			rep->SendGameStart(clientHd);
+		}
+		if(tick % 45 == 40) rep->SendClientLevelEvent(clientHd, 48);
+	}
+
+	if(tick % 25 == 24) {
+		rep->SendChatMessageToAll(L"Bench", 1, L"hello everyone", 14);
+		rep->SendChatMessageToClient(game->clients[0], L"System", EChatType::NOTICE, LFMT(L"tick %d", tick));
+		rep->SendChatWhisperConfirmToClient(game->clients[1], L"Bench2", L"psst");
+		rep->SendChatWhisperToClient(game->clients[2], L"Bench1", L"psst");
+	}
+
+	// a player leaves then comes back on a new connection
+	if(gameIndex & 1) {
+		const i32 p = RECONNECTED_PLAYER;
+		if(tick == 100) {
+			rep->OnPlayerDisconnect(game->clients[p]);
+			game->clients[p] = ClientHandle::INVALID;
+		}
+		if(tick == 130) {
+			const ClientHandle prevClientHd = BenchClient(BenchClientID(gameIndex, p));
+			game->clients[p] = BenchClient(BenchClientID(gameIndex, PLAYER_COUNT));
+			rep->OnPlayerReconnect(prevClientHd, game->clients[p], p);
+			rep->PlayerRegisterMasterActor(game->clients[p], ActorUID(1 + p * 2), g_Classes[p % ARRAY_COUNT(g_Classes)]);
+			rep->PlayerRegisterMasterActor(game->clients[p], ActorUID(2 + p * 2), g_Classes[(p + 1) % ARRAY_COUNT(g_Classes)]);
+		}
+		if(tick == 132) rep->SetPlayerAsInGame(game->clients[p]);
+		if(tick == 140) rep->SetPlayerLoaded(game->clients[p]);
+	}
+}
+
+// the lane view resolves what the encoder maps say, for every connected player
+static bool CheckLaneView(Replication* rep, const BenchGame& game)
+{
+	rep->SyncLaneView();
+
+	for(int p = 0; p < PLAYER_COUNT; p++) {
+		const ClientHandle clientHd = game.clients[p];
+		if(clientHd == ClientHandle::INVALID) continue;
+
+		const auto& localMap = rep->playerLocalInfo[p].localActorIDMap;
+		CHECK(rep->laneView.clientHandle[p] == clientHd);
+		CHECK(rep->laneView.worldActorUID[p].size() == localMap.size());
+		foreach_const(it, localMap) {
+			CHECK(rep->GetWorldActorUID(clientHd, it->second) == it->first);
+		}
+	}
+	return true;
+}
+
+static bool RunGames(bool pipelined, RunResult* out)
+{
+	Server* server = new Server();
+	defer(delete server);
+	server->running = true;
+	server->sendCoalesceThreshold = 1 << 30;
+	server->sendDisconnectThreshold = 1 << 30;
+	server->clientSocket.fill(INVALID_SOCKET);
+	for(int c = 0; c < GAME_COUNT * (PLAYER_COUNT + 1); c++) {
+		server->clientSocket[c] = (SOCKET)1; // never used, the server doesn't run
+		server->clientNet[c].pendingSendBuff.Init(64 * 1024);
+		server->clientHandle2IDMap[BenchClient(c)] = c;
+		server->clientID2HandleMap[c] = BenchClient(c);
+	}
+
+	ReplicationPipeline* pipeline = new ReplicationPipeline();
+	defer(delete pipeline);
+
+	MetricHistogram& latency = out->latency;
+	memmove(latency.bounds, LATENCY_BOUNDS, sizeof(LATENCY_BOUNDS));
+	latency.boundCount = ARRAY_COUNT(LATENCY_BOUNDS);
+	if(pipelined) {
+		pipeline->Init(0, &latency);
+	}
+
+	BenchGame* games = new BenchGame[GAME_COUNT];
+	defer(delete[] games);
+	for(int g = 0; g < GAME_COUNT; g++) {
+		BenchGame& game = games[g];
+		game.arena.Init("BenchReplication", 256 * 1024);
+		game.replication.Init(server, BenchContent(), &game.arena);
+		game.replication.pipeline = pipelined ? pipeline : nullptr;
+		for(int p = 0; p < PLAYER_COUNT; p++) {
+			game.clients[p] = BenchClient(BenchClientID(g, p));
+		}
+	}
+
+	bool viewOk = true;
+	Time tickTime = TimeNow();
+	for(int tick = 0; tick < TICK_COUNT; tick++) {
+		const Time inputRecvTime = TimeNow(); // every input of the tick arrived right before it
+		const Time t0 = TimeNow();
+
+		for(int g = 0; g < GAME_COUNT; g++) {
+			BenchGame& game = games[g];
+			LaneCalls(&game.replication, &game, g, tick);
+
+			const Time simStart = TimeNow();
+			while(TimeDurationSinceMs(simStart) < SIMULATION_MS);
+
+			PushFrame(&game.replication, game, tick);
+			game.replication.FrameEnd();
+		}
+
+		if(pipelined) {
+			pipeline->SubmitTickEnd(inputRecvTime);
+		}
+		else {
+			latency.Observe(TimeDurationSinceMs(inputRecvTime));
+		}
+		out->tickMs.Push(TimeDurationSinceMs(t0));
+
+		// waits on the pipeline, once in a while so most ticks overlap
+		if(tick % 10 == 9) {
+			for(int g = 0; g < GAME_COUNT; g++) {
+				viewOk = viewOk && CheckLaneView(&games[g].replication, games[g]);
+			}
+		}
+
+		tickTime = TimeAdd(tickTime, TimeMsToTime(UPDATE_RATE * 1000));
+		const f64 sleepMs = TimeDiffMs(TimeDiff(TimeNow(), tickTime));
+		if(sleepMs > 0 && TimeNow() < tickTime) {
+			EA::Thread::ThreadSleep((EA::Thread::ThreadTime)sleepMs);
+		}
+	}
+
+	pipeline->Cleanup();
+	for(int g = 0; g < GAME_COUNT; g++) {
+		games[g].replication.WaitEncoded();
+	}
+
+	out->streams.resize(GAME_COUNT * (PLAYER_COUNT + 1));
+	for(int c = 0; c < GAME_COUNT * (PLAYER_COUNT + 1); c++) {
+		const GrowableBuffer& buff = server->clientNet[c].pendingSendBuff;
+		out->streams[c].assign(buff.data, buff.data + buff.size);
+		out->packetCount += server->clientNet[c].pendingSendPackets;
+	}
+
+	CHECK(viewOk);
+	return true;
+}
+
+// same packets in the same order, the server time they carry aside
+static bool SameStream(const eastl::vector<u8>& a, const eastl::vector<u8>& b)
+{
+	CHECK(a.size() == b.size());
+
+	ConstBuffer ra(a.data(), a.size());
+	ConstBuffer rb(b.data(), b.size());
+	while(ra.CanRead(sizeof(NetHeader))) {
+		const NetHeader& ha = ra.Read<NetHeader>();
+		const NetHeader& hb = rb.Read<NetHeader>();
+		CHECK(ha.netID == hb.netID && ha.size == hb.size);
+
+		const u8* pa = ra.ReadRaw(ha.size - sizeof(NetHeader));
+		const u8* pb = rb.ReadRaw(hb.size - sizeof(NetHeader));
+		if(!HasServerTime(ha.netID)) {
+			CHECK(memcmp(pa, pb, ha.size - sizeof(NetHeader)) == 0);
+		}
+	}
+	return true;
+}
+
+BENCH(replication_pipeline, "20 games of 10 players, frames encoded inline against the lane pipeline: lane tick, input to frame sent, same packets")
+{
+	CHECK(BenchContent());
+	LOG("    %d cores, %d games of %d players, %.2fms of simulation per game", EA::Thread::GetProcessorCount(), GAME_COUNT, PLAYER_COUNT, SIMULATION_MS);
+
+	RunResult* inline_ = new RunResult();
+	defer(delete inline_);
+	RunResult* pipelined = new RunResult();
+	defer(delete pipelined);
+
+	if(!RunGames(false, inline_)) return false;
+	if(!RunGames(true, pipelined)) return false;
+
+	inline_->tickMs.Print("inline lane tick");
+	pipelined->tickMs.Print("pipelined lane tick");
+	LOG("    input to frame sent: inline mean=%.2fms p99<=%.2fms pipelined mean=%.2fms p99<=%.2fms",
+		HistogramMean(inline_->latency), HistogramPercentile(inline_->latency, 99), HistogramMean(pipelined->latency), HistogramPercentile(pipelined->latency, 99));
+
+	i64 bytes = 0;
+	foreach_const(s, inline_->streams) bytes += s->size();
+	LOG("    %d packets, %lld bytes per run", inline_->packetCount, (long long)bytes);
+
+	// every client got exactly the same thing
+	CHECK(inline_->packetCount == pipelined->packetCount);
+	for(int c = 0; c < (i32)inline_->streams.size(); c++) {
+		if(!SameStream(inline_->streams[c], pipelined->streams[c])) {
+			LOG("    client %d streams differ", c);
+			return false;
+		}
+	}
+
+	// the encoding has a core of its own
+	if(EA::Thread::GetProcessorCount() > 1) {
+		CHECK(pipelined->tickMs.Percentile(50) < inline_->tickMs.Percentile(50));
+	}
+	else {
+		LOG("    1 core for the lane and its pipeline, lane tick not compared");
+	}
+	return true;
+}
@@ -0,0 +1,107 @@
+#include "bench_play.h"
+#include <common/utils.h>
+#include <mxm/game_content.h>
+
+// Skill programs (compiled ActionBase.xml ops) stepped by World::ExecuteSkillPrograms
+// 10 players cast again as soon as their previous program ends, for 60 seconds of game time.
+// The same players idling give the cost of a world tick without skills.
+BENCH(skill_vm, "10 players casting continuously, world tick time with and without skill programs")
+{
+	const GameXmlContent* content = BenchContent();
+	CHECK(content);
+
+	struct Caster
+	{
+		const GameXmlContent::Master* master;
+		eastl::fixed_vector<SkillID,4,false> skills; // with a compiled action
+	};
+
+	eastl::fixed_vector<Caster,100,false> casterList;
+	foreach_const(m, content->masters) {
+		Caster c;
+		c.master = m;
+		foreach_const(s, m->skillIDs) {
+			const SkillNormalModel* skill = content->FindSkill(*s);
+			if(!skill) continue;
+
+			const GameXmlContent::CompiledActionIdx idx = content->FindCompiledAction(m->classType, skill->action);
+			if(idx == GameXmlContent::CompiledActionIdx::INVALID) continue;
+			if(content->GetCompiledAction(idx).opCount == 0) continue;
+
+			c.skills.push_back(*s);
+			if(c.skills.full()) break;
+		}
+
+		if(!c.skills.empty()) {
+			casterList.push_back(c);
+		}
+	}
+	CHECK(!casterList.empty());
+	LOG("    %d classes with castable skills", (i32)casterList.size());
+
+	const i32 PLAYER_COUNT = 10;
+	const i32 TICK_COUNT = 60 * UPDATE_TICK_RATE;
+
+	auto Run = [&](bool cast, BenchSamples* samples, i32* castCount, i32* programTicks, i32* maxRemotes) {
+		BenchWorld* bw = new BenchWorld();
+		defer(delete bw);
+		if(!bw->Init(MapIndex::PVP_DEATHMATCH)) return false;
+		defer(bw->Cleanup());
+
+		World& world = bw->world;
+		for(int i = 0; i < PLAYER_COUNT; i++) {
+			const Caster& c = casterList[i % casterList.size()];
+			const f32 a = i * 2*PI / PLAYER_COUNT;
+			bw->AddPlayer(*c.master, (u8)(i & 1), vec3(cosf(a) * 1000, sinf(a) * 1000, 0));
+		}
+
+		eastl::array<i32,PLAYER_COUNT> nextSkill;
+		nextSkill.fill(0);
+
+		for(int t = 0; t < TICK_COUNT; t++) {
+			if(cast) {
+				for(int i = 0; i < PLAYER_COUNT; i++) {
+					World::Player& p = world.players[i];
+
+					bool casting = false;
+					foreach_const(prog, world.skillProgramList) {
+						if(prog->casterUID == p.Main().UID && !prog->IsDoneExecuting()) {
+							casting = true;
+							break;
+						}
+					}
+					if(casting) continue;
+
+					const Caster& c = casterList[i % casterList.size()];
+					const f32 a = (f32)(Randf01() * 2*PI);
+					p.input.rot.upperYaw = a;
+					p.input.cast.skillID = c.skills[nextSkill[i]++ % c.skills.size()];
+					p.input.cast.pos = p.body->GetWorldPos() + vec3(cosf(a) * 500, sinf(a) * 500, 0);
+					p.input.cast.targetList.clear();
+					(*castCount)++;
+				}
+			}
+
+			samples->Push(bw->Tick());
+			*programTicks += world.skillProgramList.size();
+			*maxRemotes = MAX(*maxRemotes, world.remotes.CountAlive());
+		}
+		return true;
+	};
+
+	BenchSamples idle, casting;
+	i32 castCount = 0, programTicks = 0, maxRemotes = 0;
+	i32 idleCasts = 0, idlePrograms = 0, idleRemotes = 0;
+
+	CHECK(Run(false, &idle, &idleCasts, &idlePrograms, &idleRemotes));
+	CHECK(Run(true, &casting, &castCount, &programTicks, &maxRemotes));
+
+	idle.Print("world tick, idle");
+	casting.Print("world tick, casting");
+	LOG("    casts=%d  programs per tick=%.2f  max live remotes=%d", castCount, (f64)programTicks / TICK_COUNT, maxRemotes);
+
+	CHECK(idlePrograms == 0);
+	CHECK(castCount > PLAYER_COUNT);
+	CHECK(programTicks > 0);
+	return true;
+}
@@ -0,0 +1,190 @@
+#include "bench_play.h"
+#include <common/utils.h>
+#include <mxm/game_content.h>
+#include <game.h>
+#include <eathread/eathread_thread.h>
+
+// random point on a random navmesh polygon
+static vec3 RandWalkablePos(const NavMesh& mesh)
+{
+	const NavMeshFile::Poly& poly = mesh.polys[RandInt(0, mesh.polyCount - 1)];
+	return (mesh.vertices[poly.verts[0]] + mesh.vertices[poly.verts[1]] + mesh.vertices[poly.verts[2]]) / 3.f;
+}
+
+// PhysicsScene sweeps of skill moves on the PVP_DeathMatch map collision.
+// 10 players spam their dash skills (actions with a move), their end positions come from the queued sweeps of the tick.
+// Then the same sweeps are queued in batches and resolved at once with ResolveQueries, against resolving them one by one.
+BENCH(skill_sweeps, "10 players spamming dash skills, PhysicsScene sweeps per second")
+{
+	const GameXmlContent* content = BenchContent();
+	CHECK(content);
+
+	const NavMesh* navMesh = content->FindNavMesh(MapIndex::PVP_DEATHMATCH);
+	CHECK(navMesh);
+
+	struct Dasher
+	{
+		const GameXmlContent::Master* master;
+		eastl::fixed_vector<SkillID,4,false> skills; // moving the caster
+		eastl::fixed_vector<f32,4,false> distances;
+	};
+
+	eastl::fixed_vector<Dasher,100,false> dasherList;
+	foreach_const(m, content->masters) {
+		Dasher d;
+		d.master = m;
+		foreach_const(s, m->skillIDs) {
+			const SkillNormalModel* skill = content->FindSkill(*s);
+			if(!skill) continue;
+
+			const GameXmlContent::CompiledActionIdx idx = content->FindCompiledAction(m->classType, skill->action);
+			if(idx == GameXmlContent::CompiledActionIdx::INVALID) continue;
+			const GameXmlContent::CompiledAction& action = content->GetCompiledAction(idx);
+			if(action.moveDistance <= 0) continue;
+
+			d.skills.push_back(*s);
+			d.distances.push_back(action.moveDistance);
+			if(d.skills.full()) break;
+		}
+
+		if(!d.skills.empty()) {
+			dasherList.push_back(d);
+		}
+	}
+	CHECK(!dasherList.empty());
+	LOG("    %d classes with dash skills", (i32)dasherList.size());
+
+	BenchWorld* bw = new BenchWorld();
+	defer(delete bw);
+	CHECK(bw->Init(MapIndex::PVP_DEATHMATCH));
+	defer(bw->Cleanup());
+
+	// map collision, loaded by the physics loader thread
+	PhysicsContext::MapCollision collision;
+	CHECK(PhysContext().AcquireMapCollision(*content, MapIndex::PVP_DEATHMATCH, &collision));
+	defer(PhysContext().ReleaseMapCollision(&collision));
+	while(collision.GetLoadState() == PhysicsContext::MapCollision::LoadState::LOADING) {
+		EA::Thread::ThreadSleep(1);
+	}
+	CHECK(collision.GetLoadState() == PhysicsContext::MapCollision::LoadState::LOADED);
+
+	World& world = bw->world;
+	PhysicsScene& physics = world.physics;
+	CHECK(Game::CreateMapColliders(&physics));
+
+	const i32 PLAYER_COUNT = 10;
+	for(int i = 0; i < PLAYER_COUNT; i++) {
+		const Dasher& d = dasherList[i % dasherList.size()];
+		bw->AddPlayer(*d.master, (u8)(i & 1), RandWalkablePos(*navMesh));
+	}
+
+	// players cast again as soon as their previous skill is done
+	{
+		const i32 TICK_COUNT = 30 * UPDATE_TICK_RATE;
+		BenchSamples samples;
+		i32 castCount = 0;
+		eastl::array<i32,PLAYER_COUNT> nextSkill;
+		nextSkill.fill(0);
+
+		for(int t = 0; t < TICK_COUNT; t++) {
+			for(int i = 0; i < PLAYER_COUNT; i++) {
+				World::Player& p = world.players[i];
+
+				bool casting = false;
+				foreach_const(prog, world.skillProgramList) {
+					if(prog->casterUID == p.Main().UID && !prog->IsDoneExecuting()) {
+						casting = true;
+						break;
+					}
+				}
+				if(casting) continue;
+
+				const Dasher& d = dasherList[i % dasherList.size()];
+				const f32 a = (f32)(Randf01() * 2*PI);
+				p.input.rot.upperYaw = a;
+				p.input.cast.skillID = d.skills[nextSkill[i]++ % d.skills.size()];
+				p.input.cast.pos = p.body->GetWorldPos() + vec3(cosf(a) * 500, sinf(a) * 500, 0);
+				p.input.cast.targetList.clear();
+				castCount++;
+			}
+
+			samples.Push(bw->Tick());
+			CHECK(world.pendingSkillExecList.empty()); // every exec got its end position this tick
+		}
+
+		LOG("    dash casts=%d (%.1f per second)", castCount, castCount / (TICK_COUNT * UPDATE_RATE));
+		samples.Print("world tick, dashing");
+		CHECK(castCount > PLAYER_COUNT);
+	}
+
+	// sweeps of the same players in every direction, queued then resolved together
+	{
+		const i32 BATCH_COUNT = 200;
+		const i32 PER_PLAYER = (i32)decltype(physics.queryList)::kMaxSize / PLAYER_COUNT;
+
+		struct Sweep
+		{
+			const PhysicsDynamicBody* body;
+			vec3 disp;
+			vec3 startPos;
+		};
+
+		eastl::vector<Sweep> sweepList;
+		BenchSamples batched, direct;
+		f64 batchedTotal = 0;
+		f64 directTotal = 0;
+		i32 blocked = 0;
+		i32 sweepCount = 0;
+
+		for(int b = 0; b < BATCH_COUNT; b++) {
+			sweepList.clear();
+			for(int i = 0; i < PLAYER_COUNT; i++) {
+				const World::Player& p = world.players[i];
+				const Dasher& d = dasherList[i % dasherList.size()];
+				for(int s = 0; s < PER_PLAYER; s++) {
+					const f32 a = (f32)(Randf01() * 2*PI);
+					const f32 dist = d.distances[RandInt(0, d.distances.size() - 1)];
+					sweepList.push_back({ p.body, vec3(cosf(a) * dist, sinf(a) * dist, 0), p.body->GetWorldPos() });
+				}
+			}
+
+			foreach_const(s, sweepList) {
+				CHECK(physics.QuerySweep(s->body, s->disp) != PhysicsScene::QueryID::INVALID);
+			}
+
+			const Time t0 = TimeNow();
+			physics.ResolveQueries();
+			const f64 ms = TimeDurationSinceMs(t0);
+			batched.Push(ms);
+			batchedTotal += ms;
+
+			for(int i = 0; i < (i32)sweepList.size(); i++) {
+				const Sweep& s = sweepList[i];
+				const PhysicsScene::QueryResult& r = physics.GetQueryResult((PhysicsScene::QueryID)i);
+
+				// queries don't move anything, and never go further than asked
+				CHECK(s.body->GetWorldPos() == s.startPos);
+				CHECK(glm::length(vec2(r.pos - s.startPos)) <= glm::length(vec2(s.disp)) + 1);
+				blocked += r.hit;
+			}
+			sweepCount += sweepList.size();
+
+			// the same sweeps, one by one
+			const Time t1 = TimeNow();
+			foreach_const(s, sweepList) {
+				physics.SweepNow(s->body, s->disp);
+			}
+			const f64 dms = TimeDurationSinceMs(t1);
+			direct.Push(dms);
+			directTotal += dms;
+
+			physics.Step(); // clears the queries
+		}
+
+		LOG("    %d sweeps in batches of %d, %d blocked", sweepCount, (i32)sweepList.size(), blocked);
+		LOG("    ResolveQueries: %.0f sweeps/sec  SweepNow: %.0f sweeps/sec", sweepCount / (batchedTotal / 1000), sweepCount / (directTotal / 1000));
+		batched.Print("ResolveQueries (batch)");
+		direct.Print("SweepNow (one by one)");
+	}
+	return true;
+}
@@ -0,0 +1,116 @@
+#include "bench_play.h"
+#include <common/utils.h>
+#include <mxm/game_content.h>
+#include <instance.h>
+#include <config.h>
+#include <eathread/eathread_thread.h>
+#include <EASTL/fixed_set.h>
+
+// What a lane does to create a deathmatch game: build the instance itself (cold) or take one the InstanceWarmer built (warm).
+// The map collision is cached for both, what the pool saves is the scene, the colliders and the map actors.
+
+static const i32 RUN_COUNT = 20;
+static const i32 WARM_COUNT = 2;
+
+static In::MQ_CreateGame MakeGame(SortieUID sortieUID)
+{
+	In::MQ_CreateGame game;
+	memset(&game, 0, sizeof(game));
+	game.sortieUID = sortieUID;
+	game.mapIndex = MapIndex::PVP_DEATHMATCH;
+	game.playerCount = 1;
+	game.players[0].accountUID = AccountUID((u32)sortieUID);
+	return game;
+}
+
+static bool WaitReady(const InstanceWarmer& warmer)
+{
+	const Time t0 = TimeNow();
+	while(warmer.mapPoolList[0].readyCount.GetValue() < WARM_COUNT) {
+		if(TimeDurationSinceMs(t0) > 10000) return false;
+		EA::Thread::ThreadSleep(1);
+	}
+	return true;
+}
+
+BENCH(warm_instances, "deathmatch game created on the lane (cold) or taken from the warm pool, pool refill and instance reuse")
+{
+	CHECK(BenchPhysicsInit());
+	const GameXmlContent& content = *BenchContent();
+	LoadConfig(); // game.cfg when there is one, the defaults otherwise
+
+	Server* server = new Server();
+	defer(delete server);
+
+	// the collision stays cached while this one holds it
+	PhysicsContext::MapCollision held;
+	CHECK(PhysContext().AcquireMapCollision(content, MapIndex::PVP_DEATHMATCH, &held));
+	defer(PhysContext().ReleaseMapCollision(&held));
+	while(held.GetLoadState() == PhysicsContext::MapCollision::LoadState::LOADING) {
+		EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+	}
+	CHECK(held.GetLoadState() == PhysicsContext::MapCollision::LoadState::LOADED);
+
+	BenchSamples cold;
+	BenchSamples warm;
+	eastl::array<i32,2> coldSpawnCount;
+
+	// cold: same as InstancePool::Lane::HandleQueues without a warm instance, then until the game can start
+	for(int i = 0; i < RUN_COUNT; i++) {
+		const Time t0 = TimeNow();
+		PvpInstance* inst = new PvpInstance();
+		inst->Acquire(MapIndex::PVP_DEATHMATCH);
+		PvpInstance::PrepareResult r;
+		while((r = inst->PrepareGame()) == PvpInstance::PrepareResult::PENDING) {
+			EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+		}
+		inst->Assign((SortieUID)(i + 1), MakeGame((SortieUID)(i + 1)), server);
+		cold.Push(TimeDurationSinceMs(t0));
+
+		CHECK(r == PvpInstance::PrepareResult::READY);
+		coldSpawnCount = { (i32)inst->game.mapSpawnPoints[0].size(), (i32)inst->game.mapSpawnPoints[1].size() };
+		inst->game.Cleanup();
+		delete inst;
+	}
+	CHECK(coldSpawnCount[0] > 0 && coldSpawnCount[1] > 0);
+
+	// warm: taken ready, finished games go back to the warmer which resets and builds them again
+	InstanceWarmer* warmer = new InstanceWarmer();
+	defer(delete warmer);
+	const MapIndex mapList[] = { MapIndex::PVP_DEATHMATCH };
+	CHECK(warmer->Init(mapList, ARRAY_COUNT(mapList), WARM_COUNT));
+	defer(warmer->Cleanup());
+
+	eastl::fixed_set<PvpInstance*,RUN_COUNT,false> seen;
+	for(int i = 0; i < RUN_COUNT; i++) {
+		CHECK(WaitReady(*warmer));
+
+		const Time t0 = TimeNow();
+		PvpInstance* inst = warmer->Take(MapIndex::PVP_DEATHMATCH);
+		CHECK(inst);
+		inst->Assign((SortieUID)(i + 1), MakeGame((SortieUID)(i + 1)), server);
+		warm.Push(TimeDurationSinceMs(t0));
+
+		// the same map as a cold one, of the current content
+		CHECK(inst->prepared);
+		CHECK(inst->content.version == ContentCurrentVersion());
+		CHECK((i32)inst->game.mapSpawnPoints[0].size() == coldSpawnCount[0]);
+		CHECK((i32)inst->game.mapSpawnPoints[1].size() == coldSpawnCount[1]);
+
+		seen.insert(inst);
+		warmer->Recycle(inst);
+	}
+	CHECK(WaitReady(*warmer));
+
+	// one game at a time: the pool plus the one being replaced, every other game reused a reset instance
+	LOG("    %d games, %d instances allocated by the warmer", RUN_COUNT, (i32)seen.size());
+	CHECK((i32)seen.size() <= WARM_COUNT + 1);
+
+	// a map the pool doesn't know is built by the lane
+	CHECK(warmer->Take(MapIndex::LOBBY_NORMAL) == nullptr);
+
+	cold.Print("cold creation", "ms");
+	warm.Print("warm creation", "ms");
+	CHECK(warm.Percentile(50) < cold.Percentile(50));
+	return true;
+}
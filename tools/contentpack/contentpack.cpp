@@ -0,0 +1,64 @@
+#include <common/base.h>
+#include <common/utils.h>
+#include <mxm/game_content.h>
+
+// Bake the game content xml files into gamedata/content.<xml stamp>.pack, mapped by the servers at startup instead of parsing the xml.
+// Run from the build directory like the servers (gamedata is at ../gamedata).
+
+static bool Bake()
+{
+	GameXmlContent* content = new GameXmlContent();
+	if(!content->Load(GameXmlContent::Source::XML)) {
+		LOG("ERROR: failed to load the xml content");
+		return false;
+	}
+
+	return content->SavePack();
+}
+
+// The pack has to hold the same content as the xml, baking the xml again has to give the same bytes.
+static bool Verify()
+{
+	GameXmlContent* fromXml = new GameXmlContent();
+	if(!fromXml->Load(GameXmlContent::Source::XML)) {
+		LOG("ERROR: failed to load the xml content");
+		return false;
+	}
+
+	GameXmlContent* fromPack = new GameXmlContent();
+	if(!fromPack->Load(GameXmlContent::Source::PACK)) {
+		LOG("ERROR: failed to load the content pack");
+		return false;
+	}
+
+	// the segment of the pack is the file itself
+	if(fromXml->segment.size() != fromPack->segment.size() || memcmp(fromXml->segment.data(), fromPack->segment.data(), fromXml->segment.size()) != 0) {
+		LOG("ERROR: the content pack does not match the xml (xml=%d bytes pack=%d bytes), rebake it", (i32)fromXml->segment.size(), (i32)fromPack->segment.size());
+		return false;
+	}
+
+	LOG("Content pack matches the xml (%d bytes)", (i32)fromPack->segment.size());
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	// contentpack bake|verify
+	if(argc != 2) {
+		printf("Usage: contentpack bake|verify\n");
+		return 1;
+	}
+
+	LogInit("contentpack.log");
+	TimeInit();
+
+	if(strcmp(argv[1], "bake") == 0) {
+		return Bake() ? 0 : 1;
+	}
+	if(strcmp(argv[1], "verify") == 0) {
+		return Verify() ? 0 : 1;
+	}
+
+	printf("Usage: contentpack bake|verify\n");
+	return 1;
+}
@@ -9,6 +9,9 @@ local common_includes = {
 
 local common_files = {
 	SRC_DIR .. "/common/base.cpp",
+	SRC_DIR .. "/common/arena.cpp",
+	SRC_DIR .. "/common/memory.cpp",
+	SRC_DIR .. "/common/thread_slots.cpp",
 	SRC_DIR .. "/common/logger.cpp",
 	SRC_DIR .. "/common/platform_windows.cpp",
 	SRC_DIR .. "/common/platform_linux.cpp",
@@ -76,6 +79,7 @@ project "NavMesh"
 
 	includedirs {
 		common_includes,
+		glm_includedir,
 		"navmesh",
 	}
 
@@ -90,6 +94,38 @@ project "NavMesh"
 		"navmesh/**.cpp",
 	}
 
+project "ContentPack"
+	kind "ConsoleApp"
+	targetname "contentpack"
+
+	configuration {}
+
+	includedirs {
+		common_includes,
+		tinyxml2_includedir,
+		glm_includedir,
+		"contentpack",
+	}
+
+	links {
+		common_links
+	}
+
+	files {
+		common_files,
+		SRC_DIR .. "/common/utils.cpp",
+		SRC_DIR .. "/common/protocol.cpp",
+		SRC_DIR .. "/mxm/**.h",
+		SRC_DIR .. "/mxm/**.cpp",
+		tinyxml2_files,
+		"contentpack/**.h",
+		"contentpack/**.cpp",
+	}
+
+	defines {
+		"GLM_FORCE_XYZW_ONLY"
+	}
+
 project "ToolCollision"
 	kind "ConsoleApp"
 	targetname "col"
@@ -122,4 +158,219 @@ project "ToolCollision"
 	configuration "Debug"
 		libdirs {
 			physx_libdir_debug
-		}
\ No newline at end of file
+		}
+-- Benchmarks and behavior checks of the server code (tools/bench/bench.h), run as: bench all | bench <name>...
+local bench_includes = {
+	common_includes,
+	zlib_includedir,
+	tinyxml2_includedir,
+	tracy_includedir,
+	glm_includedir,
+	"bench",
+}
+
+local bench_links = {
+	"zlib",
+	common_links,
+}
+
+local bench_files = {
+	SRC_DIR .. "/common/**.h",
+	SRC_DIR .. "/common/**.cpp",
+	SRC_DIR .. "/mxm/**.h",
+	SRC_DIR .. "/mxm/**.cpp",
+	tinyxml2_files,
+	tracy_files,
+	glm_files,
+	"bench/bench.h",
+	"bench/bench.cpp",
+}
+
+project "Bench"
+	kind "ConsoleApp"
+	targetname "bench"
+
+	configuration {}
+
+	includedirs {
+		bench_includes,
+		physx_includedir, -- headers only, for the play server math
+		SRC_DIR .. "/servers/play",
+		SRC_DIR .. "/servers/matchmaker",
+	}
+
+	links {
+		bench_links
+	}
+
+	files {
+		bench_files,
+		SRC_DIR .. "/servers/play/remote.h",
+		SRC_DIR .. "/servers/play/remote.cpp",
+		SRC_DIR .. "/servers/play/navigation.h",
+		SRC_DIR .. "/servers/play/navigation.cpp",
+		SRC_DIR .. "/servers/matchmaker/matching.h",
+		SRC_DIR .. "/servers/matchmaker/matching.cpp",
+		"bench/*.cpp",
+	}
+
+	defines {
+		"GLM_FORCE_XYZW_ONLY"
+	}
+
+	configuration "windows"
+		links {
+			"ws2_32",
+			"user32",
+			"advapi32"
+		}
+
+	configuration "linux"
+		links {
+			"pthread",
+			"dl",
+		}
+
+-- play server benches that need a physics scene (the PhysX libs are windows only)
+project "BenchPlay"
+	kind "ConsoleApp"
+	targetname "bench_play"
+
+	configuration {}
+
+	includedirs {
+		bench_includes,
+		physx_includedir,
+		SRC_DIR .. "/servers/play",
+	}
+
+	links {
+		bench_links,
+		physx_libs_win64
+	}
+
+	files {
+		bench_files,
+		SRC_DIR .. "/servers/play/**.h",
+		SRC_DIR .. "/servers/play/**.cpp",
+		"bench/play/**.h",
+		"bench/play/**.cpp",
+	}
+
+	excludes {
+		SRC_DIR .. "/servers/play/game_main.cpp",
+		SRC_DIR .. "/servers/play/debug/**", -- stubbed in bench/play/bench_play.cpp
+	}
+
+	defines {
+		"GLM_FORCE_XYZW_ONLY"
+	}
+
+	configuration "Release"
+		libdirs {
+			physx_libdir_release
+		}
+
+	configuration "Debug"
+		libdirs {
+			physx_libdir_debug
+		}
+
+	configuration "windows"
+		links {
+			"ws2_32",
+			"user32",
+			"advapi32"
+		}
+
+	configuration "linux"
+		links {
+			"pthread",
+			"dl",
+		}
+
+-- hub server benches, built with the hub sources like BenchPlay is with the play server ones
+project "BenchHub"
+	kind "ConsoleApp"
+	targetname "bench_hub"
+
+	configuration {}
+
+	includedirs {
+		bench_includes,
+		SRC_DIR .. "/servers/hub",
+	}
+
+	links {
+		bench_links
+	}
+
+	files {
+		bench_files,
+		SRC_DIR .. "/servers/hub/**.h",
+		SRC_DIR .. "/servers/hub/**.cpp",
+		"bench/hub/**.h",
+		"bench/hub/**.cpp",
+	}
+
+	excludes {
+		SRC_DIR .. "/servers/hub/hub_main.cpp",
+	}
+
+	defines {
+		"GLM_FORCE_XYZW_ONLY"
+	}
+
+	configuration "windows"
+		links {
+			"ws2_32",
+			"user32",
+			"advapi32"
+		}
+
+	configuration "linux"
+		links {
+			"pthread",
+			"dl",
+		}
+
+-- fake play servers and hub for the local placement test (scripts/test_placement.sh)
+project "LoadTest"
+	kind "ConsoleApp"
+	targetname "loadtest"
+
+	configuration {}
+
+	includedirs {
+		bench_includes,
+	}
+
+	links {
+		bench_links
+	}
+
+	files {
+		SRC_DIR .. "/common/**.h",
+		SRC_DIR .. "/common/**.cpp",
+		tracy_files,
+		glm_files,
+		"loadtest/**.h",
+		"loadtest/**.cpp",
+	}
+
+	defines {
+		"GLM_FORCE_XYZW_ONLY"
+	}
+
+	configuration "windows"
+		links {
+			"ws2_32",
+			"user32",
+			"advapi32"
+		}
+
+	configuration "linux"
+		links {
+			"pthread",
+			"dl",
+		}
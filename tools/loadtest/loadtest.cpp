@@ -0,0 +1,483 @@
+#include <common/base.h>
+#include <common/network.h>
+#include <common/inner_protocol.h>
+#include <common/protocol.h>
+#include <common/utils.h>
+#include <EASTL/fixed_set.h>
+#include <EASTL/fixed_map.h>
+#include <eathread/eathread_thread.h>
+
+// Local multi-process tests, against a running MatchMaker (127.0.0.1:13900):
+//   loadtest play <listenPort> <maxGames> <tickMsPerGame>   fake play server, one lane, its tick grows with its games
+//   loadtest hub <matchCount> <playPort>...                 fake hub, queues 6 solo parties at a time, counts where the games go
+// Run three play servers with different costs, then the hub. Placement by load gives the cheaper servers more games,
+// round-robin would not (scripts/test_placement.sh).
+//
+// And against a running login server (127.0.0.1:10900, hubs register on 10901):
+//   loadtest lobby <listenPort> <maxPlayers> <basePlayers> <tickP99Ms>        fake hub, reports the clients connected to it
+//   loadtest login <clientCount> <saturatedPort> <hubPort>:<basePlayers>...   fake clients, log in then connect to the hub they are sent to
+// Hubs start with different player counts, the login server has to even them out, never send anyone to the
+// saturated hub and send reconnecting clients back to their hub (scripts/test_login_balance.sh).
+
+static const u8 LOCAL_IP[4] = { 127, 0, 0, 1 };
+static const u16 MM_PORT = 13900;
+static const u16 LOGIN_PORT = 10900;
+static const u16 LOGIN_INNER_PORT = 10901;
+static const f64 TICK_BUDGET_MS = 1000.0 / 60.0; // play server lane
+
+struct ServerLink
+{
+	InnerConnection conn;
+	u8 recvBuff[8192];
+
+	bool Connect(u16 port, const char* serverName)
+	{
+		// the server may not be listening yet
+		for(int i = 0; i < 50; i++) {
+			if(conn.async.ConnectTo(LOCAL_IP, port)) {
+				conn.async.StartReceiving();
+				conn.sendQ.size = 0;
+				conn.recvCounter.Reset();
+				return true;
+			}
+			EA::Thread::ThreadSleep(100);
+		}
+
+		LOG("ERROR: Failed to connect to %s server", serverName);
+		return false;
+	}
+
+	void Close()
+	{
+		closesocket(conn.async.sock);
+		conn.async.sock = INVALID_SOCKET;
+	}
+
+	// calls onPacket for every packet received, false when the connection is lost
+	template<typename Func>
+	bool Update(Func onPacket)
+	{
+		conn.SendPendingData();
+
+		i32 recvLen = 0;
+		conn.RecvPendingData(recvBuff, sizeof(recvBuff), &recvLen);
+		if(!conn.async.IsConnected()) return false;
+
+		ConstBuffer reader(recvBuff, recvLen);
+		while(reader.CanRead(sizeof(NetHeader))) {
+			const NetHeader& header = reader.Read<NetHeader>();
+			const i32 packetDataSize = header.size - sizeof(NetHeader);
+			ASSERT(reader.CanRead(packetDataSize));
+			onPacket(header, reader.ReadRaw(packetDataSize), packetDataSize);
+		}
+		return true;
+	}
+};
+
+static i32 RunPlay(u16 listenPort, i32 maxGames, f32 tickMsPerGame)
+{
+	static ServerLink mm; // 1MB send queue
+	if(!mm.Connect(MM_PORT, "matchmaker")) return 1;
+
+	In::PQ_Handshake handshake;
+	handshake.magic = In::MagicHandshake;
+	handshake.listenPort = listenPort;
+	mm.conn.SendPacket(handshake);
+
+	i32 gameCount = 0;
+	Time lastReportTime = Time::ZERO;
+
+	while(true) {
+		const bool connected = mm.Update([&](const NetHeader& header, const u8* packetData, i32 packetSize) {
+			if(header.netID != In::MQ_CreateGame::NET_ID) return;
+			const In::MQ_CreateGame& packet = SafeCast<In::MQ_CreateGame>(packetData, packetSize);
+
+			gameCount++;
+			LOG("[play:%d] Game created (sortieUID=%llu games=%d)", listenPort, (u64)packet.sortieUID, gameCount);
+
+			In::PR_GameCreated resp;
+			resp.sortieUID = packet.sortieUID;
+			mm.conn.SendPacket(resp);
+		});
+		if(!connected) break;
+
+		// same period as the play server coordinator
+		if(lastReportTime == Time::ZERO || TimeDurationSinceSec(lastReportTime) >= 1.0) {
+			lastReportTime = TimeNow();
+
+			const f32 tickMs = 1.0f + gameCount * tickMsPerGame;
+
+			In::PQ_LoadReport report;
+			report.maxGamesPerLane = (u16)maxGames;
+			report.laneCount = 1;
+			report.lanes[0].gameCount = (u16)gameCount;
+			report.lanes[0].playerCount = (u16)(gameCount * 6);
+			report.lanes[0].tickP99Ms = tickMs;
+			report.lanes[0].busyPercent = (u8)MIN(100.0, tickMs / TICK_BUDGET_MS * 100.0);
+			mm.conn.SendPacket(report);
+		}
+
+		EA::Thread::ThreadSleep(5);
+	}
+
+	LOG("[play:%d] Matchmaker disconnected (games=%d)", listenPort, gameCount);
+	return 0;
+}
+
+static i32 RunHub(i32 matchCount, const u16* playPorts, i32 playCount)
+{
+	static ServerLink mm; // 1MB send queue
+	if(!mm.Connect(MM_PORT, "matchmaker")) return 1;
+
+	In::HQ_Handshake handshake;
+	handshake.magic = In::MagicHandshake;
+	mm.conn.SendPacket(handshake);
+
+	const i32 PARTY_PER_MATCH = 6;
+	const f64 MATCH_INTERVAL_SEC = 0.25; // a few load reports per placement decision
+
+	eastl::fixed_map<PartyUID,AccountUID,64,true> partyLeader;
+	eastl::fixed_set<SortieUID,64,true> roomCreated;
+	eastl::fixed_map<u16,i32,8,false> gamesPerPort;
+	u32 nextAccount = 1;
+	i32 queuedMatches = 0;
+	i32 createdMatches = 0;
+	Time lastQueueTime = Time::ZERO;
+	const Time startTime = TimeNow();
+
+	while(createdMatches < matchCount) {
+		if(TimeDurationSinceSec(startTime) > 60 + matchCount * MATCH_INTERVAL_SEC) {
+			LOG("ERROR: Timed out (created=%d/%d)", createdMatches, matchCount);
+			return 1;
+		}
+
+		if(queuedMatches < matchCount && (lastQueueTime == Time::ZERO || TimeDurationSinceSec(lastQueueTime) >= MATCH_INTERVAL_SEC)) {
+			lastQueueTime = TimeNow();
+			queuedMatches++;
+
+			for(int i = 0; i < PARTY_PER_MATCH; i++) {
+				In::HQ_PartyCreate packet;
+				packet.name.Copy(WideString(LFMT(L"Player%u", nextAccount)));
+				packet.leader = (AccountUID)nextAccount++;
+				mm.conn.SendPacket(packet);
+			}
+		}
+
+		const bool connected = mm.Update([&](const NetHeader& header, const u8* packetData, i32 packetSize) {
+			switch(header.netID) {
+				case In::MR_PartyCreated::NET_ID: {
+					const In::MR_PartyCreated& packet = SafeCast<In::MR_PartyCreated>(packetData, packetSize);
+					partyLeader[packet.partyUID] = packet.leader;
+
+					In::HQ_PartyEnqueue enqueue;
+					enqueue.partyUID = packet.partyUID;
+					enqueue.mode = (u8)MatchMode::ARENA_3V3;
+					enqueue.region = 0;
+					enqueue.rating = 1500;
+					mm.conn.SendPacket(enqueue);
+				} break;
+
+				case In::MN_MatchingPartyFound::NET_ID: {
+					const In::MN_MatchingPartyFound& packet = SafeCast<In::MN_MatchingPartyFound>(packetData, packetSize);
+
+					In::HN_PlayerRoomConfirm confirm;
+					confirm.accountUID = partyLeader.at(packet.partyUID);
+					confirm.confirm = 1;
+					confirm.sortieUID = packet.sortieUID;
+					mm.conn.SendPacket(confirm);
+					partyLeader.erase(packet.partyUID);
+				} break;
+
+				case In::MN_RoomCreated::NET_ID: {
+					const In::MN_RoomCreated& packet = SafeCast<In::MN_RoomCreated>(packetData, packetSize);
+					if(!roomCreated.insert(packet.sortieUID).second) break; // once per player
+
+					In::HQ_RoomCreateGame create;
+					memset(&create, 0, sizeof(create));
+					create.sortieUID = packet.sortieUID;
+					create.playerCount = packet.playerCount;
+					for(int i = 0; i < packet.playerCount; i++) {
+						create.players[i].accountUID = packet.playerList[i].accountUID;
+						create.players[i].team = packet.playerList[i].team;
+						create.players[i].isBot = packet.playerList[i].isBot;
+					}
+					mm.conn.SendPacket(create);
+				} break;
+
+				case In::MN_MatchCreated::NET_ID: {
+					const In::MN_MatchCreated& packet = SafeCast<In::MN_MatchCreated>(packetData, packetSize);
+					gamesPerPort[packet.serverPort]++;
+					createdMatches++;
+				} break;
+			}
+		});
+
+		if(!connected) {
+			LOG("ERROR: Matchmaker disconnected");
+			return 1;
+		}
+
+		EA::Thread::ThreadSleep(5);
+	}
+
+	i32 minGames = matchCount;
+	i32 maxGames = 0;
+	for(int i = 0; i < playCount; i++) {
+		const i32 games = gamesPerPort[playPorts[i]];
+		minGames = MIN(minGames, games);
+		maxGames = MAX(maxGames, games);
+		LOG("[hub] Play server :%d games=%d", playPorts[i], games);
+	}
+
+	// play servers are listed cheapest first, they have to get more games (round-robin would spread them evenly)
+	bool ok = gamesPerPort.size() == (u32)playCount;
+	for(int i = 1; i < playCount; i++) {
+		ok = ok && gamesPerPort[playPorts[i - 1]] > gamesPerPort[playPorts[i]];
+	}
+
+	LOG("[hub] %d games, spread %s (min=%d max=%d)", createdMatches, ok ? "by load" : "NOT by load", minGames, maxGames);
+	return ok ? 0 : 1;
+}
+
+static intptr_t ThreadListen(void* pData)
+{
+	Listener& listener = *(Listener*)pData;
+	listener.Listen();
+	return 0;
+}
+
+static i32 RunLobby(u16 listenPort, i32 maxPlayers, i32 basePlayers, f32 tickP99Ms)
+{
+	static Server server;
+	if(!server.Init()) return 1;
+
+	static Listener listener(&server);
+	if(!listener.Init(listenPort)) return 1;
+
+	EA::Thread::Thread listenThread;
+	listenThread.Begin(ThreadListen, &listener);
+
+	static ServerLink login; // 1MB send queue
+	if(!login.Connect(LOGIN_INNER_PORT, "login")) return 1;
+
+	In::HL_Register reg;
+	reg.magic = In::MagicHandshake;
+	reg.ip = { LOCAL_IP[0], LOCAL_IP[1], LOCAL_IP[2], LOCAL_IP[3] };
+	reg.listenPort = listenPort;
+	reg.maxPlayers = (u16)maxPlayers;
+	login.conn.SendPacket(reg);
+
+	// clients don't send anything, they only count while they are connected
+	eastl::fixed_vector<ClientHandle,MAX_CLIENTS,false> connectedList;
+	eastl::fixed_vector<ClientHandle,MAX_CLIENTS,false> disconnectedList;
+	i32 clientCount = 0;
+	Time lastReportTime = Time::ZERO;
+
+	while(true) {
+		connectedList.clear();
+		disconnectedList.clear();
+		server.TransferConnectedClientList(&connectedList);
+		server.TransferDisconnectedClientList(&disconnectedList);
+		clientCount += (i32)connectedList.size() - (i32)disconnectedList.size();
+
+		// same period as the hub login connector
+		if(lastReportTime == Time::ZERO || TimeDurationSinceSec(lastReportTime) >= 1.0) {
+			lastReportTime = TimeNow();
+
+			In::HL_LoadReport report;
+			report.playerCount = (u16)(basePlayers + clientCount);
+			report.tickP99Ms = tickP99Ms;
+			login.conn.SendPacket(report);
+		}
+
+		// nothing is expected from the login server
+		if(!login.Update([](const NetHeader&, const u8*, i32) {})) break;
+
+		EA::Thread::ThreadSleep(5);
+	}
+
+	LOG("[lobby:%d] Login server disconnected (clients=%d)", listenPort, clientCount);
+	listener.Stop();
+	server.Cleanup();
+	return 0;
+}
+
+// goes through the login server like a client, up to the hub address it gets
+static bool LoginAndGetHub(i32 account, u16* outPort)
+{
+	static ServerLink login; // 1MB send queue
+	if(!login.Connect(LOGIN_PORT, "login")) return false;
+	defer(login.Close());
+
+	PacketWriter<Cl::CQ_UserLogin> packet;
+	packet.WriteStringObj(LFMT(L"Player%d", account)); // login, sticky routing key
+	packet.WriteStringObj(L"password");
+	packet.WriteStringObj(L"loadtest");
+	login.conn.SendPacketData(Cl::CQ_UserLogin::NET_ID, packet.size, packet.data);
+
+	Cl::EnterQueue enter;
+	memset(&enter, 0, sizeof(enter));
+	login.conn.SendPacket(enter);
+
+	bool found = false;
+	const Time startTime = TimeNow();
+	while(!found && TimeDurationSinceSec(startTime) < 5.0) {
+		const bool connected = login.Update([&](const NetHeader& header, const u8* packetData, i32 packetSize) {
+			if(header.netID != Sv::SN_DoConnectChannelServer::NET_ID) return;
+
+			ConstBuffer buff(packetData, packetSize);
+			buff.Read<u16>(); // count
+			buff.ReadRaw(4); // ip
+			*outPort = buff.Read<u16>();
+			found = true;
+		});
+		if(!connected) break;
+
+		EA::Thread::ThreadSleep(1);
+	}
+
+	if(!found) {
+		LOG("ERROR: Player%d was not sent to a hub", account);
+	}
+	return found;
+}
+
+static i32 RunLogin(i32 clientCount, u16 saturatedPort, const u16* hubPorts, const i32* hubBasePlayers, i32 hubCount)
+{
+	const i32 RECONNECT_PER_HUB = 5;
+
+	struct Client
+	{
+		AsyncConnection hub;
+		u16 hubPort;
+	};
+
+	eastl::vector<Client> clientList;
+	clientList.resize(clientCount);
+	eastl::fixed_map<u16,i32,8,false> clientsPerPort;
+
+	auto ConnectToHub = [&](Client* cl) {
+		if(!cl->hub.ConnectTo(LOCAL_IP, cl->hubPort)) {
+			LOG("ERROR: Failed to connect to hub :%d", cl->hubPort);
+			return false;
+		}
+		return true;
+	};
+
+	// every client logs in and stays on its hub
+	for(int i = 0; i < clientCount; i++) {
+		Client& cl = clientList[i];
+		if(!LoginAndGetHub(i, &cl.hubPort)) return 1;
+		if(!ConnectToHub(&cl)) return 1;
+		clientsPerPort[cl.hubPort]++;
+		EA::Thread::ThreadSleep(10);
+	}
+
+	bool ok = clientsPerPort.count(saturatedPort) == 0;
+	i32 minPlayers = 0x7FFFFFFF;
+	i32 maxPlayers = 0;
+	for(int i = 0; i < hubCount; i++) {
+		const i32 players = hubBasePlayers[i] + clientsPerPort[hubPorts[i]];
+		minPlayers = MIN(minPlayers, players);
+		maxPlayers = MAX(maxPlayers, players);
+		LOG("[login] Hub :%d base=%d clients=%d players=%d", hubPorts[i], hubBasePlayers[i], clientsPerPort[hubPorts[i]], players);
+	}
+	LOG("[login] Saturated hub :%d clients=%d", saturatedPort, clientsPerPort[saturatedPort]);
+
+	// one more client at most, sent before the last load report of its hub
+	ok = ok && maxPlayers - minPlayers <= 2;
+	LOG("[login] %d clients, hubs %s (players min=%d max=%d)", clientCount, ok ? "evened out" : "NOT evened out", minPlayers, maxPlayers);
+
+	// Reconnects, grouped by hub, while the old connection is still open (a client that crashed, the hub didn't notice yet).
+	// The least loaded hub would change with every one of them, they have to go back to the same hub.
+	i32 reconnectCount = 0;
+	i32 movedCount = 0;
+	for(int h = 0; h < hubCount; h++) {
+		i32 count = 0;
+		for(int i = 0; i < clientCount && count < RECONNECT_PER_HUB; i++) {
+			Client& cl = clientList[i];
+			if(cl.hubPort != hubPorts[h]) continue;
+			count++;
+
+			u16 port;
+			if(!LoginAndGetHub(i, &port)) return 1;
+			reconnectCount++;
+			if(port != cl.hubPort) {
+				LOG("[login] Player%d reconnected to :%d instead of :%d", i, port, cl.hubPort);
+				movedCount++;
+			}
+
+			closesocket(cl.hub.sock);
+			cl.hub.sock = INVALID_SOCKET;
+			cl.hubPort = port;
+			if(!ConnectToHub(&cl)) return 1;
+		}
+	}
+
+	LOG("[login] %d reconnects, %d sent to another hub", reconnectCount, movedCount);
+	ok = ok && movedCount == 0;
+	return ok ? 0 : 1;
+}
+
+static void PrintUsage()
+{
+	printf("Usage: loadtest play <listenPort> <maxGames> <tickMsPerGame>\n");
+	printf("       loadtest hub <matchCount> <playPort>... (cheapest play server first)\n");
+	printf("       loadtest lobby <listenPort> <maxPlayers> <basePlayers> <tickP99Ms>\n");
+	printf("       loadtest login <clientCount> <saturatedPort> <hubPort>:<basePlayers>...\n");
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 3) {
+		PrintUsage();
+		return 1;
+	}
+
+	PlatformInit();
+	TimeInit();
+
+	if(!NetworkInit()) return 1;
+
+	i32 r = -1;
+	if(strcmp(argv[1], "play") == 0 && argc == 5) {
+		const u16 port = (u16)atoi(argv[2]);
+		LogInit(FMT("loadtest_play_%d.log", port));
+		r = RunPlay(port, atoi(argv[3]), (f32)atof(argv[4]));
+	}
+	else if(strcmp(argv[1], "hub") == 0 && argc >= 4) {
+		LogInit("loadtest_hub.log");
+
+		eastl::fixed_vector<u16,8,false> ports;
+		for(int i = 3; i < argc && !ports.full(); i++) {
+			ports.push_back((u16)atoi(argv[i]));
+		}
+		r = RunHub(atoi(argv[2]), ports.data(), ports.size());
+	}
+	else if(strcmp(argv[1], "lobby") == 0 && argc == 6) {
+		const u16 port = (u16)atoi(argv[2]);
+		LogInit(FMT("loadtest_lobby_%d.log", port));
+		r = RunLobby(port, atoi(argv[3]), atoi(argv[4]), (f32)atof(argv[5]));
+	}
+	else if(strcmp(argv[1], "login") == 0 && argc >= 5) {
+		LogInit("loadtest_login.log");
+
+		eastl::fixed_vector<u16,8,false> ports;
+		eastl::fixed_vector<i32,8,false> basePlayers;
+		for(int i = 4; i < argc && !ports.full(); i++) {
+			i32 port, base;
+			if(sscanf(argv[i], "%d:%d", &port, &base) != 2) break;
+			ports.push_back((u16)port);
+			basePlayers.push_back(base);
+		}
+		if(ports.size() == (u32)(argc - 4)) {
+			r = RunLogin(atoi(argv[2]), (u16)atoi(argv[3]), ports.data(), basePlayers.data(), ports.size());
+		}
+	}
+
+	if(r == -1) {
+		PrintUsage();
+		return 1;
+	}
+	return r;
+}
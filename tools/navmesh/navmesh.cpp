@@ -1,5 +1,11 @@
 #include <common/base.h>
+#include <common/vector_math.h>
+#include <mxm/navmesh.h>
 #include <EAStdC/EAString.h>
+#include <EASTL/algorithm.h>
+#include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+#include <glm/geometric.hpp>
 
 #ifdef CONF_DEBUG
 	#define DBG LOG
@@ -116,8 +122,345 @@ struct NavMeshReader
 	}
 };
 
+struct BakeParams
+{
+	f32 stepHeight = 120; // GlobalTweakableVariables::stepHeight
+	f32 jumpHeight = 300; // jumpForce^2 / (2 * gravity) = 400, minus some margin
+	f32 maxDrop = 600; // highest ledge an agent is allowed to drop from (spawn platforms are ~565 above the floor)
+	f32 agentRadius = 45; // PhysXMeshComData character collider
+};
+
+// Bake a navmesh from the walkable triangles of a collision mesh (.msh)
+// The client navmesh can't be fully read yet so we build our own.
+// Surfaces that don't share vertices (steps, platforms, ledges) are stitched by probing an agent radius out of each
+// border edge: two-way when it is a step or a jump, one-way when it is a drop.
+// Regions the agent can't get out of to the main floor are discarded.
+// TODO: erode by the character radius
+static bool BakeNavMesh(const char* inputFilename, const char* outputFilename, const BakeParams& params)
+{
+	struct MeshFileHeader
+	{
+		u32 magic;
+		u16 version;
+		u16 count;
+	};
+
+	struct MeshVertex
+	{
+		f32 px, py, pz;
+		f32 nx, ny, nz;
+	};
+
+	const f32 maxSlopeCos = cosf(50.0f * (f32)PI / 180.0f);
+	const f32 weldDist = 1.0f;
+
+	i32 fileSize;
+	u8* fileData = fileOpenAndReadAll(inputFilename, &fileSize);
+	if(!fileData) {
+		LOG("ERROR: failed to open '%s'", inputFilename);
+		return false;
+	}
+	defer(memFree(fileData));
+
+	ConstBuffer buff(fileData, fileSize);
+	const MeshFileHeader& header = buff.Read<MeshFileHeader>();
+	if(strncmp((char*)&header.magic, "MESH", 4) != 0 || header.version != 2) {
+		LOG("ERROR: '%s' is not a MESH v2 file", inputFilename);
+		return false;
+	}
+
+	eastl::vector<vec3> vertexList;
+	eastl::vector<NavMeshFile::Poly> polyList;
+	eastl::hash_map<u64,u32> weldMap;
+
+	auto WeldVertex = [&](const vec3& v) {
+		const u64 x = (u64)((i64)floorf(v.x / weldDist + 0.5f) + (1 << 20)) & 0x1FFFFF;
+		const u64 y = (u64)((i64)floorf(v.y / weldDist + 0.5f) + (1 << 20)) & 0x1FFFFF;
+		const u64 z = (u64)((i64)floorf(v.z / weldDist + 0.5f) + (1 << 20)) & 0x1FFFFF;
+		const u64 key = (x << 42) | (y << 21) | z;
+
+		auto found = weldMap.find(key);
+		if(found != weldMap.end()) return found->second;
+
+		const u32 id = vertexList.size();
+		vertexList.push_back(v);
+		weldMap.emplace(key, id);
+		return id;
+	};
+
+	i32 steepCount = 0;
+	for(int m = 0; m < header.count; m++) {
+		const i32 nameLen = buff.Read<i32>();
+		const char* name = (char*)buff.ReadRaw(nameLen);
+		const u32 vertexCount = buff.Read<u32>();
+		const u32 indexCount = buff.Read<u32>();
+		const MeshVertex* vertices = (MeshVertex*)buff.ReadRaw(sizeof(MeshVertex) * vertexCount);
+		const u16* indices = (u16*)buff.ReadRaw(sizeof(u16) * indexCount);
+
+		LOG("mesh '%.*s' vertices=%u indices=%u", nameLen, name, vertexCount, indexCount);
+
+		for(u32 i = 0; i + 2 < indexCount; i += 3) {
+			vec3 tri[3];
+			for(int k = 0; k < 3; k++) {
+				const MeshVertex& mv = vertices[indices[i + k]];
+				tri[k] = vec3(mv.px, mv.py, mv.pz);
+			}
+
+			const vec3 n = glm::cross(tri[1] - tri[0], tri[2] - tri[0]);
+			const f32 len = glm::length(n);
+			if(len < 0.001f) continue; // degenerate
+
+			if(fabsf(n.z / len) < maxSlopeCos) {
+				steepCount++;
+				continue;
+			}
+
+			// counter clockwise seen from above
+			if(n.z < 0) eastl::swap(tri[1], tri[2]);
+
+			NavMeshFile::Poly poly;
+			for(int k = 0; k < 3; k++) {
+				poly.verts[k] = WeldVertex(tri[k]);
+				poly.neighbours[k] = NavMeshFile::NONE;
+			}
+
+			if(poly.verts[0] == poly.verts[1] || poly.verts[1] == poly.verts[2] || poly.verts[0] == poly.verts[2]) continue;
+			polyList.push_back(poly);
+		}
+	}
+
+	// connect polygons sharing an edge
+	eastl::hash_map<u64,u32> edgeMap; // edge -> poly * 3 + edge
+	i32 nonManifoldCount = 0;
+	for(u32 p = 0; p < polyList.size(); p++) {
+		NavMeshFile::Poly& poly = polyList[p];
+		for(int e = 0; e < 3; e++) {
+			const u32 v0 = poly.verts[e];
+			const u32 v1 = poly.verts[(e+1)%3];
+			const u64 key = ((u64)MIN(v0, v1) << 32) | (u64)MAX(v0, v1);
+
+			auto found = edgeMap.find(key);
+			if(found == edgeMap.end()) {
+				edgeMap.emplace(key, p * 3 + e);
+				continue;
+			}
+
+			const u32 other = found->second / 3;
+			const u32 otherEdge = found->second % 3;
+			if(polyList[other].neighbours[otherEdge] != NavMeshFile::NONE) {
+				nonManifoldCount++;
+				continue;
+			}
+
+			poly.neighbours[e] = other;
+			polyList[other].neighbours[otherEdge] = p;
+		}
+	}
+
+	if(polyList.empty()) {
+		LOG("ERROR: no walkable triangle found");
+		return false;
+	}
+
+	auto PolyZAt = [&](const NavMeshFile::Poly& poly, const vec2& pt, f32* outZ) {
+		const vec3& a = vertexList[poly.verts[0]];
+		const vec3& b = vertexList[poly.verts[1]];
+		const vec3& c = vertexList[poly.verts[2]];
+		const f32 area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+		if(fabsf(area) < 0.001f) return false;
+
+		// barycentric, counter clockwise so every weight is positive inside
+		const f32 wa = ((b.x - pt.x) * (c.y - pt.y) - (c.x - pt.x) * (b.y - pt.y)) / area;
+		const f32 wb = ((c.x - pt.x) * (a.y - pt.y) - (a.x - pt.x) * (c.y - pt.y)) / area;
+		const f32 wc = 1.0f - wa - wb;
+		if(wa < 0 || wb < 0 || wc < 0) return false;
+
+		*outZ = a.z * wa + b.z * wb + c.z * wc;
+		return true;
+	};
+
+	// stitch border edges to whatever surface is right outside of them
+	i32 stepLinkCount = 0;
+	i32 jumpLinkCount = 0;
+	i32 dropLinkCount = 0;
+	const f32 probeT[3] = { 0.5f, 0.25f, 0.75f };
+	for(u32 p = 0; p < polyList.size(); p++) {
+		for(int e = 0; e < 3; e++) {
+			if(polyList[p].neighbours[e] != NavMeshFile::NONE) continue;
+
+			const vec3& v0 = vertexList[polyList[p].verts[e]];
+			const vec3& v1 = vertexList[polyList[p].verts[(e+1)%3]];
+			const vec2 edge = vec2(v1 - v0);
+			const f32 edgeLen = glm::length(edge);
+			if(edgeLen < 0.001f) continue;
+			const vec2 out = vec2(edge.y, -edge.x) / edgeLen; // counter clockwise: outside is on the right
+
+			u32 best = NavMeshFile::NONE;
+			f32 bestZ = -FLT_MAX;
+			f32 fromZ = 0;
+			for(int t = 0; t < 3 && best == NavMeshFile::NONE; t++) {
+				const vec3 onEdge = v0 + (v1 - v0) * probeT[t];
+				const vec2 probe = vec2(onEdge) + out * params.agentRadius;
+
+				for(u32 o = 0; o < polyList.size(); o++) {
+					if(o == p) continue;
+
+					f32 z;
+					if(!PolyZAt(polyList[o], probe, &z)) continue;
+					if(z > onEdge.z + params.jumpHeight || onEdge.z - z > params.maxDrop) continue;
+
+					// highest surface under the probe, we land on it
+					if(z > bestZ) {
+						best = o;
+						bestZ = z;
+						fromZ = onEdge.z;
+					}
+				}
+			}
+
+			if(best == NavMeshFile::NONE) continue;
+
+			polyList[p].neighbours[e] = best;
+			if(bestZ - fromZ > params.stepHeight) jumpLinkCount++;
+			else if(fromZ - bestZ > params.stepHeight) dropLinkCount++;
+			else stepLinkCount++;
+		}
+	}
+
+	// keep what can reach the main floor: the largest region (by area) where every link goes both ways
+	const i32 polyCount = polyList.size();
+	eastl::vector<i32> regionList(polyCount, -1);
+	eastl::vector<f32> regionArea;
+	for(i32 p = 0; p < polyCount; p++) {
+		if(regionList[p] != -1) continue;
+
+		const i32 region = regionArea.size();
+		regionArea.push_back(0);
+		eastl::vector<i32> stack = { p };
+		regionList[p] = region;
+		while(!stack.empty()) {
+			const NavMeshFile::Poly& poly = polyList[stack.back()];
+			const i32 cur = stack.back();
+			stack.pop_back();
+
+			const vec3& a = vertexList[poly.verts[0]];
+			const vec3& b = vertexList[poly.verts[1]];
+			const vec3& c = vertexList[poly.verts[2]];
+			regionArea[region] += fabsf((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) * 0.5f;
+
+			for(int e = 0; e < 3; e++) {
+				const u32 next = poly.neighbours[e];
+				if(next == NavMeshFile::NONE || regionList[next] != -1) continue;
+
+				const NavMeshFile::Poly& nextPoly = polyList[next];
+				if(nextPoly.neighbours[0] != (u32)cur && nextPoly.neighbours[1] != (u32)cur && nextPoly.neighbours[2] != (u32)cur) continue; // one-way
+
+				regionList[next] = region;
+				stack.push_back(next);
+			}
+		}
+	}
+
+	const i32 mainRegion = eastl::max_element(regionArea.begin(), regionArea.end()) - regionArea.begin();
+
+	// walk links backwards from the main floor
+	eastl::vector<u8> keep(polyCount, 0);
+	eastl::vector<i32> stack;
+	for(i32 p = 0; p < polyCount; p++) {
+		if(regionList[p] == mainRegion) {
+			keep[p] = 1;
+			stack.push_back(p);
+		}
+	}
+	while(!stack.empty()) {
+		const u32 cur = stack.back();
+		stack.pop_back();
+		for(i32 p = 0; p < polyCount; p++) {
+			if(keep[p]) continue;
+			const NavMeshFile::Poly& poly = polyList[p];
+			if(poly.neighbours[0] == cur || poly.neighbours[1] == cur || poly.neighbours[2] == cur) {
+				keep[p] = 1;
+				stack.push_back(p);
+			}
+		}
+	}
+
+	// compact polygons and vertices
+	eastl::vector<u32> polyRemap(polyCount, NavMeshFile::NONE);
+	eastl::vector<u32> vertexRemap(vertexList.size(), NavMeshFile::NONE);
+	eastl::vector<NavMeshFile::Poly> keptPolyList;
+	eastl::vector<vec3> keptVertexList;
+	for(i32 p = 0; p < polyCount; p++) {
+		if(!keep[p]) continue;
+		polyRemap[p] = keptPolyList.size();
+		keptPolyList.push_back(polyList[p]);
+	}
+
+	foreach(p, keptPolyList) {
+		for(int i = 0; i < 3; i++) {
+			u32& v = vertexRemap[p->verts[i]];
+			if(v == NavMeshFile::NONE) {
+				v = keptVertexList.size();
+				keptVertexList.push_back(vertexList[p->verts[i]]);
+			}
+			p->verts[i] = v;
+
+			if(p->neighbours[i] != NavMeshFile::NONE) {
+				p->neighbours[i] = polyRemap[p->neighbours[i]];
+			}
+		}
+	}
+
+	const i32 discardedCount = polyCount - (i32)keptPolyList.size();
+	polyList = eastl::move(keptPolyList);
+	vertexList = eastl::move(keptVertexList);
+
+	i32 borderCount = 0;
+	foreach_const(p, polyList) {
+		for(int e = 0; e < 3; e++) {
+			borderCount += p->neighbours[e] == NavMeshFile::NONE;
+		}
+	}
+
+	LOG("vertices=%d polys=%d steep=%d borderEdges=%d nonManifoldEdges=%d", (i32)vertexList.size(), (i32)polyList.size(), steepCount, borderCount, nonManifoldCount);
+	LOG("stepLinks=%d jumpLinks=%d dropLinks=%d regions=%d discardedPolys=%d", stepLinkCount, jumpLinkCount, dropLinkCount, (i32)regionArea.size(), discardedCount);
+	LOG("stepHeight=%g jumpHeight=%g maxDrop=%g agentRadius=%g", params.stepHeight, params.jumpHeight, params.maxDrop, params.agentRadius);
+
+	NavMeshFile::Header outHeader;
+	outHeader.magic = NavMeshFile::MAGIC;
+	outHeader.version = NavMeshFile::VERSION;
+	outHeader.reserved = 0;
+	outHeader.vertexCount = vertexList.size();
+	outHeader.polyCount = polyList.size();
+
+	const i32 verticesSize = sizeof(vec3) * vertexList.size();
+	const i32 polysSize = sizeof(NavMeshFile::Poly) * polyList.size();
+
+	GrowableBuffer out(sizeof(outHeader) + verticesSize + polysSize);
+	out.Append(&outHeader, sizeof(outHeader));
+	out.Append(vertexList.data(), verticesSize);
+	out.Append(polyList.data(), polysSize);
+
+	if(!fileSaveBuff(outputFilename, out.data, out.size)) return false;
+
+	LOG("'%s' written (%d bytes)", outputFilename, out.size);
+	return true;
+}
+
 int main(int argc, char** argv)
 {
+	// navmesh bake input.msh output.navmesh [stepHeight [jumpHeight [maxDrop [agentRadius]]]]
+	if(argc >= 4 && argc <= 8 && strcmp(argv[1], "bake") == 0) {
+		LogInit("navmesh.log");
+
+		BakeParams params;
+		if(argc > 4) params.stepHeight = (f32)atof(argv[4]);
+		if(argc > 5) params.jumpHeight = (f32)atof(argv[5]);
+		if(argc > 6) params.maxDrop = (f32)atof(argv[6]);
+		if(argc > 7) params.agentRadius = (f32)atof(argv[7]);
+		return BakeNavMesh(argv[2], argv[3], params) ? 0 : 1;
+	}
+
 	ASSERT(argc == 2);
 
 	LogInit("navmesh.log");